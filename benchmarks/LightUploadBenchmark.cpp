@@ -0,0 +1,146 @@
+// Compare writing all the lights of the scene to the light buffer every frame with the
+// incremental upload of the LightSystem, on a scene of mostly static point lights.
+//
+// Each frame moves a few lights, updates the world transforms and copies the lights into the
+// buffer of the frame slot, like SceneRenderer::uploadLights() writes the mapped light buffers.
+//
+// usage: LightUploadBenchmark [lightCount] [movingLightCount] [frames]
+#include "LightSystem.h"
+#include "TransformSystem.h"
+
+#include <Engine/Log.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kFrameInFlightCount = 3;
+
+/// @brief Light buffer of each frame slot.
+using LightBuffers = std::array<std::vector<PointLight>, kFrameInFlightCount>;
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<entt::entity> createLights(entt::registry& registry, uint32_t lightCount) {
+    std::mt19937                          random(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::vector<entt::entity>             lights(lightCount);
+    for (entt::entity& e : lights) {
+        e = registry.create();
+        registry.emplace<CTransform>(e).position = {position(random), 5.0f, position(random)};
+        auto& light     = registry.emplace<CPointLight>(e);
+        light.ambient   = {0.2f, 0.2f, 0.2f};
+        light.diffuse   = {1.0f, 1.0f, 1.0f};
+        light.specular  = {1.0f, 1.0f, 1.0f};
+        light.constant  = 1.0f;
+        light.linear    = 0.09f;
+        light.quadratic = 0.0032f;
+    }
+    return lights;
+}
+
+/// @brief Move the first lights of the scene, each frame.
+void moveLights(entt::registry& registry, const std::vector<entt::entity>& lights, uint32_t movingCount, uint32_t frame) {
+    for (uint32_t i = 0; i < movingCount; ++i) {
+        registry.patch<CTransform>(lights[i], [frame](CTransform& transform) {
+            transform.position.y = 5.0f + static_cast<float>(frame % 16);
+        });
+    }
+}
+
+/// @brief Write all the enabled lights, what SceneRenderer::uploadLights() did before the LightSystem.
+uint32_t uploadAll(entt::registry& registry, std::vector<PointLight>& buffer) {
+    auto view = registry.view<CWorldTransform, CPointLight>();
+    buffer.resize(std::max<size_t>(buffer.size(), view.size_hint()));
+
+    uint32_t count = 0;
+    for (auto [entity, world, pointLight] : view.each()) {
+        if (!pointLight.enable) {
+            continue;
+        }
+        PointLight& light = buffer[count++];
+        light             = {};
+        light.position    = world.model[3];
+        light.ambient     = glm::vec4(pointLight.ambient, 1.0f);
+        light.diffuse     = glm::vec4(pointLight.diffuse, 1.0f);
+        light.specular    = glm::vec4(pointLight.specular, 1.0f);
+        light.constant    = pointLight.constant;
+        light.linear      = pointLight.linear;
+        light.quadratic   = pointLight.quadratic;
+        light.range       = pointLight.range;
+        light.intensity   = pointLight.intensity;
+    }
+    return count;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Engine::Log::Initialize();
+
+    const uint32_t lightCount  = argc > 1 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[1]))) : 10000;
+    const uint32_t movingCount = std::min(lightCount, argc > 2 ? static_cast<uint32_t>(std::max(0, std::atoi(argv[2]))) : 50u);
+    const uint32_t frames      = argc > 3 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[3]))) : 1000;
+
+    // Full: every light written every frame.
+    double   fullMs      = 0.0;
+    uint64_t fullWritten = 0;
+    {
+        entt::registry                  registry;
+        TransformSystem                 transformSystem(registry);
+        const std::vector<entt::entity> lights = createLights(registry, lightCount);
+        LightBuffers                    buffers;
+        transformSystem.update();
+
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            moveLights(registry, lights, movingCount, frame);
+            const auto start = std::chrono::steady_clock::now();
+            transformSystem.update();
+            fullWritten += uploadAll(registry, buffers[frame % kFrameInFlightCount]);
+            fullMs += elapsedMs(start);
+        }
+    }
+
+    // Incremental: the LightSystem writes the lights changed since the last use of the frame slot.
+    double   incrementalMs      = 0.0;
+    uint64_t incrementalWritten = 0;
+    {
+        entt::registry                  registry;
+        TransformSystem                 transformSystem(registry);
+        LightSystem                     lightSystem(registry, kFrameInFlightCount);
+        const std::vector<entt::entity> lights = createLights(registry, lightCount);
+        LightBuffers                    buffers;
+        SpotLight                       spotLight{};
+        DirectionalLight                directionalLight{};
+        transformSystem.update();
+
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            moveLights(registry, lights, movingCount, frame);
+            const auto start = std::chrono::steady_clock::now();
+            transformSystem.update();
+            lightSystem.update();
+            std::vector<PointLight>& buffer = buffers[frame % kFrameInFlightCount];
+            buffer.resize(std::max(buffer.size(), size_t(lightSystem.getPointLightCount())));
+            incrementalWritten += lightSystem.upload(frame % kFrameInFlightCount, buffer.data(), &spotLight, &directionalLight);
+            incrementalMs += elapsedMs(start);
+        }
+    }
+
+    std::printf("%u point lights, %u moving, %u frames\n", lightCount, movingCount, frames);
+    std::printf("full       : %10.4f ms/frame (%llu lights written per frame)\n", fullMs / frames,
+                static_cast<unsigned long long>(fullWritten / frames));
+    std::printf("incremental: %10.4f ms/frame (%llu lights written per frame)\n", incrementalMs / frames,
+                static_cast<unsigned long long>(incrementalWritten / frames));
+    std::printf("speedup    : %10.2fx\n", incrementalMs > 0.0 ? fullMs / incrementalMs : 0.0);
+
+    Engine::Log::Shutdown();
+    return 0;
+}
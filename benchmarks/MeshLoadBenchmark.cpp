@@ -0,0 +1,93 @@
+// Compare loading a model with the full Assimp import and from the binary mesh cache.
+//
+// Each load ends with the copy of the vertices and indices into an upload buffer, like
+// Mesh::Create() copies them into the staging ring.
+//
+// usage: MeshLoadBenchmark [modelPath] [iterations]
+#include "AssimpImporter.h"
+#include "MeshCache.h"
+
+#include <Engine/Log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+const std::filesystem::path kCacheDirectory = "./cache/benchmark";
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// @brief Copy the mesh into the upload buffer, return the number of bytes copied.
+uint64_t upload(const MeshDataView& mesh, std::vector<std::byte>& uploadBuffer) {
+    const uint64_t size = mesh.vertices.size_bytes() + mesh.indices.size_bytes();
+    uploadBuffer.resize(std::max<uint64_t>(uploadBuffer.size(), size));
+    std::memcpy(uploadBuffer.data(), mesh.vertices.data(), mesh.vertices.size_bytes());
+    std::memcpy(uploadBuffer.data() + mesh.vertices.size_bytes(), mesh.indices.data(), mesh.indices.size_bytes());
+    return size;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Engine::Log::Initialize();
+
+    const std::filesystem::path path       = argc > 1 ? argv[1] : "./data/model/edf_soldier/edf_soldier_a.obj";
+    const int                   iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+
+    AssimpImporter         importer;
+    std::vector<std::byte> uploadBuffer;
+
+    // Cold: the full Assimp pipeline, what every launch did before the cache.
+    double   coldMs    = 0.0;
+    uint64_t coldBytes = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        MeshData   meshData;
+        if (!importer.importMesh(path, meshData)) {
+            std::printf("failed to import %s\n", path.string().c_str());
+            Engine::Log::Shutdown();
+            return 1;
+        }
+        coldBytes = upload(meshData, uploadBuffer);
+        coldMs += elapsedMs(start);
+
+        if (i == 0) {
+            MeshCache::store(path, importer.getImportSettings(), meshData, kCacheDirectory);
+        }
+    }
+
+    // Cached: map the cache file and copy the blobs.
+    double   cachedMs    = 0.0;
+    uint64_t cachedBytes = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const auto            start = std::chrono::steady_clock::now();
+        MeshCache::CachedMesh cachedMesh;
+        if (!MeshCache::load(path, importer.getImportSettings(), cachedMesh, kCacheDirectory)) {
+            std::printf("failed to load the cache of %s\n", path.string().c_str());
+            Engine::Log::Shutdown();
+            return 1;
+        }
+        cachedBytes = upload(cachedMesh.view, uploadBuffer);
+        cachedMs += elapsedMs(start);
+    }
+
+    std::printf("%s, %d iterations\n", path.string().c_str(), iterations);
+    std::printf("assimp : %10.3f ms (%llu bytes)\n", coldMs / iterations, static_cast<unsigned long long>(coldBytes));
+    std::printf("cache  : %10.3f ms (%llu bytes)\n", cachedMs / iterations,
+                static_cast<unsigned long long>(cachedBytes));
+    std::printf("speedup: %10.2fx\n", cachedMs > 0.0 ? coldMs / cachedMs : 0.0);
+
+    std::error_code error;
+    std::filesystem::remove_all(kCacheDirectory, error);
+
+    Engine::Log::Shutdown();
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Compare the startup time of decoding all the images of the data directory
+// one after another on the main thread and on a thread pool, then the decoding
+// of the images with a cooked file with the reading of the cooked files.
+//
+// usage: TextureLoadBenchmark [dataDirectory] [cookedDirectory]
+#include "ImageDecoder.h"
+#include "Ktx2File.h"
+
+#include <Engine/Log.h>
+#include <Engine/ThreadPool.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::filesystem::path> findImages(const std::filesystem::path& directory) {
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension == ".png" || extension == ".tga" || extension == ".jpg" || extension == ".jpeg") {
+            paths.push_back(entry.path());
+        }
+    }
+    return paths;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Engine::Log::Initialize();
+
+    const std::filesystem::path dataDirectory   = argc > 1 ? argv[1] : "./data";
+    const std::filesystem::path cookedDirectory = argc > 2 ? argv[2] : "./cooked";
+    if (!std::filesystem::is_directory(dataDirectory)) {
+        std::printf("%s is not a directory\n", dataDirectory.string().c_str());
+        Engine::Log::Shutdown();
+        return 1;
+    }
+
+    const std::vector<std::filesystem::path> paths = findImages(dataDirectory);
+    std::printf("%zu images found in %s\n", paths.size(), dataDirectory.string().c_str());
+
+    // Serial: what the game did before, one stbi_load after another.
+    uint64_t serialBytes = 0;
+    auto     start       = std::chrono::steady_clock::now();
+    for (const auto& path : paths) {
+        const DecodedImage image = ImageDecoder::decode(path);
+        serialBytes += image.isValid() ? image.getSizeInByte() : 0;
+    }
+    const double serialMs = elapsedMs(start);
+
+    // Parallel: the pool is created outside of the measure, like the renderer thread pool.
+    Engine::ThreadPool threadPool;
+    uint64_t           parallelBytes = 0;
+    start                            = std::chrono::steady_clock::now();
+    ImageDecoder::decodeBatch(paths, threadPool, [&parallelBytes](uint32_t, DecodedImage& image) {
+        parallelBytes += image.isValid() ? image.getSizeInByte() : 0;
+    });
+    const double parallelMs = elapsedMs(start);
+
+    std::printf("serial   : %10.2f ms (%llu bytes)\n", serialMs, static_cast<unsigned long long>(serialBytes));
+    std::printf("parallel : %10.2f ms (%llu bytes, %u threads)\n", parallelMs,
+                static_cast<unsigned long long>(parallelBytes), threadPool.getThreadCount());
+    std::printf("speedup  : %10.2fx\n", parallelMs > 0.0 ? serialMs / parallelMs : 0.0);
+
+    // Cooked: the block compressed levels are read as is, the decode only has the level 0.
+    // Best of a few runs of each file, the first ones warm up the file cache.
+    constexpr int kRunCount   = 5;
+    uint32_t      cookedCount = 0;
+    double        decodeMs    = 0.0;
+    double        cookedMs    = 0.0;
+    for (const auto& path : paths) {
+        std::filesystem::path cookedPath = cookedDirectory / std::filesystem::relative(path, dataDirectory);
+        cookedPath.replace_extension(".ktx2");
+        if (!std::filesystem::exists(cookedPath)) {
+            continue;
+        }
+        double bestDecodeMs = 1e30;
+        double bestCookedMs = 1e30;
+        for (int run = 0; run < kRunCount; ++run) {
+            start                      = std::chrono::steady_clock::now();
+            const DecodedImage decoded = ImageDecoder::decode(path);
+            bestDecodeMs               = std::min(bestDecodeMs, elapsedMs(start));
+
+            start = std::chrono::steady_clock::now();
+            Ktx2::Texture texture;
+            Ktx2::read(cookedPath, texture);
+            bestCookedMs = std::min(bestCookedMs, elapsedMs(start));
+        }
+        decodeMs += bestDecodeMs;
+        cookedMs += bestCookedMs;
+        cookedCount++;
+    }
+    if (cookedCount == 0) {
+        std::printf("no cooked file in %s, run the TextureCooker first\n", cookedDirectory.string().c_str());
+    } else {
+        std::printf("%u cooked files found in %s\n", cookedCount, cookedDirectory.string().c_str());
+        std::printf("decode   : %10.2f ms (level 0 only)\n", decodeMs);
+        std::printf("cooked   : %10.2f ms (all the levels)\n", cookedMs);
+        std::printf("speedup  : %10.2fx\n", cookedMs > 0.0 ? decodeMs / cookedMs : 0.0);
+    }
+
+    Engine::Log::Shutdown();
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "FreeListAllocator.h"
+
+#include <cassert>
+#include <iterator>
+
+namespace Engine {
+
+void FreeListAllocator::reset(uint64_t capacity) {
+    mCapacity = capacity;
+    mUsedSize = 0;
+    mFreeBlocks.clear();
+    mFreeBlocksBySize.clear();
+    mAllocations.clear();
+    if (capacity > 0) {
+        addFreeBlock(0, capacity);
+    }
+}
+
+uint64_t FreeListAllocator::allocate(uint64_t size, uint64_t alignment) {
+    assert(size > 0 && alignment > 0);
+
+    // Best fit, a larger block is tried when the alignment padding doesn't fit.
+    for (auto it = mFreeBlocksBySize.lower_bound(size); it != mFreeBlocksBySize.end(); ++it) {
+        const uint64_t blockSize   = it->first;
+        const uint64_t blockOffset = it->second;
+        const uint64_t offset      = (blockOffset + alignment - 1) / alignment * alignment;
+        const uint64_t padding     = offset - blockOffset;
+        if (padding + size > blockSize) {
+            continue;
+        }
+
+        removeFreeBlock(mFreeBlocks.find(blockOffset));
+        if (padding > 0) {
+            addFreeBlock(blockOffset, padding);
+        }
+        if (const uint64_t tail = blockSize - padding - size; tail > 0) {
+            addFreeBlock(offset + size, tail);
+        }
+        mAllocations.emplace(offset, size);
+        mUsedSize += size;
+        return offset;
+    }
+    return kInvalidOffset;
+}
+
+void FreeListAllocator::free(uint64_t offset) {
+    const auto allocation = mAllocations.find(offset);
+    assert(allocation != mAllocations.end() && "Not an allocation.");
+    if (allocation == mAllocations.end()) {
+        return;
+    }
+
+    uint64_t begin = offset;
+    uint64_t end   = offset + allocation->second;
+    mUsedSize -= allocation->second;
+    mAllocations.erase(allocation);
+
+    // Merge with the free blocks right after and right before.
+    if (const auto next = mFreeBlocks.find(end); next != mFreeBlocks.end()) {
+        end += next->second->first;
+        removeFreeBlock(next);
+    }
+    if (const auto next = mFreeBlocks.lower_bound(begin); next != mFreeBlocks.begin()) {
+        const auto previous = std::prev(next);
+        if (previous->first + previous->second->first == begin) {
+            begin = previous->first;
+            removeFreeBlock(previous);
+        }
+    }
+    addFreeBlock(begin, end - begin);
+}
+
+uint64_t FreeListAllocator::getSize(uint64_t offset) const {
+    const auto allocation = mAllocations.find(offset);
+    return allocation != mAllocations.end() ? allocation->second : 0;
+}
+
+FreeListAllocator::Statistics FreeListAllocator::getStatistics() const {
+    Statistics statistics;
+    statistics.capacity         = mCapacity;
+    statistics.usedSize         = mUsedSize;
+    statistics.freeSize         = mCapacity - mUsedSize;
+    statistics.largestFreeBlock = mFreeBlocksBySize.empty() ? 0 : mFreeBlocksBySize.rbegin()->first;
+    statistics.allocationCount  = static_cast<uint32_t>(mAllocations.size());
+    statistics.freeBlockCount   = static_cast<uint32_t>(mFreeBlocks.size());
+    if (statistics.freeSize > 0) {
+        statistics.fragmentation = 1.0f - float(statistics.largestFreeBlock) / float(statistics.freeSize);
+    }
+    return statistics;
+}
+
+void FreeListAllocator::addFreeBlock(uint64_t offset, uint64_t size) {
+    const auto bySize = mFreeBlocksBySize.emplace(size, offset);
+    mFreeBlocks.emplace(offset, bySize);
+}
+
+void FreeListAllocator::removeFreeBlock(std::map<uint64_t, FreeBlocksBySize::iterator>::iterator block) {
+    mFreeBlocksBySize.erase(block->second);
+    mFreeBlocks.erase(block);
+}
+
+} // namespace Engine
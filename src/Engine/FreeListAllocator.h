@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+namespace Engine {
+
+/// @brief Sub allocator of a range of offsets, the memory itself is owned by the caller.
+///
+/// The free blocks are kept sorted by offset (to merge a released block with its neighbours)
+/// and by size (best fit: the smallest block able to hold the allocation, which keeps the
+/// large blocks for the large allocations). The alignment may be any value, for instance the
+/// size of a vertex, the padding in front of an allocation stays a free block.
+///
+/// Not thread safe.
+class FreeListAllocator {
+public:
+    /// @brief Returned by allocate() when no free block is large enough.
+    static constexpr uint64_t kInvalidOffset = std::numeric_limits<uint64_t>::max();
+
+    /// @brief Usage and fragmentation of the allocator.
+    struct Statistics {
+        uint64_t capacity{0};
+        uint64_t usedSize{0};         ///< Sum of the allocation sizes.
+        uint64_t freeSize{0};         ///< capacity - usedSize.
+        uint64_t largestFreeBlock{0}; ///< The largest allocation that would succeed (without alignment).
+        uint32_t allocationCount{0};
+        uint32_t freeBlockCount{0};
+        /// 1 - largestFreeBlock / freeSize: 0 when the free space is a single block, close to 1
+        /// when it is split in many small blocks.
+        float fragmentation{0.0f};
+    };
+
+    FreeListAllocator() = default;
+    explicit FreeListAllocator(uint64_t capacity) { reset(capacity); }
+
+    /// @brief Release all the allocations and set the capacity.
+    void reset(uint64_t capacity);
+
+    /// @brief Allocate a block.
+    /// @param size      The size of the block, must not be 0.
+    /// @param alignment The offset of the block is a multiple of it, must not be 0.
+    /// @return The offset of the block or kInvalidOffset.
+    [[nodiscard]] uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+    /// @brief Release a block returned by allocate().
+    void free(uint64_t offset);
+
+    /// @brief Return the size of a block returned by allocate().
+    [[nodiscard]] uint64_t getSize(uint64_t offset) const;
+
+    [[nodiscard]] uint64_t getCapacity() const { return mCapacity; }
+    [[nodiscard]] uint64_t getUsedSize() const { return mUsedSize; }
+    [[nodiscard]] Statistics getStatistics() const;
+
+private:
+    using FreeBlocksBySize = std::multimap<uint64_t, uint64_t>; // size -> offset
+
+    void addFreeBlock(uint64_t offset, uint64_t size);
+    void removeFreeBlock(std::map<uint64_t, FreeBlocksBySize::iterator>::iterator block);
+
+    uint64_t mCapacity{0};
+    uint64_t mUsedSize{0};
+    /// Free blocks by offset, each one points to its entry in mFreeBlocksBySize.
+    std::map<uint64_t, FreeBlocksBySize::iterator> mFreeBlocks;
+    FreeBlocksBySize                               mFreeBlocksBySize;
+    std::unordered_map<uint64_t, uint64_t>         mAllocations; // offset -> size
+};
+
+} // namespace Engine
@@ -0,0 +1,125 @@
+#include <Engine/MappedFile.h>
+
+#include <utility>
+
+#ifdef _WIN32
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace Engine {
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        mData = std::exchange(other.mData, nullptr);
+        mSize = std::exchange(other.mSize, 0);
+#ifdef _WIN32
+        mFile    = std::exchange(other.mFile, nullptr);
+        mMapping = std::exchange(other.mMapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile    = file;
+    mMapping = mapping;
+    mData    = static_cast<const std::byte*>(data);
+    mSize    = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mData) {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping) {
+        CloseHandle(mMapping);
+    }
+    if (mFile) {
+        CloseHandle(mFile);
+    }
+    mData    = nullptr;
+    mSize    = 0;
+    mFile    = nullptr;
+    mMapping = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status{};
+    if (fstat(file, &status) != 0 || status.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps a reference to the file.
+    ::close(file);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    mData = static_cast<const std::byte*>(data);
+    mSize = static_cast<std::size_t>(status.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mData) {
+        munmap(const_cast<std::byte*>(mData), mSize);
+    }
+    mData = nullptr;
+    mSize = 0;
+}
+
+#endif
+
+} // namespace Engine
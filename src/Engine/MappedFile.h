@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace Engine {
+
+/// @brief A file mapped read only in memory.
+///
+/// The pages are loaded by the OS on first access, reading a mapped file costs no copy and no
+/// allocation, which makes it the fastest way to load the cached assets.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /// @brief Map a whole file, the previous mapping is released.
+    /// @return false if the file could not be opened or mapped (or is empty).
+    bool open(const std::filesystem::path& path);
+
+    /// @brief Release the mapping, the data is no longer accessible.
+    void close();
+
+    [[nodiscard]] bool isOpen() const { return mData != nullptr; }
+
+    [[nodiscard]] const std::byte* getData() const { return mData; }
+    [[nodiscard]] std::size_t      getSize() const { return mSize; }
+
+    [[nodiscard]] std::span<const std::byte> getBytes() const { return {mData, mSize}; }
+
+private:
+    const std::byte* mData{nullptr};
+    std::size_t      mSize{0};
+#ifdef _WIN32
+    void* mFile{nullptr};
+    void* mMapping{nullptr};
+#endif
+};
+
+} // namespace Engine
@@ -0,0 +1,79 @@
+#include <Engine/ThreadPool.h>
+
+#include <algorithm>
+
+namespace Engine {
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+    if (threadCount == 0) {
+        // Keep a core for the main thread.
+        const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = std::max(1u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u);
+    }
+
+    mThreads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard lock(mMutex);
+        mStop = true;
+    }
+    mJobAvailable.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void(uint32_t)> job) {
+    {
+        std::lock_guard lock(mMutex);
+        mJobs.push_back(std::move(job));
+        mPendingJobs++;
+    }
+    mJobAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(mMutex);
+    mJobsDone.wait(lock, [this] { return mPendingJobs == 0; });
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)>& job) {
+    for (uint32_t index = 0; index < count; ++index) {
+        submit([&job, index](uint32_t threadIndex) { job(index, threadIndex); });
+    }
+    wait();
+}
+
+void ThreadPool::workerLoop(uint32_t threadIndex) {
+    while (true) {
+        std::function<void(uint32_t)> job;
+        {
+            std::unique_lock lock(mMutex);
+            mJobAvailable.wait(lock, [this] { return mStop || !mJobs.empty(); });
+            if (mJobs.empty()) {
+                return; // mStop
+            }
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        job(threadIndex);
+
+        bool done = false;
+        {
+            std::lock_guard lock(mMutex);
+            done = --mPendingJobs == 0;
+        }
+        if (done) {
+            mJobsDone.notify_all();
+        }
+    }
+}
+
+} // namespace Engine
@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Engine {
+
+/// @brief Fixed set of worker threads executing jobs.
+///
+/// Each worker has a stable index in [0, getThreadCount()) which is given
+/// to the job, so callers can keep per-thread resources (command pools, scratch
+/// memory) without any locking.
+class ThreadPool {
+public:
+    /// @brief Start the workers.
+    /// @param threadCount Number of workers, 0 selects hardware_concurrency() - 1 (at least 1).
+    explicit ThreadPool(uint32_t threadCount = 0);
+
+    /// @brief Wait for the queued jobs and join the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    /// @brief Return the number of worker threads.
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(mThreads.size()); }
+
+    /// @brief Queue a job, it receives the index of the worker running it.
+    void submit(std::function<void(uint32_t threadIndex)> job);
+
+    /// @brief Block until all the queued jobs are done.
+    void wait();
+
+    /// @brief Run job(index, threadIndex) for all the index in [0, count) and wait for them.
+    void parallelFor(uint32_t count, const std::function<void(uint32_t index, uint32_t threadIndex)>& job);
+
+private:
+    void workerLoop(uint32_t threadIndex);
+
+    std::vector<std::thread>                            mThreads;
+    std::deque<std::function<void(uint32_t)>>           mJobs;
+    std::mutex                                          mMutex;
+    std::condition_variable                             mJobAvailable;
+    std::condition_variable                             mJobsDone;
+    uint32_t                                            mPendingJobs{0};
+    bool                                                mStop{false};
+};
+
+} // namespace Engine
@@ -1,5 +1,9 @@
 #include "AssimpImporter.h"
 
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+
 #include <Engine/Log.h>
 #include <assimp/DefaultLogger.hpp>
 #include <assimp/Importer.hpp>
@@ -7,12 +11,10 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
-struct Vertex {
-    float position[3];
-    float normal[3];
-    float tangent[3];
-    float uv[2];
-};
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <limits>
 
 namespace {
 /// @brief Print datain the scene (For debugging only).
@@ -152,18 +154,7 @@ void printMaterials(const aiScene* scene) {
 
 inline glm::vec3 toGLM(aiVector3D v) { return {v.x, v.y, v.z}; }
 
-AssimpImporter::AssimpImporter() {}
-
-Mesh AssimpImporter::importMesh(const std::filesystem::path& path) {
-    Mesh importedMesh;
-
-    ENGINE_CORE_INFO("Importing {}", path.string());
-
-    Assimp::Importer importer;
-    // importer.SetPropertyInteger(AI_CONFIG_FBX_CONVERT_TO_M, 1);
-    // importer.SetPropertyFloat(AI_CONFIG_FBX_USE_SKELETON_BONE_CONTAINER, .1);
-    importer.SetPropertyFloat(AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY, .01);
-
+AssimpImporter::AssimpImporter() {
     unsigned int importFlags = 0;
     importFlags |= aiProcess_GenNormals;
     importFlags |= aiProcess_CalcTangentSpace;
@@ -176,12 +167,30 @@ Mesh AssimpImporter::importMesh(const std::filesystem::path& path) {
     importFlags |= aiProcess_LimitBoneWeights;
     // importFlags |= aiProcess_GlobalScale;
     importFlags |= aiProcess_PopulateArmatureData;
+    // Keep every sub mesh under 65536 vertices so the mesh is drawn with 16 bit indices.
+    importFlags |= aiProcess_SplitLargeMeshes;
     // importFlags |= aiProcess_PreTransformVertices;
-    const aiScene* scene = importer.ReadFile(path.string(), importFlags);
+
+    mImportSettings.importFlags = importFlags;
+    mImportSettings.scaleFactor = .01f;
+}
+
+bool AssimpImporter::importMesh(const std::filesystem::path& path, MeshData& meshData) {
+    meshData = {};
+
+    ENGINE_CORE_INFO("Importing {}", path.string());
+
+    Assimp::Importer importer;
+    // importer.SetPropertyInteger(AI_CONFIG_FBX_CONVERT_TO_M, 1);
+    // importer.SetPropertyFloat(AI_CONFIG_FBX_USE_SKELETON_BONE_CONTAINER, .1);
+    importer.SetPropertyFloat(AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY, mImportSettings.scaleFactor);
+    importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, std::numeric_limits<uint16_t>::max() + 1);
+
+    const aiScene* scene = importer.ReadFile(path.string(), mImportSettings.importFlags);
     if (!scene) {
         ENGINE_CORE_ERROR("Fail to import {}", path.string());
         ENGINE_CORE_ERROR(" Reason: {}", importer.GetErrorString());
-        return importedMesh;
+        return false;
     }
 
 #if ASSIMP_PRINT_INFO
@@ -192,90 +201,90 @@ Mesh AssimpImporter::importMesh(const std::filesystem::path& path) {
     printNodes(scene->mRootNode);
 #endif
 
-    std::vector<Vertex>   vertices;
-    std::vector<unsigned> indices;
-    unsigned              baseIndex = 0;
-
+    // Size the buffers once, the vertices and indices are then written in place.
+    size_t vertexCount = 0;
+    size_t indexCount  = 0;
     for (unsigned int meshIdx = 0; meshIdx < scene->mNumMeshes; meshIdx++) {
-        const aiMesh* aimesh = scene->mMeshes[meshIdx];
-        Mesh::SubMesh subMesh;
-
-        subMesh.nbVertices         = aimesh->mNumVertices;
-        subMesh.nbIndices          = aimesh->mNumFaces * 3;
-        subMesh.vertexBufferOffset = vertices.size() * sizeof(Vertex);
-        subMesh.indexBufferOffset  = indices.size() * sizeof(unsigned);
-        subMesh.firstIndex         = indices.size();
-        subMesh.vertexOffset       = vertices.size();
-        subMesh.aabbMin            = toGLM(aimesh->mAABB.mMin);
-        subMesh.aabbMax            = toGLM(aimesh->mAABB.mMax);
+        vertexCount += scene->mMeshes[meshIdx]->mNumVertices;
+        indexCount += scene->mMeshes[meshIdx]->mNumFaces * 3;
+    }
+    meshData.vertices.resize(vertexCount);
+    meshData.indices.resize(indexCount);
+    meshData.subMeshes.reserve(scene->mNumMeshes);
 
-        for (unsigned int vtxIdx = 0; vtxIdx < aimesh->mNumVertices; vtxIdx++) {
-            Vertex vertex;
-            vertex.position[0] = aimesh->mVertices[vtxIdx].x;
-            vertex.position[1] = aimesh->mVertices[vtxIdx].y;
-            vertex.position[2] = aimesh->mVertices[vtxIdx].z;
-            vertex.normal[0]   = aimesh->mNormals[vtxIdx].x;
-            vertex.normal[1]   = aimesh->mNormals[vtxIdx].y;
-            vertex.normal[2]   = aimesh->mNormals[vtxIdx].z;
-            vertex.tangent[0]  = aimesh->mTangents[vtxIdx].x;
-            vertex.tangent[1]  = aimesh->mTangents[vtxIdx].y;
-            vertex.tangent[2]  = aimesh->mTangents[vtxIdx].z;
-            if (aimesh->HasTextureCoords(0)) {
-                vertex.uv[0] = aimesh->mTextureCoords[0][vtxIdx].x;
-                vertex.uv[1] = aimesh->mTextureCoords[0][vtxIdx].y;
+    MeshVertex* vertex = meshData.vertices.data();
+    uint32_t*   index  = meshData.indices.data();
+    for (unsigned int meshIdx = 0; meshIdx < scene->mNumMeshes; meshIdx++) {
+        const aiMesh*     aimesh = scene->mMeshes[meshIdx];
+        MeshData::SubMesh subMesh;
 
-                // flip V for vulkan.
-                // texture are loaded top row first ....
-                // vertex.uv[1] = 1 - vertex.uv[1];
-            }
+        subMesh.vertexCount  = aimesh->mNumVertices;
+        subMesh.indexCount   = aimesh->mNumFaces * 3;
+        subMesh.firstIndex   = static_cast<uint32_t>(index - meshData.indices.data());
+        subMesh.vertexOffset = static_cast<uint32_t>(vertex - meshData.vertices.data());
+        subMesh.aabbMin      = toGLM(aimesh->mAABB.mMin);
+        subMesh.aabbMax      = toGLM(aimesh->mAABB.mMax);
 
-            vertices.push_back(vertex);
+        const bool hasTextureCoords = aimesh->HasTextureCoords(0);
+        for (unsigned int vtxIdx = 0; vtxIdx < aimesh->mNumVertices; vtxIdx++, vertex++) {
+            vertex->position[0] = aimesh->mVertices[vtxIdx].x;
+            vertex->position[1] = aimesh->mVertices[vtxIdx].y;
+            vertex->position[2] = aimesh->mVertices[vtxIdx].z;
+            vertex->normal[0]   = aimesh->mNormals[vtxIdx].x;
+            vertex->normal[1]   = aimesh->mNormals[vtxIdx].y;
+            vertex->normal[2]   = aimesh->mNormals[vtxIdx].z;
+            vertex->tangent[0]  = aimesh->mTangents[vtxIdx].x;
+            vertex->tangent[1]  = aimesh->mTangents[vtxIdx].y;
+            vertex->tangent[2]  = aimesh->mTangents[vtxIdx].z;
+            // texture are loaded top row first, the V flip is done by aiProcess_FlipUVs.
+            vertex->uv[0] = hasTextureCoords ? aimesh->mTextureCoords[0][vtxIdx].x : 0.0f;
+            vertex->uv[1] = hasTextureCoords ? aimesh->mTextureCoords[0][vtxIdx].y : 0.0f;
         }
 
         for (unsigned int faceIdx = 0; faceIdx < aimesh->mNumFaces; faceIdx++) {
             const aiFace& face = aimesh->mFaces[faceIdx];
             assert(face.mNumIndices == 3 && "Should be a triangle.");
-            for (unsigned int i = 0; i < face.mNumIndices; i++) {
-                indices.push_back(face.mIndices[i]);
-            }
+            *index++ = face.mIndices[0];
+            *index++ = face.mIndices[1];
+            *index++ = face.mIndices[2];
         }
 
-        importedMesh.subMeshs.push_back(subMesh);
+        meshData.subMeshes.push_back(subMesh);
     }
 
     // Merge submesh AABB
-    importedMesh.aabbMin = {FLT_MAX, FLT_MAX, FLT_MAX};
-    importedMesh.aabbMax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
-    for (const auto& submesh : importedMesh.subMeshs) {
-        importedMesh.aabbMin.x = std::min(importedMesh.aabbMin.x, submesh.aabbMin.x);
-        importedMesh.aabbMin.y = std::min(importedMesh.aabbMin.y, submesh.aabbMin.y);
-        importedMesh.aabbMin.z = std::min(importedMesh.aabbMin.z, submesh.aabbMin.z);
+    meshData.aabbMin = {FLT_MAX, FLT_MAX, FLT_MAX};
+    meshData.aabbMax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (const auto& submesh : meshData.subMeshes) {
+        meshData.aabbMin.x = std::min(meshData.aabbMin.x, submesh.aabbMin.x);
+        meshData.aabbMin.y = std::min(meshData.aabbMin.y, submesh.aabbMin.y);
+        meshData.aabbMin.z = std::min(meshData.aabbMin.z, submesh.aabbMin.z);
 
-        importedMesh.aabbMax.x = std::max(importedMesh.aabbMax.x, submesh.aabbMax.x);
-        importedMesh.aabbMax.y = std::max(importedMesh.aabbMax.y, submesh.aabbMax.y);
-        importedMesh.aabbMax.z = std::max(importedMesh.aabbMax.z, submesh.aabbMax.z);
+        meshData.aabbMax.x = std::max(meshData.aabbMax.x, submesh.aabbMax.x);
+        meshData.aabbMax.y = std::max(meshData.aabbMax.y, submesh.aabbMax.y);
+        meshData.aabbMax.z = std::max(meshData.aabbMax.z, submesh.aabbMax.z);
     }
 
-    VulkanBufferCreateInfo createInfo{};
-    const std::size_t      vertexBufferSize = sizeof(Vertex) * vertices.size();
-    createInfo.sizeInByte                   = vertexBufferSize;
-    createInfo.name                         = "VB";
-    createInfo.usage                        = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    createInfo.memoryProperty =
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    importedMesh.vertexBuffer = VulkanBuffer::Create(createInfo);
-    importedMesh.vertexBuffer->writeData(vertices.data(),
-                                         importedMesh.vertexBuffer->getSizeInByte());
+    // Reorder the triangles and vertices of each submesh for the post-transform cache,
+    // the overdraw and the vertex fetch.
+    const MeshOptimizer::OptimizationReport report = MeshOptimizer::optimize(meshData);
+    ENGINE_CORE_INFO(" ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", report.before.acmr, report.after.acmr,
+                     report.before.atvr, report.after.atvr);
+
+    // The LODs are simplified index lists of the optimized vertices, they are cached with the mesh.
+    MeshSimplifier::generateLods(meshData);
+    for (size_t lod = 0; lod < meshData.lods.size(); ++lod) {
+        uint32_t indexCount = 0;
+        for (uint32_t i = 0; i < meshData.lods[lod].subMeshCount; ++i) {
+            indexCount += meshData.subMeshes[meshData.lods[lod].firstSubMesh + i].indexCount;
+        }
+        ENGINE_CORE_INFO(" LOD {}: {} triangles, error {:.5f}", lod, indexCount / 3, meshData.lods[lod].error);
+    }
 
-    const std::size_t indexBufferSize = sizeof(unsigned) * indices.size();
-    createInfo.name                   = "IB";
-    createInfo.sizeInByte             = indexBufferSize;
-    createInfo.usage                  = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    createInfo.memoryProperty =
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    importedMesh.indexBuffer = VulkanBuffer::Create(createInfo);
-    importedMesh.indexBuffer->writeData(indices.data(), importedMesh.indexBuffer->getSizeInByte());
-    importedMesh.indexCount = indices.size();
+    // The triangles are reordered meshlet by meshlet, after the LODs which are built from the cache order.
+    const uint32_t meshletCount = MeshletBuilder::buildMeshlets(meshData);
+    ENGINE_CORE_INFO(" {} meshlets, {:.1f} triangles per meshlet", meshletCount,
+                     meshletCount ? float(meshData.indices.size() / 3) / float(meshletCount) : 0.0f);
 
-    return importedMesh;
+    return true;
 }
@@ -1,5 +1,6 @@
 #pragma once
-#include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshData.h"
 
 #include <filesystem>
 
@@ -8,9 +9,14 @@ public:
     AssimpImporter();
 
     /// @brief Import all mesh in a file into a single mesh
-    /// @param path The path of the file to import.
-    /// @return The imported mesh
-    Mesh importMesh(const std::filesystem::path& path);
+    /// @param path     The path of the file to import.
+    /// @param meshData Receive the imported mesh, in the layout of the GPU buffers.
+    /// @return false if the file could not be imported.
+    bool importMesh(const std::filesystem::path& path, MeshData& meshData);
+
+    /// @brief Return the settings the files are imported with (the key of the mesh cache).
+    const MeshCache::ImportSettings& getImportSettings() const { return mImportSettings; }
 
 private:
+    MeshCache::ImportSettings mImportSettings;
 };
@@ -0,0 +1,274 @@
+#include "FrustumCuller.h"
+
+#include "SceneRenderer.h"
+
+#include <cmath>
+
+#if defined(__AVX__)
+    #define FRUSTUM_CULLER_AVX 1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FRUSTUM_CULLER_SSE 1
+    #include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr uint32_t kInvalidIndex = UINT32_MAX;
+    constexpr size_t   kSimdWidth    = 8;
+
+    // Test count boxes (padded to kSimdWidth) against the 6 planes.
+    // A box is culled if it's completely behind one of the planes.
+    uint32_t cullBoxes(const float* centerX,
+                       const float* centerY,
+                       const float* centerZ,
+                       const float* extentX,
+                       const float* extentY,
+                       const float* extentZ,
+                       size_t       count,
+                       const glm::vec4 planes[6],
+                       uint8_t*     visible) {
+        size_t i = 0;
+#if defined(FRUSTUM_CULLER_AVX)
+        __m256 px[6], py[6], pz[6], pw[6], nx[6], ny[6], nz[6];
+        for (int p = 0; p < 6; ++p) {
+            px[p] = _mm256_set1_ps(planes[p].x);
+            py[p] = _mm256_set1_ps(planes[p].y);
+            pz[p] = _mm256_set1_ps(planes[p].z);
+            pw[p] = _mm256_set1_ps(planes[p].w);
+            nx[p] = _mm256_set1_ps(std::abs(planes[p].x));
+            ny[p] = _mm256_set1_ps(std::abs(planes[p].y));
+            nz[p] = _mm256_set1_ps(std::abs(planes[p].z));
+        }
+        const __m256 zero = _mm256_setzero_ps();
+        for (; i < count; i += 8) {
+            const __m256 cx = _mm256_loadu_ps(centerX + i);
+            const __m256 cy = _mm256_loadu_ps(centerY + i);
+            const __m256 cz = _mm256_loadu_ps(centerZ + i);
+            const __m256 ex = _mm256_loadu_ps(extentX + i);
+            const __m256 ey = _mm256_loadu_ps(extentY + i);
+            const __m256 ez = _mm256_loadu_ps(extentZ + i);
+            __m256 outside  = _mm256_setzero_ps();
+            for (int p = 0; p < 6; ++p) {
+                // signed distance of the center and projected radius of the box.
+                const __m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, px[p]), _mm256_mul_ps(cy, py[p])),
+                                               _mm256_add_ps(_mm256_mul_ps(cz, pz[p]), pw[p]));
+                const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, nx[p]), _mm256_mul_ps(ey, ny[p])),
+                                               _mm256_mul_ps(ez, nz[p]));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(s, r), zero, _CMP_LT_OQ));
+            }
+            const int mask = _mm256_movemask_ps(outside);
+            for (int k = 0; k < 8; ++k) {
+                visible[i + k] = !((mask >> k) & 1);
+            }
+        }
+#elif defined(FRUSTUM_CULLER_SSE)
+        __m128 px[6], py[6], pz[6], pw[6], nx[6], ny[6], nz[6];
+        for (int p = 0; p < 6; ++p) {
+            px[p] = _mm_set1_ps(planes[p].x);
+            py[p] = _mm_set1_ps(planes[p].y);
+            pz[p] = _mm_set1_ps(planes[p].z);
+            pw[p] = _mm_set1_ps(planes[p].w);
+            nx[p] = _mm_set1_ps(std::abs(planes[p].x));
+            ny[p] = _mm_set1_ps(std::abs(planes[p].y));
+            nz[p] = _mm_set1_ps(std::abs(planes[p].z));
+        }
+        const __m128 zero = _mm_setzero_ps();
+        for (; i < count; i += 4) {
+            const __m128 cx = _mm_loadu_ps(centerX + i);
+            const __m128 cy = _mm_loadu_ps(centerY + i);
+            const __m128 cz = _mm_loadu_ps(centerZ + i);
+            const __m128 ex = _mm_loadu_ps(extentX + i);
+            const __m128 ey = _mm_loadu_ps(extentY + i);
+            const __m128 ez = _mm_loadu_ps(extentZ + i);
+            __m128 outside  = _mm_setzero_ps();
+            for (int p = 0; p < 6; ++p) {
+                // signed distance of the center and projected radius of the box.
+                const __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, px[p]), _mm_mul_ps(cy, py[p])),
+                                            _mm_add_ps(_mm_mul_ps(cz, pz[p]), pw[p]));
+                const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, nx[p]), _mm_mul_ps(ey, ny[p])),
+                                            _mm_mul_ps(ez, nz[p]));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(s, r), zero));
+            }
+            const int mask = _mm_movemask_ps(outside);
+            for (int k = 0; k < 4; ++k) {
+                visible[i + k] = !((mask >> k) & 1);
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            bool outside = false;
+            for (int p = 0; p < 6 && !outside; ++p) {
+                const float s = centerX[i] * planes[p].x + centerY[i] * planes[p].y + centerZ[i] * planes[p].z + planes[p].w;
+                const float r = extentX[i] * std::abs(planes[p].x) + extentY[i] * std::abs(planes[p].y) + extentZ[i] * std::abs(planes[p].z);
+                outside       = (s + r) < 0.0f;
+            }
+            visible[i] = !outside;
+        }
+
+        uint32_t visibleCount = 0;
+        for (size_t k = 0; k < count; ++k) {
+            visibleCount += visible[k];
+        }
+        return visibleCount;
+    }
+} // namespace
+
+void transformAABB(const glm::mat4& transform,
+                   const glm::vec3& localMin,
+                   const glm::vec3& localMax,
+                   glm::vec3&       worldMin,
+                   glm::vec3&       worldMax) {
+    // Arvo's method: the world extents are the local extents transformed by
+    // the absolute value of the rotation/scale part of the matrix.
+    const glm::vec3 center      = (localMin + localMax) * 0.5f;
+    const glm::vec3 extents     = (localMax - localMin) * 0.5f;
+    const glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+    const glm::mat3 absRotScale = {glm::abs(glm::vec3(transform[0])),
+                                   glm::abs(glm::vec3(transform[1])),
+                                   glm::abs(glm::vec3(transform[2]))};
+    const glm::vec3 worldExtents = absRotScale * extents;
+    worldMin = worldCenter - worldExtents;
+    worldMax = worldCenter + worldExtents;
+}
+
+FrustumCuller::~FrustumCuller() {
+    disconnect();
+}
+
+void FrustumCuller::connect(entt::registry& registry) {
+    disconnect();
+    mRegistry = &registry;
+    mRegistry->on_construct<CWorldTransform>().connect<&FrustumCuller::onChanged>(*this);
+    mRegistry->on_update<CWorldTransform>().connect<&FrustumCuller::onChanged>(*this);
+    mRegistry->on_destroy<CWorldTransform>().connect<&FrustumCuller::onChanged>(*this);
+    mRegistry->on_construct<CMesh>().connect<&FrustumCuller::onChanged>(*this);
+    mRegistry->on_update<CMesh>().connect<&FrustumCuller::onChanged>(*this);
+    mRegistry->on_destroy<CMesh>().connect<&FrustumCuller::onChanged>(*this);
+
+    // The entities created before the culler, the ones of the previous registry are dropped.
+    for (const entt::entity entity : mEntities) {
+        mChanged.push_back(entity);
+    }
+    for (const entt::entity entity : mRegistry->view<CWorldTransform, CMesh>()) {
+        mChanged.push_back(entity);
+    }
+}
+
+void FrustumCuller::disconnect() {
+    if (!mRegistry) {
+        return;
+    }
+    mRegistry->on_construct<CWorldTransform>().disconnect(this);
+    mRegistry->on_update<CWorldTransform>().disconnect(this);
+    mRegistry->on_destroy<CWorldTransform>().disconnect(this);
+    mRegistry->on_construct<CMesh>().disconnect(this);
+    mRegistry->on_update<CMesh>().disconnect(this);
+    mRegistry->on_destroy<CMesh>().disconnect(this);
+    mRegistry = nullptr;
+}
+
+void FrustumCuller::onChanged(entt::registry&, entt::entity entity) {
+    // Resolved by update(), the components are usually filled right after being emplaced.
+    mChanged.push_back(entity);
+}
+
+void FrustumCuller::update(entt::registry& registry) {
+    if (mRegistry != &registry) {
+        connect(registry);
+    }
+
+    // A destroyed component is still attached when its signal is emitted, the entities are
+    // resolved in the order of the signals so a recycled identifier comes after its old owner.
+    for (const entt::entity entity : mChanged) {
+        if (registry.valid(entity) && registry.all_of<CWorldTransform, CMesh>(entity)) {
+            const Mesh& mesh = registry.get<CMesh>(entity).mesh;
+            assign(entity, registry.get<CWorldTransform>(entity).model, mesh.aabbMin, mesh.aabbMax);
+        } else {
+            remove(entity);
+        }
+    }
+    mChanged.clear();
+}
+
+void FrustumCuller::assign(entt::entity     entity,
+                           const glm::mat4& model,
+                           const glm::vec3& aabbMin,
+                           const glm::vec3& aabbMax) {
+    const auto entityIndex = static_cast<size_t>(entt::to_entity(entity));
+    if (entityIndex >= mEntityToIndex.size()) {
+        mEntityToIndex.resize(entityIndex + 1, kInvalidIndex);
+    }
+
+    uint32_t& index = mEntityToIndex[entityIndex];
+    if (index == kInvalidIndex || mEntities[index] != entity) {
+        index = static_cast<uint32_t>(mEntities.size());
+        mEntities.push_back(entity);
+        if (index >= mCenterX.size()) {
+            const size_t paddedSize = mCenterX.size() + kSimdWidth;
+            mCenterX.resize(paddedSize);
+            mCenterY.resize(paddedSize);
+            mCenterZ.resize(paddedSize);
+            mExtentX.resize(paddedSize);
+            mExtentY.resize(paddedSize);
+            mExtentZ.resize(paddedSize);
+            mVisible.resize(paddedSize);
+        }
+    }
+
+    glm::vec3 worldMin, worldMax;
+    transformAABB(model, aabbMin, aabbMax, worldMin, worldMax);
+    const glm::vec3 center  = (worldMin + worldMax) * 0.5f;
+    const glm::vec3 extents = (worldMax - worldMin) * 0.5f;
+    mCenterX[index] = center.x;
+    mCenterY[index] = center.y;
+    mCenterZ[index] = center.z;
+    mExtentX[index] = extents.x;
+    mExtentY[index] = extents.y;
+    mExtentZ[index] = extents.z;
+}
+
+void FrustumCuller::remove(entt::entity entity) {
+    const auto entityIndex = static_cast<size_t>(entt::to_entity(entity));
+    if (entityIndex >= mEntityToIndex.size()) {
+        return;
+    }
+    const uint32_t index = mEntityToIndex[entityIndex];
+    if (index == kInvalidIndex || index >= mEntities.size() || mEntities[index] != entity) {
+        return;
+    }
+
+    // The last entity moves into the hole, the arrays stay packed for the SIMD loop.
+    const uint32_t last = static_cast<uint32_t>(mEntities.size()) - 1;
+    if (index != last) {
+        mEntities[index] = mEntities[last];
+        mCenterX[index]  = mCenterX[last];
+        mCenterY[index]  = mCenterY[last];
+        mCenterZ[index]  = mCenterZ[last];
+        mExtentX[index]  = mExtentX[last];
+        mExtentY[index]  = mExtentY[last];
+        mExtentZ[index]  = mExtentZ[last];
+        mVisible[index]  = mVisible[last];
+        mEntityToIndex[static_cast<size_t>(entt::to_entity(mEntities[index]))] = index;
+    }
+    mEntities.pop_back();
+    mEntityToIndex[entityIndex] = kInvalidIndex;
+}
+
+void FrustumCuller::cull(const glm::vec4 planes[6]) {
+    mVisibleCount = cullBoxes(mCenterX.data(), mCenterY.data(), mCenterZ.data(),
+                              mExtentX.data(), mExtentY.data(), mExtentZ.data(),
+                              mEntities.size(), planes, mVisible.data());
+}
+
+bool FrustumCuller::isVisible(entt::entity entity) const {
+    const auto entityIndex = static_cast<size_t>(entt::to_entity(entity));
+    if (entityIndex >= mEntityToIndex.size()) {
+        return true;
+    }
+
+    const uint32_t index = mEntityToIndex[entityIndex];
+    if (index >= mEntities.size() || mEntities[index] != entity) {
+        return true;
+    }
+    return mVisible[index];
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Compute the world space AABB of a local space AABB.
+/// @param transform The local to world matrix.
+/// @param localMin  The minimum corner of the local AABB.
+/// @param localMax  The maximum corner of the local AABB.
+/// @param worldMin  Receive the minimum corner of the world AABB.
+/// @param worldMax  Receive the maximum corner of the world AABB.
+void transformAABB(const glm::mat4& transform,
+                   const glm::vec3& localMin,
+                   const glm::vec3& localMax,
+                   glm::vec3&       worldMin,
+                   glm::vec3&       worldMax);
+
+/// @brief CPU frustum culling of the entities with a CWorldTransform and a CMesh.
+///
+/// The world AABB of the entities are cached in SoA arrays (center / extents). They are
+/// recomputed only for the entities whose CWorldTransform or CMesh was constructed or updated,
+/// tracked with the entt signals of the registry, a CMesh modified in place must be notified
+/// with registry.patch<CMesh>(). The boxes are tested 8 (AVX) or 4 (SSE) at a time against the
+/// frustum planes.
+class FrustumCuller {
+public:
+    FrustumCuller() = default;
+    ~FrustumCuller();
+
+    FrustumCuller(const FrustumCuller&)            = delete;
+    FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+    /// @brief Recompute the world AABB of the changed entities.
+    ///        The first call with a registry listens to its signals and adds all its entities.
+    void update(entt::registry& registry);
+
+    /// @brief Test all the cached AABB against the frustum.
+    /// @param planes The normalized world frustum planes, the normals point inside.
+    void cull(const glm::vec4 planes[6]);
+
+    /// @brief Return true if the entity passed the last cull.
+    ///        Entities unknown to the culler are considered visible.
+    [[nodiscard]] bool isVisible(entt::entity entity) const;
+
+    /// @brief Return the number of entities which passed the last cull.
+    [[nodiscard]] uint32_t getVisibleCount() const { return mVisibleCount; }
+
+    /// @brief Return the number of entities tested by the last cull.
+    [[nodiscard]] uint32_t getTotalCount() const { return static_cast<uint32_t>(mEntities.size()); }
+
+private:
+    void connect(entt::registry& registry);
+    void disconnect();
+    void onChanged(entt::registry& registry, entt::entity entity);
+    void assign(entt::entity entity, const glm::mat4& model, const glm::vec3& aabbMin, const glm::vec3& aabbMax);
+    void remove(entt::entity entity);
+
+    entt::registry*           mRegistry{nullptr};
+    std::vector<entt::entity> mChanged; ///< Entities whose world AABB must be recomputed or removed.
+
+    std::vector<entt::entity> mEntities;
+    std::vector<uint32_t>     mEntityToIndex; ///< Indexed by the entity identifier.
+
+    // World AABB, the arrays are padded to a multiple of 8 elements.
+    std::vector<float>   mCenterX;
+    std::vector<float>   mCenterY;
+    std::vector<float>   mCenterZ;
+    std::vector<float>   mExtentX;
+    std::vector<float>   mExtentY;
+    std::vector<float>   mExtentZ;
+    std::vector<uint8_t> mVisible;
+    uint32_t             mVisibleCount{0};
+};
@@ -395,7 +395,7 @@ void GeometryGenerator::createSphere(float        pRadius,
     // This is just skipping the top pole vertex.
     unsigned int baseIndex       = 1;
     unsigned int ringVertexCount = pSliceCount + 1;
-    for (unsigned int i = 0; i < pSliceCount - 2; ++i) {
+    for (unsigned int i = 0; i < pStackCount - 2; ++i) {
         for (unsigned int j = 0; j < pSliceCount; ++j) {
             pMeshData.Indices.push_back(baseIndex + i * ringVertexCount + j);
             pMeshData.Indices.push_back(baseIndex + i * ringVertexCount + j + 1);
@@ -0,0 +1,65 @@
+#include "ImageDecoder.h"
+
+#include <Engine/Log.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+DecodedImage ImageDecoder::decode(const std::filesystem::path& path) {
+    const std::string pathString = path.string();
+
+    int   width, height, channels;
+    auto* data = stbi_load(pathString.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        ENGINE_ERROR("Failed to load {}, reason {}", pathString, stbi_failure_reason());
+        return {};
+    }
+
+    DecodedImage image;
+    image.width  = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixels = {data, stbi_image_free};
+    return image;
+}
+
+void ImageDecoder::decodeBatch(std::span<const std::filesystem::path>                     paths,
+                               Engine::ThreadPool&                                        threadPool,
+                               const std::function<void(uint32_t index, DecodedImage& image)>& onDecoded) {
+    // The workers push the decoded images, the calling thread consume them.
+    std::mutex                                    mutex;
+    std::condition_variable                       imageReady;
+    std::vector<std::pair<uint32_t, DecodedImage>> decodedImages;
+
+    for (uint32_t index = 0; index < paths.size(); ++index) {
+        threadPool.submit([&, index](uint32_t /*threadIndex*/) {
+            DecodedImage image = decode(paths[index]);
+            {
+                std::lock_guard lock(mutex);
+                decodedImages.emplace_back(index, std::move(image));
+            }
+            imageReady.notify_one();
+        });
+    }
+
+    std::vector<std::pair<uint32_t, DecodedImage>> readyImages;
+    for (size_t consumed = 0; consumed < paths.size();) {
+        {
+            std::unique_lock lock(mutex);
+            imageReady.wait(lock, [&] { return !decodedImages.empty(); });
+            readyImages.swap(decodedImages);
+        }
+        for (auto& [index, image] : readyImages) {
+            onDecoded(index, image);
+        }
+        consumed += readyImages.size();
+        readyImages.clear();
+    }
+
+    // The jobs reference the locals of this function.
+    threadPool.wait();
+}
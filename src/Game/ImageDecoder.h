@@ -0,0 +1,40 @@
+#pragma once
+#include <Engine/ThreadPool.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+
+/// @brief An image decoded in RGBA8 (4 bytes per texel, rows tightly packed).
+struct DecodedImage {
+    uint32_t width{0};
+    uint32_t height{0};
+    /// The texels, null if the decoding failed.
+    std::unique_ptr<uint8_t, void (*)(void*)> pixels{nullptr, nullptr};
+
+    [[nodiscard]] bool     isValid() const { return pixels != nullptr; }
+    [[nodiscard]] uint64_t getSizeInByte() const { return uint64_t(width) * height * 4; }
+};
+
+/// @brief CPU side image decoding (PNG, TGA, JPG, ... through stb_image).
+namespace ImageDecoder {
+
+/// @brief Decode an image file, the error is logged on failure.
+[[nodiscard]] DecodedImage decode(const std::filesystem::path& path);
+
+/// @brief Decode many image files on a thread pool.
+///
+/// The files are decoded in parallel and onDecoded is called on the calling thread as soon
+/// as each of them is ready (in completion order), so the caller can create the GPU resources
+/// and queue the copies while the other files are still being decoded.
+///
+/// @param paths      The files to decode.
+/// @param threadPool The workers decoding the files.
+/// @param onDecoded  Receive the index of the file in paths and its image (invalid on failure).
+void decodeBatch(std::span<const std::filesystem::path>                     paths,
+                 Engine::ThreadPool&                                        threadPool,
+                 const std::function<void(uint32_t index, DecodedImage& image)>& onDecoded);
+
+} // namespace ImageDecoder
@@ -0,0 +1,228 @@
+#include "Ktx2File.h"
+
+#include "TextureCompression.h"
+
+#include <Engine/Log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+using TextureCompression::BlockFormat;
+
+constexpr uint8_t kIdentifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+// Identifier, header and index.
+constexpr uint32_t kHeaderSize          = 80;
+constexpr uint32_t kLevelIndexEntrySize = 24;
+
+// Data format descriptor constants (Khronos Data Format Specification).
+constexpr uint32_t kDfdModelBC1A          = 128;
+constexpr uint32_t kDfdModelBC3           = 130;
+constexpr uint32_t kDfdModelBC5           = 132;
+constexpr uint32_t kDfdModelBC7           = 134;
+constexpr uint32_t kDfdPrimariesBT709     = 1;
+constexpr uint32_t kDfdTransferLinear     = 1;
+constexpr uint32_t kDfdTransferSRGB       = 2;
+constexpr uint32_t kDfdSampleLinear       = 0x10; // qualifier of the alpha sample of the sRGB formats
+constexpr uint32_t kDfdChannelBC3Alpha    = 15;
+constexpr uint32_t kDfdChannelBC5Green    = 1;
+constexpr uint32_t kDfdVersion            = 2;
+
+// The 64 bits fields of the index are only 4 bytes aligned in the file.
+#pragma pack(push, 4)
+struct Header {
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+#pragma pack(pop)
+static_assert(sizeof(Header) + sizeof(kIdentifier) == kHeaderSize);
+
+struct LevelIndex {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+static_assert(sizeof(LevelIndex) == kLevelIndexEntrySize);
+
+template <typename T>
+void append(std::vector<uint8_t>& data, const T& value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+/// @brief Build the data format descriptor of a block compressed format.
+std::vector<uint32_t> createDfd(BlockFormat format, bool sRGB) {
+    struct Sample {
+        uint32_t channel;
+        uint32_t bitOffset;
+        uint32_t bitLength;
+    };
+    std::vector<Sample> samples;
+    uint32_t            model = 0;
+    switch (format) {
+        case BlockFormat::BC1:
+            model   = kDfdModelBC1A;
+            samples = {{0, 0, 64}};
+            break;
+        case BlockFormat::BC3:
+            model   = kDfdModelBC3;
+            samples = {{kDfdChannelBC3Alpha | (sRGB ? kDfdSampleLinear : 0), 0, 64}, {0, 64, 64}};
+            break;
+        case BlockFormat::BC5:
+            model   = kDfdModelBC5;
+            samples = {{0, 0, 64}, {kDfdChannelBC5Green, 64, 64}};
+            break;
+        case BlockFormat::BC7:
+            model   = kDfdModelBC7;
+            samples = {{0, 0, 128}};
+            break;
+    }
+
+    const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+    std::vector<uint32_t> dfd;
+    dfd.push_back(4 + blockSize);                     // dfdTotalSize
+    dfd.push_back(0);                                 // vendorId = Khronos, descriptorType = basic
+    dfd.push_back(kDfdVersion | (blockSize << 16));   // versionNumber, descriptorBlockSize
+    dfd.push_back(model | (kDfdPrimariesBT709 << 8) | ((sRGB ? kDfdTransferSRGB : kDfdTransferLinear) << 16));
+    dfd.push_back(3 | (3 << 8));                      // 4x4 texel block, stored minus one
+    dfd.push_back(TextureCompression::getBlockSize(format)); // bytesPlane0
+    dfd.push_back(0);                                 // bytesPlane4..7
+    for (const Sample& sample : samples) {
+        dfd.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+        dfd.push_back(0);          // samplePosition
+        dfd.push_back(0);          // sampleLower
+        dfd.push_back(0xFFFFFFFF); // sampleUpper
+    }
+    return dfd;
+}
+
+} // namespace
+
+bool Ktx2::write(const std::filesystem::path&          path,
+                 uint32_t                              vkFormat,
+                 uint32_t                              width,
+                 uint32_t                              height,
+                 std::span<const std::vector<uint8_t>> levels) {
+    BlockFormat format;
+    bool        sRGB;
+    if (!TextureCompression::getBlockFormat(vkFormat, format, sRGB) || levels.empty()) {
+        ENGINE_ERROR("Ktx2: unsupported texture for {}", path.string());
+        return false;
+    }
+
+    const std::vector<uint32_t> dfd       = createDfd(format, sRGB);
+    const uint32_t              levelCount = static_cast<uint32_t>(levels.size());
+    const uint64_t              alignment  = TextureCompression::getBlockSize(format);
+
+    Header header{};
+    header.vkFormat               = vkFormat;
+    header.typeSize               = 1;
+    header.pixelWidth             = width;
+    header.pixelHeight            = height;
+    header.pixelDepth             = 0;
+    header.layerCount             = 0;
+    header.faceCount              = 1;
+    header.levelCount             = levelCount;
+    header.supercompressionScheme = 0;
+    header.dfdByteOffset          = kHeaderSize + kLevelIndexEntrySize * levelCount;
+    header.dfdByteLength          = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+    // The levels are stored from the smallest to the largest.
+    std::vector<LevelIndex> levelIndex(levelCount);
+    uint64_t                offset = header.dfdByteOffset + header.dfdByteLength;
+    for (uint32_t level = levelCount; level-- > 0;) {
+        offset                                   = (offset + alignment - 1) / alignment * alignment;
+        levelIndex[level].byteOffset             = offset;
+        levelIndex[level].byteLength             = levels[level].size();
+        levelIndex[level].uncompressedByteLength = levels[level].size();
+        offset += levels[level].size();
+    }
+
+    std::vector<uint8_t> data;
+    data.reserve(offset);
+    data.insert(data.end(), std::begin(kIdentifier), std::end(kIdentifier));
+    append(data, header);
+    for (const LevelIndex& index : levelIndex) {
+        append(data, index);
+    }
+    for (uint32_t word : dfd) {
+        append(data, word);
+    }
+    for (uint32_t level = levelCount; level-- > 0;) {
+        data.resize(levelIndex[level].byteOffset, 0);
+        data.insert(data.end(), levels[level].begin(), levels[level].end());
+    }
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+        ENGINE_ERROR("Ktx2: failed to write {}", path.string());
+        return false;
+    }
+    return true;
+}
+
+bool Ktx2::read(const std::filesystem::path& path, Texture& texture) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        ENGINE_ERROR("Ktx2: failed to open {}", path.string());
+        return false;
+    }
+    texture.data.resize(std::filesystem::file_size(path));
+    if (!ifs.read(reinterpret_cast<char*>(texture.data.data()), texture.data.size())) {
+        ENGINE_ERROR("Ktx2: failed to read {}", path.string());
+        return false;
+    }
+
+    Header header{};
+    if (texture.data.size() < kHeaderSize ||
+        std::memcmp(texture.data.data(), kIdentifier, sizeof(kIdentifier)) != 0) {
+        ENGINE_ERROR("Ktx2: {} is not a KTX2 file", path.string());
+        return false;
+    }
+    std::memcpy(&header, texture.data.data() + sizeof(kIdentifier), sizeof(header));
+
+    BlockFormat format;
+    bool        sRGB;
+    if (!TextureCompression::getBlockFormat(header.vkFormat, format, sRGB) || header.supercompressionScheme != 0 ||
+        header.pixelDepth != 0 || header.layerCount > 1 || header.faceCount != 1 || header.levelCount == 0 ||
+        texture.data.size() < kHeaderSize + uint64_t(kLevelIndexEntrySize) * header.levelCount) {
+        ENGINE_ERROR("Ktx2: {} is not a supported 2D block compressed texture", path.string());
+        return false;
+    }
+
+    texture.vkFormat = header.vkFormat;
+    texture.width    = header.pixelWidth;
+    texture.height   = header.pixelHeight;
+    texture.levels.clear();
+    for (uint32_t level = 0; level < header.levelCount; ++level) {
+        LevelIndex index{};
+        std::memcpy(&index, texture.data.data() + kHeaderSize + kLevelIndexEntrySize * level, sizeof(index));
+
+        const uint32_t levelWidth  = std::max(1u, texture.width >> level);
+        const uint32_t levelHeight = std::max(1u, texture.height >> level);
+        if (index.byteOffset + index.byteLength > texture.data.size() ||
+            index.byteLength != TextureCompression::getCompressedSize(format, levelWidth, levelHeight)) {
+            ENGINE_ERROR("Ktx2: {} has an invalid level {}", path.string(), level);
+            return false;
+        }
+        texture.levels.emplace_back(texture.data.data() + index.byteOffset, index.byteLength);
+    }
+    return true;
+}
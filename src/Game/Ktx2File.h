@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+/// @brief Minimal KTX2 container for the cooked textures.
+///
+/// Only 2D textures with one layer, one face and no supercompression are supported, which is
+/// what the texture cooker writes. The level data is stored as is and can be copied to the GPU
+/// without any decoding.
+namespace Ktx2 {
+
+/// @brief A 2D texture and its mip levels.
+struct Texture {
+    uint32_t vkFormat{0};
+    uint32_t width{0};
+    uint32_t height{0};
+    /// Content of the file, the levels point into it.
+    std::vector<uint8_t> data;
+    /// Data of each level, level 0 first.
+    std::vector<std::span<const uint8_t>> levels;
+};
+
+/// @brief Write a block compressed texture.
+/// @param path      The file to write.
+/// @param vkFormat  The VkFormat of the levels, BC1, BC3, BC5 or BC7.
+/// @param width     The width of the level 0.
+/// @param height    The height of the level 0.
+/// @param levels    Data of each level, level 0 first.
+/// @return false if the file could not be written.
+bool write(const std::filesystem::path&                 path,
+           uint32_t                                     vkFormat,
+           uint32_t                                     width,
+           uint32_t                                     height,
+           std::span<const std::vector<uint8_t>>        levels);
+
+/// @brief Read a texture, the error is logged on failure.
+/// @param path    The file to read.
+/// @param texture Receive the texture.
+/// @return false if the file could not be read or is not supported.
+bool read(const std::filesystem::path& path, Texture& texture);
+
+} // namespace Ktx2
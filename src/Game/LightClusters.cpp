@@ -0,0 +1,115 @@
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace LightClusters {
+
+Grid makeGrid(const glm::mat4& projection, float viewportWidth, float viewportHeight) {
+    assert(viewportWidth > 0.0f && viewportHeight > 0.0f);
+
+    // Depth in [0, 1]: P22 = far / (near - far) and P32 = -far * near / (far - near).
+    const float p22   = projection[2][2];
+    const float p32   = projection[3][2];
+    const float nearZ = p32 / p22;
+    float       farZ  = p32 / (p22 + 1.0f);
+    if (!std::isfinite(farZ) || farZ <= nearZ) {
+        farZ = nearZ * 10000.0f; // Infinite far plane, the last slice takes everything behind.
+    }
+
+    Grid grid{};
+    grid.unproject  = {projection[0][0], projection[1][1], projection[2][0], projection[2][1]};
+    grid.tileScale  = {float(kClusterCountX) / viewportWidth, float(kClusterCountY) / viewportHeight};
+    grid.nearZ      = nearZ;
+    grid.farZ       = farZ;
+    grid.sliceScale = float(kClusterCountZ) / std::log(farZ / nearZ);
+    grid.sliceBias  = -grid.sliceScale * std::log(nearZ);
+    return grid;
+}
+
+uint32_t getSlice(const Grid& grid, float viewDepth) {
+    if (viewDepth <= grid.nearZ) {
+        return 0;
+    }
+    const float slice = std::floor(std::log(viewDepth) * grid.sliceScale + grid.sliceBias);
+    return static_cast<uint32_t>(std::clamp(slice, 0.0f, float(kClusterCountZ - 1)));
+}
+
+float getSliceDepth(const Grid& grid, uint32_t slice) {
+    return grid.nearZ * std::pow(grid.farZ / grid.nearZ, float(slice) / float(kClusterCountZ));
+}
+
+uint32_t getClusterIndex(const Grid& grid, const glm::vec2& pixel, float viewDepth) {
+    const glm::vec2 tile = glm::max(pixel * grid.tileScale, glm::vec2(0.0f));
+    const uint32_t  x    = std::min(static_cast<uint32_t>(tile.x), kClusterCountX - 1);
+    const uint32_t  y    = std::min(static_cast<uint32_t>(tile.y), kClusterCountY - 1);
+    return getClusterIndex(x, y, getSlice(grid, viewDepth));
+}
+
+void computeClusterBounds(const Grid& grid, uint32_t clusterIndex, glm::vec3& aabbMin, glm::vec3& aabbMax) {
+    assert(clusterIndex < kClusterCount);
+    const uint32_t x = clusterIndex % kClusterCountX;
+    const uint32_t y = (clusterIndex / kClusterCountX) % kClusterCountY;
+    const uint32_t z = clusterIndex / (kClusterCountX * kClusterCountY);
+
+    // NDC rectangle of the tile, the tile row 0 is the top of the target (NDC y = 1 before the
+    // y flip of the vertex shaders).
+    const float ndcX[2]  = {-1.0f + 2.0f * float(x) / kClusterCountX, -1.0f + 2.0f * float(x + 1) / kClusterCountX};
+    const float ndcY[2]  = {1.0f - 2.0f * float(y) / kClusterCountY, 1.0f - 2.0f * float(y + 1) / kClusterCountY};
+    const float depth[2] = {getSliceDepth(grid, z), getSliceDepth(grid, z + 1)};
+
+    // The cluster is a frustum piece, its AABB is the one of its 8 corners.
+    aabbMin = glm::vec3(FLT_MAX);
+    aabbMax = glm::vec3(-FLT_MAX);
+    for (const float d : depth) {
+        for (const float nx : ndcX) {
+            for (const float ny : ndcY) {
+                const glm::vec3 corner((nx + grid.unproject.z) * d / grid.unproject.x,
+                                       (ny + grid.unproject.w) * d / grid.unproject.y,
+                                       -d);
+                aabbMin = glm::min(aabbMin, corner);
+                aabbMax = glm::max(aabbMax, corner);
+            }
+        }
+    }
+}
+
+bool sphereIntersectsAabb(const glm::vec3& center, float radius, const glm::vec3& aabbMin, const glm::vec3& aabbMax) {
+    const glm::vec3 closest = glm::clamp(center, aabbMin, aabbMax);
+    const glm::vec3 delta   = center - closest;
+    return glm::dot(delta, delta) <= radius * radius;
+}
+
+LightSphere makeSpotLightSphere(const glm::vec3& position, const glm::vec3& direction, float range, float cosOuter) {
+    if (cosOuter <= 0.0f) {
+        return {position, range}; // Wider than a half sphere.
+    }
+    if (cosOuter < 0.70710678f) {
+        // Wider than 45 degrees, the sphere of the rim circle.
+        return {position + direction * (range * cosOuter), range * std::sqrt(1.0f - cosOuter * cosOuter)};
+    }
+    // The sphere through the apex and the rim circle.
+    const float radius = range / (2.0f * cosOuter);
+    return {position + direction * radius, radius};
+}
+
+void assignLights(const Grid& grid, std::span<const LightSphere> lights, std::vector<uint32_t>& clusterLights) {
+    clusterLights.assign(size_t(kClusterCount) * kClusterStride, 0);
+    for (uint32_t cluster = 0; cluster < kClusterCount; ++cluster) {
+        glm::vec3 aabbMin, aabbMax;
+        computeClusterBounds(grid, cluster, aabbMin, aabbMax);
+
+        uint32_t* list  = &clusterLights[size_t(cluster) * kClusterStride];
+        uint32_t  count = 0;
+        for (uint32_t i = 0; i < lights.size() && count < kMaxLightsPerCluster; ++i) {
+            if (lights[i].radius > 0.0f && sphereIntersectsAabb(lights[i].center, lights[i].radius, aabbMin, aabbMax)) {
+                list[1 + count++] = i;
+            }
+        }
+        list[0] = count;
+    }
+}
+
+} // namespace LightClusters
@@ -0,0 +1,95 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// @brief Clustered (Forward+) light assignment.
+///
+/// The view frustum is split in a grid of clusters (froxels): kClusterCountX x kClusterCountY
+/// screen tiles and kClusterCountZ depth slices, spaced exponentially between the near and the far
+/// plane so the clusters are about as deep as they are wide. Each cluster has the list of the lights
+/// whose bounding sphere intersects its view space AABB, a fragment only shades the lights of its
+/// cluster.
+///
+/// The lists are built every frame by the light_cluster.slang compute pass, this is the CPU
+/// reference of the same assignment. They don't depend on Vulkan.
+///
+/// The light indices are in a single space, the point lights first and the spot lights after them:
+/// a spot light i has the index pointLightCount + i.
+namespace LightClusters {
+
+constexpr uint32_t kClusterCountX = 16;
+constexpr uint32_t kClusterCountY = 9;
+constexpr uint32_t kClusterCountZ = 24;
+constexpr uint32_t kClusterCount  = kClusterCountX * kClusterCountY * kClusterCountZ;
+
+/// @brief Maximum number of lights of a cluster, the next ones are dropped.
+constexpr uint32_t kMaxLightsPerCluster = 127;
+/// @brief Number of uint of a cluster in the cluster buffer: the light count, then the light indices.
+constexpr uint32_t kClusterStride = kMaxLightsPerCluster + 1;
+
+/// @brief Parameters of the grid, uploaded with the lights.
+/// Must match ClusterGrid in buffers.slang (std140 layout).
+struct Grid {
+    glm::vec4 unproject{};      ///< P00, P11, P20, P21 of the projection, to rebuild the view space positions.
+    glm::vec2 tileScale{};      ///< Clusters per pixel, along x and y.
+    float     sliceScale = 0.f; ///< slice = log(depth) * sliceScale + sliceBias
+    float     sliceBias  = 0.f;
+    float     nearZ      = 0.f; ///< View space depth of the first slice.
+    float     farZ       = 0.f; ///< View space depth of the end of the last slice.
+    float     _pad0      = 0.f;
+    float     _pad1      = 0.f;
+};
+static_assert(sizeof(Grid) == 48);
+
+/// @brief A light bounding sphere in view space (the camera looks along -z).
+struct LightSphere {
+    glm::vec3 center{};
+    float     radius = 0.f;
+};
+
+/// @brief Build the grid of a perspective projection (right handed, depth in [0, 1]).
+///        The near and far planes are read from the projection.
+/// @param viewportWidth  Width of the target, in pixels.
+/// @param viewportHeight Height of the target, in pixels.
+[[nodiscard]] Grid makeGrid(const glm::mat4& projection, float viewportWidth, float viewportHeight);
+
+/// @brief Return the slice of a view space depth (positive distance along -z), clamped to the grid.
+[[nodiscard]] uint32_t getSlice(const Grid& grid, float viewDepth);
+
+/// @brief Return the view space depth of the near plane of a slice, slice kClusterCountZ is the far plane.
+[[nodiscard]] float getSliceDepth(const Grid& grid, uint32_t slice);
+
+[[nodiscard]] inline uint32_t getClusterIndex(uint32_t x, uint32_t y, uint32_t z) {
+    return (z * kClusterCountY + y) * kClusterCountX + x;
+}
+
+/// @brief Return the cluster of a fragment, as the fragment shaders do.
+/// @param pixel     Framebuffer coordinates, y = 0 is the top of the target.
+/// @param viewDepth View space depth of the fragment.
+[[nodiscard]] uint32_t getClusterIndex(const Grid& grid, const glm::vec2& pixel, float viewDepth);
+
+/// @brief Compute the view space AABB of a cluster.
+void computeClusterBounds(const Grid& grid, uint32_t clusterIndex, glm::vec3& aabbMin, glm::vec3& aabbMax);
+
+/// @brief Return true if a sphere intersects an AABB.
+[[nodiscard]] bool sphereIntersectsAabb(const glm::vec3& center, float radius, const glm::vec3& aabbMin,
+                                        const glm::vec3& aabbMax);
+
+/// @brief Return the bounding sphere of the cone lit by a spot light, tighter than the sphere of
+///        its range for the narrow cones.
+/// @param direction Normalized axis of the cone.
+/// @param cosOuter  Cosine of the outer cutoff angle.
+[[nodiscard]] LightSphere makeSpotLightSphere(const glm::vec3& position, const glm::vec3& direction, float range,
+                                              float cosOuter);
+
+/// @brief Assign the lights to the clusters, same output as the compute pass.
+/// @param lights        View space bounding spheres, in the light index order. The spheres with
+///                      a zero radius are unused light slots, they are skipped.
+/// @param clusterLights Resized to kClusterCount * kClusterStride. Each cluster has its light count
+///                      followed by its light indices in increasing order.
+void assignLights(const Grid& grid, std::span<const LightSphere> lights, std::vector<uint32_t>& clusterLights);
+
+} // namespace LightClusters
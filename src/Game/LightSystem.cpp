@@ -0,0 +1,233 @@
+#include "LightSystem.h"
+
+#include "TransformSystem.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+    PointLight makePointLight(const CPointLight& pointLight, const CWorldTransform& world) {
+        if (!pointLight.enable) {
+            return {};
+        }
+        PointLight light{};
+        light.position  = world.model[3];
+        light.ambient   = glm::vec4(pointLight.ambient, 1.0f);
+        light.diffuse   = glm::vec4(pointLight.diffuse, 1.0f);
+        light.specular  = glm::vec4(pointLight.specular, 1.0f);
+        light.constant  = pointLight.constant;
+        light.linear    = pointLight.linear;
+        light.quadratic = pointLight.quadratic;
+        light.range     = pointLight.range;
+        light.intensity = pointLight.intensity;
+        return light;
+    }
+
+    SpotLight makeSpotLight(const CSpotLight& spotLight, const CWorldTransform& world) {
+        if (!spotLight.enable) {
+            return {};
+        }
+        SpotLight light{};
+        light.position    = world.model[3];
+        light.color       = glm::vec4(spotLight.color, 1.0f);
+        light.direction   = glm::vec4(glm::normalize(glm::mat3(world.model) * spotLight.direction), 1.0f);
+        light.range       = spotLight.range;
+        light.cutOffInner = glm::cos(glm::radians(spotLight.cutOffAngle));
+        light.cutOffOuter = glm::cos(glm::radians(spotLight.cutOffAngle + 12.5f));
+        return light;
+    }
+
+    DirectionalLight makeDirectionalLight(const CDirectionalLight& directionalLight) {
+        if (!directionalLight.enable) {
+            return {};
+        }
+        DirectionalLight light{};
+        light.color     = glm::vec4(directionalLight.color, 1.0f);
+        light.direction = glm::vec4(directionalLight.direction, 1.0f);
+        return light;
+    }
+} // namespace
+
+LightSystem::LightSystem(entt::registry& registry, uint32_t frameCount)
+    : mRegistry(registry)
+    , mInvalidated(frameCount, 1) {
+    assert(frameCount > 0 && frameCount <= kMaxFrameCount);
+    mPointLights.dirty.resize(frameCount);
+    mSpotLights.dirty.resize(frameCount);
+    mDirectionalLights.dirty.resize(frameCount);
+
+    mRegistry.on_construct<CPointLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_update<CPointLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_destroy<CPointLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_construct<CSpotLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_update<CSpotLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_destroy<CSpotLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_construct<CDirectionalLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_update<CDirectionalLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_destroy<CDirectionalLight>().connect<&LightSystem::onLightChanged>(*this);
+    mRegistry.on_construct<CWorldTransform>().connect<&LightSystem::onWorldTransformChanged>(*this);
+    mRegistry.on_update<CWorldTransform>().connect<&LightSystem::onWorldTransformChanged>(*this);
+    mRegistry.on_destroy<CWorldTransform>().connect<&LightSystem::onWorldTransformChanged>(*this);
+
+    // The lights created before the system.
+    for (const entt::entity entity : mRegistry.view<CPointLight>()) {
+        mChanged.push_back(entity);
+    }
+    for (const entt::entity entity : mRegistry.view<CSpotLight>()) {
+        mChanged.push_back(entity);
+    }
+    for (const entt::entity entity : mRegistry.view<CDirectionalLight>()) {
+        mChanged.push_back(entity);
+    }
+}
+
+LightSystem::~LightSystem() {
+    mRegistry.on_construct<CPointLight>().disconnect(this);
+    mRegistry.on_update<CPointLight>().disconnect(this);
+    mRegistry.on_destroy<CPointLight>().disconnect(this);
+    mRegistry.on_construct<CSpotLight>().disconnect(this);
+    mRegistry.on_update<CSpotLight>().disconnect(this);
+    mRegistry.on_destroy<CSpotLight>().disconnect(this);
+    mRegistry.on_construct<CDirectionalLight>().disconnect(this);
+    mRegistry.on_update<CDirectionalLight>().disconnect(this);
+    mRegistry.on_destroy<CDirectionalLight>().disconnect(this);
+    mRegistry.on_construct<CWorldTransform>().disconnect(this);
+    mRegistry.on_update<CWorldTransform>().disconnect(this);
+    mRegistry.on_destroy<CWorldTransform>().disconnect(this);
+}
+
+void LightSystem::update() {
+    std::sort(mChanged.begin(), mChanged.end());
+    mChanged.erase(std::unique(mChanged.begin(), mChanged.end()), mChanged.end());
+
+    // The components are read now, the destroy signals are emitted before the removal.
+    for (const entt::entity entity : mChanged) {
+        if (!mRegistry.valid(entity)) {
+            mPointLights.release(entity);
+            mSpotLights.release(entity);
+            mDirectionalLights.release(entity);
+            continue;
+        }
+
+        // The point and spot lights are placed by their world transform.
+        const auto* world      = mRegistry.try_get<CWorldTransform>(entity);
+        const auto* pointLight = mRegistry.try_get<CPointLight>(entity);
+        const auto* spotLight  = mRegistry.try_get<CSpotLight>(entity);
+        if (pointLight && world) {
+            mPointLights.assign(entity, makePointLight(*pointLight, *world));
+        } else {
+            mPointLights.release(entity);
+        }
+        if (spotLight && world) {
+            mSpotLights.assign(entity, makeSpotLight(*spotLight, *world));
+        } else {
+            mSpotLights.release(entity);
+        }
+        if (const auto* directionalLight = mRegistry.try_get<CDirectionalLight>(entity)) {
+            mDirectionalLights.assign(entity, makeDirectionalLight(*directionalLight));
+        } else {
+            mDirectionalLights.release(entity);
+        }
+    }
+    mChanged.clear();
+}
+
+uint32_t LightSystem::upload(uint32_t frameIndex, PointLight* pointLights, SpotLight* spotLights,
+                             DirectionalLight* directionalLights) {
+    assert(frameIndex < mInvalidated.size());
+    const bool all = mInvalidated[frameIndex] != 0;
+    mInvalidated[frameIndex] = 0;
+    return mPointLights.upload(frameIndex, all, pointLights) + mSpotLights.upload(frameIndex, all, spotLights) +
+           mDirectionalLights.upload(frameIndex, all, directionalLights);
+}
+
+void LightSystem::invalidate(uint32_t frameIndex) {
+    assert(frameIndex < mInvalidated.size());
+    mInvalidated[frameIndex] = 1;
+}
+
+void LightSystem::onLightChanged(entt::registry&, entt::entity entity) {
+    mChanged.push_back(entity);
+}
+
+void LightSystem::onWorldTransformChanged(entt::registry& registry, entt::entity entity) {
+    // Most of the world transforms are not lights.
+    if (registry.any_of<CPointLight, CSpotLight>(entity)) {
+        mChanged.push_back(entity);
+    }
+}
+
+template <typename T>
+void LightSystem::Slots<T>::assign(entt::entity entity, const T& light) {
+    const auto index = static_cast<size_t>(entt::to_entity(entity));
+    if (index >= entityToSlot.size()) {
+        entityToSlot.resize(index + 1, kInvalidSlot);
+    }
+
+    // A recycled identifier takes over the slot of the destroyed entity, which is then ignored.
+    uint32_t& slot = entityToSlot[index];
+    if (slot == kInvalidSlot) {
+        if (freeSlots.empty()) {
+            slot = getCount();
+            lights.emplace_back();
+            owners.push_back(entt::null);
+            dirtyFrames.push_back(0);
+        } else {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+    }
+    owners[slot] = entity;
+    lights[slot] = light;
+    markDirty(slot);
+}
+
+template <typename T>
+void LightSystem::Slots<T>::release(entt::entity entity) {
+    const auto index = static_cast<size_t>(entt::to_entity(entity));
+    if (index >= entityToSlot.size() || entityToSlot[index] == kInvalidSlot) {
+        return;
+    }
+    const uint32_t slot = entityToSlot[index];
+    if (owners[slot] != entity) {
+        return;
+    }
+    entityToSlot[index] = kInvalidSlot;
+    owners[slot]        = entt::null;
+    lights[slot]        = {};
+    freeSlots.push_back(slot);
+    markDirty(slot);
+}
+
+template <typename T>
+void LightSystem::Slots<T>::markDirty(uint32_t slot) {
+    for (uint32_t frame = 0; frame < dirty.size(); ++frame) {
+        const auto bit = static_cast<uint8_t>(1u << frame);
+        if (!(dirtyFrames[slot] & bit)) {
+            dirtyFrames[slot] |= bit;
+            dirty[frame].push_back(slot);
+        }
+    }
+}
+
+template <typename T>
+uint32_t LightSystem::Slots<T>::upload(uint32_t frameIndex, bool all, T* dst) {
+    const auto             mask       = static_cast<uint8_t>(~(1u << frameIndex));
+    std::vector<uint32_t>& frameDirty = dirty[frameIndex];
+    for (const uint32_t slot : frameDirty) {
+        dirtyFrames[slot] &= mask;
+    }
+
+    uint32_t count = 0;
+    if (all) {
+        std::copy(lights.begin(), lights.end(), dst);
+        count = getCount();
+    } else {
+        for (const uint32_t slot : frameDirty) {
+            dst[slot] = lights[slot];
+        }
+        count = static_cast<uint32_t>(frameDirty.size());
+    }
+    frameDirty.clear();
+    return count;
+}
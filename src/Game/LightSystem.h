@@ -0,0 +1,142 @@
+#pragma once
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Light components, a light modified in place must be notified with registry.patch<>().
+struct CDirectionalLight {
+    bool      enable = true;
+    glm::vec3 color;
+    glm::vec3 direction;
+};
+struct CPointLight {
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+    float     range     = 10;
+    float     intensity = 10;
+    float     constant;
+    float     linear;
+    float     quadratic;
+    bool      enable = true;
+};
+struct CSpotLight {
+    bool      enable = true;
+    glm::vec3 color;
+    glm::vec3 direction; // relative to the entity world transform
+    float     range;
+    float     cutOffAngle; // degrees
+};
+
+// The lights are in storage buffers, must match pointLights, spotLights and directionalLights in
+// lights.slang (std430 layout).
+struct PointLight {
+    glm::vec4 position;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    float range;
+    float intensity;
+    float constant;
+    float linear;
+    float quadratic;
+    float pad0;
+    float pad1;
+    float pad2;
+};
+static_assert(sizeof(PointLight) == 96);
+struct DirectionalLight {
+    glm::vec4 color;
+    glm::vec4 direction;
+};
+static_assert(sizeof(DirectionalLight) == 32);
+struct SpotLight {
+    glm::vec4 color;
+    glm::vec4 position;
+    glm::vec4 direction;
+    float     range;
+    float     cutOffInner;
+    float     cutOffOuter;
+    float     pad1;
+};
+static_assert(sizeof(SpotLight) == 64);
+
+/// @brief Keep the GPU lights in sync with the light components.
+///
+/// Each light entity owns a stable slot of the light arrays, the slots are allocated and released
+/// with the entt construct/update/destroy signals of the light components and of CWorldTransform.
+/// A released slot is reused by the next light. The released and the disabled slots are kept with
+/// a null light (zero range and color), skipped by the light passes.
+///
+/// The arrays are copied to one set of buffers per frame in flight. Each frame slot has the list of
+/// the slots changed since its last upload, a static light is written once per frame slot.
+class LightSystem {
+public:
+    /// @param frameCount Number of frame slots which own a copy of the lights, at most kMaxFrameCount.
+    LightSystem(entt::registry& registry, uint32_t frameCount);
+    ~LightSystem();
+
+    LightSystem(const LightSystem&)            = delete;
+    LightSystem& operator=(const LightSystem&) = delete;
+
+    LightSystem(LightSystem&&)            = delete;
+    LightSystem& operator=(LightSystem&&) = delete;
+
+    static constexpr uint32_t kMaxFrameCount = 8;
+
+    [[nodiscard]] entt::registry& getRegistry() const { return mRegistry; }
+
+    /// @brief Apply the changes of the lights and of their world transform since the last update.
+    void update();
+
+    /// @brief Write the slots changed since the last upload of a frame slot, all the slots after invalidate().
+    /// @param pointLights Buffer of the frame slot with room for getPointLightCount() lights, and so on.
+    /// @return The number of lights written.
+    uint32_t upload(uint32_t frameIndex, PointLight* pointLights, SpotLight* spotLights,
+                    DirectionalLight* directionalLights);
+
+    /// @brief Write all the slots at the next upload of a frame slot, when its buffers were recreated.
+    void invalidate(uint32_t frameIndex);
+
+    /// @brief Return the number of slots, the released ones included.
+    [[nodiscard]] uint32_t getPointLightCount() const { return mPointLights.getCount(); }
+    [[nodiscard]] uint32_t getSpotLightCount() const { return mSpotLights.getCount(); }
+    [[nodiscard]] uint32_t getDirectionalLightCount() const { return mDirectionalLights.getCount(); }
+
+    [[nodiscard]] const std::vector<PointLight>&       getPointLights() const { return mPointLights.lights; }
+    [[nodiscard]] const std::vector<SpotLight>&        getSpotLights() const { return mSpotLights.lights; }
+    [[nodiscard]] const std::vector<DirectionalLight>& getDirectionalLights() const { return mDirectionalLights.lights; }
+
+private:
+    static constexpr uint32_t kInvalidSlot = UINT32_MAX;
+
+    /// @brief Lights of one type and their slot allocation.
+    template <typename T>
+    struct Slots {
+        std::vector<T>                     lights;
+        std::vector<entt::entity>          owners;       ///< entt::null for a released slot.
+        std::vector<uint32_t>              freeSlots;
+        std::vector<uint32_t>              entityToSlot; ///< Indexed by the entity identifier.
+        std::vector<uint8_t>               dirtyFrames;  ///< Bit f is set when the slot is in dirty[f].
+        std::vector<std::vector<uint32_t>> dirty;        ///< Slots changed since the last upload of each frame slot.
+
+        [[nodiscard]] uint32_t getCount() const { return static_cast<uint32_t>(lights.size()); }
+        void assign(entt::entity entity, const T& light);
+        void release(entt::entity entity);
+        void markDirty(uint32_t slot);
+        uint32_t upload(uint32_t frameIndex, bool all, T* dst);
+    };
+
+    void onLightChanged(entt::registry& registry, entt::entity entity);
+    void onWorldTransformChanged(entt::registry& registry, entt::entity entity);
+
+    entt::registry&           mRegistry;
+    std::vector<entt::entity> mChanged;     ///< Entities to update, may have duplicates.
+    std::vector<uint8_t>      mInvalidated; ///< Frame slots whose next upload writes all the slots.
+
+    Slots<PointLight>       mPointLights;
+    Slots<SpotLight>        mSpotLights;
+    Slots<DirectionalLight> mDirectionalLights;
+};
@@ -1,112 +1,164 @@
 #include "Mesh.h"
 
-#include "GeometryGenerator.h"
-#include "vulkan/VulkanContext.h"
+#include "AssimpImporter.h"
+#include "MeshCache.h"
+#include "MeshShapes.h"
+#include "vulkan/VulkanUploader.h"
+
+#include <Engine/Log.h>
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <vector>
 
 namespace {
-    void uploadData(const GeometryGenerator::MeshData& meshData, Mesh& mesh) {
-        const auto vertexSize = meshData.Vertices.size() * sizeof(GeometryGenerator::Vertex);
-        const auto indexSize  = meshData.Indices.size() * sizeof(unsigned);
+    /// @brief Return true if all the indices can be stored on 16 bits.
+    bool fitsUint16(std::span<const uint32_t> indices) {
+        return std::ranges::all_of(indices, [](uint32_t index) { return index <= std::numeric_limits<uint16_t>::max(); });
+    }
+};
 
+std::span<const Mesh::SubMesh> Mesh::getSubMeshes(uint32_t lod) const {
+    if (lods.empty()) {
+        return subMeshs;
+    }
+    const MeshData::Lod& range = lods[std::min<size_t>(lod, lods.size() - 1)];
+    return std::span(subMeshs).subspan(range.firstSubMesh, range.subMeshCount);
+}
 
-        mesh.indexCount   = meshData.Indices.size();
-        VulkanBufferCreateInfo bufferCreateInfo{};
-        bufferCreateInfo.sizeInByte     = vertexSize;
-        bufferCreateInfo.usage          = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-        bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        mesh.vertexBuffer = VulkanBuffer::Create(bufferCreateInfo);
+uint32_t Mesh::getIndexCount(uint32_t lod) const {
+    if (subMeshs.empty()) {
+        return indexCount;
+    }
+    uint32_t count = 0;
+    for (const SubMesh& subMesh : getSubMeshes(lod)) {
+        count += subMesh.nbIndices;
+    }
+    return count;
+}
 
-        bufferCreateInfo.sizeInByte     = indexSize;
-        bufferCreateInfo.usage          = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-        bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        mesh.indexBuffer  = VulkanBuffer::Create(bufferCreateInfo);
+Mesh Mesh::Create(const MeshDataView& meshData, MeshVertexFormat vertexFormat) {
+    const uint32_t vertexSize = VertexQuantization::getVertexSize(vertexFormat);
 
-        mesh.vertexBuffer->writeData(meshData.Vertices.data(), vertexSize);
-        mesh.indexBuffer->writeData(meshData.Indices.data(), indexSize);
+    Mesh mesh;
+    mesh.indexType           = fitsUint16(meshData.indices) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    const uint32_t indexSize = mesh.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    mesh.aabbMin      = meshData.aabbMin;
+    mesh.aabbMax      = meshData.aabbMax;
+    mesh.indexCount   = static_cast<uint32_t>(meshData.indices.size());
+    mesh.vertexFormat = vertexFormat;
+    mesh.lods.assign(meshData.lods.begin(), meshData.lods.end());
+    mesh.meshlets.assign(meshData.meshlets.begin(), meshData.meshlets.end());
+    if (meshData.vertices.empty() || meshData.indices.empty()) {
+        return mesh;
     }
-};
 
-Mesh Mesh::CreateMeshCube(float size) { return CreateMeshCube(size, size, size); }
+    // The ranges are aligned to the vertex and index sizes, the offsets are whole vertices and indices.
+    mesh.geometry = VulkanGeometryArena::allocate(meshData.vertices.size() * vertexSize, vertexSize,
+                                                  meshData.indices.size() * indexSize, indexSize);
+    if (!mesh.geometry) {
+        return mesh;
+    }
+    mesh.firstIndex   = static_cast<uint32_t>(mesh.geometry->indexOffset / indexSize);
+    mesh.vertexOffset = static_cast<uint32_t>(mesh.geometry->vertexOffset / vertexSize);
+
+    mesh.subMeshs.reserve(meshData.subMeshes.size());
+    for (const MeshData::SubMesh& subMeshData : meshData.subMeshes) {
+        SubMesh subMesh;
+        subMesh.nbIndices          = subMeshData.indexCount;
+        subMesh.nbVertices         = subMeshData.vertexCount;
+        subMesh.firstIndex         = mesh.firstIndex + subMeshData.firstIndex;
+        subMesh.vertexOffset       = mesh.vertexOffset + subMeshData.vertexOffset;
+        subMesh.indexBufferOffset  = subMesh.firstIndex * indexSize;
+        subMesh.vertexBufferOffset = subMesh.vertexOffset * vertexSize;
+        subMesh.aabbMin            = subMeshData.aabbMin;
+        subMesh.aabbMax            = subMeshData.aabbMax;
+        subMesh.firstMeshlet       = subMeshData.firstMeshlet;
+        subMesh.meshletCount       = subMeshData.meshletCount;
+        mesh.subMeshs.push_back(subMesh);
+    }
 
-Mesh Mesh::CreateMeshCube(float width, float height, float depth) {
-    GeometryGenerator           geometryGenerator;
-    GeometryGenerator::MeshData meshData;
-    geometryGenerator.createBox(width, height, depth, meshData);
+    const VulkanBufferPtr& vertexBuffer = VulkanGeometryArena::getVertexBuffer();
+    if (vertexFormat == MeshVertexFormat::Packed) {
+        // The vertex shader dequantizes the positions with the table of the sub meshes.
+        const PackedMeshData packedData = VertexQuantization::quantize(meshData);
+        VulkanUploader::uploadBuffer(vertexBuffer, packedData.vertices.data(), mesh.geometry->vertexSize,
+                                     mesh.geometry->vertexOffset);
+
+        VulkanBufferCreateInfo createInfo{};
+        createInfo.name         = "SubMeshQuantization";
+        createInfo.sizeInByte   = packedData.subMeshes.size() * sizeof(SubMeshQuantization);
+        createInfo.usage        = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        mesh.quantizationBuffer = VulkanBuffer::CreateDeviceLocal(createInfo, packedData.subMeshes.data());
+    } else {
+        // The data is copied straight from the caller (or the mapped cache file) into the staging ring.
+        VulkanUploader::uploadBuffer(vertexBuffer, meshData.vertices.data(), mesh.geometry->vertexSize,
+                                     mesh.geometry->vertexOffset);
+    }
+
+    const VulkanBufferPtr& indexBuffer = VulkanGeometryArena::getIndexBuffer();
+    if (mesh.indexType == VK_INDEX_TYPE_UINT16) {
+        const std::vector<uint16_t> indices(meshData.indices.begin(), meshData.indices.end());
+        mesh.uploadHandle = VulkanUploader::uploadBuffer(indexBuffer, indices.data(), mesh.geometry->indexSize,
+                                                         mesh.geometry->indexOffset);
+    } else {
+        mesh.uploadHandle = VulkanUploader::uploadBuffer(indexBuffer, meshData.indices.data(),
+                                                         mesh.geometry->indexSize, mesh.geometry->indexOffset);
+    }
 
-    // upload vertex data
-    Mesh mesh;
-    uploadData(meshData, mesh);
-    VulkanContext::setDebugObjectName((uint64_t)mesh.vertexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "MeshCube");
-    VulkanContext::setDebugObjectName((uint64_t)mesh.indexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "MeshCube");
-    mesh.aabbMin = { -width/2, -height/2, -depth/2, };
-    mesh.aabbMax = {  width/2,  height/2,  depth/2, };
     return mesh;
 }
 
-Mesh Mesh::CreateGrid(float        width,
-                      float        depth,
-                      unsigned int nbVertexWidth,
-                      unsigned int nVertexDepth) {
-    GeometryGenerator           geometryGenerator;
-    GeometryGenerator::MeshData meshData;
-    geometryGenerator.createGrid(width, depth, nbVertexWidth, nVertexDepth, meshData);
+Mesh Mesh::CreateFromFile(const std::filesystem::path& path, MeshVertexFormat vertexFormat) {
+    AssimpImporter importer;
 
-    // upload vertex data
-    Mesh mesh;
-    uploadData(meshData, mesh);
-    VulkanContext::setDebugObjectName((uint64_t)mesh.vertexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "MeshGrid");
-    VulkanContext::setDebugObjectName((uint64_t)mesh.indexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "MeshGrid");
-    mesh.aabbMin = { -width/2, 0, -depth/2, };
-    mesh.aabbMax = {  width/2, 0,  depth/2, };
-    return mesh;
+    MeshCache::CachedMesh cachedMesh;
+    if (MeshCache::load(path, importer.getImportSettings(), cachedMesh)) {
+        ENGINE_INFO("Loading {} (cached)", path.string());
+        return Create(cachedMesh.view, vertexFormat);
+    }
+
+    MeshData meshData;
+    if (!importer.importMesh(path, meshData)) {
+        return {};
+    }
+    MeshCache::store(path, importer.getImportSettings(), meshData);
+    return Create(meshData, vertexFormat);
 }
 
-Mesh Mesh::CreateGeoSphere(float radius, unsigned int subdivisionCount) {
-    GeometryGenerator           geometryGenerator;
-    GeometryGenerator::MeshData meshData;
-    geometryGenerator.createGeoSphere(radius, subdivisionCount, meshData);
+Mesh Mesh::CreateMeshCube(float size, MeshVertexFormat vertexFormat) {
+    return CreateMeshCube(size, size, size, vertexFormat);
+}
 
-    // upload vertex data
-    Mesh mesh;
-    uploadData(meshData, mesh);
-    VulkanContext::setDebugObjectName((uint64_t)mesh.vertexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "GeoSphereGrid");
-    VulkanContext::setDebugObjectName((uint64_t)mesh.indexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "GeoSphereGrid");
-    mesh.aabbMin = { -radius, -radius, -radius, };
-    mesh.aabbMax = {  radius,  radius,  radius, };
-    return mesh;
+Mesh Mesh::CreateMeshCube(float width, float height, float depth, MeshVertexFormat vertexFormat) {
+    return Create(MeshShapes::createBox(width, height, depth), vertexFormat);
 }
 
-Mesh Mesh::CreateCylinder(float        bottomRadius,
-                          float        topRadius,
-                          float        height,
-                          unsigned int sliceCount,
-                          unsigned int stackCount) {
-    GeometryGenerator           geometryGenerator;
-    GeometryGenerator::MeshData meshData;
-    geometryGenerator.createCylinder(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
+Mesh Mesh::CreateGrid(float            width,
+                      float            depth,
+                      unsigned int     nbVertexWidth,
+                      unsigned int     nVertexDepth,
+                      MeshVertexFormat vertexFormat) {
+    return Create(MeshShapes::createGrid(width, depth, nbVertexWidth, nVertexDepth), vertexFormat);
+}
 
-    // upload vertex data
-    Mesh mesh;
-    uploadData(meshData, mesh);
-    VulkanContext::setDebugObjectName((uint64_t)mesh.vertexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "CylinderMesh");
-    VulkanContext::setDebugObjectName((uint64_t)mesh.indexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "CylinderMesh");
-    const auto maxRadius = std::max(bottomRadius, topRadius);
-    mesh.aabbMin = { -maxRadius, -height/2, -maxRadius, };
-    mesh.aabbMax = {  maxRadius,  height/2,  maxRadius, };
-    return mesh;
+Mesh Mesh::CreateGeoSphere(float radius, unsigned int subdivisionCount, MeshVertexFormat vertexFormat) {
+    return Create(MeshShapes::createGeoSphere(radius, subdivisionCount), vertexFormat);
 }
 
-Mesh Mesh::CreateSphere(float radius, unsigned int sliceCount, unsigned int stackCount) {
-    GeometryGenerator           geometryGenerator;
-    GeometryGenerator::MeshData meshData;
-    geometryGenerator.createSphere(radius, sliceCount, stackCount, meshData);
+Mesh Mesh::CreateCylinder(float            bottomRadius,
+                          float            topRadius,
+                          float            height,
+                          unsigned int     sliceCount,
+                          unsigned int     stackCount,
+                          MeshVertexFormat vertexFormat) {
+    return Create(MeshShapes::createCylinder(bottomRadius, topRadius, height, sliceCount, stackCount), vertexFormat);
+}
 
-    // upload vertex data
-    Mesh mesh;
-    uploadData(meshData, mesh);
-    VulkanContext::setDebugObjectName((uint64_t)mesh.vertexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "SphereMesh");
-    VulkanContext::setDebugObjectName((uint64_t)mesh.indexBuffer->getBuffer(), VK_OBJECT_TYPE_BUFFER, "SphereMesh");
-    mesh.aabbMin = { -radius, -radius, -radius, };
-    mesh.aabbMax = {  radius,  radius,  radius, };
-    return mesh;
+Mesh Mesh::CreateSphere(float            radius,
+                        unsigned int     sliceCount,
+                        unsigned int     stackCount,
+                        MeshVertexFormat vertexFormat) {
+    return Create(MeshShapes::createSphere(radius, sliceCount, stackCount), vertexFormat);
 }
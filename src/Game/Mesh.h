@@ -1,8 +1,14 @@
 #pragma once
+#include "MeshData.h"
+#include "VertexQuantization.h"
 #include "Vulkan/VulkanBuffer.h"
+#include "vulkan/VulkanGeometryArena.h"
+#include "vulkan/VulkanUploader.h"
 
 #include <glm/glm.hpp>
 
+#include <filesystem>
+#include <span>
 #include <vector>
 
 struct Mesh {
@@ -11,39 +17,101 @@ struct Mesh {
         unsigned nbIndices;
         // number of vertices in the sub mesh
         unsigned nbVertices;
-        // offset in byte in the index buffer
+        // offset in byte in the arena index buffer (firstIndex * size of indexType)
         unsigned indexBufferOffset;
-        // offset in byte in the vertex buffer
+        // offset in byte in the arena vertex buffer
         unsigned vertexBufferOffset;
-        // first index of the submesh in the vertex buffer.
+        // first index of the submesh in the arena index buffer.
         unsigned firstIndex;
-        // Value to add to a index before fetching the vertex.
+        // Value to add to a index before fetching the vertex in the arena vertex buffer.
         unsigned vertexOffset;
 
         // AABB of the sub mesh
         glm::vec3 aabbMin;
         glm::vec3 aabbMax;
+        // Range of the sub mesh in meshlets, meshletCount is 0 when the sub mesh has no meshlet.
+        unsigned firstMeshlet{0};
+        unsigned meshletCount{0};
     };
-    VulkanBufferPtr      vertexBuffer;
-    VulkanBufferPtr      indexBuffer;
+    // Ranges of the mesh in the VulkanGeometryArena buffers, nullptr for an empty mesh.
+    VulkanGeometryArena::AllocationPtr geometry;
+    // Sub meshes of all the LODs, LOD by LOD.
     std::vector<SubMesh> subMeshs;
+    // Ranges of subMeshs, empty when the mesh has a single LOD made of all the sub meshes.
+    std::vector<MeshData::Lod> lods;
+    // Meshlets of the sub meshes, culled one by one by the GPU culling, see MeshletBuilder.
+    std::vector<MeshData::Meshlet> meshlets;
     uint32_t             indexCount;
+    // First index and vertex offset of the whole mesh in the arena buffers.
+    uint32_t             firstIndex{0};
+    uint32_t             vertexOffset{0};
+    // VK_INDEX_TYPE_UINT16 when the indices of every sub mesh fit, see Mesh::Create().
+    VkIndexType          indexType{VK_INDEX_TYPE_UINT32};
+    MeshVertexFormat     vertexFormat{MeshVertexFormat::Float};
+    // SubMeshQuantization of each sub mesh, only for the packed format.
+    VulkanBufferPtr      quantizationBuffer;
+    // Last upload of the mesh, the uploads are acquired in order.
+    VulkanUploader::UploadHandle uploadHandle;
 
     // AABB of the mesh
     glm::vec3 aabbMin;
     glm::vec3 aabbMax;
 
+    /// @brief Return true once the geometry was acquired, the frame can draw the mesh.
+    [[nodiscard]] bool isReady() const {
+        return geometry && VulkanUploader::isAcquired(uploadHandle) &&
+               (!quantizationBuffer || quantizationBuffer->isReady());
+    }
+
+    /// @brief Return the number of LODs, at least 1.
+    [[nodiscard]] uint32_t getLodCount() const { return lods.empty() ? 1 : static_cast<uint32_t>(lods.size()); }
+
+    /// @brief Return the coarsest LOD whose error is at most maxError (in mesh units).
+    [[nodiscard]] uint32_t selectLod(float maxError) const { return selectMeshLod(lods, maxError); }
+
+    /// @brief Return the sub meshes of a LOD, empty for a mesh without sub mesh.
+    [[nodiscard]] std::span<const SubMesh> getSubMeshes(uint32_t lod = 0) const;
+
+    /// @brief Return the number of indices drawn for a LOD.
+    [[nodiscard]] uint32_t getIndexCount(uint32_t lod = 0) const;
+
+    /// @brief Create a mesh from its CPU side content, the vertices and indices are sub allocated in the
+    ///        VulkanGeometryArena and uploaded through the staging ring.
+    ///
+    /// The indices are relative to the vertexOffset of their sub mesh, they are narrowed to 16 bits
+    /// when all the sub meshes have less than 65536 vertices.
+    ///
+    /// @param meshData     The content of the mesh.
+    /// @param vertexFormat The layout of the vertex buffer, the vertices are packed for MeshVertexFormat::Packed.
+    /// @return The mesh, without geometry if it is empty or the arena is full.
+    [[nodiscard]] static Mesh Create(const MeshDataView& meshData,
+                                     MeshVertexFormat    vertexFormat = MeshVertexFormat::Float);
+
+    /// @brief Load a mesh from a model file.
+    ///
+    /// The mesh is read from the mesh cache when it holds an up to date import of the file,
+    /// otherwise the file is imported with Assimp and the result is written in the cache.
+    ///
+    /// @param path         The path of the model file.
+    /// @param vertexFormat The layout of the vertex buffer.
+    /// @return The mesh, without geometry if the file could not be imported.
+    [[nodiscard]] static Mesh CreateFromFile(const std::filesystem::path& path,
+                                             MeshVertexFormat             vertexFormat = MeshVertexFormat::Float);
+
     /// @brief
     /// @param size
     /// @return
-    [[nodiscard]] static Mesh CreateMeshCube(float size);
+    [[nodiscard]] static Mesh CreateMeshCube(float size, MeshVertexFormat vertexFormat = MeshVertexFormat::Float);
 
     /// @brief
     /// @param width
     /// @param height
     /// @param depth
     /// @return
-    [[nodiscard]] static Mesh CreateMeshCube(float width, float height, float depth);
+    [[nodiscard]] static Mesh CreateMeshCube(float            width,
+                                             float            height,
+                                             float            depth,
+                                             MeshVertexFormat vertexFormat = MeshVertexFormat::Float);
 
     /// @brief
     /// @param width
@@ -51,36 +119,41 @@ struct Mesh {
     /// @param nbVertexWidth
     /// @param nVertexDepth
     /// @return
-    [[nodiscard]] static Mesh CreateGrid(float        width,
-                                         float        depth,
-                                         unsigned int nbVertexWidth,
-                                         unsigned int nVertexDepth);
+    [[nodiscard]] static Mesh CreateGrid(float            width,
+                                         float            depth,
+                                         unsigned int     nbVertexWidth,
+                                         unsigned int     nVertexDepth,
+                                         MeshVertexFormat vertexFormat = MeshVertexFormat::Float);
 
-    /// @brief
+    /// @brief Create a geodesic sphere, with a LOD chain of less subdivisions down to the icosahedron.
     /// @param radius
     /// @param subdivisionCount
     /// @return
-    [[nodiscard]] static Mesh CreateGeoSphere(float radius, unsigned int subdivisionCount);
+    [[nodiscard]] static Mesh CreateGeoSphere(float            radius,
+                                              unsigned int     subdivisionCount,
+                                              MeshVertexFormat vertexFormat = MeshVertexFormat::Float);
 
-    /// @brief
+    /// @brief Create a cylinder, with a LOD chain of less slices and stacks.
     /// @param bottomRadius
     /// @param topRadius
     /// @param height
     /// @param sliceCount
     /// @param stackCounta
     /// @return
-    [[nodiscard]] static Mesh CreateCylinder(float        bottomRadius,
-                                             float        topRadius,
-                                             float        height,
-                                             unsigned int sliceCount,
-                                             unsigned int stackCounta);
+    [[nodiscard]] static Mesh CreateCylinder(float            bottomRadius,
+                                             float            topRadius,
+                                             float            height,
+                                             unsigned int     sliceCount,
+                                             unsigned int     stackCounta,
+                                             MeshVertexFormat vertexFormat = MeshVertexFormat::Float);
 
-    /// @brief
+    /// @brief Create a UV sphere, with a LOD chain of less slices and stacks.
     /// @param radius
     /// @param sliceCount
     /// @param stackCount
     /// @return
-    [[nodiscard]] static Mesh CreateSphere(float        radius,
-                                           unsigned int sliceCount,
-                                           unsigned int stackCount);
+    [[nodiscard]] static Mesh CreateSphere(float            radius,
+                                           unsigned int     sliceCount,
+                                           unsigned int     stackCount,
+                                           MeshVertexFormat vertexFormat = MeshVertexFormat::Float);
 };
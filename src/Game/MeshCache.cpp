@@ -0,0 +1,213 @@
+#include "MeshCache.h"
+
+#include <Engine/Log.h>
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+constexpr char     kMagic[4]  = {'M', 'E', 'S', 'H'};
+constexpr uint32_t kVersion   = 4; // 2: optimized vertex and index order, 3: LODs, 4: meshlets
+constexpr uint64_t kAlignment = 16;
+
+static_assert(std::is_trivially_copyable_v<MeshVertex>);
+static_assert(std::is_trivially_copyable_v<MeshData::SubMesh>);
+static_assert(std::is_trivially_copyable_v<MeshData::Lod>);
+static_assert(std::is_trivially_copyable_v<MeshData::Meshlet>);
+
+/// @brief Header of a cache file, followed by the source path, the sub meshes, the LODs, the
+///        meshlets, the vertices and the indices, each blob aligned on kAlignment bytes.
+struct Header {
+    char     magic[4];
+    uint32_t version;
+    uint32_t importFlags;
+    float    scaleFactor;
+    int64_t  sourceTime;
+    uint64_t sourceSize;
+    uint32_t vertexStride;
+    uint32_t subMeshStride;
+    uint32_t pathLength;
+    uint32_t subMeshCount;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float    aabbMin[3];
+    float    aabbMax[3];
+    uint64_t pathOffset;
+    uint64_t subMeshOffset;
+    uint64_t lodOffset;
+    uint64_t meshletOffset;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+};
+
+struct SourceInfo {
+    std::string path;
+    int64_t     time{0};
+    uint64_t    size{0};
+};
+
+bool getSourceInfo(const std::filesystem::path& source, SourceInfo& info) {
+    std::error_code error;
+    info.path = std::filesystem::absolute(source, error).lexically_normal().generic_string();
+    info.time = std::filesystem::last_write_time(source, error).time_since_epoch().count();
+    if (error) {
+        return false;
+    }
+    info.size = std::filesystem::file_size(source, error);
+    return !error;
+}
+
+uint64_t align(uint64_t offset) { return (offset + kAlignment - 1) / kAlignment * kAlignment; }
+
+/// @brief FNV-1a, stable between runs and compilers unlike std::hash.
+uint64_t hashString(const std::string& text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : text) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+std::span<const T> getBlob(const Engine::MappedFile& file, uint64_t offset, uint32_t count) {
+    return {reinterpret_cast<const T*>(file.getData() + offset), count};
+}
+
+} // namespace
+
+std::filesystem::path MeshCache::getCachePath(const std::filesystem::path& source,
+                                              const std::filesystem::path& directory) {
+    std::error_code   error;
+    const std::string key = std::filesystem::absolute(source, error).lexically_normal().generic_string();
+    return directory / std::format("{}-{:016x}.mesh", source.stem().string(), hashString(key));
+}
+
+bool MeshCache::load(const std::filesystem::path& source,
+                     const ImportSettings&        settings,
+                     CachedMesh&                  mesh,
+                     const std::filesystem::path& directory) {
+    SourceInfo sourceInfo;
+    if (!getSourceInfo(source, sourceInfo) || !mesh.file.open(getCachePath(source, directory))) {
+        return false;
+    }
+
+    Header header{};
+    if (mesh.file.getSize() < sizeof(Header)) {
+        mesh.file.close();
+        return false;
+    }
+    std::memcpy(&header, mesh.file.getData(), sizeof(Header));
+
+    const uint64_t fileSize = mesh.file.getSize();
+    const bool     valid =
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+        header.importFlags == settings.importFlags && header.scaleFactor == settings.scaleFactor &&
+        header.sourceTime == sourceInfo.time && header.sourceSize == sourceInfo.size &&
+        header.vertexStride == sizeof(MeshVertex) && header.subMeshStride == sizeof(MeshData::SubMesh) &&
+        header.pathOffset + header.pathLength <= fileSize &&
+        header.subMeshOffset + uint64_t(header.subMeshCount) * sizeof(MeshData::SubMesh) <= fileSize &&
+        header.lodOffset + uint64_t(header.lodCount) * sizeof(MeshData::Lod) <= fileSize &&
+        header.meshletOffset + uint64_t(header.meshletCount) * sizeof(MeshData::Meshlet) <= fileSize &&
+        header.vertexOffset + uint64_t(header.vertexCount) * sizeof(MeshVertex) <= fileSize &&
+        header.indexOffset + uint64_t(header.indexCount) * sizeof(uint32_t) <= fileSize &&
+        header.subMeshOffset % kAlignment == 0 && header.lodOffset % kAlignment == 0 &&
+        header.meshletOffset % kAlignment == 0 &&
+        header.vertexOffset % kAlignment == 0 &&
+        header.indexOffset % kAlignment == 0 &&
+        std::string_view(reinterpret_cast<const char*>(mesh.file.getData() + header.pathOffset),
+                         header.pathLength) == sourceInfo.path;
+    if (!valid) {
+        ENGINE_INFO("Mesh cache of {} is out of date", source.string());
+        mesh.file.close();
+        return false;
+    }
+
+    mesh.view.subMeshes = getBlob<MeshData::SubMesh>(mesh.file, header.subMeshOffset, header.subMeshCount);
+    mesh.view.lods      = getBlob<MeshData::Lod>(mesh.file, header.lodOffset, header.lodCount);
+    mesh.view.meshlets  = getBlob<MeshData::Meshlet>(mesh.file, header.meshletOffset, header.meshletCount);
+    mesh.view.vertices  = getBlob<MeshVertex>(mesh.file, header.vertexOffset, header.vertexCount);
+    mesh.view.indices   = getBlob<uint32_t>(mesh.file, header.indexOffset, header.indexCount);
+    mesh.view.aabbMin   = {header.aabbMin[0], header.aabbMin[1], header.aabbMin[2]};
+    mesh.view.aabbMax   = {header.aabbMax[0], header.aabbMax[1], header.aabbMax[2]};
+    return true;
+}
+
+bool MeshCache::store(const std::filesystem::path& source,
+                      const ImportSettings&        settings,
+                      const MeshData&              mesh,
+                      const std::filesystem::path& directory) {
+    SourceInfo sourceInfo;
+    if (!getSourceInfo(source, sourceInfo)) {
+        ENGINE_ERROR("Mesh cache: can't stat {}", source.string());
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version       = kVersion;
+    header.importFlags   = settings.importFlags;
+    header.scaleFactor   = settings.scaleFactor;
+    header.sourceTime    = sourceInfo.time;
+    header.sourceSize    = sourceInfo.size;
+    header.vertexStride  = sizeof(MeshVertex);
+    header.subMeshStride = sizeof(MeshData::SubMesh);
+    header.pathLength    = static_cast<uint32_t>(sourceInfo.path.size());
+    header.subMeshCount  = static_cast<uint32_t>(mesh.subMeshes.size());
+    header.lodCount      = static_cast<uint32_t>(mesh.lods.size());
+    header.meshletCount  = static_cast<uint32_t>(mesh.meshlets.size());
+    header.vertexCount   = static_cast<uint32_t>(mesh.vertices.size());
+    header.indexCount    = static_cast<uint32_t>(mesh.indices.size());
+    for (int i = 0; i < 3; ++i) {
+        header.aabbMin[i] = mesh.aabbMin[i];
+        header.aabbMax[i] = mesh.aabbMax[i];
+    }
+    header.pathOffset    = sizeof(Header);
+    header.subMeshOffset = align(header.pathOffset + header.pathLength);
+    header.lodOffset     = align(header.subMeshOffset + mesh.subMeshes.size() * sizeof(MeshData::SubMesh));
+    header.meshletOffset = align(header.lodOffset + mesh.lods.size() * sizeof(MeshData::Lod));
+    header.vertexOffset  = align(header.meshletOffset + mesh.meshlets.size() * sizeof(MeshData::Meshlet));
+    header.indexOffset   = align(header.vertexOffset + mesh.vertices.size() * sizeof(MeshVertex));
+
+    const uint64_t size = header.indexOffset + mesh.indices.size() * sizeof(uint32_t);
+
+    std::vector<char> data(size, 0);
+    std::memcpy(data.data(), &header, sizeof(Header));
+    std::memcpy(data.data() + header.pathOffset, sourceInfo.path.data(), header.pathLength);
+    std::memcpy(data.data() + header.subMeshOffset, mesh.subMeshes.data(),
+                mesh.subMeshes.size() * sizeof(MeshData::SubMesh));
+    std::memcpy(data.data() + header.lodOffset, mesh.lods.data(), mesh.lods.size() * sizeof(MeshData::Lod));
+    std::memcpy(data.data() + header.meshletOffset, mesh.meshlets.data(),
+                mesh.meshlets.size() * sizeof(MeshData::Meshlet));
+    std::memcpy(data.data() + header.vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(MeshVertex));
+    std::memcpy(data.data() + header.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+
+    // Write a temporary file renamed at the end, a partially written cache is never mapped.
+    const std::filesystem::path path          = getCachePath(source, directory);
+    std::filesystem::path       temporaryPath = path;
+    temporaryPath += ".tmp";
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    {
+        std::ofstream ofs(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!ofs.write(data.data(), data.size())) {
+            ENGINE_ERROR("Mesh cache: failed to write {}", temporaryPath.string());
+            return false;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        ENGINE_ERROR("Mesh cache: failed to write {} ({})", path.string(), error.message());
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "MeshData.h"
+
+#include <Engine/MappedFile.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+/// @brief Binary cache of the imported meshes.
+///
+/// Importing a model with Assimp (normals, tangents, vertex welding, ...) is slow, the result is
+/// written once into a versioned binary file holding the sub mesh, LOD and meshlet tables, the AABB and the vertex
+/// and index blobs already in the GPU layout. The next loads map the file and the blobs are copied
+/// straight into the upload buffers.
+///
+/// A cache file is keyed by the path of the source, its modification time and size and the
+/// import settings, it is ignored (and rewritten) as soon as one of them changes.
+namespace MeshCache {
+
+/// @brief The settings of the import, the cached data is only valid for the same settings.
+struct ImportSettings {
+    uint32_t importFlags{0};
+    float    scaleFactor{1.0f};
+};
+
+/// @brief A mesh read from the cache, the view points into the mapped file.
+struct CachedMesh {
+    Engine::MappedFile file;
+    MeshDataView       view;
+};
+
+/// @brief The directory of the cache files when none is given.
+inline const std::filesystem::path kDefaultDirectory = "./cache/meshes";
+
+/// @brief Return the cache file of a source file.
+[[nodiscard]] std::filesystem::path getCachePath(const std::filesystem::path& source,
+                                                 const std::filesystem::path& directory = kDefaultDirectory);
+
+/// @brief Map the cache file of a source file.
+/// @return false if there is no cache file or if it doesn't match the source or the settings.
+bool load(const std::filesystem::path& source,
+          const ImportSettings&        settings,
+          CachedMesh&                  mesh,
+          const std::filesystem::path& directory = kDefaultDirectory);
+
+/// @brief Write the cache file of a source file, the error is logged on failure.
+bool store(const std::filesystem::path& source,
+           const ImportSettings&        settings,
+           const MeshData&              mesh,
+           const std::filesystem::path& directory = kDefaultDirectory);
+
+} // namespace MeshCache
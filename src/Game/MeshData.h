@@ -0,0 +1,91 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// @brief Vertex of the imported meshes, in the layout of the vertex buffer.
+struct MeshVertex {
+    float position[3];
+    float normal[3];
+    float tangent[3];
+    float uv[2];
+};
+
+/// @brief CPU side content of a mesh, in the layout of the GPU buffers.
+///
+/// Produced by the importer (or read back from the mesh cache) and turned into a Mesh by
+/// Mesh::Create(). It doesn't depend on Vulkan so the offline tools and tests can use it.
+struct MeshData {
+    struct SubMesh {
+        uint32_t  indexCount{0};   ///< Number of indices of the sub mesh.
+        uint32_t  vertexCount{0};  ///< Number of vertices of the sub mesh.
+        uint32_t  firstIndex{0};   ///< First index of the sub mesh in the index buffer.
+        uint32_t  vertexOffset{0}; ///< Value to add to an index before fetching the vertex.
+        glm::vec3 aabbMin{0.0f};
+        glm::vec3 aabbMax{0.0f};
+        uint32_t  firstMeshlet{0}; ///< First meshlet of the sub mesh in meshlets.
+        uint32_t  meshletCount{0}; ///< Number of meshlets, 0 when the sub mesh is culled as a whole.
+    };
+
+    /// @brief A cluster of at most 64 vertices and 124 triangles of a sub mesh, see MeshletBuilder.
+    struct Meshlet {
+        glm::vec3 center{0.0f};     ///< Bounding sphere, in mesh units.
+        float     radius{0.0f};
+        glm::vec3 coneAxis{0.0f};   ///< Average direction of the triangle normals.
+        float     coneCutoff{1.0f}; ///< Sine of the cone angle, 1 when the cone is too wide to cull.
+        uint32_t  firstIndex{0};    ///< First index, from the first index of the sub mesh.
+        uint32_t  triangleCount{0};
+        uint32_t  vertexCount{0};   ///< Number of distinct vertices.
+        uint32_t  _pad{0};
+    };
+
+    /// @brief A level of detail, a range of sub meshes drawn instead of the ones of LOD 0.
+    ///
+    /// LOD 0 is the first range. The sub meshes of a LOD reuse the vertices of LOD 0 (simplified
+    /// index lists) or have their own (generated shapes with less slices).
+    struct Lod {
+        uint32_t firstSubMesh{0};
+        uint32_t subMeshCount{0};
+        float    error{0.0f}; ///< Estimated distance to the surface of LOD 0, in mesh units.
+    };
+
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t>   indices;
+    std::vector<SubMesh>    subMeshes; ///< The sub meshes of all the LODs, LOD by LOD.
+    std::vector<Lod>        lods;      ///< Empty when the mesh has a single LOD made of all the sub meshes.
+    std::vector<Meshlet>    meshlets;  ///< The meshlets of all the sub meshes, sub mesh by sub mesh.
+
+    // AABB of the mesh
+    glm::vec3 aabbMin{0.0f};
+    glm::vec3 aabbMax{0.0f};
+};
+
+/// @brief Read only view of the content of a mesh, either a MeshData or a mapped cache file.
+struct MeshDataView {
+    std::span<const MeshData::SubMesh> subMeshes;
+    std::span<const MeshData::Lod>     lods;
+    std::span<const MeshData::Meshlet> meshlets;
+    std::span<const MeshVertex>        vertices;
+    std::span<const uint32_t>          indices;
+    glm::vec3                          aabbMin{0.0f};
+    glm::vec3                          aabbMax{0.0f};
+
+    MeshDataView() = default;
+    MeshDataView(const MeshData& meshData)
+        : subMeshes(meshData.subMeshes), lods(meshData.lods), meshlets(meshData.meshlets),
+          vertices(meshData.vertices), indices(meshData.indices), aabbMin(meshData.aabbMin),
+          aabbMax(meshData.aabbMax) {}
+};
+
+/// @brief Return the coarsest LOD whose error is at most maxError, the errors grow with the LOD.
+/// @param lods     The LODs of a mesh, may be empty.
+/// @param maxError The error allowed at the distance of the mesh, in mesh units.
+[[nodiscard]] inline uint32_t selectMeshLod(std::span<const MeshData::Lod> lods, float maxError) {
+    uint32_t lod = 0;
+    while (lod + 1 < lods.size() && lods[lod + 1].error <= maxError) {
+        ++lod;
+    }
+    return lod;
+}
@@ -0,0 +1,346 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+/// @brief A FIFO post-transform cache, the stamps avoid clearing an array on reset.
+class CacheSimulator {
+public:
+    CacheSimulator(uint32_t vertexCount, uint32_t cacheSize)
+        : mCacheSize(cacheSize), mTimestamps(vertexCount, 0) {}
+
+    /// @brief Forget all the cached vertices.
+    void reset() { mTime += mCacheSize + 1; }
+
+    /// @brief Return the number of vertices of the triangle which were not in the cache.
+    uint32_t addTriangle(const uint32_t* triangle) {
+        uint32_t misses = 0;
+        for (int i = 0; i < 3; ++i) {
+            const uint32_t vertex = triangle[i];
+            // A FIFO only inserts on a miss: the vertex is cached if less than cacheSize
+            // vertices were inserted since its own insertion.
+            if (mTime - mTimestamps[vertex] >= mCacheSize || mTimestamps[vertex] == 0) {
+                mTimestamps[vertex] = ++mTime;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+
+private:
+    uint32_t              mCacheSize;
+    uint32_t              mTime{0};
+    std::vector<uint32_t> mTimestamps;
+};
+
+uint64_t countCacheMisses(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize) {
+    CacheSimulator cache(vertexCount, cacheSize);
+    uint64_t       misses = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        misses += cache.addTriangle(&indices[i]);
+    }
+    return misses;
+}
+
+MeshOptimizer::VertexCacheStatistics makeStatistics(uint64_t misses, uint64_t triangleCount, uint64_t vertexCount) {
+    MeshOptimizer::VertexCacheStatistics statistics;
+    statistics.acmr = triangleCount ? float(double(misses) / double(triangleCount)) : 0.0f;
+    statistics.atvr = vertexCount ? float(double(misses) / double(vertexCount)) : 0.0f;
+    return statistics;
+}
+
+/// @brief Triangles using each vertex (compressed rows).
+struct Adjacency {
+    std::vector<uint32_t> offsets;   ///< First triangle of each vertex in triangles, vertexCount + 1 entries.
+    std::vector<uint32_t> triangles; ///< Triangles of the vertices.
+
+    Adjacency(std::span<const uint32_t> indices, uint32_t vertexCount) : offsets(vertexCount + 1, 0) {
+        for (const uint32_t index : indices) {
+            ++offsets[index + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        triangles.resize(indices.size());
+        std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+};
+
+} // namespace
+
+MeshOptimizer::VertexCacheStatistics MeshOptimizer::analyzeVertexCache(std::span<const uint32_t> indices,
+                                                                       uint32_t                  vertexCount,
+                                                                       uint32_t                  cacheSize) {
+    return makeStatistics(countCacheMisses(indices, vertexCount, cacheSize), indices.size() / 3, vertexCount);
+}
+
+void MeshOptimizer::optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize) {
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+
+    const Adjacency adjacency(indices, vertexCount);
+
+    // Number of not yet emitted triangles of each vertex.
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+        liveTriangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+    }
+
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;    // recently used vertices, to restart from when stuck
+    std::vector<uint32_t> candidates; // vertices of the triangles emitted around the fanning vertex
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t time   = cacheSize + 1;
+    uint32_t cursor = 0;
+    int64_t  fanningVertex = 0;
+    while (fanningVertex >= 0) {
+        // Emit all the triangles around the fanning vertex.
+        candidates.clear();
+        const uint32_t fanning = static_cast<uint32_t>(fanningVertex);
+        for (uint32_t t = adjacency.offsets[fanning]; t < adjacency.offsets[fanning + 1]; ++t) {
+            const uint32_t triangle = adjacency.triangles[t];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (int i = 0; i < 3; ++i) {
+                const uint32_t vertex = indices[triangle * 3 + i];
+                output.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+                if (time - cacheTimestamps[vertex] > cacheSize) {
+                    cacheTimestamps[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // The next fanning vertex is the candidate which will still be in the cache after
+        // emitting its triangles and is the oldest in the cache.
+        fanningVertex     = -1;
+        int64_t bestScore = -1;
+        for (const uint32_t vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+            int64_t score = 0;
+            if (time - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                score = time - cacheTimestamps[vertex];
+            }
+            if (score > bestScore) {
+                bestScore     = score;
+                fanningVertex = vertex;
+            }
+        }
+
+        // Dead end: restart from a recently used vertex, or from the next vertex with triangles.
+        while (fanningVertex < 0 && !deadEnd.empty()) {
+            const uint32_t vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                fanningVertex = vertex;
+            }
+        }
+        while (fanningVertex < 0 && cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) {
+                fanningVertex = cursor;
+            }
+            ++cursor;
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void MeshOptimizer::optimizeOverdraw(std::span<uint32_t> indices,
+                                     const float*        positions,
+                                     size_t              positionStride,
+                                     uint32_t            vertexCount,
+                                     float               threshold) {
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+
+    auto position = [&](uint32_t vertex) {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const std::byte*>(positions) +
+                                                        size_t(vertex) * positionStride);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    // Hard boundaries: the triangles missing all their vertices, the cache is cold there so the
+    // clusters can be moved without changing the cache efficiency.
+    std::vector<uint32_t> hardBoundaries;
+    {
+        CacheSimulator cache(vertexCount, kCacheSize);
+        for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+            if (cache.addTriangle(&indices[triangle * 3]) == 3) {
+                hardBoundaries.push_back(triangle);
+            }
+        }
+        hardBoundaries.push_back(triangleCount);
+    }
+
+    // Soft boundaries: split the clusters as soon as the ACMR of the part already walked is
+    // within the threshold of the whole cluster ACMR, giving more clusters to sort.
+    std::vector<uint32_t> clusters; // first triangle of each cluster
+    CacheSimulator        cache(vertexCount, kCacheSize);
+    for (size_t i = 0; i + 1 < hardBoundaries.size(); ++i) {
+        const uint32_t begin = hardBoundaries[i];
+        const uint32_t end   = hardBoundaries[i + 1];
+
+        cache.reset();
+        uint64_t clusterMisses = 0;
+        for (uint32_t triangle = begin; triangle < end; ++triangle) {
+            clusterMisses += cache.addTriangle(&indices[triangle * 3]);
+        }
+        const float clusterAcmr = float(clusterMisses) / float(end - begin);
+
+        cache.reset();
+        clusters.push_back(begin);
+        uint32_t clusterBegin = begin;
+        uint64_t misses       = 0;
+        for (uint32_t triangle = begin; triangle < end; ++triangle) {
+            misses += cache.addTriangle(&indices[triangle * 3]);
+            if (triangle + 1 < end && float(misses) / float(triangle + 1 - clusterBegin) <= clusterAcmr * threshold) {
+                clusterBegin = triangle + 1;
+                clusters.push_back(clusterBegin);
+                misses = 0;
+                cache.reset();
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Sort the clusters by how much they face away from the mesh center: the outer surfaces
+    // facing the camera are drawn first and hide the rest.
+    glm::vec3 meshCenter(0.0f);
+    float     meshArea = 0.0f;
+    struct Cluster {
+        uint32_t  begin;
+        uint32_t  end;
+        glm::vec3 center;
+        glm::vec3 normal;
+        float     area;
+        float     sortKey;
+    };
+    std::vector<Cluster> clusterInfos;
+    clusterInfos.reserve(clusters.size() - 1);
+    for (size_t i = 0; i + 1 < clusters.size(); ++i) {
+        Cluster cluster{clusters[i], clusters[i + 1], glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, 0.0f};
+        for (uint32_t triangle = cluster.begin; triangle < cluster.end; ++triangle) {
+            const glm::vec3 p0     = position(indices[triangle * 3 + 0]);
+            const glm::vec3 p1     = position(indices[triangle * 3 + 1]);
+            const glm::vec3 p2     = position(indices[triangle * 3 + 2]);
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0); // length is twice the area
+            const float     area   = glm::length(normal);
+            cluster.center += (p0 + p1 + p2) * (area / 3.0f);
+            cluster.normal += normal;
+            cluster.area += area;
+        }
+        meshCenter += cluster.center;
+        meshArea += cluster.area;
+        clusterInfos.push_back(cluster);
+    }
+    meshCenter = meshArea > 0.0f ? meshCenter / meshArea : meshCenter;
+    for (Cluster& cluster : clusterInfos) {
+        if (cluster.area > 0.0f) {
+            cluster.center = cluster.center / cluster.area;
+        }
+        const float normalLength = glm::length(cluster.normal);
+        cluster.sortKey =
+            normalLength > 0.0f ? glm::dot(cluster.center - meshCenter, cluster.normal / normalLength) : 0.0f;
+    }
+    std::stable_sort(clusterInfos.begin(), clusterInfos.end(),
+                     [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const Cluster& cluster : clusterInfos) {
+        output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+uint32_t MeshOptimizer::optimizeVertexFetch(std::span<uint32_t> indices,
+                                            void*               vertices,
+                                            uint32_t            vertexCount,
+                                            size_t              vertexSize) {
+    constexpr uint32_t kUnused = ~0u;
+
+    std::vector<uint32_t> remap(vertexCount, kUnused);
+    uint32_t              usedCount = 0;
+    for (uint32_t& index : indices) {
+        if (remap[index] == kUnused) {
+            remap[index] = usedCount++;
+        }
+        index = remap[index];
+    }
+    uint32_t unusedCount = usedCount;
+    for (uint32_t& newIndex : remap) {
+        if (newIndex == kUnused) {
+            newIndex = unusedCount++;
+        }
+    }
+
+    auto*                  data = static_cast<std::byte*>(vertices);
+    std::vector<std::byte> reordered(size_t(vertexCount) * vertexSize);
+    for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+        std::memcpy(reordered.data() + size_t(remap[vertex]) * vertexSize, data + size_t(vertex) * vertexSize,
+                    vertexSize);
+    }
+    std::memcpy(data, reordered.data(), reordered.size());
+    return usedCount;
+}
+
+MeshOptimizer::OptimizationReport MeshOptimizer::optimize(std::span<uint32_t> indices,
+                                                          void*               vertices,
+                                                          uint32_t            vertexCount,
+                                                          size_t              vertexSize,
+                                                          size_t              positionOffset) {
+    OptimizationReport report;
+    report.before = analyzeVertexCache(indices, vertexCount);
+
+    optimizeVertexCache(indices, vertexCount);
+    const auto* positions = reinterpret_cast<const float*>(static_cast<const std::byte*>(vertices) + positionOffset);
+    optimizeOverdraw(indices, positions, vertexSize, vertexCount);
+    optimizeVertexFetch(indices, vertices, vertexCount, vertexSize);
+
+    report.after = analyzeVertexCache(indices, vertexCount);
+    return report;
+}
+
+MeshOptimizer::OptimizationReport MeshOptimizer::optimize(MeshData& meshData) {
+    uint64_t missesBefore  = 0;
+    uint64_t missesAfter   = 0;
+    uint64_t triangleCount = 0;
+    uint64_t vertexCount   = 0;
+    for (const MeshData::SubMesh& subMesh : meshData.subMeshes) {
+        // The indices of a sub mesh are relative to its first vertex.
+        const std::span<uint32_t> indices(meshData.indices.data() + subMesh.firstIndex, subMesh.indexCount);
+        MeshVertex*               vertices = meshData.vertices.data() + subMesh.vertexOffset;
+
+        missesBefore += countCacheMisses(indices, subMesh.vertexCount, kCacheSize);
+        optimize(indices, vertices, subMesh.vertexCount, sizeof(MeshVertex), offsetof(MeshVertex, position));
+        missesAfter += countCacheMisses(indices, subMesh.vertexCount, kCacheSize);
+
+        triangleCount += subMesh.indexCount / 3;
+        vertexCount += subMesh.vertexCount;
+    }
+
+    OptimizationReport report;
+    report.before = makeStatistics(missesBefore, triangleCount, vertexCount);
+    report.after  = makeStatistics(missesAfter, triangleCount, vertexCount);
+    return report;
+}
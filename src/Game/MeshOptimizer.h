@@ -0,0 +1,82 @@
+#pragma once
+#include "MeshData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/// @brief CPU side reordering of indexed triangle lists for the GPU.
+///
+/// - Vertex cache: the triangles are reordered with Tipsify (Sander et al. 2007) so the vertices
+///   shared by neighbour triangles are still in the post-transform cache.
+/// - Overdraw: the cache friendly order is split into clusters, which are sorted front facing
+///   first (from the mesh center), the cache efficiency is kept within a threshold.
+/// - Vertex fetch: the vertices are reordered in the order of their first use.
+///
+/// All the functions work on plain index and vertex arrays so they can be used on MeshData,
+/// GeometryGenerator::MeshData or any vertex layout. They don't depend on Vulkan.
+namespace MeshOptimizer {
+
+/// @brief Size of the simulated post-transform cache (FIFO), typical of current GPUs.
+constexpr uint32_t kCacheSize = 16;
+
+/// @brief Efficiency of the post-transform cache for an index buffer.
+struct VertexCacheStatistics {
+    /// Average cache miss ratio: transformed vertices per triangle, 0.5 to 3 (lower is better).
+    float acmr{0.0f};
+    /// Average transform to vertex ratio: transformed vertices per vertex, 1 is optimal.
+    float atvr{0.0f};
+};
+
+/// @brief The cache statistics before and after an optimization.
+struct OptimizationReport {
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+/// @brief Simulate a FIFO post-transform cache.
+/// @param indices     The triangle list.
+/// @param vertexCount The number of vertices referenced by the indices.
+/// @param cacheSize   The number of entries of the cache.
+[[nodiscard]] VertexCacheStatistics analyzeVertexCache(std::span<const uint32_t> indices,
+                                                       uint32_t                  vertexCount,
+                                                       uint32_t                  cacheSize = kCacheSize);
+
+/// @brief Reorder the triangles for the post-transform cache (Tipsify), the winding is kept.
+void optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = kCacheSize);
+
+/// @brief Reorder the triangles to reduce the overdraw, the indices should be cache optimized.
+/// @param indices        The triangle list.
+/// @param positions      The position (3 floats) of the first vertex.
+/// @param positionStride The distance in bytes between two positions.
+/// @param vertexCount    The number of vertices.
+/// @param threshold      How much the ACMR may grow to get smaller clusters (1.05 = 5%).
+void optimizeOverdraw(std::span<uint32_t> indices,
+                      const float*        positions,
+                      size_t              positionStride,
+                      uint32_t            vertexCount,
+                      float               threshold = 1.05f);
+
+/// @brief Reorder the vertices in the order of their first use and remap the indices.
+///        The unused vertices are moved at the end.
+/// @return The number of vertices used by the indices.
+uint32_t optimizeVertexFetch(std::span<uint32_t> indices, void* vertices, uint32_t vertexCount, size_t vertexSize);
+
+/// @brief Run the vertex cache, overdraw and vertex fetch passes on a triangle list.
+/// @param indices        The triangle list.
+/// @param vertices       The vertices referenced by the indices.
+/// @param vertexCount    The number of vertices.
+/// @param vertexSize     The size in bytes of a vertex.
+/// @param positionOffset The offset in bytes of the position (3 floats) in a vertex.
+/// @return The cache statistics before and after the optimization.
+OptimizationReport optimize(std::span<uint32_t> indices,
+                            void*               vertices,
+                            uint32_t            vertexCount,
+                            size_t              vertexSize,
+                            size_t              positionOffset);
+
+/// @brief Optimize each sub mesh of a mesh.
+/// @return The cache statistics of the whole mesh before and after the optimization.
+OptimizationReport optimize(MeshData& meshData);
+
+} // namespace MeshOptimizer
@@ -0,0 +1,179 @@
+#include "MeshShapes.h"
+
+#include "GeometryGenerator.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <vector>
+
+namespace {
+    /// @brief Optimize the content built by the GeometryGenerator and append it to a mesh.
+    /// @return The sub mesh of the appended content.
+    MeshData::SubMesh appendGenerated(MeshData& meshData, GeometryGenerator::MeshData& generated) {
+        MeshOptimizer::optimize(generated.Indices, generated.Vertices.data(),
+                                static_cast<uint32_t>(generated.Vertices.size()), sizeof(GeometryGenerator::Vertex),
+                                offsetof(GeometryGenerator::Vertex, Position));
+
+        MeshData::SubMesh subMesh;
+        subMesh.indexCount   = static_cast<uint32_t>(generated.Indices.size());
+        subMesh.vertexCount  = static_cast<uint32_t>(generated.Vertices.size());
+        subMesh.firstIndex   = static_cast<uint32_t>(meshData.indices.size());
+        subMesh.vertexOffset = static_cast<uint32_t>(meshData.vertices.size());
+        subMesh.aabbMin      = glm::vec3(std::numeric_limits<float>::max());
+        subMesh.aabbMax      = glm::vec3(std::numeric_limits<float>::lowest());
+        for (const GeometryGenerator::Vertex& vertex : generated.Vertices) {
+            meshData.vertices.push_back({{vertex.Position.x, vertex.Position.y, vertex.Position.z},
+                                         {vertex.Normal.x, vertex.Normal.y, vertex.Normal.z},
+                                         {vertex.TangentU.x, vertex.TangentU.y, vertex.TangentU.z},
+                                         {vertex.TexC.u, vertex.TexC.v}});
+            subMesh.aabbMin = glm::min(subMesh.aabbMin, vertex.Position);
+            subMesh.aabbMax = glm::max(subMesh.aabbMax, vertex.Position);
+        }
+        meshData.indices.insert(meshData.indices.end(), generated.Indices.begin(), generated.Indices.end());
+        return subMesh;
+    }
+
+    /// @brief Optimize the content built by the GeometryGenerator.
+    MeshData createFromGenerator(GeometryGenerator::MeshData& generated) {
+        MeshData meshData;
+        appendGenerated(meshData, generated);
+        return meshData;
+    }
+
+    /// @brief A level of the LOD chain of a generated shape.
+    struct GeneratedLod {
+        GeometryGenerator::MeshData meshData;
+        float                       error{0.0f}; ///< Distance to the LOD 0 surface, in mesh units.
+    };
+
+    /// @brief Create a mesh with one sub mesh per level, each level has its own vertices.
+    MeshData createFromGenerator(std::span<GeneratedLod> generatedLods) {
+        if (generatedLods.size() == 1) {
+            return createFromGenerator(generatedLods[0].meshData);
+        }
+
+        MeshData meshData;
+        for (GeneratedLod& generatedLod : generatedLods) {
+            meshData.lods.push_back({static_cast<uint32_t>(meshData.subMeshes.size()), 1, generatedLod.error});
+            meshData.subMeshes.push_back(appendGenerated(meshData, generatedLod.meshData));
+        }
+        return meshData;
+    }
+
+    /// @brief Distance between the middle of a chord and its arc, the error of a tessellated circle.
+    /// @param radius The radius of the circle.
+    /// @param angle  The angle between the ends of the chord, in radian.
+    float getSagitta(float radius, float angle) { return radius * (1.0f - std::cos(angle / 2.0f)); }
+};
+
+namespace MeshShapes {
+
+MeshData createBox(float width, float height, float depth) {
+    GeometryGenerator           geometryGenerator;
+    GeometryGenerator::MeshData generated;
+    geometryGenerator.createBox(width, height, depth, generated);
+
+    MeshData meshData = createFromGenerator(generated);
+    meshData.aabbMin = { -width/2, -height/2, -depth/2, };
+    meshData.aabbMax = {  width/2,  height/2,  depth/2, };
+    return meshData;
+}
+
+MeshData createGrid(float width, float depth, unsigned int nbVertexWidth, unsigned int nVertexDepth) {
+    GeometryGenerator           geometryGenerator;
+    GeometryGenerator::MeshData generated;
+    geometryGenerator.createGrid(width, depth, nbVertexWidth, nVertexDepth, generated);
+
+    MeshData meshData = createFromGenerator(generated);
+    meshData.aabbMin = { -width/2, 0, -depth/2, };
+    meshData.aabbMax = {  width/2, 0,  depth/2, };
+    return meshData;
+}
+
+MeshData createGeoSphere(float radius, unsigned int subdivisionCount) {
+    // One subdivision less per LOD down to the icosahedron, the generator caps the subdivisions at 5.
+    GeometryGenerator         geometryGenerator;
+    std::vector<GeneratedLod> generatedLods;
+    const unsigned int        maxSubdivisionCount = std::min(subdivisionCount, 5u);
+    for (unsigned int lod = 0; lod < MeshSimplifier::kMaxLodCount && lod <= maxSubdivisionCount; ++lod) {
+        GeneratedLod& generatedLod = generatedLods.emplace_back();
+        geometryGenerator.createGeoSphere(radius, maxSubdivisionCount - lod, generatedLod.meshData);
+        // An edge of the icosahedron spans 1.107 radian, each subdivision splits it in two.
+        const float edgeAngle = 1.1071487f / float(1u << (maxSubdivisionCount - lod));
+        generatedLod.error    = lod == 0 ? 0.0f : getSagitta(radius, edgeAngle);
+    }
+
+    MeshData meshData = createFromGenerator(generatedLods);
+    meshData.aabbMin = { -radius, -radius, -radius, };
+    meshData.aabbMax = {  radius,  radius,  radius, };
+    return meshData;
+}
+
+MeshData createCylinder(float        bottomRadius,
+                        float        topRadius,
+                        float        height,
+                        unsigned int sliceCount,
+                        unsigned int stackCount) {
+    // Half the slices and the stacks per LOD, the stacks are straight and can go down to 1.
+    const auto                maxRadius = std::max(bottomRadius, topRadius);
+    GeometryGenerator         geometryGenerator;
+    std::vector<GeneratedLod> generatedLods;
+    unsigned int              previousSliceCount = 0;
+    unsigned int              previousStackCount = 0;
+    for (unsigned int lod = 0; lod < MeshSimplifier::kMaxLodCount; ++lod) {
+        const unsigned int lodSliceCount = std::max(sliceCount >> lod, std::min(sliceCount, 8u));
+        const unsigned int lodStackCount = std::max(stackCount >> lod, 1u);
+        // The clamped counts stop decreasing, the LOD would be the same as the previous one.
+        if (lodSliceCount == previousSliceCount && lodStackCount == previousStackCount) {
+            break;
+        }
+        previousSliceCount = lodSliceCount;
+        previousStackCount = lodStackCount;
+        GeneratedLod& generatedLod = generatedLods.emplace_back();
+        geometryGenerator.createCylinder(bottomRadius, topRadius, height, lodSliceCount, lodStackCount,
+                                         generatedLod.meshData);
+        generatedLod.error =
+            lod == 0 ? 0.0f : getSagitta(maxRadius, 2.0f * std::numbers::pi_v<float> / float(lodSliceCount));
+    }
+
+    MeshData meshData = createFromGenerator(generatedLods);
+    meshData.aabbMin = { -maxRadius, -height/2, -maxRadius, };
+    meshData.aabbMax = {  maxRadius,  height/2,  maxRadius, };
+    return meshData;
+}
+
+MeshData createSphere(float radius, unsigned int sliceCount, unsigned int stackCount) {
+    // Half the slices and the stacks per LOD, down to 8 slices and 4 stacks.
+    GeometryGenerator         geometryGenerator;
+    std::vector<GeneratedLod> generatedLods;
+    unsigned int              previousSliceCount = 0;
+    unsigned int              previousStackCount = 0;
+    for (unsigned int lod = 0; lod < MeshSimplifier::kMaxLodCount; ++lod) {
+        const unsigned int lodSliceCount = std::max(sliceCount >> lod, std::min(sliceCount, 8u));
+        const unsigned int lodStackCount = std::max(stackCount >> lod, std::min(stackCount, 4u));
+        // The clamped counts stop decreasing, the LOD would be the same as the previous one.
+        if (lodSliceCount == previousSliceCount && lodStackCount == previousStackCount) {
+            break;
+        }
+        previousSliceCount = lodSliceCount;
+        previousStackCount = lodStackCount;
+        GeneratedLod& generatedLod = generatedLods.emplace_back();
+        geometryGenerator.createSphere(radius, lodSliceCount, lodStackCount, generatedLod.meshData);
+        const float sliceError = getSagitta(radius, 2.0f * std::numbers::pi_v<float> / float(lodSliceCount));
+        const float stackError = getSagitta(radius, std::numbers::pi_v<float> / float(lodStackCount));
+        generatedLod.error     = lod == 0 ? 0.0f : std::max(sliceError, stackError);
+    }
+
+    MeshData meshData = createFromGenerator(generatedLods);
+    meshData.aabbMin = { -radius, -radius, -radius, };
+    meshData.aabbMax = {  radius,  radius,  radius, };
+    return meshData;
+}
+
+} // namespace MeshShapes
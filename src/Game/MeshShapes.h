@@ -0,0 +1,32 @@
+#pragma once
+#include "MeshData.h"
+
+/// @brief CPU side content of the generated shapes, built by the GeometryGenerator and optimized
+///        with the MeshOptimizer.
+///
+/// The spheres and the cylinder have a LOD chain, each LOD is a sub mesh with its own vertices and
+/// the error of its tessellation. A shape whose LOD chain would have a single level has no LOD.
+/// They don't depend on Vulkan, Mesh creates the meshes from them.
+namespace MeshShapes {
+
+/// @brief Create a box centered on the origin.
+[[nodiscard]] MeshData createBox(float width, float height, float depth);
+
+/// @brief Create a grid in the XZ plane, centered on the origin.
+[[nodiscard]] MeshData createGrid(float width, float depth, unsigned int nbVertexWidth, unsigned int nVertexDepth);
+
+/// @brief Create a geodesic sphere, one subdivision less per LOD down to the icosahedron.
+/// @param subdivisionCount The subdivisions of the LOD 0, capped at 5. 0 is the icosahedron.
+[[nodiscard]] MeshData createGeoSphere(float radius, unsigned int subdivisionCount);
+
+/// @brief Create a cylinder, half the slices and stacks per LOD, down to 8 slices and 1 stack.
+[[nodiscard]] MeshData createCylinder(float        bottomRadius,
+                                      float        topRadius,
+                                      float        height,
+                                      unsigned int sliceCount,
+                                      unsigned int stackCount);
+
+/// @brief Create a UV sphere, half the slices and stacks per LOD, down to 8 slices and 4 stacks.
+[[nodiscard]] MeshData createSphere(float radius, unsigned int sliceCount, unsigned int stackCount);
+
+} // namespace MeshShapes
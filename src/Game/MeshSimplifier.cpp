@@ -0,0 +1,400 @@
+#include "MeshSimplifier.h"
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+/// @brief Symmetric 4x4 matrix, the sum of the squared distances to a set of planes.
+struct Quadric {
+    double a00{0}, a01{0}, a02{0}, a03{0};
+    double a11{0}, a12{0}, a13{0};
+    double a22{0}, a23{0};
+    double a33{0};
+
+    Quadric& operator+=(const Quadric& other) {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+        a11 += other.a11; a12 += other.a12; a13 += other.a13;
+        a22 += other.a22; a23 += other.a23;
+        a33 += other.a33;
+        return *this;
+    }
+
+    static Quadric fromPlane(double a, double b, double c, double d) {
+        Quadric q;
+        q.a00 = a * a; q.a01 = a * b; q.a02 = a * c; q.a03 = a * d;
+        q.a11 = b * b; q.a12 = b * c; q.a13 = b * d;
+        q.a22 = c * c; q.a23 = c * d;
+        q.a33 = d * d;
+        return q;
+    }
+
+    /// @brief Sum of the squared distances of a point to the planes.
+    [[nodiscard]] double evaluate(const glm::vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        const double result = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+                              a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+                              a22 * z * z + 2 * a23 * z + a33;
+        return std::max(result, 0.0);
+    }
+};
+
+/// @brief A candidate collapse of the position `from` onto the position `to`.
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double   error;
+};
+
+class Simplifier {
+public:
+    Simplifier(std::span<const uint32_t> indices, const float* positions, size_t positionStride, uint32_t vertexCount)
+        : mIndices(indices.begin(), indices.end()) {
+        mPositions.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + i * positionStride);
+            mPositions[i] = {position[0], position[1], position[2]};
+        }
+        buildPositionRemap();
+        buildQuadrics();
+        lockBorders();
+    }
+
+    /// @brief Collapse edges until the target is reached or no collapse is possible.
+    /// @return The largest quadric error of the collapses.
+    double run(uint32_t targetIndexCount, double maxError) {
+        double error = 0.0;
+        while (mIndices.size() > targetIndexCount) {
+            const uint32_t collapseCount = runPass(targetIndexCount, maxError, error);
+            if (collapseCount == 0) {
+                break;
+            }
+        }
+        return error;
+    }
+
+    std::vector<uint32_t>& getIndices() { return mIndices; }
+
+private:
+    /// @brief The first vertex at the same position of each vertex, the seams move as one position.
+    void buildPositionRemap() {
+        const auto vertexCount = static_cast<uint32_t>(mPositions.size());
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0u);
+        const auto less = [this](uint32_t a, uint32_t b) {
+            const glm::vec3& pa = mPositions[a];
+            const glm::vec3& pb = mPositions[b];
+            if (pa.x != pb.x) return pa.x < pb.x;
+            if (pa.y != pb.y) return pa.y < pb.y;
+            if (pa.z != pb.z) return pa.z < pb.z;
+            return a < b;
+        };
+        std::sort(order.begin(), order.end(), less);
+
+        mPositionOf.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            const bool same = i > 0 && mPositions[order[i]] == mPositions[order[i - 1]];
+            mPositionOf[order[i]] = same ? mPositionOf[order[i - 1]] : order[i];
+        }
+    }
+
+    /// @brief Sum the planes of the triangles around each position.
+    void buildQuadrics() {
+        mQuadrics.assign(mPositions.size(), Quadric{});
+        for (size_t i = 0; i + 2 < mIndices.size(); i += 3) {
+            const glm::vec3& p0     = mPositions[mIndices[i + 0]];
+            const glm::vec3  normal = glm::cross(mPositions[mIndices[i + 1]] - p0, mPositions[mIndices[i + 2]] - p0);
+            const float      length = glm::length(normal);
+            if (length == 0.0f) {
+                continue;
+            }
+            const glm::vec3 n       = normal / length;
+            const Quadric   quadric = Quadric::fromPlane(n.x, n.y, n.z, -glm::dot(n, p0));
+            for (int corner = 0; corner < 3; ++corner) {
+                mQuadrics[mPositionOf[mIndices[i + corner]]] += quadric;
+            }
+        }
+    }
+
+    /// @brief Lock the positions on an edge used by one triangle (open border) or more than two.
+    void lockBorders() {
+        mLocked.assign(mPositions.size(), false);
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        edgeUses.reserve(mIndices.size());
+        forEachEdge([&](uint32_t a, uint32_t b) { edgeUses[edgeKey(a, b)]++; });
+        for (const auto& [key, uses] : edgeUses) {
+            if (uses != 2) {
+                mLocked[static_cast<uint32_t>(key >> 32)]        = true;
+                mLocked[static_cast<uint32_t>(key & 0xffffffff)] = true;
+            }
+        }
+    }
+
+    static uint64_t edgeKey(uint32_t a, uint32_t b) {
+        return (uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+    }
+
+    /// @brief Call a function with the positions of each edge of each triangle.
+    template <typename Function>
+    void forEachEdge(Function&& function) const {
+        for (size_t i = 0; i + 2 < mIndices.size(); i += 3) {
+            for (int corner = 0; corner < 3; ++corner) {
+                function(mPositionOf[mIndices[i + corner]], mPositionOf[mIndices[i + (corner + 1) % 3]]);
+            }
+        }
+    }
+
+    /// @brief The triangles around each position, in mAdjacency[mAdjacencyOffsets[p], mAdjacencyOffsets[p + 1]).
+    void buildAdjacency() {
+        mAdjacencyOffsets.assign(mPositions.size() + 1, 0);
+        for (const uint32_t index : mIndices) {
+            mAdjacencyOffsets[mPositionOf[index] + 1]++;
+        }
+        std::partial_sum(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end(), mAdjacencyOffsets.begin());
+        mAdjacency.resize(mIndices.size());
+        std::vector<uint32_t> fill(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < mIndices.size(); ++i) {
+            mAdjacency[fill[mPositionOf[mIndices[i]]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::span<const uint32_t> getTriangles(uint32_t position) const {
+        return {mAdjacency.data() + mAdjacencyOffsets[position],
+                mAdjacency.data() + mAdjacencyOffsets[position + 1]};
+    }
+
+    /// @brief Check a collapse and find the vertex each vertex at `from` becomes.
+    ///
+    /// A triangle around `from` which doesn't contain `to` must not flip. Each vertex at `from`
+    /// must share a triangle with a single vertex at `to`: a seam can only collapse along itself.
+    bool prepareCollapse(const Collapse& collapse, std::vector<std::pair<uint32_t, uint32_t>>& vertexMap) const {
+        vertexMap.clear();
+        const glm::vec3& target = mPositions[collapse.to];
+        for (const uint32_t triangle : getTriangles(collapse.from)) {
+            const uint32_t* corners  = &mIndices[triangle * 3];
+            int             fromCorner = -1;
+            int             toCorner   = -1;
+            for (int corner = 0; corner < 3; ++corner) {
+                const uint32_t position = mPositionOf[corners[corner]];
+                fromCorner = position == collapse.from ? corner : fromCorner;
+                toCorner   = position == collapse.to ? corner : toCorner;
+            }
+            if (toCorner >= 0) {
+                const uint32_t from = corners[fromCorner];
+                const uint32_t to   = corners[toCorner];
+                const auto     it   = std::find_if(vertexMap.begin(), vertexMap.end(),
+                                                   [from](const auto& entry) { return entry.first == from; });
+                if (it == vertexMap.end()) {
+                    vertexMap.emplace_back(from, to);
+                } else if (it->second != to) {
+                    return false;
+                }
+                continue;
+            }
+
+            const glm::vec3& p0     = mPositions[corners[0]];
+            const glm::vec3& p1     = mPositions[corners[1]];
+            const glm::vec3& p2     = mPositions[corners[2]];
+            const glm::vec3  before = glm::cross(p1 - p0, p2 - p0);
+            glm::vec3        moved[3] = {p0, p1, p2};
+            moved[fromCorner]       = target;
+            const glm::vec3  after  = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+            // The normal may not turn by more than about 75 degrees, a flat fin is as bad as a flip.
+            if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after)) {
+                return false;
+            }
+        }
+
+        for (const uint32_t triangle : getTriangles(collapse.from)) {
+            for (int corner = 0; corner < 3; ++corner) {
+                const uint32_t vertex = mIndices[triangle * 3 + corner];
+                if (mPositionOf[vertex] == collapse.from &&
+                    std::none_of(vertexMap.begin(), vertexMap.end(),
+                                 [vertex](const auto& entry) { return entry.first == vertex; })) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// @brief Collapse the cheapest edges, the neighbourhood of a collapse is locked until the next pass.
+    /// @return The number of collapses.
+    uint32_t runPass(uint32_t targetIndexCount, double maxError, double& error) {
+        buildAdjacency();
+
+        std::vector<Collapse> collapses;
+        collapses.reserve(mIndices.size() * 2);
+        forEachEdge([&](uint32_t a, uint32_t b) {
+            if (a == b) {
+                return;
+            }
+            // Both directions, each edge is seen by its two triangles, the duplicates are removed below.
+            if (!mLocked[a]) {
+                collapses.push_back({a, b, 0.0});
+            }
+            if (!mLocked[b]) {
+                collapses.push_back({b, a, 0.0});
+            }
+        });
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+            return x.from != y.from ? x.from < y.from : x.to < y.to;
+        });
+        collapses.erase(std::unique(collapses.begin(), collapses.end(),
+                                    [](const Collapse& x, const Collapse& y) { return x.from == y.from && x.to == y.to; }),
+                        collapses.end());
+        for (Collapse& collapse : collapses) {
+            Quadric quadric = mQuadrics[collapse.from];
+            quadric += mQuadrics[collapse.to];
+            collapse.error = quadric.evaluate(mPositions[collapse.to]);
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+        // A collapse removes the triangles holding the edge, usually two.
+        const size_t trianglesToRemove = (mIndices.size() - targetIndexCount + 2) / 3;
+        size_t       trianglesRemoved  = 0;
+        uint32_t     collapseCount     = 0;
+
+        std::vector<uint32_t> vertexRemap(mPositions.size());
+        std::iota(vertexRemap.begin(), vertexRemap.end(), 0u);
+        std::vector<bool>                          passLocked(mPositions.size(), false);
+        std::vector<std::pair<uint32_t, uint32_t>> vertexMap;
+        for (const Collapse& collapse : collapses) {
+            if (collapse.error > maxError || trianglesRemoved >= trianglesToRemove) {
+                break;
+            }
+            if (passLocked[collapse.from] || passLocked[collapse.to] || !prepareCollapse(collapse, vertexMap)) {
+                continue;
+            }
+
+            for (const auto& [from, to] : vertexMap) {
+                vertexRemap[from] = to;
+            }
+            mQuadrics[collapse.to] += mQuadrics[collapse.from];
+            error = std::max(error, collapse.error);
+            collapseCount++;
+
+            // The positions of the triangles around `from` must not change again in this pass.
+            for (const uint32_t triangle : getTriangles(collapse.from)) {
+                bool degenerate = false;
+                for (int corner = 0; corner < 3; ++corner) {
+                    const uint32_t position = mPositionOf[mIndices[triangle * 3 + corner]];
+                    passLocked[position]    = true;
+                    degenerate |= position == collapse.to;
+                }
+                trianglesRemoved += degenerate ? 1 : 0;
+            }
+        }
+
+        if (collapseCount == 0) {
+            return 0;
+        }
+
+        // Remap the indices and drop the triangles with two corners at the same position.
+        size_t count = 0;
+        for (size_t i = 0; i + 2 < mIndices.size(); i += 3) {
+            const uint32_t a = vertexRemap[mIndices[i + 0]];
+            const uint32_t b = vertexRemap[mIndices[i + 1]];
+            const uint32_t c = vertexRemap[mIndices[i + 2]];
+            const uint32_t pa = mPositionOf[a];
+            const uint32_t pb = mPositionOf[b];
+            const uint32_t pc = mPositionOf[c];
+            if (pa == pb || pb == pc || pa == pc) {
+                continue;
+            }
+            mIndices[count++] = a;
+            mIndices[count++] = b;
+            mIndices[count++] = c;
+        }
+        mIndices.resize(count);
+        return collapseCount;
+    }
+
+    std::vector<uint32_t>  mIndices;
+    std::vector<glm::vec3> mPositions;
+    std::vector<uint32_t>  mPositionOf; ///< First vertex with the same position.
+    std::vector<Quadric>   mQuadrics;   ///< By position.
+    std::vector<bool>      mLocked;     ///< By position.
+    std::vector<uint32_t>  mAdjacencyOffsets;
+    std::vector<uint32_t>  mAdjacency;
+};
+
+} // namespace
+
+namespace MeshSimplifier {
+
+float simplify(std::span<const uint32_t> indices,
+               const float*              positions,
+               size_t                    positionStride,
+               uint32_t                  vertexCount,
+               uint32_t                  targetIndexCount,
+               float                     maxError,
+               std::vector<uint32_t>&    result) {
+    assert(indices.size() % 3 == 0);
+    Simplifier simplifier(indices, positions, positionStride, vertexCount);
+    const double maxQuadricError = maxError >= FLT_MAX ? DBL_MAX : double(maxError) * double(maxError);
+    const double error           = simplifier.run(targetIndexCount, maxQuadricError);
+    result                       = std::move(simplifier.getIndices());
+    return static_cast<float>(std::sqrt(error));
+}
+
+uint32_t generateLods(MeshData& meshData) {
+    if (!meshData.lods.empty()) {
+        return static_cast<uint32_t>(meshData.lods.size());
+    }
+    if (meshData.subMeshes.empty()) {
+        return 1;
+    }
+
+    const auto subMeshCount = static_cast<uint32_t>(meshData.subMeshes.size());
+    meshData.lods.push_back({0, subMeshCount, 0.0f});
+
+    std::vector<uint32_t> source;
+    std::vector<uint32_t> simplified;
+    while (meshData.lods.size() < kMaxLodCount) {
+        const MeshData::Lod previous       = meshData.lods.back();
+        const size_t        indexCountBase = meshData.indices.size();
+        uint64_t            previousCount  = 0;
+        uint64_t            lodCount       = 0;
+        float               lodError       = 0.0f;
+        for (uint32_t i = 0; i < previous.subMeshCount; ++i) {
+            MeshData::SubMesh subMesh = meshData.subMeshes[previous.firstSubMesh + i];
+            source.assign(meshData.indices.begin() + subMesh.firstIndex,
+                          meshData.indices.begin() + subMesh.firstIndex + subMesh.indexCount);
+
+            const uint32_t target = subMesh.indexCount / 2 / 3 * 3;
+            const float    error  = simplify(source, meshData.vertices[subMesh.vertexOffset].position,
+                                             sizeof(MeshVertex), subMesh.vertexCount, target, FLT_MAX, simplified);
+            MeshOptimizer::optimizeVertexCache(simplified, subMesh.vertexCount);
+
+            previousCount += subMesh.indexCount;
+            lodCount += simplified.size();
+            lodError = std::max(lodError, error);
+
+            subMesh.firstIndex = static_cast<uint32_t>(meshData.indices.size());
+            subMesh.indexCount = static_cast<uint32_t>(simplified.size());
+            meshData.indices.insert(meshData.indices.end(), simplified.begin(), simplified.end());
+            meshData.subMeshes.push_back(subMesh);
+        }
+
+        // Not worth a LOD, the borders and seams are probably all that is left.
+        if (lodCount * 4 > previousCount * 3) {
+            meshData.indices.resize(indexCountBase);
+            meshData.subMeshes.resize(meshData.subMeshes.size() - previous.subMeshCount);
+            break;
+        }
+        // The error of a LOD is measured from the previous one, it adds up.
+        meshData.lods.push_back({previous.firstSubMesh + previous.subMeshCount, previous.subMeshCount,
+                                 previous.error + lodError});
+    }
+    return static_cast<uint32_t>(meshData.lods.size());
+}
+
+} // namespace MeshSimplifier
@@ -0,0 +1,50 @@
+#pragma once
+#include "MeshData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// @brief Simplification of indexed triangle lists and generation of the LOD chain of a mesh.
+///
+/// Edge collapses ordered by quadric error (Garland and Heckbert 1997). A collapse moves a vertex
+/// onto a neighbour (half edge collapse), so the simplified index list references the vertices of
+/// the source and the LODs share the vertex buffer of LOD 0.
+///
+/// The vertices sharing a position (UV or normal seams) move together, a seam vertex only moves
+/// along the seam. The vertices on an open border never move, the silhouette of an open mesh is kept.
+///
+/// They don't depend on Vulkan.
+namespace MeshSimplifier {
+
+/// @brief Maximum number of LODs of a mesh, LOD 0 included.
+constexpr uint32_t kMaxLodCount = 4;
+
+/// @brief Simplify a triangle list.
+/// @param indices          The triangle list.
+/// @param positions        The position (3 floats) of the first vertex.
+/// @param positionStride   The distance in bytes between two positions.
+/// @param vertexCount      The number of vertices.
+/// @param targetIndexCount The simplification stops once the result has this number of indices or less.
+/// @param maxError         The collapses with a larger error are rejected, in mesh units.
+/// @param result           The simplified triangle list, it references the same vertices.
+/// @return The error of the simplification, an estimation of the largest distance to the source surface.
+float simplify(std::span<const uint32_t> indices,
+               const float*              positions,
+               size_t                    positionStride,
+               uint32_t                  vertexCount,
+               uint32_t                  targetIndexCount,
+               float                     maxError,
+               std::vector<uint32_t>&    result);
+
+/// @brief Append the LODs 1 and more to a mesh, each one has about half the triangles of the previous.
+///
+/// Each sub mesh is simplified on its own, the simplified lists are appended to the indices and
+/// their sub meshes to the sub meshes. The chain stops when a LOD is not at least 25% smaller.
+/// Do nothing if the mesh has no sub mesh or already has LODs.
+///
+/// @return The number of LODs, LOD 0 included.
+uint32_t generateLods(MeshData& meshData);
+
+} // namespace MeshSimplifier
@@ -0,0 +1,289 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+constexpr uint32_t kInvalid = UINT32_MAX;
+
+glm::vec3 getPosition(const float* positions, size_t positionStride, uint32_t index) {
+    const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + index * positionStride);
+    return {position[0], position[1], position[2]};
+}
+
+/// @brief The first vertex at the same position of each vertex, the meshlets grow across the seams.
+std::vector<uint32_t> buildPositionRemap(const std::vector<glm::vec3>& points) {
+    const auto            vertexCount = static_cast<uint32_t>(points.size());
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&points](uint32_t a, uint32_t b) {
+        const glm::vec3& pa = points[a];
+        const glm::vec3& pb = points[b];
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b;
+    });
+
+    std::vector<uint32_t> positionOf(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        const bool same       = i > 0 && points[order[i]] == points[order[i - 1]];
+        positionOf[order[i]] = same ? positionOf[order[i - 1]] : order[i];
+    }
+    return positionOf;
+}
+
+} // namespace
+
+namespace MeshletBuilder {
+
+uint32_t build(std::span<uint32_t>             indices,
+               const float*                    positions,
+               size_t                          positionStride,
+               uint32_t                        vertexCount,
+               std::vector<MeshData::Meshlet>& meshlets) {
+    const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0 || vertexCount == 0) {
+        return 0;
+    }
+
+    std::vector<glm::vec3> points(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        points[i] = getPosition(positions, positionStride, i);
+    }
+    const std::vector<uint32_t> positionOf = buildPositionRemap(points);
+
+    // Triangles around each position.
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t i = 0; i < triangleCount * 3; ++i) {
+        adjacencyOffsets[positionOf[indices[i]] + 1]++;
+    }
+    std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (uint32_t i = 0; i < triangleCount * 3; ++i) {
+            adjacency[fill[positionOf[indices[i]]]++] = i / 3;
+        }
+    }
+
+    // Triangles not yet emitted around each position.
+    std::vector<uint32_t> liveCounts(vertexCount, 0);
+    for (uint32_t position = 0; position < vertexCount; ++position) {
+        liveCounts[position] = adjacencyOffsets[position + 1] - adjacencyOffsets[position];
+    }
+
+    std::vector<glm::vec3> centroids(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        centroids[t] = (points[indices[t * 3]] + points[indices[t * 3 + 1]] + points[indices[t * 3 + 2]]) / 3.0f;
+    }
+
+    // The marks hold the id of the meshlet being built, nothing to clear between two meshlets.
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> vertexMark(vertexCount, kInvalid);
+    std::vector<uint32_t> positionMark(vertexCount, kInvalid);
+    std::vector<uint32_t> candidateMark(triangleCount, kInvalid);
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> triangles;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    const auto firstMeshlet = static_cast<uint32_t>(meshlets.size());
+    uint32_t   nextSeed     = 0;
+    for (uint32_t meshletId = 0; result.size() < triangleCount * 3; ++meshletId) {
+        // Continue next to the previous meshlet, or from the first triangle left in the cache order.
+        // The most cornered triangle is taken, the one with the fewest neighbours left.
+        uint32_t seed      = kInvalid;
+        uint32_t seedScore = UINT32_MAX;
+        for (const uint32_t candidate : candidates) {
+            if (emitted[candidate]) {
+                continue;
+            }
+            uint32_t score = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                score += liveCounts[positionOf[indices[candidate * 3 + corner]]];
+            }
+            if (score < seedScore) {
+                seed      = candidate;
+                seedScore = score;
+            }
+        }
+        if (seed == kInvalid) {
+            while (emitted[nextSeed]) {
+                ++nextSeed;
+            }
+            seed = nextSeed;
+        }
+
+        candidates.assign(1, seed);
+        candidateMark[seed] = meshletId;
+        triangles.clear();
+        uint32_t  meshletVertexCount = 0;
+        glm::vec3 positionSum(0.0f);
+        while (triangles.size() < kMaxTriangleCount) {
+            uint32_t best         = kInvalid;
+            uint32_t bestNewCount = 4;
+            bool     bestIsolated = false;
+            float    bestDistance = FLT_MAX;
+            const glm::vec3 center = meshletVertexCount ? positionSum / float(meshletVertexCount) : centroids[seed];
+            for (size_t c = 0; c < candidates.size();) {
+                const uint32_t triangle = candidates[c];
+                if (emitted[triangle]) {
+                    candidates[c] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                ++c;
+
+                const uint32_t a = indices[triangle * 3], b = indices[triangle * 3 + 1], d = indices[triangle * 3 + 2];
+                const uint32_t newCount = (vertexMark[a] != meshletId) + (vertexMark[b] != meshletId && b != a) +
+                                          (vertexMark[d] != meshletId && d != a && d != b);
+                if (meshletVertexCount + newCount > kMaxVertexCount) {
+                    continue;
+                }
+                // A triangle about to be left alone around one of its positions is taken first,
+                // otherwise it ends up in a meshlet of its own.
+                const bool isolated = std::min({liveCounts[positionOf[a]], liveCounts[positionOf[b]],
+                                                liveCounts[positionOf[d]]}) <= 1;
+                const glm::vec3 offset   = centroids[triangle] - center;
+                const float     distance = glm::dot(offset, offset);
+                if (isolated > bestIsolated ||
+                    (isolated == bestIsolated && (newCount < bestNewCount ||
+                                                  (newCount == bestNewCount && distance < bestDistance)))) {
+                    best         = triangle;
+                    bestNewCount = newCount;
+                    bestIsolated = isolated;
+                    bestDistance = distance;
+                }
+            }
+            if (best == kInvalid) {
+                break;
+            }
+
+            emitted[best] = true;
+            triangles.push_back(best);
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                liveCounts[positionOf[indices[best * 3 + corner]]]--;
+            }
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                const uint32_t vertex = indices[best * 3 + corner];
+                if (vertexMark[vertex] != meshletId) {
+                    vertexMark[vertex] = meshletId;
+                    meshletVertexCount++;
+                    positionSum += points[vertex];
+                }
+                const uint32_t position = positionOf[vertex];
+                if (positionMark[position] == meshletId) {
+                    continue;
+                }
+                positionMark[position] = meshletId;
+                for (uint32_t i = adjacencyOffsets[position]; i < adjacencyOffsets[position + 1]; ++i) {
+                    const uint32_t neighbour = adjacency[i];
+                    if (!emitted[neighbour] && candidateMark[neighbour] != meshletId) {
+                        candidateMark[neighbour] = meshletId;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+        }
+        assert(!triangles.empty());
+
+        const auto firstIndex = static_cast<uint32_t>(result.size());
+        for (const uint32_t triangle : triangles) {
+            result.insert(result.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+        }
+        MeshData::Meshlet meshlet = computeBounds(std::span(result).subspan(firstIndex), positions, positionStride);
+        meshlet.firstIndex        = firstIndex;
+        meshlet.triangleCount     = static_cast<uint32_t>(triangles.size());
+        meshlet.vertexCount       = meshletVertexCount;
+        meshlets.push_back(meshlet);
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin());
+    return static_cast<uint32_t>(meshlets.size()) - firstMeshlet;
+}
+
+MeshData::Meshlet computeBounds(std::span<const uint32_t> indices, const float* positions, size_t positionStride) {
+    MeshData::Meshlet meshlet;
+    if (indices.empty()) {
+        return meshlet;
+    }
+
+    // Sphere around the center of the AABB.
+    glm::vec3 aabbMin(FLT_MAX);
+    glm::vec3 aabbMax(-FLT_MAX);
+    for (const uint32_t index : indices) {
+        const glm::vec3 position = getPosition(positions, positionStride, index);
+        aabbMin                  = glm::min(aabbMin, position);
+        aabbMax                  = glm::max(aabbMax, position);
+    }
+    meshlet.center = (aabbMin + aabbMax) * 0.5f;
+    for (const uint32_t index : indices) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(getPosition(positions, positionStride, index) - meshlet.center));
+    }
+
+    // The axis is the average of the unit normals, the cone is as wide as the farthest normal.
+    std::vector<glm::vec3> normals;
+    normals.reserve(indices.size() / 3);
+    glm::vec3 axis(0.0f);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3 a      = getPosition(positions, positionStride, indices[i]);
+        const glm::vec3 b      = getPosition(positions, positionStride, indices[i + 1]);
+        const glm::vec3 c      = getPosition(positions, positionStride, indices[i + 2]);
+        const glm::vec3 normal = glm::cross(b - a, c - a);
+        const float     length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+    }
+
+    const float axisLength = glm::length(axis);
+    if (axisLength < 1e-6f) {
+        return meshlet;
+    }
+    meshlet.coneAxis = axis / axisLength;
+
+    float minDot = 1.0f;
+    for (const glm::vec3& normal : normals) {
+        minDot = std::min(minDot, glm::dot(meshlet.coneAxis, normal));
+    }
+    // The normals are within acos(minDot) of the axis, a view direction within 90 - acos(minDot)
+    // of the axis sees all the triangles from behind: the cutoff is cos(90 - acos(minDot)).
+    meshlet.coneCutoff = minDot <= 0.0f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+    return meshlet;
+}
+
+bool isBackFacing(const MeshData::Meshlet& meshlet, const glm::vec3& viewPosition) {
+    if (meshlet.coneCutoff >= 1.0f) {
+        return false;
+    }
+    // Every point of the bounding sphere must see the cone from behind, the radius widens the test.
+    const glm::vec3 direction = meshlet.center - viewPosition;
+    return glm::dot(direction, meshlet.coneAxis) >=
+           meshlet.coneCutoff * glm::length(direction) + meshlet.radius * (1.0f + meshlet.coneCutoff);
+}
+
+uint32_t buildMeshlets(MeshData& meshData) {
+    if (!meshData.meshlets.empty()) {
+        return static_cast<uint32_t>(meshData.meshlets.size());
+    }
+
+    for (MeshData::SubMesh& subMesh : meshData.subMeshes) {
+        subMesh.firstMeshlet = static_cast<uint32_t>(meshData.meshlets.size());
+        subMesh.meshletCount = 0;
+        if (subMesh.vertexCount == 0 || subMesh.indexCount == 0) {
+            continue;
+        }
+        const std::span<uint32_t> indices(meshData.indices.data() + subMesh.firstIndex, subMesh.indexCount);
+        subMesh.meshletCount = build(indices, meshData.vertices[subMesh.vertexOffset].position, sizeof(MeshVertex),
+                                     subMesh.vertexCount, meshData.meshlets);
+    }
+    return static_cast<uint32_t>(meshData.meshlets.size());
+}
+
+} // namespace MeshletBuilder
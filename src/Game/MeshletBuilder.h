@@ -0,0 +1,55 @@
+#pragma once
+#include "MeshData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// @brief Split of triangle lists into meshlets, small clusters culled one by one on the GPU.
+///
+/// A meshlet grows greedily from a seed triangle, the next triangle is the one adding the fewest
+/// vertices and nearest to the meshlet center, among the triangles sharing a position with the
+/// meshlet (the UV and normal seams don't stop a meshlet). The triangles of a meshlet are made
+/// contiguous in the index list, a meshlet is drawn with a single indexed draw.
+///
+/// Each meshlet has a bounding sphere and a cone of its triangle normals, which is used to cull
+/// the meshlets facing away from the camera. The front faces are counter clockwise.
+///
+/// They don't depend on Vulkan.
+namespace MeshletBuilder {
+
+/// @brief Maximum number of distinct vertices of a meshlet.
+constexpr uint32_t kMaxVertexCount = 64;
+/// @brief Maximum number of triangles of a meshlet.
+constexpr uint32_t kMaxTriangleCount = 124;
+
+/// @brief Split a triangle list into meshlets, the triangles are reordered meshlet by meshlet.
+/// @param indices        The triangle list, reordered in place.
+/// @param positions      The position (3 floats) of the first vertex.
+/// @param positionStride The distance in bytes between two positions.
+/// @param vertexCount    The number of vertices.
+/// @param meshlets       The meshlets are appended, their first index is from the start of indices.
+/// @return The number of meshlets appended.
+uint32_t build(std::span<uint32_t>             indices,
+               const float*                    positions,
+               size_t                          positionStride,
+               uint32_t                        vertexCount,
+               std::vector<MeshData::Meshlet>& meshlets);
+
+/// @brief Compute the bounding sphere and the normal cone of a set of triangles.
+/// @return A meshlet with the bounds of the triangles, the index range is not set.
+[[nodiscard]] MeshData::Meshlet computeBounds(std::span<const uint32_t> indices,
+                                              const float*              positions,
+                                              size_t                    positionStride);
+
+/// @brief Return true if all the triangles of a meshlet face away from a point, in mesh units.
+///        Conservative, same test as the GPU culling pass.
+[[nodiscard]] bool isBackFacing(const MeshData::Meshlet& meshlet, const glm::vec3& viewPosition);
+
+/// @brief Build the meshlets of each sub mesh (the LODs included) and fill their meshlet ranges.
+///        Do nothing if the mesh already has meshlets.
+/// @return The number of meshlets of the mesh.
+uint32_t buildMeshlets(MeshData& meshData);
+
+} // namespace MeshletBuilder
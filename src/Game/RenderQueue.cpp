@@ -0,0 +1,69 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+constexpr uint32_t kPipelineBits = 4;
+constexpr uint32_t kMaterialBits = 16;
+constexpr uint32_t kMeshBits     = 20;
+constexpr uint32_t kDepthBits    = 24;
+static_assert(kPipelineBits + kMaterialBits + kMeshBits + kDepthBits == 64);
+
+constexpr uint64_t mask(uint32_t bits) { return (uint64_t(1) << bits) - 1; }
+} // namespace
+
+uint64_t RenderQueue::MakeKey(uint32_t pipeline,
+                              uint32_t material,
+                              uint32_t mesh,
+                              float    depth,
+                              float    maxDepth) {
+    const float normalized = maxDepth > 0.f ? std::clamp(depth / maxDepth, 0.f, 1.f) : 0.f;
+    const auto  quantized  = static_cast<uint64_t>(normalized * float(mask(kDepthBits)));
+
+    uint64_t key = 0;
+    key |= (pipeline & mask(kPipelineBits)) << (kMaterialBits + kMeshBits + kDepthBits);
+    key |= (material & mask(kMaterialBits)) << (kMeshBits + kDepthBits);
+    key |= (mesh & mask(kMeshBits)) << kDepthBits;
+    key |= quantized & mask(kDepthBits);
+    return key;
+}
+
+void RenderQueue::sort() {
+    if (mItems.size() < 2) {
+        return;
+    }
+
+    // One histogram per byte, built in a single pass over the keys.
+    std::array<std::array<uint32_t, 256>, 8> histograms{};
+    for (const Item& item : mItems) {
+        for (uint32_t pass = 0; pass < 8; ++pass) {
+            histograms[pass][(item.key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    mScratch.resize(mItems.size());
+    const auto count = static_cast<uint32_t>(mItems.size());
+    for (uint32_t pass = 0; pass < 8; ++pass) {
+        auto& histogram = histograms[pass];
+
+        // All the keys share this byte, the pass would not move anything.
+        // This is the common case for the pipeline and the high material bits.
+        const uint32_t firstByte = (mItems[0].key >> (pass * 8)) & 0xFF;
+        if (histogram[firstByte] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram) {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (const Item& item : mItems) {
+            mScratch[histogram[(item.key >> (pass * 8)) & 0xFF]++] = item;
+        }
+        mItems.swap(mScratch);
+    }
+}
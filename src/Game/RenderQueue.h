@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/// @brief Sort the draws of a pass with packed 64 bits keys.
+///
+/// The key is compared as a plain integer, from the most to the least significant bits:
+///   [63..60] pipeline   (4 bits)
+///   [59..44] material   (16 bits)
+///   [43..24] mesh       (20 bits)
+///   [23..0]  depth      (24 bits, front to back)
+/// so the draws sharing the same pipeline, then material, then geometry end up next
+/// to each other. The ids are masked to their field, a collision only degrades the
+/// sort, the emitter must still compare the real handles before skipping a bind.
+class RenderQueue {
+public:
+    struct Item {
+        uint64_t key;
+        uint32_t index; ///< Index of the draw in the caller array.
+    };
+
+    /// @brief Build a sort key.
+    /// @param pipeline Id of the pipeline.
+    /// @param material Id of the material descriptor set.
+    /// @param mesh     Id of the mesh buffers.
+    /// @param depth    Distance to the camera, clamped to [0, maxDepth].
+    /// @param maxDepth Distance mapped to the largest depth value.
+    [[nodiscard]] static uint64_t MakeKey(uint32_t pipeline,
+                                          uint32_t material,
+                                          uint32_t mesh,
+                                          float    depth,
+                                          float    maxDepth);
+
+    void clear() { mItems.clear(); }
+    void reserve(size_t count) { mItems.reserve(count); }
+    void push(uint64_t key, uint32_t index) { mItems.push_back({key, index}); }
+
+    /// @brief Sort the items by key (LSD radix sort, stable).
+    void sort();
+
+    [[nodiscard]] const std::vector<Item>& getItems() const { return mItems; }
+    [[nodiscard]] size_t size() const { return mItems.size(); }
+    [[nodiscard]] bool empty() const { return mItems.empty(); }
+
+private:
+    std::vector<Item> mItems;
+    std::vector<Item> mScratch;
+};
@@ -1,32 +1,54 @@
 #include "Renderer.h"
 
-void Renderer::Init() {}
+#include "vulkan/VulkanDepthPyramid.h"
+#include "vulkan/VulkanGeometryArena.h"
+#include "vulkan/VulkanMipGenerator.h"
+#include "vulkan/VulkanUploader.h"
 
-void Renderer::Shutdown() {}
+void Renderer::Init() {
+    VulkanUploader::Init();
+    VulkanMipGenerator::Init();
+    VulkanDepthPyramid::Init();
+    VulkanGeometryArena::Init();
+}
 
-void Renderer::DrawMesh(VkCommandBuffer cmd, const Mesh& mesh) {
-    VkDeviceSize offset = 0;
-    VkBuffer     vBuffer = mesh.vertexBuffer->getBuffer();
-    if(mesh.subMeshs.size()) {
-#if 0
-        for(const auto& subMesh : mesh.subMeshs) {
+void Renderer::Shutdown() {
+    VulkanGeometryArena::Shutdown();
+    VulkanDepthPyramid::Shutdown();
+    VulkanMipGenerator::Shutdown();
+    VulkanUploader::Shutdown();
+}
 
-            offset = subMesh.vertexBufferOffset;
-            vkCmdBindVertexBuffers(cmd, 0, 1, &vBuffer, &offset);
-            vkCmdBindIndexBuffer(cmd, mesh.indexBuffer->getBuffer(), subMesh.indexBufferOffset, VK_INDEX_TYPE_UINT32);
-            vkCmdDrawIndexed(cmd, subMesh.nbIndices, 1/*intance count*/, 0/*firstIndex*/, 0/*vertexOffset*/, 0/*firstInstance*/);
-        }
-#else
-        vkCmdBindVertexBuffers(cmd, 0, 1, &vBuffer, &offset);
-        vkCmdBindIndexBuffer(cmd, mesh.indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-        for(const auto& subMesh : mesh.subMeshs) {
-            vkCmdDrawIndexed(cmd, subMesh.nbIndices, 1/*intance count*/, subMesh.firstIndex/*firstIndex*/, subMesh.vertexOffset/*vertexOffset*/, 0/*firstInstance*/);
+void Renderer::BindMesh(VkCommandBuffer cmd, const Mesh& mesh) {
+    VulkanGeometryArena::bindVertexBuffer(cmd);
+    VulkanGeometryArena::bindIndexBuffer(cmd, mesh.indexType);
+}
+
+uint32_t Renderer::DrawMesh(VkCommandBuffer cmd,
+                            const Mesh&     mesh,
+                            uint32_t        instanceCount,
+                            uint32_t        firstInstance) {
+    if (!mesh.geometry) {
+        return 0;
+    }
+    BindMesh(cmd, mesh);
+    return DrawSubMeshes(cmd, mesh, instanceCount, firstInstance);
+}
+
+uint32_t Renderer::DrawSubMeshes(VkCommandBuffer cmd,
+                                 const Mesh&     mesh,
+                                 uint32_t        instanceCount,
+                                 uint32_t        firstInstance,
+                                 uint32_t        lod) {
+    if(mesh.subMeshs.size()) {
+        const std::span<const Mesh::SubMesh> subMeshes = mesh.getSubMeshes(lod);
+        for(const auto& subMesh : subMeshes) {
+            vkCmdDrawIndexed(cmd, subMesh.nbIndices, instanceCount, subMesh.firstIndex/*firstIndex*/, subMesh.vertexOffset/*vertexOffset*/, firstInstance);
         }
-#endif
+        return static_cast<uint32_t>(subMeshes.size());
     }
     else {
-        vkCmdBindVertexBuffers(cmd, 0, 1, &vBuffer, &offset);
-        vkCmdBindIndexBuffer(cmd, mesh.indexBuffer->getBuffer(), offset, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(cmd, mesh.indexCount, 1, 0, 0, 0);
+        vkCmdDrawIndexed(cmd, mesh.indexCount, instanceCount, mesh.firstIndex, mesh.vertexOffset, firstInstance);
+        return 1;
     }
 }
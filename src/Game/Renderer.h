@@ -6,5 +6,30 @@ class Renderer {
 public:
     static void Init();
     static void Shutdown();
-    static void DrawMesh(VkCommandBuffer cmd, const Mesh& mesh);
+
+    /// @brief Bind the VulkanGeometryArena buffers with the index type of a mesh.
+    ///        All the meshes of the same index type can then be drawn with DrawSubMeshes().
+    static void BindMesh(VkCommandBuffer cmd, const Mesh& mesh);
+
+    /// @brief Record the draw calls of a mesh.
+    /// @param cmd           The command buffer to record into.
+    /// @param mesh          The mesh to draw.
+    /// @param instanceCount The number of instances to draw.
+    /// @param firstInstance The instance index of the first instance.
+    /// @return The number of draw calls recorded, 0 for a mesh without geometry.
+    static uint32_t DrawMesh(VkCommandBuffer cmd,
+                             const Mesh&     mesh,
+                             uint32_t        instanceCount = 1,
+                             uint32_t        firstInstance = 0);
+
+    /// @brief Record the draw calls of a mesh without binding the buffers, they are drawn with the
+    ///        firstIndex and vertexOffset of the mesh in the arena. BindMesh() must have been called
+    ///        for a mesh of the same index type.
+    /// @param lod The LOD to draw, clamped to the LODs of the mesh.
+    /// @return The number of draw calls recorded.
+    static uint32_t DrawSubMeshes(VkCommandBuffer cmd,
+                                  const Mesh&     mesh,
+                                  uint32_t        instanceCount = 1,
+                                  uint32_t        firstInstance = 0,
+                                  uint32_t        lod           = 0);
 };
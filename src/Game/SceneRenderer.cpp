@@ -1,15 +1,25 @@
 #include "SceneRenderer.h"
 
+#include "LightClusters.h"
+#include "MeshSimplifier.h"
 #include "Renderer.h"
+#include "VertexQuantization.h"
 
 #include "vulkan/VulkanContext.h"
 #include "vulkan/VulkanTexture.h"
 #include "vulkan/VulkanShaderProgram.h"
 #include "vulkan/VulkanGraphicPipeline.h"
+#include "vulkan/VulkanComputePipeline.h"
+#include "vulkan/VulkanGeometryArena.h"
+#include "vulkan/VulkanUtils.h"
 
 #include <glm/gtc/matrix_transform.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/euler_angles.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 
 namespace {
     void planeNormalize(glm::vec4& v) {
@@ -52,43 +62,15 @@ struct TerrainSetting {
 	float maxTess;
 };
 
-struct PointLight {
-    glm::vec4 position;
-    glm::vec4 ambient;
-    glm::vec4 diffuse;
-    glm::vec4 specular;
-    float range;
-    float intensity;
-    float constant;
-    float linear;
-    float quadratic;
-    float pad0;
-    float pad1;
-    float pad2;
-};
-//static_assert(sizeof(PointLight) == sizeof(float) * 22);
-struct DirectionalLight {
-    glm::vec4 color;
-    glm::vec4 direction;
-};
-struct SpotLight {
-    glm::vec4 color;
-    glm::vec4 position;
-    glm::vec4 direction;
-    float     range;
-    float     cutOffInner;
-    float     cutOffOuter;
-    float     pad1;
-};
+// The lights are in the storage buffers of the LightSystem.
 struct LightData {
     uint32_t nbLight;
     uint32_t nbDirectionalLight;
     uint32_t nbSpotLight;
     uint32_t _pad2;
-    PointLight lights[512];
-    DirectionalLight directionalLight[4];
-    SpotLight        spotLights[4];
+    LightClusters::Grid clusterGrid;
 };
+static_assert(offsetof(LightData, clusterGrid) == 16);
 
 
 struct PushData {
@@ -102,9 +84,149 @@ struct PushData {
 };
 static_assert(sizeof(PushData) == sizeof(float) * 47);
 
-SceneRenderer::SceneRenderer() {
+// Per instance data of the instanced mesh pass.
+// Must match InstanceData in mesh.slang (std430 layout).
+struct InstanceData {
+    glm::mat4 transform;
+    glm::mat4 normalMatrix;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    glm::vec2 texScale;
+    float     shininess;
+    float     _pad;
+};
+static_assert(sizeof(InstanceData) == 192);
+
+// Input of the GPU culling pass, one per (instance, sub mesh) or (instance, meshlet).
+// Must match CullItem in mesh_cull.slang (std430 layout).
+struct CullItem {
+    glm::vec4 aabbMin;
+    glm::vec4 aabbMax;
+    glm::vec4 cone;       ///< World space normal cone of a meshlet, axis and cutoff. w >= 1 disables the cone test.
+    uint32_t  indexCount;
+    uint32_t  firstIndex;
+    int32_t   vertexOffset;
+    uint32_t  firstInstance;
+    uint32_t  drawCountIndex;
+    uint32_t  firstCommand;
+    float     coneRadius; ///< Bounding sphere radius around the AABB center, for the cone test.
+    uint32_t  _pad;
+};
+static_assert(sizeof(CullItem) == 80);
+
+// Cone of the cull items without cone test.
+constexpr glm::vec4 kNoCone{0.0f, 0.0f, 0.0f, 1.0f};
+
+// Modes of the GPU culling pass, must match kCullMode in mesh_cull.slang.
+constexpr uint32_t kCullModeFrustum = 0;
+constexpr uint32_t kCullModeEarly   = 1;
+constexpr uint32_t kCullModeLate    = 2;
+
+// Must match PushData in mesh_cull.slang.
+struct CullPushData {
+    uint32_t itemCount;
+    uint32_t mode;
+    uint32_t commandOffset;
+    uint32_t counterOffset;
+    uint32_t depthWidth;
+    uint32_t depthHeight;
+    uint32_t levelCount;
+};
+
+// Scopes of the GPU timer, reported in SceneRendererStats.
+constexpr uint32_t kGpuScopeCulling      = 0;
+constexpr uint32_t kGpuScopeDepthPrepass = 1;
+constexpr uint32_t kGpuScopeMeshPass     = 2;
+constexpr uint32_t kGpuScopeLightClusters = 3;
+constexpr uint32_t kGpuScopeCount        = 4;
+
+// Minimum number of draws recorded by a mesh pass chunk, smaller chunks cost more than they save.
+constexpr uint32_t kMinMeshChunkSize = 64;
+
+namespace {
+    // Vertex input of the mesh pipelines, see VSInput and PackedVSInput in mesh.slang.
+    // The depth only pipelines read the position only, from the same vertex buffer.
+    void setMeshVertexInput(VulkanGraphicPipelineCreateInfo& createInfo, MeshVertexFormat vertexFormat,
+                            bool positionOnly = false) {
+        createInfo.vertexStride = VertexQuantization::getVertexSize(vertexFormat);
+        if (vertexFormat == MeshVertexFormat::Packed) {
+            createInfo.vertexInput = {
+                {0, 0, VK_FORMAT_R16G16B16A16_UINT, offsetof(PackedMeshVertex, position)},
+                {1, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedMeshVertex, normal)},
+                {2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedMeshVertex, tangent)},
+                {3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedMeshVertex, uv)}
+            };
+        } else {
+            createInfo.vertexInput = {
+                {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, position)},
+                {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, normal)},
+                {2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, tangent)},
+                {3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(MeshVertex, uv)}
+            };
+        }
+        if (positionOnly) {
+            createInfo.vertexInput.resize(1);
+        }
+    }
+
+    // Create the depth pre-pass and the lit after pre-pass variants of a mesh pipeline. The depth
+    // pipeline only has the vertex stage of depthShader, it uses the layout of the lit shader so
+    // the same descriptor sets are bound.
+    void createMeshPassVariants(VulkanGraphicPipelineCreateInfo      createInfo,
+                                MeshVertexFormat                     vertexFormat,
+                                std::shared_ptr<VulkanShaderProgram> depthShader,
+                                VulkanGraphicPipelinePtr&            depthPipeline,
+                                VulkanGraphicPipelinePtr&            equalPipeline) {
+        const std::string name = createInfo.name;
+
+        createInfo.name           = name + "Equal";
+        createInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+        createInfo.depthWrite     = false;
+        equalPipeline             = VulkanGraphicPipeline::Create(createInfo);
+        assert(equalPipeline);
+
+        createInfo.name           = name + "Depth";
+        createInfo.layoutShader   = createInfo.shader;
+        createInfo.shader         = std::move(depthShader);
+        createInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+        createInfo.depthWrite     = true;
+        createInfo.colorWrite     = false;
+        setMeshVertexInput(createInfo, vertexFormat, true /*positionOnly*/);
+        depthPipeline = VulkanGraphicPipeline::Create(createInfo);
+        assert(depthPipeline);
+    }
+} // namespace
+
+// Pipeline id of the mesh pass in the render queue keys, the packed meshes are drawn after the others.
+constexpr uint32_t kMeshPipelineSortId       = 0;
+constexpr uint32_t kMeshPackedPipelineSortId = 1;
+// Distance mapped to the farthest depth of the render queue keys (camera far plane).
+constexpr float kMaxSortDepth = 1000.0f;
+
+// Capacity of a frame region of the frame allocator, the per frame uniform blocks each padded
+// up to the offset alignment, with room for the passes added later.
+constexpr uint64_t kFrameAllocatorSize =
+    2 * (sizeof(PerFrameData) + sizeof(LightData) + 2 * VulkanLinearAllocator::kMaxAlignment);
+
+SceneRenderer::SceneRenderer(uint32_t frameInFlightCount)
+    : mFrameInFlightCount(std::clamp(frameInFlightCount, 1u, MAX_FRAME_IN_FLIGHT)) {
      mDescriptorPool.init();
 
+    // One command pool per worker thread and per frame in flight, a command pool must not
+    // be used by two threads at once nor be reset while its command buffers are pending.
+    for (uint32_t frame = 0; frame < mFrameInFlightCount; ++frame) {
+        mRecordContexts[frame].resize(mThreadPool.getThreadCount());
+        for (RecordContext& context : mRecordContexts[frame]) {
+            context.commandPool = VulkanContext::createCommandPool(VulkanContext::getGraphicQueueFamilyIndex(),
+                                                                   true /*transient*/, false /*reset*/);
+        }
+    }
+
+    // PerFrameData and LightData are sub allocated every frame and bound with dynamic offsets.
+    mFrameAllocator.init("FrameUniforms", kFrameAllocatorSize, mFrameInFlightCount);
+    mGpuTimer.init("SceneGpuTimer", kGpuScopeCount, mFrameInFlightCount);
+
     mMeshShader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_vert.spv", "./shaders/mesh_frag.spv"});
     VulkanContext::setDebugObjectName((uint64_t)mMeshShader->getPipelineLayout(), VK_OBJECT_TYPE_PIPELINE_LAYOUT, "MeshPipelineLayout" );
     bool a = mMeshShader->hasShaderStage(VK_SHADER_STAGE_VERTEX_BIT);
@@ -114,55 +236,55 @@ SceneRenderer::SceneRenderer() {
 
     // Mesh pipeline
     {
-        VulkanBufferCreateInfo bufferCreateInfo{};
-        bufferCreateInfo.name           = "PerFrameData";
-        bufferCreateInfo.sizeInByte     = sizeof(PerFrameData);
-        bufferCreateInfo.usage          = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        mPerFrameBuffer                 = VulkanBuffer::Create(bufferCreateInfo);
-
-        bufferCreateInfo.name           = "LightData";
-        bufferCreateInfo.sizeInByte     = sizeof(LightData);
-        bufferCreateInfo.usage          = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        mLightDataBuffer                = VulkanBuffer::Create(bufferCreateInfo);
-
         VulkanGraphicPipelineCreateInfo createInfo{};
         createInfo.name = "meshPipeline";
         createInfo.shader = mMeshShader;
         createInfo.cullMode = VK_CULL_MODE_NONE;
-        createInfo.vertexStride = 44;
-        createInfo.vertexInput = {
-            {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 * 3}, // position
-            {1, 0, VK_FORMAT_R32G32B32_SFLOAT, 4 * 3}, // normal
-            {2, 0, VK_FORMAT_R32G32B32_SFLOAT, 4 * 6}, // tangent
-            {3, 0, VK_FORMAT_R32G32_SFLOAT, 4 * 9}     // tex
-        };
+        setMeshVertexInput(createInfo, MeshVertexFormat::Float);
         mMeshPipeline    = VulkanGraphicPipeline::Create(createInfo);
-        mDescriptorSet   = mDescriptorPool.allocate(mMeshPipeline->getDescriptorSetLayouts()[0]);
-
-        VkDescriptorBufferInfo bufferInfo[2];
-        bufferInfo[0].buffer = mPerFrameBuffer->getBuffer();
-        bufferInfo[0].offset = 0;
-        bufferInfo[0].range  = VK_WHOLE_SIZE;
-        bufferInfo[1].buffer = mLightDataBuffer->getBuffer();
-        bufferInfo[1].offset = 0;
-        bufferInfo[1].range  = VK_WHOLE_SIZE;
-
-        VkWriteDescriptorSet writeDescriptorSet[3]{};
-        writeDescriptorSet[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writeDescriptorSet[0].dstSet          = mDescriptorSet;
-        writeDescriptorSet[0].dstBinding      = 0;
-        writeDescriptorSet[0].descriptorCount = 1;
-        writeDescriptorSet[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        writeDescriptorSet[0].pBufferInfo     = bufferInfo;
-        writeDescriptorSet[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writeDescriptorSet[1].dstSet          = mDescriptorSet;
-        writeDescriptorSet[1].dstBinding      = 1;
-        writeDescriptorSet[1].descriptorCount = 1;
-        writeDescriptorSet[1].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        writeDescriptorSet[1].pBufferInfo     = &bufferInfo[1];
-        vkUpdateDescriptorSets(VulkanContext::getDevice(), 2, writeDescriptorSet, 0, nullptr);
+
+        mMeshDepthShader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_depth_vert.spv"});
+        assert(mMeshDepthShader);
+        createMeshPassVariants(createInfo, MeshVertexFormat::Float, mMeshDepthShader, mMeshDepthPipeline,
+                               mMeshEqualPipeline);
+
+        // Same pipeline for the packed meshes, it has a set 2 with the SubMeshQuantization.
+        mMeshPackedShader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_packed_vert.spv", "./shaders/mesh_frag.spv"});
+        assert(mMeshPackedShader);
+        createInfo.name   = "meshPackedPipeline";
+        createInfo.shader = mMeshPackedShader;
+        setMeshVertexInput(createInfo, MeshVertexFormat::Packed);
+        mMeshPackedPipeline = VulkanGraphicPipeline::Create(createInfo);
+        assert(mMeshPackedPipeline);
+
+        mMeshPackedDepthShader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_depth_packed_vert.spv"});
+        assert(mMeshPackedDepthShader);
+        createMeshPassVariants(createInfo, MeshVertexFormat::Packed, mMeshPackedDepthShader,
+                               mMeshPackedDepthPipeline, mMeshPackedEqualPipeline);
+
+        // One set per frame in flight, the light buffers of the frames are bound to it.
+        for (uint32_t frame = 0; frame < mFrameInFlightCount; ++frame) {
+            mDescriptorSet[frame] = mDescriptorPool.allocate(mMeshPipeline->getDescriptorSetLayouts()[0]);
+
+            VkDescriptorBufferInfo bufferInfo[2];
+            bufferInfo[0] = getPerFrameBufferInfo();
+            bufferInfo[1] = getLightDataBufferInfo();
+
+            VkWriteDescriptorSet writeDescriptorSet[2]{};
+            writeDescriptorSet[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet[0].dstSet          = mDescriptorSet[frame];
+            writeDescriptorSet[0].dstBinding      = 0;
+            writeDescriptorSet[0].descriptorCount = 1;
+            writeDescriptorSet[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet[0].pBufferInfo     = bufferInfo;
+            writeDescriptorSet[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet[1].dstSet          = mDescriptorSet[frame];
+            writeDescriptorSet[1].dstBinding      = 1;
+            writeDescriptorSet[1].descriptorCount = 1;
+            writeDescriptorSet[1].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet[1].pBufferInfo     = &bufferInfo[1];
+            vkUpdateDescriptorSets(VulkanContext::getDevice(), 2, writeDescriptorSet, 0, nullptr);
+        }
 
         //VulkanContext::setDebugObjectName((uint64_t)mMeshPipeline.descriptorSetLayout[0], VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
         //                                  "MeshPipelineDescriptorSet0Layout");
@@ -174,6 +296,110 @@ SceneRenderer::SceneRenderer() {
                                           VK_OBJECT_TYPE_PIPELINE_LAYOUT, "meshpipelineLayout");
     }
 
+    // Instanced mesh pipeline
+    {
+        mMeshInstanced.shader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_instanced_vert.spv", "./shaders/mesh_frag.spv"});
+        VulkanContext::setDebugObjectName((uint64_t)mMeshInstanced.shader->getPipelineLayout(), VK_OBJECT_TYPE_PIPELINE_LAYOUT, "MeshInstancedPipelineLayout" );
+        assert(mMeshInstanced.shader);
+
+        VulkanGraphicPipelineCreateInfo createInfo{};
+        createInfo.name         = "MeshInstanced";
+        createInfo.shader       = mMeshInstanced.shader;
+        createInfo.cullMode     = VK_CULL_MODE_NONE;
+        setMeshVertexInput(createInfo, MeshVertexFormat::Float);
+        mMeshInstanced.pipeline = VulkanGraphicPipeline::Create(createInfo);
+        assert(mMeshInstanced.pipeline);
+
+        mMeshInstanced.depthShader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_depth_instanced_vert.spv"});
+        assert(mMeshInstanced.depthShader);
+        createMeshPassVariants(createInfo, MeshVertexFormat::Float, mMeshInstanced.depthShader,
+                               mMeshInstanced.depthPipeline, mMeshInstanced.equalPipeline);
+
+        mMeshInstanced.packedShader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_instanced_packed_vert.spv", "./shaders/mesh_frag.spv"});
+        assert(mMeshInstanced.packedShader);
+        createInfo.name   = "MeshInstancedPacked";
+        createInfo.shader = mMeshInstanced.packedShader;
+        setMeshVertexInput(createInfo, MeshVertexFormat::Packed);
+        mMeshInstanced.packedPipeline = VulkanGraphicPipeline::Create(createInfo);
+        assert(mMeshInstanced.packedPipeline);
+
+        mMeshInstanced.packedDepthShader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_depth_instanced_packed_vert.spv"});
+        assert(mMeshInstanced.packedDepthShader);
+        createMeshPassVariants(createInfo, MeshVertexFormat::Packed, mMeshInstanced.packedDepthShader,
+                               mMeshInstanced.packedDepthPipeline, mMeshInstanced.packedEqualPipeline);
+
+        for (uint32_t frame = 0; frame < mFrameInFlightCount; ++frame) {
+            mMeshInstanced.descriptorSet[frame] = mDescriptorPool.allocate(mMeshInstanced.pipeline->getDescriptorSetLayouts()[0]);
+            VulkanContext::setDebugObjectName((uint64_t)mMeshInstanced.descriptorSet[frame], VK_OBJECT_TYPE_DESCRIPTOR_SET, "MeshInstanced" );
+
+            VkDescriptorBufferInfo bufferInfo[2];
+            bufferInfo[0] = getPerFrameBufferInfo();
+            bufferInfo[1] = getLightDataBufferInfo();
+
+            VkWriteDescriptorSet writeDescriptorSet[2]{};
+            writeDescriptorSet[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet[0].dstSet          = mMeshInstanced.descriptorSet[frame];
+            writeDescriptorSet[0].dstBinding      = 0;
+            writeDescriptorSet[0].descriptorCount = 1;
+            writeDescriptorSet[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet[0].pBufferInfo     = &bufferInfo[0];
+            writeDescriptorSet[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet[1].dstSet          = mMeshInstanced.descriptorSet[frame];
+            writeDescriptorSet[1].dstBinding      = 1;
+            writeDescriptorSet[1].descriptorCount = 1;
+            writeDescriptorSet[1].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet[1].pBufferInfo     = &bufferInfo[1];
+            vkUpdateDescriptorSets(VulkanContext::getDevice(), 2, writeDescriptorSet, 0, nullptr);
+
+            reserveInstanceBuffer(frame, 1024);
+        }
+    }
+
+    // GPU culling
+    {
+        mGpuCulling.shader = VulkanShaderProgram::CreateFromSpirv({"./shaders/mesh_cull_comp.spv"});
+        assert(mGpuCulling.shader);
+        VulkanContext::setDebugObjectName((uint64_t)mGpuCulling.shader->getPipelineLayout(), VK_OBJECT_TYPE_PIPELINE_LAYOUT, "MeshCullPipelineLayout" );
+
+        VulkanComputePipelineCreateInfo createInfo{};
+        createInfo.name   = "MeshCull";
+        createInfo.shader = mGpuCulling.shader;
+        mGpuCulling.pipeline = VulkanComputePipeline::Create(createInfo);
+        assert(mGpuCulling.pipeline);
+
+        // Replaced by setDepthBuffer(), the culling pass always reads a pyramid.
+        mDepthPyramid = VulkanDepthPyramid::Create(1, 1);
+
+        for (uint32_t frame = 0; frame < mFrameInFlightCount; ++frame) {
+            mGpuCulling.descriptorSet[frame] = mDescriptorPool.allocate(mGpuCulling.pipeline->getDescriptorSetLayouts()[0]);
+            VulkanContext::setDebugObjectName((uint64_t)mGpuCulling.descriptorSet[frame], VK_OBJECT_TYPE_DESCRIPTOR_SET, "MeshCull" );
+
+            VkDescriptorBufferInfo bufferInfo = getPerFrameBufferInfo();
+
+            VkWriteDescriptorSet writeDescriptorSet{};
+            writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet.dstSet          = mGpuCulling.descriptorSet[frame];
+            writeDescriptorSet.dstBinding      = 0;
+            writeDescriptorSet.descriptorCount = 1;
+            writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet.pBufferInfo     = &bufferInfo;
+            vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+
+            VulkanBufferCreateInfo bufferCreateInfo{};
+            bufferCreateInfo.name           = "MeshCullReadback";
+            bufferCreateInfo.sizeInByte     = sizeof(uint32_t) * 2;
+            bufferCreateInfo.usage          = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            bufferCreateInfo.persistentMapping = true;
+            bufferCreateInfo.hostRead          = true;
+            mGpuCulling.readbackBuffer[frame] = VulkanBuffer::Create(bufferCreateInfo);
+            const uint32_t counts[2] = {0, 0};
+            mGpuCulling.readbackBuffer[frame]->writeData(counts, sizeof(counts));
+
+            reserveCullBuffers(frame, 1024, 256);
+        }
+    }
+
     // Skybox
     {
         mSkyboxShader   = VulkanShaderProgram::CreateFromSpirv({"./shaders/skybox_vert.spv", "./shaders/skybox_frag.spv"});
@@ -215,17 +441,12 @@ SceneRenderer::SceneRenderer() {
         bufferCreateInfo.name           = "SkyBoxVB";
         bufferCreateInfo.sizeInByte     = sizeof(cubeVertices);
         bufferCreateInfo.usage          = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-        bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        mSkyBoxVertexBuffer = VulkanBuffer::Create(bufferCreateInfo);
+        mSkyBoxVertexBuffer = VulkanBuffer::CreateDeviceLocal(bufferCreateInfo, cubeVertices);
 
         bufferCreateInfo.name           = "SkyBoxIB";
         bufferCreateInfo.sizeInByte     = sizeof(cubeIndices);
         bufferCreateInfo.usage          = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-        bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        mSkyBoxIndexBuffer = VulkanBuffer::Create(bufferCreateInfo);
-
-        mSkyBoxVertexBuffer->writeData(cubeVertices, sizeof(cubeVertices));
-        mSkyBoxIndexBuffer->writeData(cubeIndices, sizeof(cubeIndices));
+        mSkyBoxIndexBuffer = VulkanBuffer::CreateDeviceLocal(bufferCreateInfo, cubeIndices);
     }
 
     // Draw mesh AABB
@@ -245,17 +466,14 @@ SceneRenderer::SceneRenderer() {
         mDrawMeshAABB.descriptorSet = mDescriptorPool.allocate(mDrawMeshAABB.pipeline->getDescriptorSetLayouts()[0]);
         VulkanContext::setDebugObjectName((uint64_t)mDrawMeshAABB.descriptorSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "MeshAABB" );
 
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = mPerFrameBuffer->getBuffer();
-        bufferInfo.offset = 0;
-        bufferInfo.range  = VK_WHOLE_SIZE;
+        VkDescriptorBufferInfo bufferInfo = getPerFrameBufferInfo();
 
         VkWriteDescriptorSet writeDescriptorSet{};
         writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         writeDescriptorSet.dstSet          = mDrawMeshAABB.descriptorSet;
         writeDescriptorSet.dstBinding      = 0;
         writeDescriptorSet.descriptorCount = 1;
-        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         writeDescriptorSet.pBufferInfo     = &bufferInfo;
         vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
     }
@@ -271,30 +489,27 @@ SceneRenderer::SceneRenderer() {
         createInfo.shader = mDrawMeshNormals.shader;
         createInfo.primitiveTopology =VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         createInfo.cullMode=VK_CULL_MODE_NONE;
-        createInfo.vertexStride = 44;
+        createInfo.vertexStride = sizeof(MeshVertex);
         createInfo.vertexInput = {
-            {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 * 3}, // position
-            {1, 0, VK_FORMAT_R32G32B32_SFLOAT, 4 * 3}, // normal
-            {2, 0, VK_FORMAT_R32G32B32_SFLOAT, 4 * 6}, // tangent
+            {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, position)},
+            {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, normal)},
+            {2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, tangent)},
         };
         mDrawMeshNormals.pipeline = VulkanGraphicPipeline::Create(createInfo);
         assert(mDrawMeshNormals.pipeline);
 
-        mDrawMeshNormals.descriptorSet = mDescriptorPool.allocate(mDrawMeshNormals.pipeline->getDescriptorSetLayouts()[0]);
         VulkanContext::setDebugObjectName((uint64_t)mDrawMeshNormals.pipeline->getDescriptorSetLayouts()[0], VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "MeshNormalSetLayout0" );
+        mDrawMeshNormals.descriptorSet = mDescriptorPool.allocate(mDrawMeshNormals.pipeline->getDescriptorSetLayouts()[0]);
         VulkanContext::setDebugObjectName((uint64_t)mDrawMeshNormals.descriptorSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "MeshNormal" );
 
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = mPerFrameBuffer->getBuffer();
-        bufferInfo.offset = 0;
-        bufferInfo.range  = VK_WHOLE_SIZE;
+        VkDescriptorBufferInfo bufferInfo = getPerFrameBufferInfo();
 
         VkWriteDescriptorSet writeDescriptorSet{};
         writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         writeDescriptorSet.dstSet          = mDrawMeshNormals.descriptorSet;
         writeDescriptorSet.dstBinding      = 0;
         writeDescriptorSet.descriptorCount = 1;
-        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         writeDescriptorSet.pBufferInfo     = &bufferInfo;
         vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
     }
@@ -308,6 +523,21 @@ SceneRenderer::SceneRenderer() {
         bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
         mTerrainSettings                = VulkanBuffer::Create(bufferCreateInfo);
 
+        // The settings never change, upload them once instead of writing a buffer
+        // which may still be read by a frame in flight.
+        TerrainSetting ts{};
+        ts.tessFactor[0]       = 64;
+        ts.tessFactor[1]       = 64;
+        ts.tessFactor[2]       = 64;
+        ts.tessFactor[3]       = 64;
+        ts.insideTessFactor[0] = 64;
+        ts.insideTessFactor[1] = 64;
+        ts.maxTess = 6;
+        ts.minTess = 0;
+        ts.maxDistance = 1000.0f;
+        ts.minDistance = 20.0f;
+        mTerrainSettings->writeData(&ts, sizeof(ts));
+
         mDrawTerrain.shader = VulkanShaderProgram::CreateFromSpirv(
             {"./shaders/terrain_vert.spv", "./shaders/terrain_hull.spv", "./shaders/terrain_dom.spv", "./shaders/terrain_frag.spv"});
         VulkanContext::setDebugObjectName((uint64_t)mDrawTerrain.shader->getPipelineLayout(), VK_OBJECT_TYPE_PIPELINE_LAYOUT, "TerrainPipelineLayout");
@@ -328,49 +558,175 @@ SceneRenderer::SceneRenderer() {
         mDrawTerrain.pipeline = VulkanGraphicPipeline::Create(createInfo);
         assert(mDrawTerrain.pipeline);
 
-        mDrawTerrain.descriptorSet0 = mDescriptorPool.allocate(mDrawTerrain.pipeline->getDescriptorSetLayouts()[0]);
-        VulkanContext::setDebugObjectName((uint64_t)mDrawTerrain.descriptorSet0, VK_OBJECT_TYPE_DESCRIPTOR_SET, "TerrainDescriptorSet0" );
+        for (uint32_t frame = 0; frame < mFrameInFlightCount; ++frame) {
+            mDrawTerrain.descriptorSet0[frame] = mDescriptorPool.allocate(mDrawTerrain.pipeline->getDescriptorSetLayouts()[0]);
+            VulkanContext::setDebugObjectName((uint64_t)mDrawTerrain.descriptorSet0[frame], VK_OBJECT_TYPE_DESCRIPTOR_SET, "TerrainDescriptorSet0" );
+
+            VkDescriptorBufferInfo bufferInfo[2]{};
+            bufferInfo[0] = getPerFrameBufferInfo();
+            bufferInfo[1] = getLightDataBufferInfo();
+            VkWriteDescriptorSet writeDescriptorSet{};
+            writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet0[frame];
+            writeDescriptorSet.dstBinding      = 0;
+            writeDescriptorSet.descriptorCount = 1;
+            writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet.pBufferInfo     = &bufferInfo[0];
+            vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+            writeDescriptorSet.dstBinding      = 1;
+            writeDescriptorSet.pBufferInfo     = &bufferInfo[1];
+            vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+        }
+    }
 
-        VkDescriptorBufferInfo bufferInfo[2]{};
-        bufferInfo[0].buffer = mPerFrameBuffer->getBuffer();
-        bufferInfo[0].offset = 0;
-        bufferInfo[0].range  = VK_WHOLE_SIZE;
-        bufferInfo[1].buffer = mLightDataBuffer->getBuffer();
-        bufferInfo[1].offset = 0;
-        bufferInfo[1].range  = VK_WHOLE_SIZE;
-        VkWriteDescriptorSet writeDescriptorSet{};
-        writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet0;
-        writeDescriptorSet.dstBinding      = 0;
-        writeDescriptorSet.descriptorCount = 1;
-        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        writeDescriptorSet.pBufferInfo     = &bufferInfo[0];
-        vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
-        writeDescriptorSet.dstBinding      = 1;
-        writeDescriptorSet.pBufferInfo     = &bufferInfo[1];
-        vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+    // Light clusters, created after the lit pipelines so their set 0 receive the light buffers of the frames.
+    {
+        mLightClusters.shader = VulkanShaderProgram::CreateFromSpirv({"./shaders/light_cluster_comp.spv"});
+        assert(mLightClusters.shader);
+        VulkanContext::setDebugObjectName((uint64_t)mLightClusters.shader->getPipelineLayout(), VK_OBJECT_TYPE_PIPELINE_LAYOUT, "LightClusterPipelineLayout" );
+
+        VulkanComputePipelineCreateInfo createInfo{};
+        createInfo.name   = "LightCluster";
+        createInfo.shader = mLightClusters.shader;
+        mLightClusters.pipeline = VulkanComputePipeline::Create(createInfo);
+        assert(mLightClusters.pipeline);
+
+        for (uint32_t frame = 0; frame < mFrameInFlightCount; ++frame) {
+            mLightClusters.descriptorSet[frame] = mDescriptorPool.allocate(mLightClusters.pipeline->getDescriptorSetLayouts()[0]);
+            VulkanContext::setDebugObjectName((uint64_t)mLightClusters.descriptorSet[frame], VK_OBJECT_TYPE_DESCRIPTOR_SET, "LightCluster" );
+
+            VulkanBufferCreateInfo bufferCreateInfo{};
+            bufferCreateInfo.name           = "LightClusters";
+            bufferCreateInfo.sizeInByte     = sizeof(uint32_t) * LightClusters::kClusterCount * LightClusters::kClusterStride;
+            bufferCreateInfo.usage          = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            mLightClusters.clusterBuffer[frame] = VulkanBuffer::Create(bufferCreateInfo);
+
+            // The cluster buffer is written by the compute pass and read by the lit passes.
+            const VkDescriptorSet  sets[] = {mLightClusters.descriptorSet[frame], mDescriptorSet[frame],
+                                             mMeshInstanced.descriptorSet[frame], mDrawTerrain.descriptorSet0[frame]};
+            VkDescriptorBufferInfo bufferInfo[2];
+            bufferInfo[0] = getPerFrameBufferInfo();
+            bufferInfo[1] = getLightDataBufferInfo();
+            const VkDescriptorBufferInfo clusterBufferInfo{mLightClusters.clusterBuffer[frame]->getBuffer(), 0, VK_WHOLE_SIZE};
+
+            VkWriteDescriptorSet writeDescriptorSet[6]{};
+            for (uint32_t i = 0; i < 6; ++i) {
+                writeDescriptorSet[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDescriptorSet[i].descriptorCount = 1;
+            }
+            writeDescriptorSet[0].dstSet         = mLightClusters.descriptorSet[frame];
+            writeDescriptorSet[0].dstBinding     = 0;
+            writeDescriptorSet[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet[0].pBufferInfo    = &bufferInfo[0];
+            writeDescriptorSet[1].dstSet         = mLightClusters.descriptorSet[frame];
+            writeDescriptorSet[1].dstBinding     = 1;
+            writeDescriptorSet[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet[1].pBufferInfo    = &bufferInfo[1];
+            for (uint32_t i = 0; i < std::size(sets); ++i) {
+                writeDescriptorSet[2 + i].dstSet         = sets[i];
+                writeDescriptorSet[2 + i].dstBinding     = 5;
+                writeDescriptorSet[2 + i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writeDescriptorSet[2 + i].pBufferInfo    = &clusterBufferInfo;
+            }
+            vkUpdateDescriptorSets(VulkanContext::getDevice(), 6, writeDescriptorSet, 0, nullptr);
+
+            reserveLightBuffers(frame, 64, 16, 4);
+        }
     }
 }
 
 SceneRenderer::~SceneRenderer() {
     mDescriptorPool.destroy();
+    mMaterialSets.clear();
+    mQuantizationSets.clear();
+
+    for (auto& recordContexts : mRecordContexts) {
+        for (RecordContext& context : recordContexts) {
+            vkDestroyCommandPool(VulkanContext::getDevice(), context.commandPool, nullptr);
+        }
+    }
 
-    mPerFrameBuffer.reset();
-    mLightDataBuffer.reset();
+    mFrameAllocator.destroy();
+    mGpuTimer.destroy();
     mSkyBoxVertexBuffer.reset();
     mSkyBoxIndexBuffer.reset();
+    for (uint32_t frame = 0; frame < mFrameInFlightCount; ++frame) {
+        mMeshInstanced.instanceBuffer[frame].reset();
+        mGpuCulling.cullItemBuffer[frame].reset();
+        mGpuCulling.drawCommandBuffer[frame].reset();
+        mGpuCulling.drawCountBuffer[frame].reset();
+        mGpuCulling.occludedBuffer[frame].reset();
+        mGpuCulling.readbackBuffer[frame].reset();
+        mLightClusters.pointLightBuffer[frame].reset();
+        mLightClusters.spotLightBuffer[frame].reset();
+        mLightClusters.directionalLightBuffer[frame].reset();
+        mLightClusters.clusterBuffer[frame].reset();
+    }
+    mDepthPyramid.reset();
+    mDepthBuffer.reset();
+    mMeshInstanced.pipeline.reset();
+    mMeshInstanced.packedPipeline.reset();
+    mMeshInstanced.depthPipeline.reset();
+    mMeshInstanced.packedDepthPipeline.reset();
+    mMeshInstanced.equalPipeline.reset();
+    mMeshInstanced.packedEqualPipeline.reset();
+    mMeshInstanced.shader.reset();
+    mMeshInstanced.packedShader.reset();
+    mMeshInstanced.depthShader.reset();
+    mMeshInstanced.packedDepthShader.reset();
+    mGpuCulling.pipeline.reset();
+    mGpuCulling.shader.reset();
+    mLightClusters.lightSystem.reset();
+    mLightClusters.pipeline.reset();
+    mLightClusters.shader.reset();
     mMeshPipeline.reset();
+    mMeshPackedPipeline.reset();
+    mMeshDepthPipeline.reset();
+    mMeshPackedDepthPipeline.reset();
+    mMeshEqualPipeline.reset();
+    mMeshPackedEqualPipeline.reset();
     mSkyboxPipeline.reset();
     mMeshShader.reset();
+    mMeshPackedShader.reset();
+    mMeshDepthShader.reset();
+    mMeshPackedDepthShader.reset();
     mSkyboxShader.reset();
 }
 
-void SceneRenderer::render(entt::registry*  registry,
-                           VkCommandBuffer  cmd,
-                           const glm::mat4& proj,
-                           const glm::mat4& view,
-                           const glm::vec3& viewPosition) {
-    mRegistry = registry;
+void SceneRenderer::prepare(entt::registry*  registry,
+                            VkCommandBuffer  cmd,
+                            uint32_t         frameIndex,
+                            const glm::mat4& proj,
+                            const glm::mat4& view,
+                            const glm::vec3& viewPosition) {
+    assert(frameIndex < mFrameInFlightCount);
+    const auto cpuStart = std::chrono::high_resolution_clock::now();
+    mRegistry     = registry;
+    mFrameIndex   = frameIndex;
+    mFrameNumber++;
+    mViewPosition = viewPosition;
+    mStats        = {};
+    mProjectionScaleY = std::abs(proj[1][1]);
+    mFrameAllocator.beginFrame(mFrameIndex);
+    releaseCachedSets();
+
+    // The counts written by the culling pass the last time this frame slot was used,
+    // the caller has waited for its fence.
+    if (mUseGpuCulling) {
+        const auto* counts      = static_cast<const uint32_t*>(mGpuCulling.readbackBuffer[mFrameIndex]->map());
+        mStats.gpuVisibleCount  = counts[0];
+        mStats.gpuOccludedCount = counts[1];
+        mGpuCulling.readbackBuffer[mFrameIndex]->unmap();
+    }
+    mLatePass = mUseGpuCulling && mUseOcclusionCulling && mDepthBuffer;
+
+    // The durations of the passes recorded the last time this frame slot was used.
+    mGpuTimer.beginFrame(cmd, mFrameIndex);
+    mStats.gpuCullingMs      = mGpuTimer.getElapsedMs(kGpuScopeCulling);
+    mStats.gpuDepthPrepassMs = mGpuTimer.getElapsedMs(kGpuScopeDepthPrepass);
+    mStats.gpuMeshPassMs     = mGpuTimer.getElapsedMs(kGpuScopeMeshPass);
+    mStats.gpuLightClustersMs = mGpuTimer.getElapsedMs(kGpuScopeLightClusters);
 
     // upload per frame data
     {
@@ -413,231 +769,510 @@ void SceneRenderer::render(entt::registry*  registry,
         // Normalize the plane equations.
         for (int i = 0; i < 6; ++i) {
             planeNormalize(perFrameData.worldFrustumPlanes[i]);
+            mWorldFrustumPlanes[i] = perFrameData.worldFrustumPlanes[i];
         }
 
         perFrameData.ambientLight = glm::vec4(mAmbientLight, 1.0f);
         perFrameData.useBlinnPhong = mUseBlinnPhong;
         perFrameData.useGammaCorrection = mUseGammaCorrection;
         perFrameData.gamma = mGamma;
-        mPerFrameBuffer->writeData(&perFrameData, sizeof(perFrameData));
+        mFrameDynamicOffsets[0] = mFrameAllocator.push(perFrameData);
     }
 
-    {
-        TerrainSetting ts{};
-        ts.tessFactor[0]       = 64;
-        ts.tessFactor[1]       = 64;
-        ts.tessFactor[2]       = 64;
-        ts.tessFactor[3]       = 64;
-        ts.insideTessFactor[0] = 64;
-        ts.insideTessFactor[1] = 64;
-        ts.maxTess = 6;
-        ts.minTess = 0;
-        ts.maxDistance = 1000.0f;
-        ts.minDistance = 20.0f;
-        mTerrainSettings->writeData(&ts, sizeof(ts));
+    uploadLights(proj);
+
+    // CPU culling, the culled entities are skipped by the mesh passes. The bounds are kept up to
+    // date even when the culling is off, the changes would pile up otherwise.
+    mFrustumCuller.update(*mRegistry);
+    if (mUseCpuCulling && !mUseGpuCulling) {
+        mFrustumCuller.cull(mWorldFrustumPlanes);
+        mStats.cpuVisibleCount = mFrustumCuller.getVisibleCount();
+        mStats.cpuTotalCount   = mFrustumCuller.getTotalCount();
     }
 
-    //
-    // Point Light
-    //
-    {
-        auto view = mRegistry->view<CTransform, CPointLight>();
-        LightData lightData{};
-        lightData.nbLight = 0;
-        for (auto [entity, ctrans, pointLight] : view.each()) {
-            if(!pointLight.enable) {
-                continue;
-            }
-            PointLight& light = lightData.lights[lightData.nbLight];
-            light.position = glm::vec4(ctrans.position, 1.0f);
-            light.ambient   = glm::vec4(pointLight.ambient, 1.0f);
-            light.diffuse   = glm::vec4(pointLight.diffuse, 1.0f);
-            light.specular  = glm::vec4(pointLight.specular, 1.0f);
-            light.constant  = pointLight.constant;
-            light.linear    = pointLight.linear;
-            light.quadratic = pointLight.quadratic;
-            light.range     = pointLight.range;
-            light.intensity = pointLight.intensity;
-            lightData.nbLight++;
-        }
-
-        lightData.nbDirectionalLight = 0;
-        for (auto [entity, directionalLight] : mRegistry->view<CDirectionalLight>().each()) {
-            if(!directionalLight.enable) {
-                continue;
-            }
-            DirectionalLight& light = lightData.directionalLight[lightData.nbDirectionalLight];
-            light.color     = glm::vec4(directionalLight.color, 1.0f);
-            light.direction = glm::vec4(directionalLight.direction, 1.0f);
-            lightData.nbDirectionalLight++;
-        }
+    buildRenderQueue();
+    createPassDescriptorSets();
 
-        lightData.nbSpotLight = 0;
-        for (auto [entity, transform, spotLight] : mRegistry->view<CTransform, CSpotLight>().each()) {
-            if(!spotLight.enable) {
-                continue;
-            }
-            SpotLight& light = lightData.nbSpotLight[lightData.spotLights];
-            light.position  = glm::vec4(transform.position, 1.0f);
-            light.color     = glm::vec4(spotLight.color, 1.0f);
-            light.direction = glm::vec4(spotLight.direction, 1.0f);
-            light.range     = spotLight.range;
-            light.cutOffInner = glm::cos(glm::radians(spotLight.cutOffAngle));
-            light.cutOffOuter = glm::cos(glm::radians(spotLight.cutOffAngle+12.5f));
-            lightData.nbSpotLight++;
-        }
+    if (mUseInstancing || mUseGpuCulling) {
+        buildDrawGroups();
+    }
+    if (mUseDepthPrepass) {
+        buildDepthQueue();
+    }
 
-        mLightDataBuffer->writeData(&lightData,sizeof(lightData));
+    if (mUseGpuCulling) {
+        cullMeshesGpu(cmd);
     }
+    assignLightsGpu(cmd);
 
+    const auto cpuEnd = std::chrono::high_resolution_clock::now();
+    mStats.cpuTimeMs  = std::chrono::duration<float, std::milli>(cpuEnd - cpuStart).count();
+}
 
+void SceneRenderer::render(VkCommandBuffer cmd) {
+    const auto cpuStart = std::chrono::high_resolution_clock::now();
 
-    // render scene
-    {
-        vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mMeshPipeline->getPipeline());
+    // The depth pre-pass and the lit pass are in the same rendering scope, the fragment tests
+    // of the lit pass see the depth written by the pre-pass in rasterization order.
+    if (mUseDepthPrepass) {
+        mGpuTimer.writeBegin(cmd, kGpuScopeDepthPrepass);
+        drawMeshPass(cmd, 0, getMeshPassSize(), mStats, MeshPass::Depth);
+        mGpuTimer.writeEnd(cmd, kGpuScopeDepthPrepass);
+    }
 
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-            mMeshPipeline->getPipelineLayout(), 0 /*firstSet*/, 1 /*nbSet*/,
-            &mDescriptorSet, 0, nullptr);
+    // With a late pass, the passes drawn over the meshes wait for the meshes of the second phase.
+    mGpuTimer.writeBegin(cmd, kGpuScopeMeshPass);
+    drawMeshPass(cmd, 0, getMeshPassSize(), mStats, mUseDepthPrepass ? MeshPass::LitEqual : MeshPass::Lit);
+    mGpuTimer.writeEnd(cmd, kGpuScopeMeshPass);
+    if (!mLatePass) {
+        drawSkybox(cmd);
+        drawMeshAABBs(cmd);
+        drawMeshNormals(cmd);
+    }
+    drawTerrain(cmd);
 
-        PushData pushData{};
-        auto view           = mRegistry->view<CTransform, CMesh, CMaterial>();
-        for (auto [entity, ctrans, cmesh, cmat] : view.each()) {
+    const auto cpuEnd = std::chrono::high_resolution_clock::now();
+    mStats.cpuTimeMs += std::chrono::duration<float, std::milli>(cpuEnd - cpuStart).count();
+}
 
-            if(cmat.descriptorSet1 == VK_NULL_HANDLE) {
-                cmat.descriptorSet1 = mDescriptorPool.allocate(mMeshPipeline->getDescriptorSetLayouts()[1]);
+void SceneRenderer::cullLate(VkCommandBuffer cmd) {
+    if (!mLatePass) {
+        return;
+    }
+    const auto cpuStart = std::chrono::high_resolution_clock::now();
+
+    // The meshes visible in the first phase and the terrain are the occluders of the second phase.
+    mDepthPyramid->build(cmd, mDepthBuffer->getImage(), mDepthBuffer->getDepthView());
+    if (mGpuCulling.itemCount > 0) {
+        VulkanContext::CmdBeginsLabel(cmd, "MeshCullingLate");
+        dispatchCulling(cmd, kCullModeLate);
+        readbackCullCounters(cmd);
+        VulkanContext::CmdEndLabel(cmd);
+    }
 
-                VkDescriptorImageInfo descriptorImageInfo;
-                descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                descriptorImageInfo.imageView   = cmat.diffuseMap->getImageView();
-                descriptorImageInfo.sampler     = cmat.diffuseMap->getSampler();
-
-                VkWriteDescriptorSet writeDescriptorSet2[1]{};
-                writeDescriptorSet2[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                writeDescriptorSet2[0].dstSet          = cmat.descriptorSet1;
-                writeDescriptorSet2[0].dstBinding      = 2;
-                writeDescriptorSet2[0].descriptorCount = 1;
-                writeDescriptorSet2[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                writeDescriptorSet2[0].pImageInfo      = &descriptorImageInfo;
-                vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet2, 0, nullptr);
+    const auto cpuEnd = std::chrono::high_resolution_clock::now();
+    mStats.cpuTimeMs += std::chrono::duration<float, std::milli>(cpuEnd - cpuStart).count();
+}
 
-                descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                descriptorImageInfo.imageView   = cmat.specularMap->getImageView();
-                descriptorImageInfo.sampler     = cmat.specularMap->getSampler();
-                writeDescriptorSet2[0].dstBinding =3;
-                vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet2, 0, nullptr);
+void SceneRenderer::renderLate(VkCommandBuffer cmd) {
+    if (!mLatePass) {
+        return;
+    }
+    const auto cpuStart = std::chrono::high_resolution_clock::now();
 
-                descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                descriptorImageInfo.imageView   = cmat.normalMap->getImageView();
-                descriptorImageInfo.sampler     = cmat.normalMap->getSampler();
-                writeDescriptorSet2[0].dstBinding =4;
-                vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet2, 0, nullptr);
-            }
+    // The meshes of the second phase are not in the depth pre-pass.
+    drawMeshesIndirect(cmd, 0, mGpuCulling.groupCount, mStats, MeshPass::Lit, true /*late*/);
+    drawSkybox(cmd);
+    drawMeshAABBs(cmd);
+    drawMeshNormals(cmd);
 
-            auto translateMat  = glm::translate(glm::mat4(1), ctrans.position);
-            auto rotationMat   = glm::eulerAngleYXZ(glm::radians(ctrans.rotation.y), glm::radians(ctrans.rotation.x), glm::radians(ctrans.rotation.z));
-            auto scaleMat      = glm::scale(glm::mat4(1), ctrans.scale);
-            pushData.transform     = translateMat * rotationMat * scaleMat;
-            pushData.normalMatrix  = glm::transpose(glm::inverse(pushData.transform));
-            pushData.ambient   = cmat.ambient;
-            pushData.diffuse   = cmat.diffuse;
-            pushData.specular  = cmat.specular;
-            pushData.shininess = cmat.shininess;
-            pushData.texScale  = cmat.texScale;
+    const auto cpuEnd = std::chrono::high_resolution_clock::now();
+    mStats.cpuTimeMs += std::chrono::duration<float, std::milli>(cpuEnd - cpuStart).count();
+}
 
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                    mMeshPipeline->getPipelineLayout(), 1 /*firstSet*/, 1 /*nbSet*/,
-                                    &cmat.descriptorSet1, 0, nullptr);
-            vkCmdPushConstants(cmd, mMeshPipeline->getPipelineLayout(),
-                               VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
-                               sizeof(pushData), reinterpret_cast<void*>(&pushData));
+void SceneRenderer::setDepthBuffer(VulkanTexturePtr depthBuffer) {
+    // The descriptor sets of the frames are updated by cullMeshesGpu() when they are reused,
+    // the cached views are reset because a new view may reuse the handle of the destroyed one.
+    mDepthBuffer  = std::move(depthBuffer);
+    mDepthPyramid = mDepthBuffer ? VulkanDepthPyramid::Create(mDepthBuffer->getWidth(), mDepthBuffer->getHeight())
+                                 : VulkanDepthPyramid::Create(1, 1);
+    for (VkImageView& view : mGpuCulling.depthPyramidView) {
+        view = VK_NULL_HANDLE;
+    }
+}
+
+void SceneRenderer::renderSecondary(VkCommandBuffer cmd, const SceneRenderTarget& target) {
+    const auto cpuStart = std::chrono::high_resolution_clock::now();
+
+    // The command buffers recorded the last time this frame slot was used have completed.
+    for (RecordContext& context : mRecordContexts[mFrameIndex]) {
+        vkResetCommandPool(VulkanContext::getDevice(), context.commandPool, 0);
+        context.usedCount = 0;
+    }
 
-            Renderer::DrawMesh(cmd, cmesh.mesh);
+    // The mesh passes are split in chunks, the other passes are recorded as a whole.
+    // The secondary command buffers are executed in the order of the jobs, the GPU timer scope
+    // of a mesh pass begins in its first chunk and ends in its last one.
+    enum class Pass { DepthMeshes, Meshes, Skybox, MeshAABBs, MeshNormals, Terrain };
+    struct RecordJob {
+        Pass     pass;
+        uint32_t first;
+        uint32_t count;
+        bool     firstChunk{false};
+        bool     lastChunk{false};
+    };
+    std::vector<RecordJob> jobs;
+
+    const uint32_t meshPassSize = getMeshPassSize();
+    const uint32_t chunkCount   = std::clamp<uint32_t>((meshPassSize + kMinMeshChunkSize - 1) / kMinMeshChunkSize,
+                                                       1, mThreadPool.getThreadCount());
+    const uint32_t chunkSize    = (meshPassSize + chunkCount - 1) / chunkCount;
+    const auto     addMeshJobs  = [&](Pass pass) {
+        const size_t firstJob = jobs.size();
+        for (uint32_t first = 0; first < meshPassSize; first += chunkSize) {
+            jobs.push_back({pass, first, std::min(chunkSize, meshPassSize - first)});
+        }
+        if (jobs.size() > firstJob) {
+            jobs[firstJob].firstChunk = true;
+            jobs.back().lastChunk     = true;
         }
+    };
+    if (mUseDepthPrepass) {
+        addMeshJobs(Pass::DepthMeshes);
+    }
+    addMeshJobs(Pass::Meshes);
+    if (!mLatePass) {
+        jobs.push_back({Pass::Skybox, 0, 0});
+        jobs.push_back({Pass::MeshAABBs, 0, 0});
+        jobs.push_back({Pass::MeshNormals, 0, 0});
     }
+    jobs.push_back({Pass::Terrain, 0, 0});
+
+    const VkFormat colorFormat = target.colorFormat;
+    VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+    renderingInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    renderingInfo.colorAttachmentCount    = 1;
+    renderingInfo.pColorAttachmentFormats = &colorFormat;
+    renderingInfo.depthAttachmentFormat   = target.depthFormat;
+    renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+    renderingInfo.rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = &renderingInfo;
+
+    VkViewport viewport{};
+    viewport.width    = static_cast<float>(target.extent.width);
+    viewport.height   = static_cast<float>(target.extent.height);
+    viewport.minDepth = 0;
+    viewport.maxDepth = 1;
+    const VkRect2D scissor{{0, 0}, target.extent};
+
+    std::vector<VkCommandBuffer>    commandBuffers(jobs.size());
+    std::vector<SceneRendererStats> jobStats(jobs.size());
+    mThreadPool.parallelFor(static_cast<uint32_t>(jobs.size()), [&](uint32_t index, uint32_t threadIndex) {
+        VkCommandBuffer secondary = acquireSecondaryCommandBuffer(mRecordContexts[mFrameIndex][threadIndex]);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                                     VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+        vkBeginCommandBuffer(secondary, &beginInfo);
+
+        // The dynamic states are not inherited from the primary command buffer.
+        vkCmdSetViewportWithCount(secondary, 1, &viewport);
+        vkCmdSetScissorWithCount(secondary, 1, &scissor);
+
+        const RecordJob& job = jobs[index];
+        const uint32_t   timerScope = job.pass == Pass::DepthMeshes ? kGpuScopeDepthPrepass : kGpuScopeMeshPass;
+        if (job.firstChunk) {
+            mGpuTimer.writeBegin(secondary, timerScope);
+        }
+        switch (job.pass) {
+            case Pass::DepthMeshes: drawMeshPass(secondary, job.first, job.count, jobStats[index], MeshPass::Depth); break;
+            case Pass::Meshes:
+                drawMeshPass(secondary, job.first, job.count, jobStats[index],
+                             mUseDepthPrepass ? MeshPass::LitEqual : MeshPass::Lit);
+                break;
+            case Pass::Skybox:      drawSkybox(secondary); break;
+            case Pass::MeshAABBs:   drawMeshAABBs(secondary); break;
+            case Pass::MeshNormals: drawMeshNormals(secondary); break;
+            case Pass::Terrain:     drawTerrain(secondary); break;
+        }
+        if (job.lastChunk) {
+            mGpuTimer.writeEnd(secondary, timerScope);
+        }
 
-    // skybox
-    {
-        if(auto* skybox = mRegistry->ctx().find<CSkyBox>()) {
-            if(!mSkyBoxDescriptorSet1) {
-                mSkyBoxDescriptorSet0= mDescriptorPool.allocate(mSkyboxShader->getDescriptorSetLayouts()[0]);
-                mSkyBoxDescriptorSet1= mDescriptorPool.allocate(mSkyboxShader->getDescriptorSetLayouts()[1]);
-
-                VkDescriptorBufferInfo bufferInfo[2];
-                bufferInfo[0].buffer = mPerFrameBuffer->getBuffer();
-                bufferInfo[0].offset = 0;
-                bufferInfo[0].range  = VK_WHOLE_SIZE;
-
-                VkWriteDescriptorSet writeDescriptorSet[1]{};
-                writeDescriptorSet[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                writeDescriptorSet[0].dstSet          = mSkyBoxDescriptorSet0;
-                writeDescriptorSet[0].dstBinding      = 0;
-                writeDescriptorSet[0].descriptorCount = 1;
-                writeDescriptorSet[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                writeDescriptorSet[0].pBufferInfo     = bufferInfo;
-                vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet, 0, nullptr);
+        vkEndCommandBuffer(secondary);
+        commandBuffers[index] = secondary;
+    });
+
+    for (const SceneRendererStats& stats : jobStats) {
+        mStats.drawCalls     += stats.drawCalls;
+        mStats.instanceCount += stats.instanceCount;
+        mStats.bindsIssued   += stats.bindsIssued;
+        mStats.bindsSkipped  += stats.bindsSkipped;
+        mStats.triangleCount += stats.triangleCount;
+    }
+    mStats.recordJobCount = static_cast<uint32_t>(jobs.size());
+
+    vkCmdExecuteCommands(cmd, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+
+    const auto cpuEnd = std::chrono::high_resolution_clock::now();
+    mStats.cpuTimeMs += std::chrono::duration<float, std::milli>(cpuEnd - cpuStart).count();
+}
+
+VkCommandBuffer SceneRenderer::acquireSecondaryCommandBuffer(RecordContext& context) {
+    if (context.usedCount == context.commandBuffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool        = context.commandPool;
+        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+        vkAllocateCommandBuffers(VulkanContext::getDevice(), &allocInfo, &commandBuffer);
+        context.commandBuffers.push_back(commandBuffer);
+    }
+    return context.commandBuffers[context.usedCount++];
+}
+
+void SceneRenderer::createPassDescriptorSets() {
+    if(auto* skybox = mRegistry->ctx().find<CSkyBox>()) {
+        if(!mSkyBoxDescriptorSet1) {
+            mSkyBoxDescriptorSet0= mDescriptorPool.allocate(mSkyboxShader->getDescriptorSetLayouts()[0]);
+            mSkyBoxDescriptorSet1= mDescriptorPool.allocate(mSkyboxShader->getDescriptorSetLayouts()[1]);
+
+            VkDescriptorBufferInfo bufferInfo = getPerFrameBufferInfo();
+
+            VkWriteDescriptorSet writeDescriptorSet[1]{};
+            writeDescriptorSet[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet[0].dstSet          = mSkyBoxDescriptorSet0;
+            writeDescriptorSet[0].dstBinding      = 0;
+            writeDescriptorSet[0].descriptorCount = 1;
+            writeDescriptorSet[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            writeDescriptorSet[0].pBufferInfo     = &bufferInfo;
+            vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet, 0, nullptr);
+
+            VkDescriptorImageInfo descriptorImageInfo;
+            descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+            descriptorImageInfo.imageView   = skybox->texture->getImageView();
+            descriptorImageInfo.sampler     = skybox->texture->getSampler();
+
+            VkWriteDescriptorSet writeDescriptorSet2[1]{};
+            writeDescriptorSet2[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet2[0].dstSet          = mSkyBoxDescriptorSet1;
+            writeDescriptorSet2[0].dstBinding      = 0;
+            writeDescriptorSet2[0].descriptorCount = 1;
+            writeDescriptorSet2[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writeDescriptorSet2[0].pImageInfo      = &descriptorImageInfo;
+            vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet2, 0, nullptr);
+        }
+    }
+
+    if(mTerrainVisible) {
+        auto view           = mRegistry->view<CTransform, CTerrain>();
+        for (auto [entity, ctrans, cterrain] : view.each()) {
+            if(!mDrawTerrain.descriptorSet1) {
+                mDrawTerrain.descriptorSet1 = mDescriptorPool.allocate(mDrawTerrain.pipeline->getDescriptorSetLayouts()[1]);
+                VulkanContext::setDebugObjectName((uint64_t)mDrawTerrain.descriptorSet1, VK_OBJECT_TYPE_DESCRIPTOR_SET, "TerrainDescriptorSet1" );
+                VulkanContext::setDebugObjectName((uint64_t)mDrawTerrain.pipeline->getDescriptorSetLayouts()[1], VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "TerrainDescriptorSetLayout1" );
 
                 VkDescriptorImageInfo descriptorImageInfo;
                 descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                descriptorImageInfo.imageView   = skybox->texture->getImageView();
-                descriptorImageInfo.sampler     = skybox->texture->getSampler();
-
-                VkWriteDescriptorSet writeDescriptorSet2[1]{};
-                writeDescriptorSet2[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                writeDescriptorSet2[0].dstSet          = mSkyBoxDescriptorSet1;
-                writeDescriptorSet2[0].dstBinding      = 0;
-                writeDescriptorSet2[0].descriptorCount = 1;
-                writeDescriptorSet2[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                writeDescriptorSet2[0].pImageInfo      = &descriptorImageInfo;
-                vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet2, 0, nullptr);
-            }
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mSkyboxPipeline->getPipelineLayout(), 0 /*firstSet*/, 1 /*nbSet*/, &mSkyBoxDescriptorSet0, 0, nullptr);
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mSkyboxPipeline->getPipelineLayout(), 1 /*firstSet*/, 1 /*nbSet*/, &mSkyBoxDescriptorSet1, 0, nullptr);
+                descriptorImageInfo.imageView   = cterrain.terrain->getHeightMap()->getImageView();
+                descriptorImageInfo.sampler     = cterrain.terrain->getHeightMap()->getSampler();
+
+                VkWriteDescriptorSet writeDescriptorSet{};
+                writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
+                writeDescriptorSet.dstBinding      = 0;
+                writeDescriptorSet.descriptorCount = 1;
+                writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writeDescriptorSet.pImageInfo      = &descriptorImageInfo;
+                vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+
+                // buffers
+                {
+                    VkDescriptorBufferInfo descriptorInfo;
+                    descriptorInfo.buffer = mTerrainSettings->getBuffer();
+                    descriptorInfo.offset = 0;
+                    descriptorInfo.range  = VK_WHOLE_SIZE;
 
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mSkyboxPipeline->getPipeline());
-            //Renderer::DrawMesh(cmd, skyBoxMesh);
-            VkDeviceSize offset{};
-            VkBuffer buffer = mSkyBoxVertexBuffer->getBuffer();
-            vkCmdBindVertexBuffers(cmd, 0, 1, &buffer, &offset);
-            vkCmdBindIndexBuffer(cmd, mSkyBoxIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-            vkCmdDrawIndexed(cmd, 36, 1, 0, 0, 1);
+                    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                    writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
+                    writeDescriptorSet.dstBinding      = 1;
+                    writeDescriptorSet.descriptorCount = 1;
+                    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                    writeDescriptorSet.pBufferInfo      = &descriptorInfo;
+                    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+                }
+
+                // diffuse map
+                {
+                    VkDescriptorImageInfo imageInfo[5]{};
+                    imageInfo[0].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[0].imageView      = cterrain.diffuseMap0->getImageView();
+                    imageInfo[0].sampler        = cterrain.diffuseMap0->getSampler();
+                    imageInfo[1].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[1].imageView      = cterrain.diffuseMap1->getImageView();
+                    imageInfo[1].sampler        = cterrain.diffuseMap1->getSampler();
+                    imageInfo[2].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[2].imageView      = cterrain.diffuseMap2->getImageView();
+                    imageInfo[2].sampler        = cterrain.diffuseMap2->getSampler();
+                    imageInfo[3].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[3].imageView      = cterrain.diffuseMap3->getImageView();
+                    imageInfo[3].sampler        = cterrain.diffuseMap3->getSampler();
+                    imageInfo[4].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[4].imageView      = cterrain.diffuseMap4->getImageView();
+                    imageInfo[4].sampler        = cterrain.diffuseMap4->getSampler();
+                    writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
+                    writeDescriptorSet.dstBinding      = 2;
+                    writeDescriptorSet.descriptorCount = 5;
+                    writeDescriptorSet.dstArrayElement = 0;
+                    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    writeDescriptorSet.pImageInfo      = imageInfo;
+                    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+                }
+                // normal map
+                {
+                    VkDescriptorImageInfo imageInfo[5]{};
+                    imageInfo[0].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[0].imageView      = cterrain.normalMap0->getImageView();
+                    imageInfo[0].sampler        = cterrain.normalMap0->getSampler();
+                    imageInfo[1].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[1].imageView      = cterrain.normalMap1->getImageView();
+                    imageInfo[1].sampler        = cterrain.normalMap1->getSampler();
+                    imageInfo[2].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[2].imageView      = cterrain.normalMap2->getImageView();
+                    imageInfo[2].sampler        = cterrain.normalMap2->getSampler();
+                    imageInfo[3].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[3].imageView      = cterrain.normalMap3->getImageView();
+                    imageInfo[3].sampler        = cterrain.normalMap3->getSampler();
+                    imageInfo[4].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[4].imageView      = cterrain.normalMap4->getImageView();
+                    imageInfo[4].sampler        = cterrain.normalMap4->getSampler();
+                    writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
+                    writeDescriptorSet.dstBinding      = 3;
+                    writeDescriptorSet.descriptorCount = 5;
+                    writeDescriptorSet.dstArrayElement = 0;
+                    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    writeDescriptorSet.pImageInfo      = imageInfo;
+                    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+                }
+                // specular map
+                {
+                    VkDescriptorImageInfo imageInfo[5]{};
+                    imageInfo[0].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[0].imageView      = cterrain.specularMap0->getImageView();
+                    imageInfo[0].sampler        = cterrain.specularMap0->getSampler();
+                    imageInfo[1].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[1].imageView      = cterrain.specularMap1->getImageView();
+                    imageInfo[1].sampler        = cterrain.specularMap1->getSampler();
+                    imageInfo[2].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[2].imageView      = cterrain.specularMap2->getImageView();
+                    imageInfo[2].sampler        = cterrain.specularMap2->getSampler();
+                    imageInfo[3].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[3].imageView      = cterrain.specularMap3->getImageView();
+                    imageInfo[3].sampler        = cterrain.specularMap3->getSampler();
+                    imageInfo[4].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                    imageInfo[4].imageView      = cterrain.specularMap4->getImageView();
+                    imageInfo[4].sampler        = cterrain.specularMap4->getSampler();
+                    writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
+                    writeDescriptorSet.dstBinding      = 4;
+                    writeDescriptorSet.descriptorCount = 5;
+                    writeDescriptorSet.dstArrayElement = 0;
+                    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    writeDescriptorSet.pImageInfo      = imageInfo;
+                    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+                }
+
+                // blend map
+                descriptorImageInfo.imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                descriptorImageInfo.imageView      = cterrain.blendMap->getImageView();
+                descriptorImageInfo.sampler        = cterrain.blendMap->getSampler();
+                writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
+                writeDescriptorSet.dstBinding      = 5;
+                writeDescriptorSet.descriptorCount = 1;
+                writeDescriptorSet.dstArrayElement = 0;
+                writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writeDescriptorSet.pImageInfo      = &descriptorImageInfo;
+                vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+            }
         }
     }
+}
 
-    // Render Mesh AABB
-    {
-        vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawMeshAABB.pipeline->getPipeline());
-        vkCmdBindDescriptorSets(
+uint32_t SceneRenderer::getMeshPassSize() const {
+    if (mUseGpuCulling || mUseInstancing) {
+        return static_cast<uint32_t>(mMeshInstanced.drawGroups.size());
+    }
+    return static_cast<uint32_t>(mDrawItems.size());
+}
+
+VkDescriptorBufferInfo SceneRenderer::getPerFrameBufferInfo() const {
+    // The offset is given at bind time, see mFrameDynamicOffsets.
+    return {mFrameAllocator.getBuffer(), 0, sizeof(PerFrameData)};
+}
+
+VkDescriptorBufferInfo SceneRenderer::getLightDataBufferInfo() const {
+    return {mFrameAllocator.getBuffer(), 0, sizeof(LightData)};
+}
+
+void SceneRenderer::drawMeshPass(VkCommandBuffer     cmd,
+                                 uint32_t            first,
+                                 uint32_t            count,
+                                 SceneRendererStats& stats,
+                                 MeshPass            pass) {
+    if (mUseGpuCulling) {
+        drawMeshesIndirect(cmd, first, count, stats, pass);
+    } else if (mUseInstancing) {
+        drawMeshesInstanced(cmd, first, count, stats, pass);
+    } else {
+        drawMeshes(cmd, first, count, stats, pass);
+    }
+}
+
+void SceneRenderer::drawSkybox(VkCommandBuffer cmd) {
+    if(auto* skybox = mRegistry->ctx().find<CSkyBox>()) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mSkyboxPipeline->getPipelineLayout(), 0 /*firstSet*/, 1 /*nbSet*/, &mSkyBoxDescriptorSet0, 1, mFrameDynamicOffsets.data());
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mSkyboxPipeline->getPipelineLayout(), 1 /*firstSet*/, 1 /*nbSet*/, &mSkyBoxDescriptorSet1, 0, nullptr);
+
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mSkyboxPipeline->getPipeline());
+        //Renderer::DrawMesh(cmd, skyBoxMesh);
+        VkDeviceSize offset{};
+        VkBuffer buffer = mSkyBoxVertexBuffer->getBuffer();
+        vkCmdBindVertexBuffers(cmd, 0, 1, &buffer, &offset);
+        vkCmdBindIndexBuffer(cmd, mSkyBoxIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexed(cmd, 36, 1, 0, 0, 1);
+    }
+}
+
+void SceneRenderer::drawMeshAABBs(VkCommandBuffer cmd) {
+    vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawMeshAABB.pipeline->getPipeline());
+    vkCmdBindDescriptorSets(
+        cmd,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        mDrawMeshAABB.pipeline->getPipelineLayout(),
+        0 /*firstSet*/,
+        1 /*nbSet*/,
+        &mDrawMeshAABB.descriptorSet,
+        1 /*dynamicOffsetCount*/,
+        mFrameDynamicOffsets.data()
+    );
+
+    struct {
+        glm::mat4 transform;
+        glm::vec3 min;
+        float _pad0;
+        glm::vec3 max;
+        float _pad1;
+        glm::vec3 color;
+    }aabb;
+    auto view           = mRegistry->view<CWorldTransform, CMesh>();
+    for (auto [entity, world, cmesh] : view.each()) {
+        aabb.transform = world.model;
+#if 1
+        aabb.color   = {0.f, 1.f, 0.f};
+        aabb.min     = cmesh.mesh.aabbMin;
+        aabb.max     = cmesh.mesh.aabbMax;
+        vkCmdPushConstants(
             cmd,
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
             mDrawMeshAABB.pipeline->getPipelineLayout(),
-            0 /*firstSet*/,
-            1 /*nbSet*/,
-            &mDrawMeshAABB.descriptorSet,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
             0,
-            nullptr
+            sizeof(aabb),
+            reinterpret_cast<void*>(&aabb)
         );
 
-        struct {
-            glm::mat4 transform;
-            glm::vec3 min;
-            float _pad0;
-            glm::vec3 max;
-            float _pad1;
-            glm::vec3 color;
-        }aabb;
-        auto view           = mRegistry->view<CTransform, CMesh>();
-        for (auto [entity, ctrans, cmesh] : view.each()) {
-            auto translateMat  = glm::translate(glm::mat4(1), ctrans.position);
-            auto rotationMat   = glm::eulerAngleYXZ(glm::radians(ctrans.rotation.y), glm::radians(ctrans.rotation.x), glm::radians(ctrans.rotation.z));
-            auto scaleMat      = glm::scale(glm::mat4(1), ctrans.scale);
-            aabb.transform = translateMat * rotationMat * scaleMat;
-#if 1
-            aabb.color   = {0.f, 1.f, 0.f};
-            aabb.min     = cmesh.mesh.aabbMin;
-            aabb.max     = cmesh.mesh.aabbMax;
+        vkCmdDraw(cmd, 1, 1, 0, 0);
+#else
+        for(const auto& submesh : cmesh.mesh.getSubMeshes()) {
+            aabb.color   = {0.f, 0.f, 1.f};
+            aabb.min = submesh.aabbMin;
+            aabb.max = submesh.aabbMax;
             vkCmdPushConstants(
                 cmd,
                 mDrawMeshAABB.pipeline->getPipelineLayout(),
@@ -646,263 +1281,996 @@ void SceneRenderer::render(entt::registry*  registry,
                 sizeof(aabb),
                 reinterpret_cast<void*>(&aabb)
             );
-
             vkCmdDraw(cmd, 1, 1, 0, 0);
-#else
-            for(const auto& submesh : cmesh.mesh.subMeshs) {
-                aabb.color   = {0.f, 0.f, 1.f};
-                aabb.min = submesh.aabbMin;
-                aabb.max = submesh.aabbMax;
-                vkCmdPushConstants(
-                    cmd,
-                    mDrawMeshAABB.pipeline->getPipelineLayout(),
-                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                    0,
-                    sizeof(aabb),
-                    reinterpret_cast<void*>(&aabb)
-                );
-                vkCmdDraw(cmd, 1, 1, 0, 0);
-            }
-#endif
         }
+#endif
     }
+}
 
-    // Render Mesh Normals
-    {
-        vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawMeshNormals.pipeline->getPipeline());
-        vkCmdBindDescriptorSets(
+void SceneRenderer::drawMeshNormals(VkCommandBuffer cmd) {
+    vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawMeshNormals.pipeline->getPipeline());
+    vkCmdBindDescriptorSets(
+        cmd,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        mDrawMeshNormals.pipeline->getPipelineLayout(),
+        0 /*firstSet*/,
+        1 /*nbSet*/,
+        &mDrawMeshNormals.descriptorSet,
+        1 /*dynamicOffsetCount*/,
+        mFrameDynamicOffsets.data()
+    );
+
+    struct {
+        glm::mat4 transform;
+        glm::mat4 normalMatrix;
+    }aabb;
+    VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+    auto view           = mRegistry->view<CWorldTransform, CMesh>();
+    for (auto [entity, world, cmesh] : view.each()) {
+        // The pipeline reads the float vertices only.
+        if (cmesh.mesh.vertexFormat != MeshVertexFormat::Float || !cmesh.mesh.isReady()) {
+            continue;
+        }
+        aabb.transform     = world.model;
+        aabb.normalMatrix  = world.normalMatrix;
+        vkCmdPushConstants(
             cmd,
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
             mDrawMeshNormals.pipeline->getPipelineLayout(),
-            0 /*firstSet*/,
-            1 /*nbSet*/,
-            &mDrawMeshNormals.descriptorSet,
+            VK_SHADER_STAGE_VERTEX_BIT,
             0,
-            nullptr
+            sizeof(aabb),
+            reinterpret_cast<void*>(&aabb)
         );
 
-        struct {
-            glm::mat4 transform;
-            glm::mat4 normalMatrix;
-        }aabb;
-        auto view           = mRegistry->view<CTransform, CMesh>();
-        for (auto [entity, ctrans, cmesh] : view.each()) {
-            const auto translateMat  = glm::translate(glm::mat4(1), ctrans.position);
-            const auto rotationMat   = glm::eulerAngleYXZ(glm::radians(ctrans.rotation.y), glm::radians(ctrans.rotation.x), glm::radians(ctrans.rotation.z));
-            const auto scaleMat      = glm::scale(glm::mat4(1), ctrans.scale);
-            aabb.transform     = translateMat * rotationMat * scaleMat;
-            aabb.normalMatrix  = glm::transpose(glm::inverse(aabb.transform));
-            vkCmdPushConstants(
+        // The arena buffers are bound again only when the index type changes.
+        if (cmesh.mesh.indexType != indexType) {
+            Renderer::BindMesh(cmd, cmesh.mesh);
+            indexType = cmesh.mesh.indexType;
+        }
+        Renderer::DrawSubMeshes(cmd, cmesh.mesh);
+    }
+}
+
+void SceneRenderer::drawTerrain(VkCommandBuffer cmd) {
+    //vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawTerrain.pipeline->getPipeline());
+    vkCmdBindDescriptorSets(
+        cmd,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        mDrawTerrain.pipeline->getPipelineLayout(),
+        0 /*firstSet*/,
+        1 /*nbSet*/,
+        &mDrawTerrain.descriptorSet0[mFrameIndex],
+        2 /*dynamicOffsetCount*/,
+        mFrameDynamicOffsets.data()
+    );
+
+    if(mTerrainVisible) {
+        auto view           = mRegistry->view<CTransform, CTerrain>();
+        for (auto [entity, ctrans, cterrain] : view.each()) {
+            vkCmdBindDescriptorSets(
                 cmd,
-                mDrawMeshNormals.pipeline->getPipelineLayout(),
-                VK_SHADER_STAGE_VERTEX_BIT,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                mDrawTerrain.pipeline->getPipelineLayout(),
+                1 /*firstSet*/,
+                1 /*nbSet*/,
+                &mDrawTerrain.descriptorSet1,
                 0,
-                sizeof(aabb),
-                reinterpret_cast<void*>(&aabb)
+                nullptr
             );
 
-            Renderer::DrawMesh(cmd, cmesh.mesh);
+            VkDeviceSize offset{};
+            VkBuffer buffer = cterrain.terrain->getVertexBuffer()->getBuffer();
+            vkCmdBindVertexBuffers(cmd, 0, 1, &buffer, &offset);
+            vkCmdBindIndexBuffer(cmd, cterrain.terrain->getIndexBuffer()->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdDrawIndexed(cmd, cterrain.terrain->getNumIndices(), 1, 0, 0, 1);
+
+            if(mTerrainAABBVisible) {
+                vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawMeshAABB.pipeline->getPipeline());
+                vkCmdBindDescriptorSets(
+                    cmd,
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    mDrawMeshAABB.pipeline->getPipelineLayout(),
+                    0 /*firstSet*/,
+                    1 /*nbSet*/,
+                    &mDrawMeshAABB.descriptorSet,
+                    1 /*dynamicOffsetCount*/,
+                    mFrameDynamicOffsets.data()
+                );
+
+                struct {
+                    glm::mat4 transform;
+                    glm::vec3 min;
+                    float _pad0;
+                    glm::vec3 max;
+                    float _pad1;
+                    glm::vec3 color;
+                }aabb;
+                for(unsigned i = 0; i < 1024; i++) {
+                    aabb.transform = glm::mat4(1);
+                    if(i % 2) {
+                        aabb.color   = {1.f, 1.f, 1.f};
+                    } else {
+                        aabb.color   = {0.f, 0.f, 1.f};
+                    }
+
+                    cterrain.terrain->getBound(i, aabb.min, aabb.max);
+                    vkCmdPushConstants(cmd, mDrawMeshAABB.pipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(aabb), reinterpret_cast<void*>(&aabb));
+                    vkCmdDraw(cmd, 1, 1, 0, 0);
+                }
+            }
         }
     }
+}
 
-    // Render Terrain
-    {
-        //vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawTerrain.pipeline->getPipeline());
-        vkCmdBindDescriptorSets(
-            cmd,
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            mDrawTerrain.pipeline->getPipelineLayout(),
-            0 /*firstSet*/,
-            1 /*nbSet*/,
-            &mDrawTerrain.descriptorSet0,
-            0,
-            nullptr
-        );
+void SceneRenderer::createMaterialDescriptorSet(CMaterial& cmat) {
+    // The descriptor set only holds the maps, the materials using the same maps share it.
+    const MaterialMaps maps{cmat.diffuseMap, cmat.specularMap, cmat.normalMap};
+    if (auto it = mMaterialSets.find(maps); it != mMaterialSets.end()) {
+        cmat.descriptorSet1 = it->second.descriptorSet;
+        cmat.sortId         = it->second.sortId;
+        return;
+    }
 
-        if(mTerrainVisible) {
-            auto view           = mRegistry->view<CTransform, CTerrain>();
-            for (auto [entity, ctrans, cterrain] : view.each()) {
-                if(!mDrawTerrain.descriptorSet1) {
-                    mDrawTerrain.descriptorSet1 = mDescriptorPool.allocate(mDrawTerrain.pipeline->getDescriptorSetLayouts()[1]);
-                    VulkanContext::setDebugObjectName((uint64_t)mDrawTerrain.descriptorSet0, VK_OBJECT_TYPE_DESCRIPTOR_SET, "TerrainDescriptorSet1" );
-                    VulkanContext::setDebugObjectName((uint64_t)mDrawTerrain.pipeline->getDescriptorSetLayouts()[1], VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "TerrainDescriptorSetLayout1" );
+    MaterialSet materialSet;
+    if (mFreeMaterialSets.empty()) {
+        materialSet.descriptorSet = mDescriptorPool.allocate(mMeshPipeline->getDescriptorSetLayouts()[1]);
+        // Each allocated set is either in the cache or in the free list.
+        materialSet.sortId = static_cast<uint32_t>(mMaterialSets.size() + mFreeMaterialSets.size());
+    } else {
+        materialSet              = mFreeMaterialSets.back();
+        materialSet.releaseFrame = 0;
+        mFreeMaterialSets.pop_back();
+    }
+    cmat.descriptorSet1 = materialSet.descriptorSet;
+    cmat.sortId         = materialSet.sortId;
+    mMaterialSets.emplace(maps, materialSet);
+
+    VkDescriptorImageInfo descriptorImageInfo;
+    descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+    descriptorImageInfo.imageView   = cmat.diffuseMap->getImageView();
+    descriptorImageInfo.sampler     = cmat.diffuseMap->getSampler();
+
+    VkWriteDescriptorSet writeDescriptorSet2[1]{};
+    writeDescriptorSet2[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet2[0].dstSet          = cmat.descriptorSet1;
+    writeDescriptorSet2[0].dstBinding      = 2;
+    writeDescriptorSet2[0].descriptorCount = 1;
+    writeDescriptorSet2[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writeDescriptorSet2[0].pImageInfo      = &descriptorImageInfo;
+    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet2, 0, nullptr);
+
+    descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+    descriptorImageInfo.imageView   = cmat.specularMap->getImageView();
+    descriptorImageInfo.sampler     = cmat.specularMap->getSampler();
+    writeDescriptorSet2[0].dstBinding =3;
+    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet2, 0, nullptr);
+
+    descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+    descriptorImageInfo.imageView   = cmat.normalMap->getImageView();
+    descriptorImageInfo.sampler     = cmat.normalMap->getSampler();
+    writeDescriptorSet2[0].dstBinding =4;
+    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, writeDescriptorSet2, 0, nullptr);
+}
 
-                    VkDescriptorImageInfo descriptorImageInfo;
-                    descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                    descriptorImageInfo.imageView   = cterrain.terrain->getHeightMap()->getImageView();
-                    descriptorImageInfo.sampler     = cterrain.terrain->getHeightMap()->getSampler();
+uint32_t SceneRenderer::getMeshSortId(const VulkanGeometryArena::Allocation* geometry, uint32_t lod) const {
+    // The LODs of a mesh are different draws. The allocation ids are never reused, a wrapped id
+    // only degrades the sort.
+    return geometry->id * MeshSimplifier::kMaxLodCount + lod;
+}
 
-                    VkWriteDescriptorSet writeDescriptorSet{};
-                    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
-                    writeDescriptorSet.dstBinding      = 0;
-                    writeDescriptorSet.descriptorCount = 1;
-                    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                    writeDescriptorSet.pImageInfo      = &descriptorImageInfo;
-                    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+uint32_t SceneRenderer::selectMeshLod(const Mesh& mesh, const glm::mat4& model) const {
+    if (!mUseLod || mesh.getLodCount() <= 1) {
+        return 0;
+    }
 
-                    // buffers
-                    {
-                        VkDescriptorBufferInfo descriptorInfo;
-                        descriptorInfo.buffer = mTerrainSettings->getBuffer();
-                        descriptorInfo.offset = 0;
-                        descriptorInfo.range  = VK_WHOLE_SIZE;
-
-                        writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                        writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
-                        writeDescriptorSet.dstBinding      = 1;
-                        writeDescriptorSet.descriptorCount = 1;
-                        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                        writeDescriptorSet.pBufferInfo      = &descriptorInfo;
-                        vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
-                    }
+    // Bounding sphere of the AABB in world space, the largest scale of the model is used for the error.
+    const float     scale  = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+                                       glm::length(glm::vec3(model[2]))});
+    const glm::vec3 center = glm::vec3(model * glm::vec4((mesh.aabbMin + mesh.aabbMax) * 0.5f, 1.0f));
+    const float     radius = glm::length(mesh.aabbMax - mesh.aabbMin) * 0.5f * scale;
+
+    // An error e at distance d covers e * proj[1][1] / d * height / 2 pixels, the nearest point
+    // of the sphere is used. The maximum error is converted back to mesh units.
+    const float distance = std::max(glm::distance(mViewPosition, center) - radius, 1e-3f);
+    const float maxError = mLodPixelError * 2.0f * distance / (mProjectionScaleY * mViewportHeight * scale);
+    return mesh.selectLod(maxError);
+}
 
-                    // diffuse map
-                    {
-                        VkDescriptorImageInfo imageInfo[5]{};
-                        imageInfo[0].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[0].imageView      = cterrain.diffuseMap0->getImageView();
-                        imageInfo[0].sampler        = cterrain.diffuseMap0->getSampler();
-                        imageInfo[1].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[1].imageView      = cterrain.diffuseMap1->getImageView();
-                        imageInfo[1].sampler        = cterrain.diffuseMap1->getSampler();
-                        imageInfo[2].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[2].imageView      = cterrain.diffuseMap2->getImageView();
-                        imageInfo[2].sampler        = cterrain.diffuseMap2->getSampler();
-                        imageInfo[3].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[3].imageView      = cterrain.diffuseMap3->getImageView();
-                        imageInfo[3].sampler        = cterrain.diffuseMap3->getSampler();
-                        imageInfo[4].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[4].imageView      = cterrain.diffuseMap4->getImageView();
-                        imageInfo[4].sampler        = cterrain.diffuseMap4->getSampler();
-                        writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
-                        writeDescriptorSet.dstBinding      = 2;
-                        writeDescriptorSet.descriptorCount = 5;
-                        writeDescriptorSet.dstArrayElement = 0;
-                        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                        writeDescriptorSet.pImageInfo      = imageInfo;
-                        vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
-                    }
-                    // normal map
-                    {
-                        VkDescriptorImageInfo imageInfo[5]{};
-                        imageInfo[0].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[0].imageView      = cterrain.normalMap0->getImageView();
-                        imageInfo[0].sampler        = cterrain.normalMap0->getSampler();
-                        imageInfo[1].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[1].imageView      = cterrain.normalMap1->getImageView();
-                        imageInfo[1].sampler        = cterrain.normalMap1->getSampler();
-                        imageInfo[2].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[2].imageView      = cterrain.normalMap2->getImageView();
-                        imageInfo[2].sampler        = cterrain.normalMap2->getSampler();
-                        imageInfo[3].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[3].imageView      = cterrain.normalMap3->getImageView();
-                        imageInfo[3].sampler        = cterrain.normalMap3->getSampler();
-                        imageInfo[4].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[4].imageView      = cterrain.normalMap4->getImageView();
-                        imageInfo[4].sampler        = cterrain.normalMap4->getSampler();
-                        writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
-                        writeDescriptorSet.dstBinding      = 3;
-                        writeDescriptorSet.descriptorCount = 5;
-                        writeDescriptorSet.dstArrayElement = 0;
-                        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                        writeDescriptorSet.pImageInfo      = imageInfo;
-                        vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
-                    }
-                    // specular map
-                    {
-                        VkDescriptorImageInfo imageInfo[5]{};
-                        imageInfo[0].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[0].imageView      = cterrain.specularMap0->getImageView();
-                        imageInfo[0].sampler        = cterrain.specularMap0->getSampler();
-                        imageInfo[1].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[1].imageView      = cterrain.specularMap1->getImageView();
-                        imageInfo[1].sampler        = cterrain.specularMap1->getSampler();
-                        imageInfo[2].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[2].imageView      = cterrain.specularMap2->getImageView();
-                        imageInfo[2].sampler        = cterrain.specularMap2->getSampler();
-                        imageInfo[3].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[3].imageView      = cterrain.specularMap3->getImageView();
-                        imageInfo[3].sampler        = cterrain.specularMap3->getSampler();
-                        imageInfo[4].imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                        imageInfo[4].imageView      = cterrain.specularMap4->getImageView();
-                        imageInfo[4].sampler        = cterrain.specularMap4->getSampler();
-                        writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
-                        writeDescriptorSet.dstBinding      = 4;
-                        writeDescriptorSet.descriptorCount = 5;
-                        writeDescriptorSet.dstArrayElement = 0;
-                        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                        writeDescriptorSet.pImageInfo      = imageInfo;
-                        vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
-                    }
+VkDescriptorSet SceneRenderer::getQuantizationDescriptorSet(const Mesh& mesh) {
+    if (mesh.vertexFormat != MeshVertexFormat::Packed) {
+        return VK_NULL_HANDLE;
+    }
 
-                    // blend map
-                    descriptorImageInfo.imageLayout    = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-                    descriptorImageInfo.imageView      = cterrain.blendMap->getImageView();
-                    descriptorImageInfo.sampler        = cterrain.blendMap->getSampler();
-                    writeDescriptorSet.dstSet          = mDrawTerrain.descriptorSet1;
-                    writeDescriptorSet.dstBinding      = 5;
-                    writeDescriptorSet.descriptorCount = 1;
-                    writeDescriptorSet.dstArrayElement = 0;
-                    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                    writeDescriptorSet.pImageInfo      = &descriptorImageInfo;
-                    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
-                }
-                vkCmdBindDescriptorSets(
-                    cmd,
-                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    mDrawTerrain.pipeline->getPipelineLayout(),
-                    1 /*firstSet*/,
-                    1 /*nbSet*/,
-                    &mDrawTerrain.descriptorSet1,
-                    0,
-                    nullptr
-                );
+    // The entry holds the buffer, its handle can not be reused by another mesh while the set exists.
+    const auto [it, inserted] = mQuantizationSets.try_emplace(mesh.quantizationBuffer);
+    if (!inserted) {
+        return it->second.descriptorSet;
+    }
 
-                VkDeviceSize offset{};
-                VkBuffer buffer = cterrain.terrain->getVertexBuffer()->getBuffer();
-                vkCmdBindVertexBuffers(cmd, 0, 1, &buffer, &offset);
-                vkCmdBindIndexBuffer(cmd, cterrain.terrain->getIndexBuffer()->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-                vkCmdDrawIndexed(cmd, cterrain.terrain->getNumIndices(), 1, 0, 0, 1);
-
-                if(mTerrainAABBVisible) {
-                    vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
-                    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawMeshAABB.pipeline->getPipeline());
-                    vkCmdBindDescriptorSets(
-                        cmd,
-                        VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        mDrawMeshAABB.pipeline->getPipelineLayout(),
-                        0 /*firstSet*/,
-                        1 /*nbSet*/,
-                        &mDrawMeshAABB.descriptorSet,
-                        0,
-                        nullptr
-                    );
-
-                    struct {
-                        glm::mat4 transform;
-                        glm::vec3 min;
-                        float _pad0;
-                        glm::vec3 max;
-                        float _pad1;
-                        glm::vec3 color;
-                    }aabb;
-                    for(unsigned i = 0; i < 1024; i++) {
-                        aabb.transform = glm::mat4(1);
-                        if(i % 2) {
-                            aabb.color   = {1.f, 1.f, 1.f};
-                        } else {
-                            aabb.color   = {0.f, 0.f, 1.f};
-                        }
-
-                        cterrain.terrain->getBound(i, aabb.min, aabb.max);
-                        vkCmdPushConstants(cmd, mDrawMeshAABB.pipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(aabb), reinterpret_cast<void*>(&aabb));
-                        vkCmdDraw(cmd, 1, 1, 0, 0);
-                    }
+    // The set 2 layout is the same in the packed pipelines, the instanced one included.
+    if (mFreeQuantizationSets.empty()) {
+        it->second.descriptorSet = mDescriptorPool.allocate(mMeshPackedPipeline->getDescriptorSetLayouts()[2]);
+    } else {
+        it->second.descriptorSet = mFreeQuantizationSets.back();
+        mFreeQuantizationSets.pop_back();
+    }
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = mesh.quantizationBuffer->getBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range  = VK_WHOLE_SIZE;
+
+    VkWriteDescriptorSet writeDescriptorSet{};
+    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet          = it->second.descriptorSet;
+    writeDescriptorSet.dstBinding      = 0;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo     = &bufferInfo;
+    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+    return it->second.descriptorSet;
+}
+
+void SceneRenderer::releaseCachedSets() {
+    // Nothing but the cache can use a resource it is the last owner of. The entry is dropped once
+    // the frames in flight which drew with it are done, its set is reused by the next entry.
+    const auto isReleased = [this](bool lastOwner, uint64_t& releaseFrame) {
+        if (!lastOwner) {
+            return false;
+        }
+        if (releaseFrame == 0) {
+            releaseFrame = mFrameNumber;
+        }
+        return mFrameNumber >= releaseFrame + mFrameInFlightCount;
+    };
+
+    // A material holds all its maps, the set is unused once one of them is only held by the cache.
+    // A map may be used twice by the same key.
+    std::erase_if(mMaterialSets, [&](auto& entry) {
+        const auto& [diffuseMap, specularMap, normalMap] = entry.first;
+        const auto isCacheOwned = [&](const VulkanTexturePtr& map) {
+            return map.use_count() <= (map == diffuseMap) + (map == specularMap) + (map == normalMap);
+        };
+        const bool lastOwner = isCacheOwned(diffuseMap) || isCacheOwned(specularMap) || isCacheOwned(normalMap);
+        if (!isReleased(lastOwner, entry.second.releaseFrame)) {
+            return false;
+        }
+        mFreeMaterialSets.push_back(entry.second);
+        return true;
+    });
+
+    std::erase_if(mQuantizationSets, [&](auto& entry) {
+        if (!isReleased(entry.first.use_count() == 1, entry.second.releaseFrame)) {
+            return false;
+        }
+        mFreeQuantizationSets.push_back(entry.second.descriptorSet);
+        return true;
+    });
+}
+
+void SceneRenderer::buildRenderQueue() {
+    mDrawItems.clear();
+    mRenderQueue.clear();
+
+    auto view = mRegistry->view<CWorldTransform, CMesh, CMaterial>();
+    for (auto [entity, world, cmesh, cmat] : view.each()) {
+        // The meshes and the maps still uploading are drawn once acquired.
+        if (!cmesh.mesh.isReady() || !cmat.isReady() || isCpuCulled(entity)) {
+            continue;
+        }
+
+        if(cmat.descriptorSet1 == VK_NULL_HANDLE) {
+            createMaterialDescriptorSet(cmat);
+        }
+
+        const auto*    geometry     = cmesh.mesh.geometry.get();
+        const uint32_t lod          = selectMeshLod(cmesh.mesh, world.model);
+        const float    depth        = glm::distance(mViewPosition, glm::vec3(world.model[3]));
+        const uint32_t pipeline     = cmesh.mesh.vertexFormat == MeshVertexFormat::Packed ? kMeshPackedPipelineSortId
+                                                                                          : kMeshPipelineSortId;
+        mRenderQueue.push(RenderQueue::MakeKey(pipeline, cmat.sortId,
+                                               getMeshSortId(geometry, lod), depth, kMaxSortDepth),
+                          static_cast<uint32_t>(mDrawItems.size()));
+        mDrawItems.push_back({cmat.descriptorSet1, getQuantizationDescriptorSet(cmesh.mesh), geometry,
+                              &cmesh.mesh, lod, depth, entity, &world, &cmat});
+    }
+
+    // Entities sharing the same material and the same geometry end up next to each
+    // other, front to back. The draw items are reordered so every pass walks them linearly.
+    mRenderQueue.sort();
+    mDrawItemsScratch.resize(mDrawItems.size());
+    const auto& items = mRenderQueue.getItems();
+    for (size_t i = 0; i < items.size(); ++i) {
+        mDrawItemsScratch[i] = mDrawItems[items[i].index];
+    }
+    mDrawItems.swap(mDrawItemsScratch);
+}
+
+void SceneRenderer::buildDepthQueue() {
+    // The depth pre-pass ignores the materials, the draws are only sorted by vertex format then
+    // front to back. A draw group is as near as its nearest instance.
+    mDepthQueue.clear();
+    const auto pipelineSortId = [](const Mesh& mesh) {
+        return mesh.vertexFormat == MeshVertexFormat::Packed ? kMeshPackedPipelineSortId : kMeshPipelineSortId;
+    };
+    if (mUseGpuCulling || mUseInstancing) {
+        const auto& drawGroups = mMeshInstanced.drawGroups;
+        for (uint32_t groupIndex = 0; groupIndex < drawGroups.size(); ++groupIndex) {
+            const DrawGroup& group = drawGroups[groupIndex];
+            float            depth = kMaxSortDepth;
+            for (uint32_t i = group.firstInstance; i < group.firstInstance + group.instanceCount; ++i) {
+                depth = std::min(depth, mDrawItems[i].depth);
+            }
+            mDepthQueue.push(RenderQueue::MakeKey(pipelineSortId(*group.mesh), 0, 0, depth, kMaxSortDepth), groupIndex);
+        }
+    } else {
+        for (uint32_t i = 0; i < mDrawItems.size(); ++i) {
+            const DrawItem& item = mDrawItems[i];
+            mDepthQueue.push(RenderQueue::MakeKey(pipelineSortId(*item.mesh), 0, 0, item.depth, kMaxSortDepth), i);
+        }
+    }
+    mDepthQueue.sort();
+}
+
+const VulkanGraphicPipeline& SceneRenderer::getMeshPipeline(MeshVertexFormat format, bool instanced, MeshPass pass) const {
+    const bool packed = format == MeshVertexFormat::Packed;
+    if (instanced) {
+        switch (pass) {
+            case MeshPass::Depth:    return packed ? *mMeshInstanced.packedDepthPipeline : *mMeshInstanced.depthPipeline;
+            case MeshPass::LitEqual: return packed ? *mMeshInstanced.packedEqualPipeline : *mMeshInstanced.equalPipeline;
+            case MeshPass::Lit:      break;
+        }
+        return packed ? *mMeshInstanced.packedPipeline : *mMeshInstanced.pipeline;
+    }
+    switch (pass) {
+        case MeshPass::Depth:    return packed ? *mMeshPackedDepthPipeline : *mMeshDepthPipeline;
+        case MeshPass::LitEqual: return packed ? *mMeshPackedEqualPipeline : *mMeshEqualPipeline;
+        case MeshPass::Lit:      break;
+    }
+    return packed ? *mMeshPackedPipeline : *mMeshPipeline;
+}
+
+void SceneRenderer::bindMeshPipeline(VkCommandBuffer              cmd,
+                                     const VulkanGraphicPipeline& pipeline,
+                                     VkDescriptorSet              frameSet,
+                                     MeshBindState&               state) const {
+    if (&pipeline == state.pipeline) {
+        return;
+    }
+    // The pipelines of the two vertex formats have different layouts, the sets are bound again.
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipeline());
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipelineLayout(), 0 /*firstSet*/,
+                            1 /*nbSet*/, &frameSet, 2 /*dynamicOffsetCount*/, mFrameDynamicOffsets.data());
+    state.pipeline     = &pipeline;
+    state.material     = VK_NULL_HANDLE;
+    state.quantization = VK_NULL_HANDLE;
+}
+
+void SceneRenderer::bindMaterial(VkCommandBuffer     cmd,
+                                 VkPipelineLayout    layout,
+                                 VkDescriptorSet     material,
+                                 MeshBindState&      state,
+                                 SceneRendererStats& stats) {
+    if (material == state.material) {
+        stats.bindsSkipped++;
+        return;
+    }
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1 /*firstSet*/,
+                            1 /*nbSet*/, &material, 0, nullptr);
+    state.material = material;
+    stats.bindsIssued++;
+}
+
+void SceneRenderer::bindMeshBuffers(VkCommandBuffer     cmd,
+                                    const Mesh&         mesh,
+                                    VkDescriptorSet     quantization,
+                                    MeshBindState&      state,
+                                    SceneRendererStats& stats) {
+    if (quantization != VK_NULL_HANDLE && quantization != state.quantization) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, state.pipeline->getPipelineLayout(),
+                                2 /*firstSet*/, 1 /*nbSet*/, &quantization, 0, nullptr);
+        state.quantization = quantization;
+        stats.bindsIssued++;
+    }
+
+    // All the meshes live in the arena buffers, the vertex buffer is bound once per command buffer
+    // and the index buffer again only when the index type changes.
+    if (state.vertexBufferBound) {
+        stats.bindsSkipped++;
+    } else {
+        VulkanGeometryArena::bindVertexBuffer(cmd);
+        state.vertexBufferBound = true;
+        stats.bindsIssued++;
+    }
+
+    if (mesh.indexType == state.indexType) {
+        stats.bindsSkipped++;
+    } else {
+        VulkanGeometryArena::bindIndexBuffer(cmd, mesh.indexType);
+        state.indexType = mesh.indexType;
+        stats.bindsIssued++;
+    }
+}
+
+void SceneRenderer::drawMeshes(VkCommandBuffer     cmd,
+                               uint32_t            first,
+                               uint32_t            count,
+                               SceneRendererStats& stats,
+                               MeshPass            pass) {
+    if (count == 0) {
+        return;
+    }
+
+    vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+    PushData      pushData{};
+    MeshBindState bindState{};
+    for (uint32_t i = first; i < first + count; ++i) {
+        const DrawItem&  item = mDrawItems[getMeshPassIndex(pass, i)];
+        const CMaterial& cmat = *item.cmaterial;
+        // The packed meshes are sorted after the others, the pipeline changes at most once.
+        const VulkanGraphicPipeline& pipeline = getMeshPipeline(item.mesh->vertexFormat, false /*instanced*/, pass);
+        bindMeshPipeline(cmd, pipeline, mDescriptorSet[mFrameIndex], bindState);
+
+        pushData.transform    = item.world->model;
+        pushData.normalMatrix = item.world->normalMatrix;
+        pushData.ambient   = cmat.ambient;
+        pushData.diffuse   = cmat.diffuse;
+        pushData.specular  = cmat.specular;
+        pushData.shininess = cmat.shininess;
+        pushData.texScale  = cmat.texScale;
+
+        if (pass != MeshPass::Depth) {
+            bindMaterial(cmd, pipeline.getPipelineLayout(), item.material, bindState, stats);
+        }
+        vkCmdPushConstants(cmd, pipeline.getPipelineLayout(),
+                           mMeshShader->getPushConstantStages(), 0,
+                           sizeof(pushData), reinterpret_cast<void*>(&pushData));
+
+        bindMeshBuffers(cmd, *item.mesh, item.quantization, bindState, stats);
+        stats.drawCalls += Renderer::DrawSubMeshes(cmd, *item.mesh, 1, 0, item.lod);
+        if (pass == MeshPass::Depth) {
+            continue; // The instances and triangles are counted by the lit pass.
+        }
+        stats.instanceCount++;
+        stats.triangleCount += item.mesh->getIndexCount(item.lod) / 3;
+    }
+}
+
+void SceneRenderer::buildDrawGroups() {
+    // The draw items are sorted by the render queue, the entities sharing the same
+    // material, the same geometry and the same LOD are next to each other.
+    const auto& drawItems  = mDrawItems;
+    auto&       drawGroups = mMeshInstanced.drawGroups;
+    drawGroups.clear();
+    if (drawItems.empty()) {
+        return;
+    }
+
+    // Upload the instance data in the sorted order so each group is a contiguous range.
+    reserveInstanceBuffer(mFrameIndex, static_cast<uint32_t>(drawItems.size()));
+    auto* instances = static_cast<InstanceData*>(mMeshInstanced.instanceBuffer[mFrameIndex]->map());
+    for (size_t i = 0; i < drawItems.size(); ++i) {
+        const CMaterial& cmat  = *drawItems[i].cmaterial;
+        InstanceData& instance = instances[i];
+        instance.transform     = drawItems[i].world->model;
+        instance.normalMatrix  = drawItems[i].world->normalMatrix;
+        instance.ambient       = cmat.ambient;
+        instance.diffuse       = cmat.diffuse;
+        instance.specular      = cmat.specular;
+        instance.texScale      = cmat.texScale;
+        instance.shininess     = cmat.shininess;
+    }
+    mMeshInstanced.instanceBuffer[mFrameIndex]->unmap();
+
+    uint32_t firstCommand = 0;
+    size_t   first        = 0;
+    while (first < drawItems.size()) {
+        const DrawItem& item = drawItems[first];
+        size_t          last = first + 1;
+        while (last < drawItems.size() && drawItems[last].material == item.material &&
+               drawItems[last].geometry == item.geometry && drawItems[last].lod == item.lod) {
+            ++last;
+        }
+
+        const auto instanceCount = static_cast<uint32_t>(last - first);
+
+        DrawGroup& group    = drawGroups.emplace_back();
+        group.material      = item.material;
+        group.quantization  = item.quantization;
+        group.mesh          = item.mesh;
+        group.lod           = item.lod;
+        group.firstInstance = static_cast<uint32_t>(first);
+        group.instanceCount = instanceCount;
+        group.firstCommand  = firstCommand;
+        group.commandCount  = instanceCount * getCullItemCount(*item.mesh, item.lod);
+        firstCommand += group.commandCount;
+        first = last;
+    }
+}
+
+void SceneRenderer::drawMeshesInstanced(VkCommandBuffer     cmd,
+                                        uint32_t            first,
+                                        uint32_t            count,
+                                        SceneRendererStats& stats,
+                                        MeshPass            pass) {
+    if (count == 0) {
+        return;
+    }
+
+    vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+    MeshBindState bindState{};
+    for (uint32_t i = first; i < first + count; ++i) {
+        const DrawGroup&             group    = mMeshInstanced.drawGroups[getMeshPassIndex(pass, i)];
+        const VulkanGraphicPipeline& pipeline = getMeshPipeline(group.mesh->vertexFormat, true /*instanced*/, pass);
+        bindMeshPipeline(cmd, pipeline, mMeshInstanced.descriptorSet[mFrameIndex], bindState);
+        if (pass != MeshPass::Depth) {
+            bindMaterial(cmd, pipeline.getPipelineLayout(), group.material, bindState, stats);
+        }
+        bindMeshBuffers(cmd, *group.mesh, group.quantization, bindState, stats);
+        stats.drawCalls += Renderer::DrawSubMeshes(cmd, *group.mesh, group.instanceCount, group.firstInstance,
+                                                   group.lod);
+        if (pass == MeshPass::Depth) {
+            continue; // The instances and triangles are counted by the lit pass.
+        }
+        stats.instanceCount += group.instanceCount;
+        stats.triangleCount += group.mesh->getIndexCount(group.lod) / 3 * group.instanceCount;
+    }
+}
+
+uint32_t SceneRenderer::getCullItemCount(const Mesh& mesh, uint32_t lod) const {
+    if (mesh.subMeshs.empty()) {
+        return 1;
+    }
+    uint32_t count = 0;
+    for (const Mesh::SubMesh& subMesh : mesh.getSubMeshes(lod)) {
+        count += mUseMeshletCulling && subMesh.meshletCount > 0 ? subMesh.meshletCount : 1;
+    }
+    return count;
+}
+
+void SceneRenderer::cullMeshesGpu(VkCommandBuffer cmd) {
+    const auto& drawGroups = mMeshInstanced.drawGroups;
+    mGpuCulling.itemCount  = 0;
+    mGpuCulling.groupCount = 0;
+    if (drawGroups.empty()) {
+        const uint32_t counts[2] = {0, 0};
+        mGpuCulling.readbackBuffer[mFrameIndex]->writeData(counts, sizeof(counts));
+        return;
+    }
+
+    const uint32_t itemCount  = drawGroups.back().firstCommand + drawGroups.back().commandCount;
+    const auto     groupCount = static_cast<uint32_t>(drawGroups.size());
+    reserveCullBuffers(mFrameIndex, itemCount, groupCount);
+    mGpuCulling.itemCount  = itemCount;
+    mGpuCulling.groupCount = groupCount;
+
+    // The pyramid is bound even without occlusion culling, the frame slot is not in use.
+    if (!mDepthPyramid->isInitialized()) {
+        mDepthPyramid->clear(cmd);
+    }
+    if (mGpuCulling.depthPyramidView[mFrameIndex] != mDepthPyramid->getImageView()) {
+        mGpuCulling.depthPyramidView[mFrameIndex] = mDepthPyramid->getImageView();
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageView   = mDepthPyramid->getImageView();
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkWriteDescriptorSet writeDescriptorSet{};
+        writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDescriptorSet.dstSet          = mGpuCulling.descriptorSet[mFrameIndex];
+        writeDescriptorSet.dstBinding      = 6;
+        writeDescriptorSet.descriptorCount = 1;
+        writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writeDescriptorSet.pImageInfo      = &imageInfo;
+        vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+    }
+
+    // One cull item per instance and per sub mesh, or per meshlet when the sub mesh has meshlets.
+    // The bounds are tested in world space.
+    auto*    cullItems = static_cast<CullItem*>(mGpuCulling.cullItemBuffer[mFrameIndex]->map());
+    uint32_t itemIndex = 0;
+    for (uint32_t groupIndex = 0; groupIndex < groupCount; ++groupIndex) {
+        const DrawGroup& group = drawGroups[groupIndex];
+        const Mesh&      mesh  = *group.mesh;
+        for (uint32_t instance = group.firstInstance; instance < group.firstInstance + group.instanceCount; ++instance) {
+            const glm::mat4& transform = mDrawItems[instance].world->model;
+            const auto addItem = [&](const glm::vec3& worldMin, const glm::vec3& worldMax, const glm::vec4& cone,
+                                     float coneRadius, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset) {
+                CullItem& item = cullItems[itemIndex++];
+                item.aabbMin        = glm::vec4(worldMin, 1.0f);
+                item.aabbMax        = glm::vec4(worldMax, 1.0f);
+                item.cone           = cone;
+                item.coneRadius     = coneRadius;
+                item.indexCount     = indexCount;
+                item.firstIndex     = firstIndex;
+                item.vertexOffset   = vertexOffset;
+                item.firstInstance  = instance;
+                item.drawCountIndex = 1 + groupIndex;
+                item.firstCommand   = group.firstCommand;
+            };
+            const auto addBox = [&](const glm::vec3& aabbMin, const glm::vec3& aabbMax,
+                                    uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset) {
+                glm::vec3 worldMin, worldMax;
+                transformAABB(transform, aabbMin, aabbMax, worldMin, worldMax);
+                addItem(worldMin, worldMax, kNoCone, 0.0f, indexCount, firstIndex, vertexOffset);
+            };
+
+            if (mesh.subMeshs.empty()) {
+                addBox(mesh.aabbMin, mesh.aabbMax, mesh.indexCount, mesh.firstIndex,
+                       static_cast<int32_t>(mesh.vertexOffset));
+                continue;
+            }
+
+            // The normal cone survives a uniform scale, it is flipped by a mirror.
+            const glm::mat3 linear(transform);
+            const float     scaleX    = glm::length(linear[0]);
+            const float     scaleY    = glm::length(linear[1]);
+            const float     scaleZ    = glm::length(linear[2]);
+            const float     maxScale  = std::max({scaleX, scaleY, scaleZ});
+            const bool      useCone   = maxScale <= 1.01f * std::min({scaleX, scaleY, scaleZ});
+            const float     coneSign  = glm::determinant(linear) < 0.0f ? -1.0f : 1.0f;
+            for (const auto& subMesh : mesh.getSubMeshes(group.lod)) {
+                if (!mUseMeshletCulling || subMesh.meshletCount == 0) {
+                    addBox(subMesh.aabbMin, subMesh.aabbMax, subMesh.nbIndices, subMesh.firstIndex,
+                           static_cast<int32_t>(subMesh.vertexOffset));
+                    continue;
+                }
+                for (uint32_t i = subMesh.firstMeshlet; i < subMesh.firstMeshlet + subMesh.meshletCount; ++i) {
+                    const MeshData::Meshlet& meshlet = mesh.meshlets[i];
+                    const glm::vec3 center = glm::vec3(transform * glm::vec4(meshlet.center, 1.0f));
+                    const float     radius = meshlet.radius * maxScale;
+                    const glm::vec4 cone   = useCone && meshlet.coneCutoff < 1.0f
+                                                 ? glm::vec4(glm::normalize(linear * meshlet.coneAxis) * coneSign,
+                                                             meshlet.coneCutoff)
+                                                 : kNoCone;
+                    addItem(center - radius, center + radius, cone, radius, meshlet.triangleCount * 3,
+                            subMesh.firstIndex + meshlet.firstIndex, static_cast<int32_t>(subMesh.vertexOffset));
                 }
             }
         }
     }
+    mGpuCulling.cullItemBuffer[mFrameIndex]->unmap();
+
+    VulkanContext::CmdBeginsLabel(cmd, "MeshCulling");
+
+    // The indirect draws of the previous frame must be done with the counters before clearing them.
+    // The counters of both phases are cleared, the late ones stay at zero without a late pass.
+    VulkanUtils::memoryBarrier(cmd,
+                               VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_NONE,
+                               VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    vkCmdFillBuffer(cmd, mGpuCulling.drawCountBuffer[mFrameIndex]->getBuffer(), 0, sizeof(uint32_t) * 2 * (1 + groupCount), 0);
+    VulkanUtils::memoryBarrier(cmd,
+                               VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                               VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                               VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    mGpuTimer.writeBegin(cmd, kGpuScopeCulling);
+    dispatchCulling(cmd, mLatePass ? kCullModeEarly : kCullModeFrustum);
+    mGpuTimer.writeEnd(cmd, kGpuScopeCulling);
+    if (!mLatePass) {
+        readbackCullCounters(cmd);
+    }
+
+    VulkanContext::CmdEndLabel(cmd);
+}
+
+void SceneRenderer::dispatchCulling(VkCommandBuffer cmd, uint32_t mode) {
+    // The late phase writes its commands and counters after the ones of the first phase.
+    CullPushData pushData{};
+    pushData.itemCount     = mGpuCulling.itemCount;
+    pushData.mode          = mode;
+    pushData.commandOffset = mode == kCullModeLate ? mGpuCulling.itemCount : 0;
+    pushData.counterOffset = mode == kCullModeLate ? 1 + mGpuCulling.groupCount : 0;
+    pushData.depthWidth    = mDepthPyramid->getDepthWidth();
+    pushData.depthHeight   = mDepthPyramid->getDepthHeight();
+    pushData.levelCount    = mDepthPyramid->getLevelCount();
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mGpuCulling.pipeline->getPipeline());
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            mGpuCulling.pipeline->getPipelineLayout(), 0 /*firstSet*/,
+                            1 /*nbSet*/, &mGpuCulling.descriptorSet[mFrameIndex],
+                            1 /*dynamicOffsetCount*/, mFrameDynamicOffsets.data());
+    vkCmdPushConstants(cmd, mGpuCulling.pipeline->getPipelineLayout(),
+                       mGpuCulling.shader->getPushConstantStages(), 0,
+                       sizeof(pushData), &pushData);
+    vkCmdDispatch(cmd, (mGpuCulling.itemCount + 63) / 64, 1, 1);
+
+    // The commands and counters are consumed by the indirect draws and read back, the occluded
+    // items of the first phase by the late phase.
+    VulkanUtils::memoryBarrier(cmd,
+                               VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                               VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT |
+                                   VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                               VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_TRANSFER_READ_BIT |
+                                   VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+}
+
+void SceneRenderer::readbackCullCounters(VkCommandBuffer cmd) {
+    // The total visible count and the number of items still occluded after the late phase.
+    VkBufferCopy regions[2]{};
+    regions[0].srcOffset = 0;
+    regions[0].dstOffset = 0;
+    regions[0].size      = sizeof(uint32_t);
+    regions[1].srcOffset = sizeof(uint32_t) * (1 + mGpuCulling.groupCount);
+    regions[1].dstOffset = sizeof(uint32_t);
+    regions[1].size      = sizeof(uint32_t);
+    vkCmdCopyBuffer(cmd, mGpuCulling.drawCountBuffer[mFrameIndex]->getBuffer(), mGpuCulling.readbackBuffer[mFrameIndex]->getBuffer(), 2, regions);
+    VulkanUtils::memoryBarrier(cmd,
+                               VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                               VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT);
+}
+
+void SceneRenderer::drawMeshesIndirect(VkCommandBuffer     cmd,
+                                       uint32_t            first,
+                                       uint32_t            count,
+                                       SceneRendererStats& stats,
+                                       MeshPass            pass,
+                                       bool                late) {
+    if (count == 0) {
+        return;
+    }
+
+    // The commands and counters of the late phase follow the ones of the first phase.
+    const uint32_t commandOffset = late ? mGpuCulling.itemCount : 0;
+    const uint32_t counterOffset = late ? 1 + mGpuCulling.groupCount : 0;
+
+    vkCmdSetPrimitiveTopology(cmd, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+    // Each group has a range of commands compacted by the culling pass and its own counter.
+    MeshBindState bindState{};
+    for (uint32_t i = first; i < first + count; ++i) {
+        const uint32_t               groupIndex = getMeshPassIndex(pass, i);
+        const DrawGroup&             group      = mMeshInstanced.drawGroups[groupIndex];
+        const VulkanGraphicPipeline& pipeline   = getMeshPipeline(group.mesh->vertexFormat, true /*instanced*/, pass);
+        bindMeshPipeline(cmd, pipeline, mMeshInstanced.descriptorSet[mFrameIndex], bindState);
+        if (pass != MeshPass::Depth) {
+            bindMaterial(cmd, pipeline.getPipelineLayout(), group.material, bindState, stats);
+        }
+        bindMeshBuffers(cmd, *group.mesh, group.quantization, bindState, stats);
+        vkCmdDrawIndexedIndirectCount(cmd,
+                                      mGpuCulling.drawCommandBuffer[mFrameIndex]->getBuffer(),
+                                      sizeof(VkDrawIndexedIndirectCommand) * (commandOffset + group.firstCommand),
+                                      mGpuCulling.drawCountBuffer[mFrameIndex]->getBuffer(),
+                                      sizeof(uint32_t) * (counterOffset + 1 + groupIndex),
+                                      group.commandCount,
+                                      sizeof(VkDrawIndexedIndirectCommand));
+        stats.drawCalls++;
+        if (late || pass == MeshPass::Depth) {
+            continue; // The instances and triangles are counted by the lit pass of the first phase.
+        }
+        stats.instanceCount += group.instanceCount;
+        stats.triangleCount += group.mesh->getIndexCount(group.lod) / 3 * group.instanceCount;
+    }
+}
+
+void SceneRenderer::reserveInstanceBuffer(uint32_t frameIndex, uint32_t instanceCount) {
+    if (instanceCount <= mMeshInstanced.capacity[frameIndex]) {
+        return;
+    }
+
+    // The previous buffer is released right away, this is safe because each frame in
+    // flight owns its buffer and the caller has waited for the frame fence.
+    mMeshInstanced.capacity[frameIndex] = std::bit_ceil(instanceCount);
+
+    VulkanBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.name              = "InstanceData";
+    bufferCreateInfo.sizeInByte        = sizeof(InstanceData) * mMeshInstanced.capacity[frameIndex];
+    bufferCreateInfo.usage             = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferCreateInfo.memoryProperty    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    bufferCreateInfo.persistentMapping = true;
+    mMeshInstanced.instanceBuffer[frameIndex] = VulkanBuffer::Create(bufferCreateInfo);
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = mMeshInstanced.instanceBuffer[frameIndex]->getBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range  = VK_WHOLE_SIZE;
+
+    VkWriteDescriptorSet writeDescriptorSet{};
+    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet          = mMeshInstanced.descriptorSet[frameIndex];
+    writeDescriptorSet.dstBinding      = 2;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo     = &bufferInfo;
+    vkUpdateDescriptorSets(VulkanContext::getDevice(), 1, &writeDescriptorSet, 0, nullptr);
+}
+
+void SceneRenderer::reserveCullBuffers(uint32_t frameIndex, uint32_t itemCount, uint32_t groupCount) {
+    // The first counter is the total number of visible items.
+    const uint32_t counterCount = groupCount + 1;
+    if (itemCount <= mGpuCulling.itemCapacity[frameIndex] && counterCount <= mGpuCulling.groupCapacity[frameIndex]) {
+        return;
+    }
+
+    // The previous buffers are released right away, this is safe because each frame in
+    // flight owns its buffers and the caller has waited for the frame fence.
+    VkDescriptorBufferInfo bufferInfo[4]{};
+    VkWriteDescriptorSet   writeDescriptorSet[4]{};
+    uint32_t               writeCount = 0;
+
+    if (itemCount > mGpuCulling.itemCapacity[frameIndex]) {
+        mGpuCulling.itemCapacity[frameIndex] = std::bit_ceil(itemCount);
+
+        VulkanBufferCreateInfo bufferCreateInfo{};
+        bufferCreateInfo.name              = "MeshCullItems";
+        bufferCreateInfo.sizeInByte        = sizeof(CullItem) * mGpuCulling.itemCapacity[frameIndex];
+        bufferCreateInfo.usage             = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bufferCreateInfo.memoryProperty    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        bufferCreateInfo.persistentMapping = true;
+        mGpuCulling.cullItemBuffer[frameIndex]    = VulkanBuffer::Create(bufferCreateInfo);
+
+        bufferCreateInfo.name              = "MeshDrawCommands";
+        bufferCreateInfo.sizeInByte        = sizeof(VkDrawIndexedIndirectCommand) * 2 * mGpuCulling.itemCapacity[frameIndex];
+        bufferCreateInfo.usage             = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+        bufferCreateInfo.memoryProperty    = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        bufferCreateInfo.persistentMapping = false;
+        mGpuCulling.drawCommandBuffer[frameIndex] = VulkanBuffer::Create(bufferCreateInfo);
+
+        bufferCreateInfo.name              = "MeshCullOccluded";
+        bufferCreateInfo.sizeInByte        = sizeof(uint32_t) * mGpuCulling.itemCapacity[frameIndex];
+        bufferCreateInfo.usage             = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        mGpuCulling.occludedBuffer[frameIndex] = VulkanBuffer::Create(bufferCreateInfo);
+
+        bufferInfo[writeCount] = {mGpuCulling.cullItemBuffer[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE};
+        writeDescriptorSet[writeCount].dstBinding = 2;
+        writeCount++;
+        bufferInfo[writeCount] = {mGpuCulling.drawCommandBuffer[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE};
+        writeDescriptorSet[writeCount].dstBinding = 3;
+        writeCount++;
+        bufferInfo[writeCount] = {mGpuCulling.occludedBuffer[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE};
+        writeDescriptorSet[writeCount].dstBinding = 5;
+        writeCount++;
+    }
+
+    if (counterCount > mGpuCulling.groupCapacity[frameIndex]) {
+        mGpuCulling.groupCapacity[frameIndex] = std::bit_ceil(counterCount);
+
+        VulkanBufferCreateInfo bufferCreateInfo{};
+        bufferCreateInfo.name           = "MeshDrawCounts";
+        bufferCreateInfo.sizeInByte     = sizeof(uint32_t) * 2 * mGpuCulling.groupCapacity[frameIndex];
+        bufferCreateInfo.usage          = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferCreateInfo.memoryProperty = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        mGpuCulling.drawCountBuffer[frameIndex]   = VulkanBuffer::Create(bufferCreateInfo);
+
+        bufferInfo[writeCount] = {mGpuCulling.drawCountBuffer[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE};
+        writeDescriptorSet[writeCount].dstBinding = 4;
+        writeCount++;
+    }
+
+    for (uint32_t i = 0; i < writeCount; ++i) {
+        writeDescriptorSet[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDescriptorSet[i].dstSet          = mGpuCulling.descriptorSet[frameIndex];
+        writeDescriptorSet[i].descriptorCount = 1;
+        writeDescriptorSet[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writeDescriptorSet[i].pBufferInfo     = &bufferInfo[i];
+    }
+    vkUpdateDescriptorSets(VulkanContext::getDevice(), writeCount, writeDescriptorSet, 0, nullptr);
+}
+
+void SceneRenderer::uploadLights(const glm::mat4& proj) {
+    // The light system follows the registry of the scene.
+    if (!mLightClusters.lightSystem || &mLightClusters.lightSystem->getRegistry() != mRegistry) {
+        mLightClusters.lightSystem = std::make_unique<LightSystem>(*mRegistry, mFrameInFlightCount);
+    }
+    LightSystem& lightSystem = *mLightClusters.lightSystem;
+    lightSystem.update();
+
+    const uint32_t pointLightCount       = lightSystem.getPointLightCount();
+    const uint32_t spotLightCount        = lightSystem.getSpotLightCount();
+    const uint32_t directionalLightCount = lightSystem.getDirectionalLightCount();
+    if (reserveLightBuffers(mFrameIndex, pointLightCount, spotLightCount, directionalLightCount)) {
+        lightSystem.invalidate(mFrameIndex);
+    }
+
+    // Only the lights changed since the last use of the frame slot are written.
+    mStats.lightUploadCount = lightSystem.upload(
+        mFrameIndex, static_cast<PointLight*>(mLightClusters.pointLightBuffer[mFrameIndex]->map()),
+        static_cast<SpotLight*>(mLightClusters.spotLightBuffer[mFrameIndex]->map()),
+        static_cast<DirectionalLight*>(mLightClusters.directionalLightBuffer[mFrameIndex]->map()));
+    mLightClusters.pointLightBuffer[mFrameIndex]->unmap();
+    mLightClusters.spotLightBuffer[mFrameIndex]->unmap();
+    mLightClusters.directionalLightBuffer[mFrameIndex]->unmap();
+
+    LightData lightData{};
+    lightData.nbLight            = pointLightCount;
+    lightData.nbDirectionalLight = directionalLightCount;
+    lightData.nbSpotLight        = spotLightCount;
+    lightData.clusterGrid        = LightClusters::makeGrid(proj, mViewportWidth, mViewportHeight);
+    mStats.lightCount            = pointLightCount + spotLightCount;
+
+    mFrameDynamicOffsets[1] = mFrameAllocator.push(lightData);
+}
+
+void SceneRenderer::assignLightsGpu(VkCommandBuffer cmd) {
+    // Always dispatched, the lit passes read the light count of the clusters even without lights.
+    VulkanContext::CmdBeginsLabel(cmd, "LightClusters");
+    mGpuTimer.writeBegin(cmd, kGpuScopeLightClusters);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mLightClusters.pipeline->getPipeline());
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            mLightClusters.pipeline->getPipelineLayout(), 0 /*firstSet*/,
+                            1 /*nbSet*/, &mLightClusters.descriptorSet[mFrameIndex],
+                            2 /*dynamicOffsetCount*/, mFrameDynamicOffsets.data());
+    vkCmdDispatch(cmd, (LightClusters::kClusterCount + 63) / 64, 1, 1);
+
+    // The light lists are read by the fragment shaders of the lit passes. The previous reads of the
+    // buffer are done, it belongs to the frame slot whose fence was waited.
+    VulkanUtils::memoryBarrier(cmd,
+                               VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                               VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+
+    mGpuTimer.writeEnd(cmd, kGpuScopeLightClusters);
+    VulkanContext::CmdEndLabel(cmd);
+}
+
+bool SceneRenderer::reserveLightBuffers(uint32_t frameIndex, uint32_t pointLightCount, uint32_t spotLightCount,
+                                        uint32_t directionalLightCount) {
+    // An empty buffer can't be bound, there is always room for one light.
+    pointLightCount       = std::max(pointLightCount, 1u);
+    spotLightCount        = std::max(spotLightCount, 1u);
+    directionalLightCount = std::max(directionalLightCount, 1u);
+    if (pointLightCount <= mLightClusters.pointCapacity[frameIndex] &&
+        spotLightCount <= mLightClusters.spotCapacity[frameIndex] &&
+        directionalLightCount <= mLightClusters.directionalCapacity[frameIndex]) {
+        return false;
+    }
+
+    // The previous buffers are released right away, this is safe because each frame in
+    // flight owns its buffers and the caller has waited for the frame fence.
+    VulkanBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.usage             = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferCreateInfo.memoryProperty    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    bufferCreateInfo.persistentMapping = true;
+    if (pointLightCount > mLightClusters.pointCapacity[frameIndex]) {
+        mLightClusters.pointCapacity[frameIndex] = std::bit_ceil(pointLightCount);
+        bufferCreateInfo.name       = "PointLights";
+        bufferCreateInfo.sizeInByte = sizeof(PointLight) * mLightClusters.pointCapacity[frameIndex];
+        mLightClusters.pointLightBuffer[frameIndex] = VulkanBuffer::Create(bufferCreateInfo);
+    }
+    if (spotLightCount > mLightClusters.spotCapacity[frameIndex]) {
+        mLightClusters.spotCapacity[frameIndex] = std::bit_ceil(spotLightCount);
+        bufferCreateInfo.name       = "SpotLights";
+        bufferCreateInfo.sizeInByte = sizeof(SpotLight) * mLightClusters.spotCapacity[frameIndex];
+        mLightClusters.spotLightBuffer[frameIndex] = VulkanBuffer::Create(bufferCreateInfo);
+    }
+    if (directionalLightCount > mLightClusters.directionalCapacity[frameIndex]) {
+        mLightClusters.directionalCapacity[frameIndex] = std::bit_ceil(directionalLightCount);
+        bufferCreateInfo.name       = "DirectionalLights";
+        bufferCreateInfo.sizeInByte = sizeof(DirectionalLight) * mLightClusters.directionalCapacity[frameIndex];
+        mLightClusters.directionalLightBuffer[frameIndex] = VulkanBuffer::Create(bufferCreateInfo);
+    }
+
+    // The point and spot lights are bound to the compute pass and to the set 0 of the lit passes,
+    // the directional lights only to the lit passes.
+    const VkDescriptorSet sets[] = {mLightClusters.descriptorSet[frameIndex], mDescriptorSet[frameIndex],
+                                    mMeshInstanced.descriptorSet[frameIndex], mDrawTerrain.descriptorSet0[frameIndex]};
+    const VkDescriptorBufferInfo bufferInfo[3] = {
+        {mLightClusters.pointLightBuffer[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE},
+        {mLightClusters.spotLightBuffer[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE},
+        {mLightClusters.directionalLightBuffer[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE},
+    };
+    constexpr uint32_t bindings[3] = {3, 4, 6};
+
+    VkWriteDescriptorSet writeDescriptorSet[3 * std::size(sets)]{};
+    uint32_t             writeCount = 0;
+    for (uint32_t i = 0; i < std::size(sets); ++i) {
+        const uint32_t bufferCount = i == 0 ? 2 : 3; // The compute set comes first.
+        for (uint32_t j = 0; j < bufferCount; ++j) {
+            VkWriteDescriptorSet& write = writeDescriptorSet[writeCount++];
+            write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet          = sets[i];
+            write.dstBinding      = bindings[j];
+            write.descriptorCount = 1;
+            write.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.pBufferInfo     = &bufferInfo[j];
+        }
+    }
+    vkUpdateDescriptorSets(VulkanContext::getDevice(), writeCount, writeDescriptorSet, 0, nullptr);
+    return true;
 }
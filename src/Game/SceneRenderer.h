@@ -1,23 +1,34 @@
 #pragma once
+#include "FrustumCuller.h"
+#include "LightSystem.h"
 #include "Mesh.h"
+#include "RenderQueue.h"
 #include "Terrain.h"
+#include "TransformSystem.h"
 
 #include "vulkan/VulkanBuffer.h"
+#include "vulkan/VulkanComputePipeline.h"
+#include "vulkan/VulkanDepthPyramid.h"
 #include "vulkan/VulkanDescriptorPool.h"
+#include "vulkan/VulkanGeometryArena.h"
+#include "vulkan/VulkanGpuTimer.h"
 #include "vulkan/VulkanGraphicPipeline.h"
+#include "vulkan/VulkanLinearAllocator.h"
 #include "vulkan/VulkanTexture.h"
 #include "vulkan/vulkan.h"
 
+#include <Engine/ThreadPool.h>
+
 #include <entt/entt.hpp>
 #include <glm/glm.hpp>
 
+#include <array>
+#include <map>
 #include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
-struct CTransform {
-    glm::vec3 position = {0.f, 0.f, 0.f};
-    glm::vec3 rotation = {0.f, 0.f, 0.f};
-    glm::vec3 scale    = {1.f, 1.f, 1.f};
-};
 struct CMesh {
     Mesh mesh;
 };
@@ -49,39 +60,52 @@ struct CMaterial {
     glm::vec4        specular  = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     float            shininess = 32;
     glm::vec2        texScale  = glm::vec2(1.0f, 1.0f);
-    VkDescriptorSet  descriptorSet1;
-};
-struct CDirectionalLight {
-    bool      enable = true;
-    glm::vec3 color;
-    glm::vec3 direction;
+    VkDescriptorSet  descriptorSet1{VK_NULL_HANDLE}; ///< Shared by the materials with the same maps.
+    uint32_t         sortId = 0;                      ///< Id of descriptorSet1 in the render queue keys.
+
+    /// @brief Return true once the maps were acquired, the frame can sample them.
+    [[nodiscard]] bool isReady() const {
+        return diffuseMap->isReady() && specularMap->isReady() && normalMap->isReady();
+    }
 };
-struct CPointLight {
-    glm::vec3 ambient;
-    glm::vec3 diffuse;
-    glm::vec3 specular;
-    float     range     = 10;
-    float     intensity = 10;
-    float     constant;
-    float     linear;
-    float     quadratic;
-    bool      enable = true;
+struct CSkyBox {
+    VulkanTexturePtr texture;
 };
-struct CSpotLight {
-    bool      enable = true;
-    glm::vec3 color;
-    glm::vec3 direction;
-    float     range;
-    float     cutOffAngle; // degrees
+
+/// @brief Counters collected while recording a frame.
+struct SceneRendererStats {
+    uint32_t drawCalls     = 0;  ///< Number of draw calls recorded by the mesh passes, depth pre-pass included.
+    uint32_t instanceCount = 0;  ///< Number of mesh entities drawn by the mesh pass.
+    float    cpuTimeMs     = 0.f; ///< CPU time spent recording SceneRenderer::prepare and render.
+    uint32_t gpuVisibleCount = 0; ///< Number of draws which passed the GPU culling (last use of the frame slot).
+    uint32_t cpuVisibleCount = 0; ///< Number of mesh entities which passed the CPU culling.
+    uint32_t cpuTotalCount   = 0; ///< Number of mesh entities tested by the CPU culling.
+    uint32_t bindsIssued     = 0; ///< Material / vertex / index buffer binds recorded by the mesh pass.
+    uint32_t bindsSkipped    = 0; ///< Binds skipped because the state was already bound.
+    uint32_t recordJobCount  = 0; ///< Secondary command buffers recorded by the worker threads.
+    uint32_t triangleCount   = 0; ///< Triangles submitted by the mesh pass, before the GPU culling.
+    uint32_t gpuOccludedCount = 0; ///< Number of draws hidden by the occlusion culling (last use of the frame slot).
+    float    gpuCullingMs      = 0.f; ///< GPU time of the first culling phase (last use of the frame slot).
+    float    gpuDepthPrepassMs = 0.f; ///< GPU time of the depth pre-pass (last use of the frame slot).
+    float    gpuMeshPassMs     = 0.f; ///< GPU time of the lit mesh pass, without the late phase (last use of the frame slot).
+    float    gpuLightClustersMs = 0.f; ///< GPU time of the light assignment to the clusters (last use of the frame slot).
+    uint32_t lightCount         = 0;   ///< Point and spot lights assigned to the clusters.
+    uint32_t lightUploadCount   = 0;   ///< Lights written to the light buffers of the frame slot.
 };
 
-struct CSkyBox {
-    VulkanTexturePtr texture;
+/// @brief Attachments of the rendering scope the scene is recorded into.
+struct SceneRenderTarget {
+    VkFormat   colorFormat{VK_FORMAT_UNDEFINED};
+    VkFormat   depthFormat{VK_FORMAT_UNDEFINED};
+    VkExtent2D extent{};
 };
 
 class SceneRenderer {
 public:
-    SceneRenderer();
+    /// @param frameInFlightCount Number of frames the GPU may be processing while a new one is
+    ///                           recorded, clamped to [1, MAX_FRAME_IN_FLIGHT]. Each frame owns its
+    ///                           region of the frame allocator, its instance / culling buffers and command pools.
+    explicit SceneRenderer(uint32_t frameInFlightCount = MAX_FRAME_IN_FLIGHT);
     ~SceneRenderer();
 
     SceneRenderer(const SceneRenderer&)            = delete;
@@ -90,11 +114,41 @@ public:
     SceneRenderer(SceneRenderer&&)            = delete;
     SceneRenderer& operator=(SceneRenderer&&) = delete;
 
-    void render(entt::registry*,
-                VkCommandBuffer  cmd,
-                const glm::mat4& proj,
-                const glm::mat4& view,
-                const glm::vec3& viewPosition);
+    /// @brief Upload the frame data and record the work which must happen outside of
+    ///        a rendering scope (compute culling). Must be called before render(),
+    ///        once the CWorldTransform are up to date.
+    /// @param frameIndex Frame slot in [0, frameInFlightCount), the caller must have waited for
+    ///                   the fence of the previous submission using this slot.
+    void prepare(entt::registry*,
+                 VkCommandBuffer  cmd,
+                 uint32_t         frameIndex,
+                 const glm::mat4& proj,
+                 const glm::mat4& view,
+                 const glm::vec3& viewPosition);
+
+    /// @brief Record the draw calls of the scene. Must be called inside a rendering scope.
+    ///        With a late pass (see hasLatePass()), only the meshes visible in the first phase of
+    ///        the occlusion culling and the terrain are drawn.
+    void render(VkCommandBuffer cmd);
+
+    /// @brief Return true if the frame has a second occlusion culling phase, decided by prepare().
+    ///        cullLate() must then be recorded after render() or renderSecondary(), outside of the
+    ///        rendering scope, and renderLate() in a rendering scope loading the attachments.
+    bool hasLatePass() const { return mLatePass; }
+
+    /// @brief Build the Hi-Z pyramid from the depth written by the first phase (the meshes which
+    ///        were visible and the terrain) and test again the meshes it hid in the first phase.
+    ///        The pyramid is kept for the first phase of the next frame.
+    void cullLate(VkCommandBuffer cmd);
+
+    /// @brief Record the meshes which passed the second phase, then the passes drawn over the
+    ///        meshes (skybox, AABBs, normals). Must be called inside a rendering scope.
+    void renderLate(VkCommandBuffer cmd);
+
+    /// @brief Record the passes of the scene into secondary command buffers on the worker
+    ///        threads and execute them into cmd. The rendering scope of cmd must be started
+    ///        with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT.
+    void renderSecondary(VkCommandBuffer cmd, const SceneRenderTarget& target);
 
     void setUseBlinnPhong(bool useBlinnPhong) { mUseBlinnPhong = useBlinnPhong; }
     bool isUseBlinnPhong() const { return mUseBlinnPhong; }
@@ -119,7 +173,141 @@ public:
     void setTerrainVisible(bool isVisible) {
         mTerrainVisible = isVisible;
     }
+
+    /// @brief Draw entities sharing the same mesh and material with a single instanced draw.
+    void setUseInstancing(bool useInstancing) { mUseInstancing = useInstancing; }
+    bool isUseInstancing() const { return mUseInstancing; }
+
+    /// @brief Frustum cull the mesh entities on the CPU before recording the draws.
+    ///        Ignored when the GPU culling is enabled.
+    void setUseCpuCulling(bool useCpuCulling) { mUseCpuCulling = useCpuCulling; }
+    bool isUseCpuCulling() const { return mUseCpuCulling; }
+
+    /// @brief Frustum cull the meshes in a compute pass which write the indirect draw commands.
+    void setUseGpuCulling(bool useGpuCulling) { mUseGpuCulling = useGpuCulling; }
+    bool isUseGpuCulling() const { return mUseGpuCulling; }
+
+    /// @brief Cull the meshlets of the meshes which have some one by one in the GPU culling pass,
+    ///        against the frustum and by normal cone. The other meshes are culled by sub mesh.
+    void setUseMeshletCulling(bool useMeshletCulling) { mUseMeshletCulling = useMeshletCulling; }
+    bool isUseMeshletCulling() const { return mUseMeshletCulling; }
+
+    /// @brief Test the meshes against a Hi-Z pyramid of the depth buffer in the GPU culling pass.
+    ///        The first phase uses the pyramid of the previous frame, the meshes it hides are tested
+    ///        again by cullLate() against the depth of the first phase. Requires the GPU culling and
+    ///        a depth buffer given to setDepthBuffer().
+    void setUseOcclusionCulling(bool useOcclusionCulling) { mUseOcclusionCulling = useOcclusionCulling; }
+    bool isUseOcclusionCulling() const { return mUseOcclusionCulling; }
+
+    /// @brief Set the depth buffer of the rendering scope, the Hi-Z pyramid is built from it.
+    ///        Call again when the depth buffer is recreated, once the GPU is done with the previous one.
+    void setDepthBuffer(VulkanTexturePtr depthBuffer);
+
+    /// @brief Draw the meshes front to back in a depth only pass before the lit mesh pass, which
+    ///        then only shades the visible fragments (depth test EQUAL, no depth writes).
+    ///        The meshes revealed by the late occlusion culling phase are not in the pre-pass.
+    void setUseDepthPrepass(bool useDepthPrepass) { mUseDepthPrepass = useDepthPrepass; }
+    bool isUseDepthPrepass() const { return mUseDepthPrepass; }
+
+    /// @brief Record the passes with renderSecondary() instead of render().
+    void setUseMultithreadedRecording(bool useMultithreadedRecording) { mUseMultithreadedRecording = useMultithreadedRecording; }
+    bool isUseMultithreadedRecording() const { return mUseMultithreadedRecording; }
+
+    /// @brief Draw the meshes with the coarsest LOD whose error projects to less than the
+    ///        pixel error, LOD 0 is always drawn otherwise.
+    void setUseLod(bool useLod) { mUseLod = useLod; }
+    bool isUseLod() const { return mUseLod; }
+
+    /// @brief Screen-space error tolerated by the LOD selection, in pixels.
+    void  setLodPixelError(float pixelError) { mLodPixelError = pixelError; }
+    float getLodPixelError() const { return mLodPixelError; }
+
+    /// @brief Size in pixels of the target, used to project the LOD errors and to find the light
+    ///        cluster of the fragments. Call before prepare().
+    void setViewportSize(float viewportWidth, float viewportHeight) {
+        mViewportWidth  = viewportWidth;
+        mViewportHeight = viewportHeight;
+    }
+
+    /// @brief Return the counters of the last rendered frame.
+    const SceneRendererStats& getStats() const { return mStats; }
+
 private:
+    void createMaterialDescriptorSet(CMaterial& material);
+    bool isCpuCulled(entt::entity entity) const {
+        return mUseCpuCulling && !mUseGpuCulling && !mFrustumCuller.isVisible(entity);
+    }
+    void createPassDescriptorSets();
+    uint32_t getMeshSortId(const VulkanGeometryArena::Allocation* geometry, uint32_t lod) const;
+    uint32_t selectMeshLod(const Mesh& mesh, const glm::mat4& model) const;
+    VkDescriptorSet getQuantizationDescriptorSet(const Mesh& mesh);
+    void releaseCachedSets();
+    void buildRenderQueue();
+    void buildDepthQueue();
+    uint32_t getMeshPassSize() const;
+
+    /// @brief Pipeline variant of a mesh pass.
+    enum class MeshPass {
+        Lit,      ///< Depth test LESS with depth writes.
+        Depth,    ///< Depth pre-pass, position only without color writes, drawn front to back.
+        LitEqual, ///< Lit pass after the depth pre-pass, depth test EQUAL without depth writes.
+    };
+    const VulkanGraphicPipeline& getMeshPipeline(MeshVertexFormat format, bool instanced, MeshPass pass) const;
+    /// @brief Index of the i-th draw item or draw group of the pass, the depth pre-pass has its own order.
+    uint32_t getMeshPassIndex(MeshPass pass, uint32_t i) const {
+        return pass == MeshPass::Depth ? mDepthQueue.getItems()[i].index : i;
+    }
+    void drawMeshPass(VkCommandBuffer cmd, uint32_t first, uint32_t count, SceneRendererStats& stats, MeshPass pass);
+    void drawMeshes(VkCommandBuffer cmd, uint32_t first, uint32_t count, SceneRendererStats& stats, MeshPass pass);
+    void buildDrawGroups();
+    void drawMeshesInstanced(VkCommandBuffer cmd, uint32_t first, uint32_t count, SceneRendererStats& stats,
+                             MeshPass pass);
+    uint32_t getCullItemCount(const Mesh& mesh, uint32_t lod) const;
+    void cullMeshesGpu(VkCommandBuffer cmd);
+    void drawMeshesIndirect(VkCommandBuffer cmd, uint32_t first, uint32_t count, SceneRendererStats& stats,
+                            MeshPass pass, bool late = false);
+    void dispatchCulling(VkCommandBuffer cmd, uint32_t mode);
+    void readbackCullCounters(VkCommandBuffer cmd);
+    void drawSkybox(VkCommandBuffer cmd);
+    void drawMeshAABBs(VkCommandBuffer cmd);
+    void drawMeshNormals(VkCommandBuffer cmd);
+    void drawTerrain(VkCommandBuffer cmd);
+    void reserveInstanceBuffer(uint32_t frameIndex, uint32_t instanceCount);
+    void reserveCullBuffers(uint32_t frameIndex, uint32_t itemCount, uint32_t groupCount);
+    void uploadLights(const glm::mat4& proj);
+    void assignLightsGpu(VkCommandBuffer cmd);
+    bool reserveLightBuffers(uint32_t frameIndex, uint32_t pointLightCount, uint32_t spotLightCount,
+                             uint32_t directionalLightCount);
+    VkDescriptorBufferInfo getPerFrameBufferInfo() const;
+    VkDescriptorBufferInfo getLightDataBufferInfo() const;
+
+    /// @brief One resource per frame in flight, indexed by mFrameIndex.
+    template <typename T>
+    using PerFrame = std::array<T, MAX_FRAME_IN_FLIGHT>;
+
+    /// @brief State bound by a mesh pass, used to skip the redundant binds.
+    struct MeshBindState {
+        const VulkanGraphicPipeline* pipeline{nullptr};
+        VkDescriptorSet              material{VK_NULL_HANDLE};
+        VkDescriptorSet              quantization{VK_NULL_HANDLE};
+        bool                         vertexBufferBound{false};
+        VkIndexType                  indexType{VK_INDEX_TYPE_MAX_ENUM}; ///< Of the bound arena index buffer.
+    };
+    void bindMeshPipeline(VkCommandBuffer cmd, const VulkanGraphicPipeline& pipeline, VkDescriptorSet frameSet,
+                          MeshBindState& state) const;
+    static void bindMaterial(VkCommandBuffer cmd, VkPipelineLayout layout, VkDescriptorSet material,
+                             MeshBindState& state, SceneRendererStats& stats);
+    static void bindMeshBuffers(VkCommandBuffer cmd, const Mesh& mesh, VkDescriptorSet quantization,
+                                MeshBindState& state, SceneRendererStats& stats);
+
+    /// @brief Command buffers recorded by a worker thread.
+    struct RecordContext {
+        VkCommandPool                commandPool{VK_NULL_HANDLE};
+        std::vector<VkCommandBuffer> commandBuffers;
+        uint32_t                     usedCount{0};
+    };
+    static VkCommandBuffer acquireSecondaryCommandBuffer(RecordContext& context);
+
     entt::registry*                      mRegistry{};
     bool                                 mUseBlinnPhong      = true;
     bool                                 mUseGammaCorrection = true;
@@ -127,21 +315,135 @@ private:
     bool                                 mTerrainAABBVisible = false;
     bool                                 mTerrainVisible     = true;
     glm::vec3                            mAmbientLight       = {0.01f, 0.01f, 0.01f};
-    VulkanBufferPtr                      mPerFrameBuffer;
+    bool                                 mUseInstancing      = true;
+    bool                                 mUseGpuCulling      = false;
+    bool                                 mUseCpuCulling      = true;
+    bool                                 mUseMultithreadedRecording = false;
+    bool                                 mUseMeshletCulling  = true;
+    bool                                 mUseOcclusionCulling = true;
+    bool                                 mLatePass           = false; ///< Occlusion culling of the recorded frame.
+    bool                                 mUseDepthPrepass    = false;
+    bool                                 mUseLod             = true;
+    float                                mLodPixelError      = 1.0f;
+    float                                mViewportWidth      = 1920.0f;
+    float                                mViewportHeight     = 1080.0f;
+    float                                mProjectionScaleY   = 1.0f; ///< proj[1][1], cot(fovy / 2).
+    uint32_t                             mFrameInFlightCount{1};
+    uint32_t                             mFrameIndex{0};
+    uint64_t                             mFrameNumber{0}; ///< Number of prepared frames.
+    Engine::ThreadPool                   mThreadPool;
+    PerFrame<std::vector<RecordContext>> mRecordContexts;
+    FrustumCuller                        mFrustumCuller;
+    glm::vec4                            mWorldFrustumPlanes[6]{};
+    glm::vec3                            mViewPosition{};
+    SceneRendererStats                   mStats{};
+    VulkanGpuTimer                       mGpuTimer;             ///< Scopes are the kGpuScope constants of SceneRenderer.cpp.
+    VulkanLinearAllocator                mFrameAllocator;       ///< PerFrameData and LightData of the frames in flight.
+    std::array<uint32_t, 2>              mFrameDynamicOffsets{}; ///< Offsets of PerFrameData and LightData (set 0 bindings 0 and 1).
     VulkanBufferPtr                      mTerrainSettings;
-    VulkanBufferPtr                      mLightDataBuffer;
+    VulkanTexturePtr                     mDepthBuffer;
+    VulkanDepthPyramidPtr                mDepthPyramid; ///< 1x1 until a depth buffer is set, always bound to the culling pass.
     std::shared_ptr<VulkanShaderProgram> mMeshShader;
+    std::shared_ptr<VulkanShaderProgram> mMeshPackedShader;
+    std::shared_ptr<VulkanShaderProgram> mMeshDepthShader;
+    std::shared_ptr<VulkanShaderProgram> mMeshPackedDepthShader;
     std::shared_ptr<VulkanShaderProgram> mSkyboxShader;
     VulkanGraphicPipelinePtr             mMeshPipeline;
+    VulkanGraphicPipelinePtr             mMeshPackedPipeline; ///< mMeshPipeline for MeshVertexFormat::Packed.
+    VulkanGraphicPipelinePtr             mMeshDepthPipeline;       ///< MeshPass::Depth variant of mMeshPipeline.
+    VulkanGraphicPipelinePtr             mMeshPackedDepthPipeline;
+    VulkanGraphicPipelinePtr             mMeshEqualPipeline;       ///< MeshPass::LitEqual variant of mMeshPipeline.
+    VulkanGraphicPipelinePtr             mMeshPackedEqualPipeline;
     VulkanGraphicPipelinePtr             mSkyboxPipeline;
     VulkanDescriptorPool                 mDescriptorPool;
-    VkDescriptorSet                      mDescriptorSet;
+    PerFrame<VkDescriptorSet>            mDescriptorSet{}; ///< Set 0 of the mesh pipelines.
 
     VulkanBufferPtr mSkyBoxVertexBuffer{};
     VulkanBufferPtr mSkyBoxIndexBuffer{};
     VkDescriptorSet mSkyBoxDescriptorSet0{VK_NULL_HANDLE};
     VkDescriptorSet mSkyBoxDescriptorSet1{VK_NULL_HANDLE};
 
+    struct DrawItem {
+        VkDescriptorSet                        material;
+        VkDescriptorSet                        quantization; ///< Set 2 of the packed meshes, VK_NULL_HANDLE otherwise.
+        const VulkanGeometryArena::Allocation* geometry;     ///< Identify the mesh, the meshes share the arena buffers.
+        const Mesh*                            mesh;
+        uint32_t                               lod;          ///< LOD of the mesh drawn for this entity.
+        float                                  depth;        ///< Distance to the camera.
+        entt::entity           entity;
+        const CWorldTransform* world;
+        const CMaterial*       cmaterial;
+    };
+
+    /// @brief Visible mesh entities, in the order of the render queue.
+    std::vector<DrawItem> mDrawItems;
+    std::vector<DrawItem> mDrawItemsScratch;
+    RenderQueue           mRenderQueue;
+    RenderQueue           mDepthQueue; ///< Draw items or draw groups front to back, for the depth pre-pass.
+
+    /// @brief Material descriptor sets shared by the materials using the same maps, the cache owns the maps.
+    using MaterialMaps = std::tuple<VulkanTexturePtr, VulkanTexturePtr, VulkanTexturePtr>;
+    struct MaterialSet {
+        VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+        uint32_t        sortId{0};
+        uint64_t        releaseFrame{0}; ///< Frame when the cache became the last owner of a map, 0 before.
+    };
+    std::map<MaterialMaps, MaterialSet> mMaterialSets;
+    std::vector<MaterialSet>            mFreeMaterialSets; ///< Sets and sort ids of the released maps.
+    /// @brief Descriptor set cached for the resources it references, the cache owns the resources.
+    struct CachedSet {
+        VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+        uint64_t        releaseFrame{0}; ///< Frame when the cache became the last owner, 0 before.
+    };
+    /// @brief Descriptor sets of the SubMeshQuantization of the packed meshes, by quantization buffer.
+    std::unordered_map<VulkanBufferPtr, CachedSet> mQuantizationSets;
+    std::vector<VkDescriptorSet>                   mFreeQuantizationSets; ///< Sets of the released buffers.
+
+    /// @brief Consecutive draw items sharing the same material, geometry and LOD.
+    struct DrawGroup {
+        VkDescriptorSet material;
+        VkDescriptorSet quantization;
+        const Mesh*     mesh;
+        uint32_t        lod;
+        uint32_t        firstInstance; ///< First instance in the instance buffer.
+        uint32_t        instanceCount;
+        uint32_t        firstCommand;  ///< First indirect command slot (GPU culling).
+        uint32_t        commandCount;  ///< instanceCount * number of cull items (sub meshes or meshlets).
+    };
+
+    struct {
+        std::shared_ptr<VulkanShaderProgram> shader{};
+        std::shared_ptr<VulkanShaderProgram> packedShader{};
+        std::shared_ptr<VulkanShaderProgram> depthShader{};
+        std::shared_ptr<VulkanShaderProgram> packedDepthShader{};
+        VulkanGraphicPipelinePtr             pipeline{};
+        VulkanGraphicPipelinePtr             packedPipeline{}; ///< pipeline for MeshVertexFormat::Packed.
+        VulkanGraphicPipelinePtr             depthPipeline{};  ///< MeshPass::Depth variants.
+        VulkanGraphicPipelinePtr             packedDepthPipeline{};
+        VulkanGraphicPipelinePtr             equalPipeline{};  ///< MeshPass::LitEqual variants.
+        VulkanGraphicPipelinePtr             packedEqualPipeline{};
+        PerFrame<VkDescriptorSet>            descriptorSet{};
+        PerFrame<VulkanBufferPtr>            instanceBuffer{};
+        PerFrame<uint32_t>                   capacity{};
+        std::vector<DrawGroup>               drawGroups;
+    } mMeshInstanced;
+
+    struct {
+        std::shared_ptr<VulkanShaderProgram> shader{};
+        VulkanComputePipelinePtr             pipeline{};
+        PerFrame<VkDescriptorSet>            descriptorSet{};
+        PerFrame<VulkanBufferPtr>            cullItemBuffer{};    ///< Inputs of the culling pass.
+        PerFrame<VulkanBufferPtr>            drawCommandBuffer{}; ///< VkDrawIndexedIndirectCommand, first then late phase.
+        PerFrame<VulkanBufferPtr>            drawCountBuffer{};   ///< Visible count + one per group, first then late phase.
+        PerFrame<VulkanBufferPtr>            occludedBuffer{};    ///< Items hidden in the first phase.
+        PerFrame<VulkanBufferPtr>            readbackBuffer{};    ///< Copy of the visible and occluded counts.
+        PerFrame<VkImageView>                depthPyramidView{};  ///< Pyramid bound to the descriptor set.
+        PerFrame<uint32_t>                   itemCapacity{};
+        PerFrame<uint32_t>                   groupCapacity{};
+        uint32_t                             itemCount{0};        ///< Items culled by the recorded frame.
+        uint32_t                             groupCount{0};
+    } mGpuCulling;
+
     struct {
         std::shared_ptr<VulkanShaderProgram> shader{};
         VulkanGraphicPipelinePtr             pipeline{};
@@ -157,7 +459,24 @@ private:
     struct {
         std::shared_ptr<VulkanShaderProgram> shader{};
         VulkanGraphicPipelinePtr             pipeline{};
-        VkDescriptorSet                      descriptorSet0{VK_NULL_HANDLE};
+        PerFrame<VkDescriptorSet>            descriptorSet0{};
         VkDescriptorSet                      descriptorSet1{VK_NULL_HANDLE};
     } mDrawTerrain;
+
+    /// @brief Lights of the frames, the point and spot lights are assigned to the view clusters by a
+    ///        compute pass. The light buffers are bound to the set 0 of the lit passes with the cluster
+    ///        buffer, they are kept in sync with the registry by the light system.
+    struct {
+        std::shared_ptr<VulkanShaderProgram> shader{};
+        VulkanComputePipelinePtr             pipeline{};
+        std::unique_ptr<LightSystem>         lightSystem{};
+        PerFrame<VkDescriptorSet>            descriptorSet{};
+        PerFrame<VulkanBufferPtr>            pointLightBuffer{};
+        PerFrame<VulkanBufferPtr>            spotLightBuffer{};
+        PerFrame<VulkanBufferPtr>            directionalLightBuffer{};
+        PerFrame<VulkanBufferPtr>            clusterBuffer{};  ///< Light list of each cluster, see LightClusters.h.
+        PerFrame<uint32_t>                   pointCapacity{};
+        PerFrame<uint32_t>                   spotCapacity{};
+        PerFrame<uint32_t>                   directionalCapacity{};
+    } mLightClusters;
 };
@@ -25,16 +25,12 @@ Terrain::Terrain() {
         createInfo.name           = "TerrainVB";
         createInfo.sizeInByte     = mPatchVertices.size() * sizeof(Vertex);
         createInfo.usage          = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-        createInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        mVertexBuffer             = VulkanBuffer::Create(createInfo);
-        mVertexBuffer->writeData(mPatchVertices.data(), createInfo.sizeInByte);
+        mVertexBuffer             = VulkanBuffer::CreateDeviceLocal(createInfo, mPatchVertices.data());
 
         createInfo.name           = "TerrainIB";
         createInfo.sizeInByte     = mIndices.size() * sizeof(unsigned);
         createInfo.usage          = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-        createInfo.memoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        mIndexBuffer              = VulkanBuffer::Create(createInfo);
-        mIndexBuffer->writeData(mIndices.data(), createInfo.sizeInByte);
+        mIndexBuffer              = VulkanBuffer::CreateDeviceLocal(createInfo, mIndices.data());
     }
     {
         VulkanTexture2DCreateInfo createInfo{};
@@ -9,14 +9,15 @@
 #include "Spirv/SpirvReflection.h"
 #include "vulkan/VulkanContext.h"
 #include "vulkan/VulkanDescriptorPool.h"
+#include "vulkan/VulkanGeometryArena.h"
 #include "vulkan/VulkanSwapchain.h"
 #include "vulkan/VulkanUtils.h"
 #include "vulkan/VulkanShaderProgram.h"
 #include "vulkan/VulkanImGuiRenderer.h"
 #include "vulkan/VulkanTexture.h"
 #include "vulkan/VulkanGraphicPipeline.h"
-
-#include "AssimpImporter.h"
+#include "vulkan/VulkanMipGenerator.h"
+#include "vulkan/VulkanUploader.h"
 
 #include <Engine/Application.h>
 #include <Engine/Event.h>
@@ -24,19 +25,27 @@
 #include <Engine/Layer.h>
 #include <Engine/Log.h>
 #include <Engine/SDL3/SDL3Window.h>
+#include <Engine/ThreadPool.h>
 #include <SDL3/SDL.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <imgui.h>
 
 #include <array>
+#include <chrono>
 #include <filesystem>
 
 struct FrameData {
     VkCommandPool   commandPool;
     VkCommandBuffer commandBuffer;
+    VkFence         inFlightFence;  // Signaled when the GPU is done with the frame.
+    VkSemaphore     imageAvailable; // Signaled when the acquired swapchain image is ready.
 };
-FrameData        frameData{};
+// Number of frames recorded while the GPU is still processing the previous ones.
+constexpr uint32_t kFrameInFlightCount = 2;
+static_assert(kFrameInFlightCount <= MAX_FRAME_IN_FLIGHT);
+std::array<FrameData, kFrameInFlightCount> frames{};
+uint32_t         frameIndex{};
 VulkanSwapchain* vulkanSwapchain{};
 std::shared_ptr<VulkanShaderProgram> fullScreenShader;
 VulkanGraphicPipelinePtr  pipelineFullScreen;
@@ -52,6 +61,7 @@ entt::entity light1;
 entt::entity light2;
 entt::entity light3;
 entt::entity flashLight;
+entt::entity cameraEntity;
 
 bool gWalkCamMode = true;
 
@@ -60,51 +70,60 @@ TestLayer1::~TestLayer1() {}
 void TestLayer1::onAttach() {
     VulkanContext::Initialize();
     Renderer::Init();
-    mSceneRenderer = new SceneRenderer();
+    mSceneRenderer = new SceneRenderer(kFrameInFlightCount);
 
     gTerrain = std::make_shared<Terrain>();
 
     cameraController.setPosition({0, gTerrain->getHeight(0, 0), 0});
 
     // generate mipmap for normal and specular map ?
-    gTextureCache["ab_crate_a"]        = VulkanTexture::Create("./data/ab_crate_a.png", true, true);
-    gTextureCache["ab_crate_a_nm"]     = VulkanTexture::Create("./data/ab_crate_a_nm.png", false, true);
-    gTextureCache["ab_crate_a_sm"]     = VulkanTexture::Create("./data/ab_crate_a_sm.png", false, true);
-    gTextureCache["brick_wall2"]       = VulkanTexture::Create("./data/brick_wall2-diff-512.tga", true, true);
-    gTextureCache["brick_wall2_sm"]    = VulkanTexture::Create("./data/brick_wall2-spec-512.tga", false, true);
-    gTextureCache["brick_wall2_nm"]    = VulkanTexture::Create("./data/brick_wall2-nor-512.tga", false, true);
-    gTextureCache["metal1"]            = VulkanTexture::Create("./data/metal1-dif-1024.tga", true, true);
-    gTextureCache["metal1_sm"]         = VulkanTexture::Create("./data/metal1-spec-1024.tga", false, true);
-    gTextureCache["metal1_nm"]         = VulkanTexture::Create("./data/metal1-nor-1024.tga", false, true);
-    gTextureCache["FloorSandStone"]    = VulkanTexture::Create("./data/FloorDiffuse.png", true, true); // FloorAmbientOcclusion
-    gTextureCache["FloorSandStone_nm"] = VulkanTexture::Create("./data/FloorNormal.png", false, true);
-    gTextureCache["FloorSandStone_sm"] = VulkanTexture::Create("./data/FloorSpacular.png", false, true);
-
-    gTextureCache["edf_soldier_a"]    = VulkanTexture::Create("./data/model/edf_soldier/edf_body_d.tga", true, true);
-    gTextureCache["edf_soldier_a_nm"] = VulkanTexture::Create("./data/model/edf_soldier/edf_body_n.tga", false, true);
-    gTextureCache["edf_soldier_a_sm"] = VulkanTexture::Create("./data/model/edf_soldier/edf_body_s.tga", false, true);
-
-    gTextureCache["grass"]                 = VulkanTexture::Create("./data/textures/pattern_216/T_216_d.tga", true, true); // grass
-    gTextureCache["grass_s"]               = VulkanTexture::Create("./data/textures/pattern_216/T_216_s.tga", true, true);
-    gTextureCache["grass_n"]               = VulkanTexture::Create("./data/textures/pattern_216/T_216_n.tga", false, true);
-
-    gTextureCache["coast_land_rocks_01"]   = VulkanTexture::Create("./data/textures/pattern_218/T_218_d.tga", true, true); // rock
-    gTextureCache["coast_land_rocks_01_s"] = VulkanTexture::Create("./data/textures/pattern_218/T_218_s.tga", true, true);
-    gTextureCache["coast_land_rocks_01_n"] = VulkanTexture::Create("./data/textures/pattern_218/T_218_n.tga", false, true);
-
-    gTextureCache["coast_sand_rocks_02"]   = VulkanTexture::Create("./data/textures/pattern_216/T_216_d.tga", true, true); // grass
-    gTextureCache["coast_sand_rocks_02_s"] = VulkanTexture::Create("./data/textures/pattern_216/T_216_s.tga", true, true);
-    gTextureCache["coast_sand_rocks_02_n"] = VulkanTexture::Create("./data/textures/pattern_216/T_216_n.tga", false, true);
-
-    gTextureCache["brown_mud_02"]          = VulkanTexture::Create("./data/textures/pattern_91/T_91_d.tga", true, true); // tiles
-    gTextureCache["brown_mud_02_s"]        = VulkanTexture::Create("./data/textures/pattern_91/T_91_s.tga", true, true);
-    gTextureCache["brown_mud_02_n"]        = VulkanTexture::Create("./data/textures/pattern_91/T_91_n.tga", false, true);
-
-    gTextureCache["stones"]                = VulkanTexture::Create("./data/textures/pattern_215/T_215_d.tga", true, true); // grass with rock
-    gTextureCache["stones_s"]              = VulkanTexture::Create("./data/textures/pattern_215/T_215_s.tga", true, true);
-    gTextureCache["stones_n"]              = VulkanTexture::Create("./data/textures/pattern_215/T_215_n.tga", false, true);
-
-    gTextureCache["TerrainBlendMap"] = VulkanTexture::Create("./data/terrain/blend.png", false, false);
+    const std::pair<std::string, VulkanTextureLoadInfo> textureLoadInfos[] = {
+        {"ab_crate_a",            {"./data/ab_crate_a.png",                   true,  true}},
+        {"ab_crate_a_nm",         {"./data/ab_crate_a_nm.png",                false, true, true}},
+        {"ab_crate_a_sm",         {"./data/ab_crate_a_sm.png",                false, true}},
+        {"brick_wall2",           {"./data/brick_wall2-diff-512.tga",         true,  true}},
+        {"brick_wall2_sm",        {"./data/brick_wall2-spec-512.tga",         false, true}},
+        {"brick_wall2_nm",        {"./data/brick_wall2-nor-512.tga",          false, true, true}},
+        {"metal1",                {"./data/metal1-dif-1024.tga",              true,  true}},
+        {"metal1_sm",             {"./data/metal1-spec-1024.tga",             false, true}},
+        {"metal1_nm",             {"./data/metal1-nor-1024.tga",              false, true, true}},
+        {"FloorSandStone",        {"./data/FloorDiffuse.png",                 true,  true}}, // FloorAmbientOcclusion
+        {"FloorSandStone_nm",     {"./data/FloorNormal.png",                  false, true, true}},
+        {"FloorSandStone_sm",     {"./data/FloorSpacular.png",                false, true}},
+        {"edf_soldier_a",         {"./data/model/edf_soldier/edf_body_d.tga", true,  true}},
+        {"edf_soldier_a_nm",      {"./data/model/edf_soldier/edf_body_n.tga", false, true, true}},
+        {"edf_soldier_a_sm",      {"./data/model/edf_soldier/edf_body_s.tga", false, true}},
+        {"grass",                 {"./data/textures/pattern_216/T_216_d.tga", true,  true}}, // grass
+        {"grass_s",               {"./data/textures/pattern_216/T_216_s.tga", true,  true}},
+        {"grass_n",               {"./data/textures/pattern_216/T_216_n.tga", false, true, true}},
+        {"coast_land_rocks_01",   {"./data/textures/pattern_218/T_218_d.tga", true,  true}}, // rock
+        {"coast_land_rocks_01_s", {"./data/textures/pattern_218/T_218_s.tga", true,  true}},
+        {"coast_land_rocks_01_n", {"./data/textures/pattern_218/T_218_n.tga", false, true, true}},
+        {"coast_sand_rocks_02",   {"./data/textures/pattern_216/T_216_d.tga", true,  true}}, // grass
+        {"coast_sand_rocks_02_s", {"./data/textures/pattern_216/T_216_s.tga", true,  true}},
+        {"coast_sand_rocks_02_n", {"./data/textures/pattern_216/T_216_n.tga", false, true, true}},
+        {"brown_mud_02",          {"./data/textures/pattern_91/T_91_d.tga",   true,  true}}, // tiles
+        {"brown_mud_02_s",        {"./data/textures/pattern_91/T_91_s.tga",   true,  true}},
+        {"brown_mud_02_n",        {"./data/textures/pattern_91/T_91_n.tga",   false, true, true}},
+        {"stones",                {"./data/textures/pattern_215/T_215_d.tga", true,  true}}, // grass with rock
+        {"stones_s",              {"./data/textures/pattern_215/T_215_s.tga", true,  true}},
+        {"stones_n",              {"./data/textures/pattern_215/T_215_n.tga", false, true, true}},
+        {"TerrainBlendMap",       {"./data/terrain/blend.png",                false, false}},
+    };
+
+    // The files are decoded on worker threads, each texture upload is queued as soon as its file is decoded.
+    const auto         textureLoadStart = std::chrono::steady_clock::now();
+    Engine::ThreadPool loadThreadPool;
+    {
+        std::vector<VulkanTextureLoadInfo> loadInfos;
+        for (const auto& [name, loadInfo] : textureLoadInfos) {
+            loadInfos.push_back(loadInfo);
+        }
+        const std::vector<VulkanTexturePtr> textures = VulkanTexture::CreateBatch(loadInfos, loadThreadPool);
+        for (size_t i = 0; i < textures.size(); ++i) {
+            gTextureCache[textureLoadInfos[i].first] = textures[i];
+        }
+    }
 
     std::filesystem::path cubeMapPaths[6] = {
         "./data/skybox/sleepyhollow_ft.jpg", // right +z
@@ -115,7 +134,9 @@ void TestLayer1::onAttach() {
         "./data/skybox/sleepyhollow_lf.jpg", // left   -x
     };
 
-    gTextureCache["SkyBox"] = VulkanTexture::CreateCubeMap(cubeMapPaths, true);
+    gTextureCache["SkyBox"] = VulkanTexture::CreateCubeMap(cubeMapPaths, true, &loadThreadPool);
+    ENGINE_INFO("Textures loaded in {} ms",
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - textureLoadStart).count());
     gTextureCache["WhiteTexture"] = VulkanTexture::CreateWhiteTexture();
     gTextureCache["BlackTexture"] = VulkanTexture::CreateBlackTexture();
     gTextureCache["CheckBoard"]   = VulkanTexture::CreateCheckBoard();
@@ -131,8 +152,7 @@ void TestLayer1::onAttach() {
     meshs.push_back(meshSphere);
     meshs.push_back(meshGeoSphere);
 
-    AssimpImporter assimpImporter;
-    auto importedMesh = assimpImporter.importMesh("./data/model/edf_soldier/edf_soldier_a.obj");
+    auto importedMesh = Mesh::CreateFromFile("./data/model/edf_soldier/edf_soldier_a.obj");
     meshs.push_back(importedMesh);
 #if 1
     mRegistry.ctx().emplace<CSkyBox>().texture = gTextureCache["SkyBox"];
@@ -405,7 +425,11 @@ auto createCynlinderAndSphere = [this, &meshCylinder, &meshGeoSphere](glm::vec3
         mat.normalMap                             = gTextureCache["ab_crate_a_sm"];
         return e;
     };
-    flashLight = createSpotLight({0, 10, 0}, {1, -1, 0});
+    // The flash light follow the camera, its transform is relative to the camera entity.
+    cameraEntity = mRegistry.create();
+    mRegistry.emplace<CTransform>(cameraEntity);
+    flashLight = createSpotLight({0, 0, 0}, {0, 0, -1});
+    mRegistry.emplace<CHierarchy>(flashLight).parent = cameraEntity;
 
     auto sdlWindow   = Engine::Application::Get().GetWindow().getSDLWindow();
     auto win32Handle = SDL_GetPointerProperty(SDL_GetWindowProperties(sdlWindow),
@@ -428,34 +452,45 @@ auto createCynlinderAndSphere = [this, &meshCylinder, &meshGeoSphere](glm::vec3
         new VulkanSwapchain(VulkanContext::getIntance(), VulkanContext::getPhycalDevice(),
                             VulkanContext::getDevice(), surface);
     vulkanSwapchain->build();
-    // Create Command pool
-    {
-        VkCommandPoolCreateFlags flags{};
-        // allows any command buffer allocated from a pool to be individually
-        // reset to the initial state; either by calling vkResetCommandBuffer,
-        // or via the implicit reset when calling vkBeginCommandBuffer.
-        flags |= VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        // specifies that command buffers allocated from the pool will be short-lived,
-        // meaning that they will be reset or freed in a relatively short timeframe.
-        flags |= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-
-        VkCommandPoolCreateInfo commandPoolCreateInfo = {
-            .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-            .pNext            = nullptr,
-            .flags            = flags,
-            .queueFamilyIndex = VulkanContext::getGraphicQueueFamilyIndex()};
-        vkCreateCommandPool(VulkanContext::getDevice(), &commandPoolCreateInfo, nullptr,
-                            &frameData.commandPool);
-    }
+    for (FrameData& frameData : frames) {
+        // Create Command pool
+        {
+            VkCommandPoolCreateFlags flags{};
+            // specifies that command buffers allocated from the pool will be short-lived,
+            // meaning that they will be reset or freed in a relatively short timeframe.
+            // The whole pool is reset once the frame fence is signaled.
+            flags |= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+            VkCommandPoolCreateInfo commandPoolCreateInfo = {
+                .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .pNext            = nullptr,
+                .flags            = flags,
+                .queueFamilyIndex = VulkanContext::getGraphicQueueFamilyIndex()};
+            vkCreateCommandPool(VulkanContext::getDevice(), &commandPoolCreateInfo, nullptr,
+                                &frameData.commandPool);
+        }
 
-    // Command buffer allocation
-    {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.commandPool        = frameData.commandPool;
-        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandBufferCount = 1;
-        vkAllocateCommandBuffers(VulkanContext::getDevice(), &allocInfo, &frameData.commandBuffer);
+        // Command buffer allocation
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool        = frameData.commandPool;
+            allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            vkAllocateCommandBuffers(VulkanContext::getDevice(), &allocInfo, &frameData.commandBuffer);
+        }
+
+        // Synchronization, the fence is created signaled so the first wait returns right away.
+        {
+            VkFenceCreateInfo fenceCreateInfo{};
+            fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+            VK_CHECK(vkCreateFence(VulkanContext::getDevice(), &fenceCreateInfo, nullptr, &frameData.inFlightFence));
+
+            VkSemaphoreCreateInfo semaphoreCreateInfo{};
+            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            VK_CHECK(vkCreateSemaphore(VulkanContext::getDevice(), &semaphoreCreateInfo, nullptr, &frameData.imageAvailable));
+        }
     }
 
     fullScreenShader   = VulkanShaderProgram::CreateFromSpirv({"./shaders/fullscreen_vert.spv", "./shaders/fullscreen_frag.spv"});
@@ -466,20 +501,26 @@ auto createCynlinderAndSphere = [this, &meshCylinder, &meshGeoSphere](glm::vec3
     pipelineFullScreen = VulkanGraphicPipeline::Create(createInfo);
 
     depthBuffer = VulkanTexture::CreateDepthBuffer(vulkanSwapchain->getSize().width, vulkanSwapchain->getSize().height);
+    mSceneRenderer->setDepthBuffer(depthBuffer);
+
+    // The sky box and the terrain are not gated by their upload, the scene is complete before the first frame.
+    VulkanUploader::flush();
+    VulkanUploader::wait({VulkanUploader::getSubmittedValue()});
     //depthBuffer = VulkanContext::createTexture(
     //    vulkanSwapchain->getSize().width, vulkanSwapchain->getSize().height,
     //    VK_FORMAT_D24_UNORM_S8_UINT, 1, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
 }
 
 void TestLayer1::onDetach() {
+    // The frames in flight may still use the resources held by the registry.
+    vkDeviceWaitIdle(VulkanContext::getDevice());
+
     // destroy the registry frist.
     // All component which hold shared ptr on vulkan ressource
     // will be released.
     mRegistry.clear();
     mRegistry.ctx().erase<CSkyBox>();
 
-    vkDeviceWaitIdle(VulkanContext::getDevice());
-
     VulkanImGuiRenderer::Shutdown();
 
     meshs.clear();
@@ -487,7 +528,11 @@ void TestLayer1::onDetach() {
     gTextureCache.clear();
 
     delete mSceneRenderer;
-    vkDestroyCommandPool(VulkanContext::getDevice(), frameData.commandPool, nullptr);
+    for (FrameData& frameData : frames) {
+        vkDestroyCommandPool(VulkanContext::getDevice(), frameData.commandPool, nullptr);
+        vkDestroyFence(VulkanContext::getDevice(), frameData.inFlightFence, nullptr);
+        vkDestroySemaphore(VulkanContext::getDevice(), frameData.imageAvailable, nullptr);
+    }
 
     depthBuffer.reset();
 
@@ -510,10 +555,25 @@ void TestLayer1::onUpdate(float timeStep) {
         }
     }
 
-    auto& lightTrans = mRegistry.get<CTransform>(flashLight);
-    auto& light = mRegistry.get<CSpotLight>(flashLight);
-    lightTrans.position = cameraController.getPosition();
-    light.direction     = cameraController.getDirection();
+    // Rotation angles (degrees) which transform (0,0,-1) into the camera direction.
+    mRegistry.patch<CTransform>(cameraEntity, [](CTransform& cameraTrans) {
+        const glm::vec3 direction = cameraController.getDirection();
+        cameraTrans.position      = cameraController.getPosition();
+        cameraTrans.rotation.x    = glm::degrees(std::asin(glm::clamp(direction.y, -1.0f, 1.0f)));
+        cameraTrans.rotation.y    = glm::degrees(std::atan2(-direction.x, -direction.z));
+        cameraTrans.rotation.z    = 0.0f;
+    });
+
+    mTransformSystem.update();
+
+    // Wait for the GPU to be done with the last submission of this frame slot, only then
+    // its command buffer and per frame resources can be reused.
+    FrameData& frameData = frames[frameIndex];
+    vkWaitForFences(VulkanContext::getDevice(), 1, &frameData.inFlightFence, VK_TRUE, UINT64_MAX);
+    vkResetFences(VulkanContext::getDevice(), 1, &frameData.inFlightFence);
+    VulkanGeometryArena::beginFrame(kFrameInFlightCount);
+    vulkanSwapchain->acquireNextImage(frameData.imageAvailable);
+    vkResetCommandPool(VulkanContext::getDevice(), frameData.commandPool, 0);
 
     // start command buffer
     {
@@ -529,11 +589,16 @@ void TestLayer1::onUpdate(float timeStep) {
         beginInfo.flags            = flags;   // Optional
         beginInfo.pInheritanceInfo = nullptr; // Optional
 
-        // If the command buffer was already recorded once, then a call to vkBeginCommandBuffer will
-        // implicitly reset it.
         vkBeginCommandBuffer(frameData.commandBuffer, &beginInfo);
     }
 
+    // Submit the pending uploads and take the ownership of the resources uploaded by the GPU.
+    // The uploads still in flight are not waited for, their meshes and materials are skipped.
+    // The mipmaps of the acquired textures are generated together.
+    VulkanUploader::flush();
+    VulkanUploader::acquire(frameData.commandBuffer);
+    VulkanMipGenerator::record(frameData.commandBuffer);
+
     // transition swapchain image layout
     {
         // Move the swapchain's back image layour from
@@ -542,13 +607,30 @@ void TestLayer1::onUpdate(float timeStep) {
             frameData.commandBuffer,
             vulkanSwapchain->getImages()[vulkanSwapchain->getCurrentBackImageIndex()],
             VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE, // acquire semaphore wait stage
             VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
             VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, 1);
+
+        // The depth buffer is shared by the frames in flight, the previous frame
+        // may still be testing against it.
+        VulkanUtils::memoryBarrier(
+            frameData.commandBuffer,
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
     }
 
+    // upload the scene data and run the compute passes before rendering
+    mSceneRenderer->setViewportSize(static_cast<float>(vulkanSwapchain->getSize().width),
+                                    static_cast<float>(vulkanSwapchain->getSize().height));
+    mSceneRenderer->prepare(&mRegistry, frameData.commandBuffer, frameIndex,
+                            cameraController.getProjectonMatrix(),
+                            cameraController.getViewMatrix(), cameraController.getPosition());
+
     // start render pass
-    {
+    // The scene can be split in several rendering scopes, only the first one clears the attachments.
+    const auto beginRendering = [&frameData](VkAttachmentLoadOp loadOp, VkRenderingFlags flags) {
         VkRenderingAttachmentInfo colorAttachmentInfo[1]{};
         colorAttachmentInfo[0].sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
         colorAttachmentInfo[0].pNext = 0;
@@ -558,7 +640,7 @@ void TestLayer1::onUpdate(float timeStep) {
         colorAttachmentInfo[0].resolveMode        = VK_RESOLVE_MODE_NONE;
         colorAttachmentInfo[0].resolveImageView   = nullptr;
         colorAttachmentInfo[0].resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachmentInfo[0].loadOp             = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachmentInfo[0].loadOp             = loadOp;
         colorAttachmentInfo[0].storeOp            = VK_ATTACHMENT_STORE_OP_STORE;
         colorAttachmentInfo[0].clearValue.color   = {{1.0f, 0.0f, 1.0f, 1.0f}};
 
@@ -570,14 +652,14 @@ void TestLayer1::onUpdate(float timeStep) {
         depthAttachmentInfo.resolveMode        = VK_RESOLVE_MODE_NONE;
         depthAttachmentInfo.resolveImageView   = nullptr;
         depthAttachmentInfo.resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachmentInfo.loadOp             = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachmentInfo.loadOp             = loadOp;
         depthAttachmentInfo.storeOp            = VK_ATTACHMENT_STORE_OP_STORE;
         depthAttachmentInfo.clearValue.depthStencil = {1.0f, 0};
 
         VkRenderingInfo info{};
         info.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO;
         info.pNext                = nullptr;
-        info.flags                = 0;
+        info.flags                = flags;
         info.renderArea           = {0, 0, vulkanSwapchain->getSize().width,
                                      vulkanSwapchain->getSize().height};
         info.layerCount           = 1;
@@ -587,7 +669,8 @@ void TestLayer1::onUpdate(float timeStep) {
         info.pDepthAttachment     = &depthAttachmentInfo;
         info.pStencilAttachment   = nullptr;
         vkCmdBeginRendering(frameData.commandBuffer, &info);
-    }
+    };
+    beginRendering(VK_ATTACHMENT_LOAD_OP_CLEAR, 0);
 
     // render stuff
     {
@@ -618,9 +701,36 @@ void TestLayer1::onUpdate(float timeStep) {
             vkCmdDraw(frameData.commandBuffer, 3, 1, 0, 0);
         }
 
-        mSceneRenderer->render(&mRegistry, frameData.commandBuffer,
-                               cameraController.getProjectonMatrix(),
-                               cameraController.getViewMatrix(), cameraController.getPosition());
+        if (mSceneRenderer->isUseMultithreadedRecording()) {
+            // A rendering scope with secondary command buffers can't record commands inline.
+            SceneRenderTarget target{};
+            target.colorFormat = vulkanSwapchain->getFormat();
+            target.depthFormat = depthBuffer->getFormat();
+            target.extent      = vulkanSwapchain->getSize();
+
+            vkCmdEndRendering(frameData.commandBuffer);
+            beginRendering(VK_ATTACHMENT_LOAD_OP_LOAD, VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+            mSceneRenderer->renderSecondary(frameData.commandBuffer, target);
+            vkCmdEndRendering(frameData.commandBuffer);
+            if (!mSceneRenderer->hasLatePass()) {
+                beginRendering(VK_ATTACHMENT_LOAD_OP_LOAD, 0);
+            }
+        } else {
+            mSceneRenderer->render(frameData.commandBuffer);
+            if (mSceneRenderer->hasLatePass()) {
+                vkCmdEndRendering(frameData.commandBuffer);
+            }
+        }
+
+        // The second phase of the occlusion culling reads the depth of the first one, outside of
+        // the rendering scope, and draws the meshes it revealed over the same attachments.
+        if (mSceneRenderer->hasLatePass()) {
+            mSceneRenderer->cullLate(frameData.commandBuffer);
+            beginRendering(VK_ATTACHMENT_LOAD_OP_LOAD, 0);
+            vkCmdSetViewportWithCount(frameData.commandBuffer, 1, &viewport);
+            vkCmdSetScissorWithCount(frameData.commandBuffer, 1, &rect);
+            mSceneRenderer->renderLate(frameData.commandBuffer);
+        }
 
         VulkanContext::CmdEndLabel(frameData.commandBuffer);
     }
@@ -661,11 +771,16 @@ void TestLayer1::onUpdate(float timeStep) {
             VkSemaphoreSubmitInfo info;
             info.sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
             info.pNext       = nullptr;
-            info.semaphore   = vulkanSwapchain->getImageAvailableSemaphores();
+            info.semaphore   = frameData.imageAvailable;
             info.value       = 0;
             info.stageMask   = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
             info.deviceIndex = 0;
             waitSemaphoreSubmitInfo.push_back(info);
+
+            info.semaphore   = VulkanUploader::getTimelineSemaphore();
+            info.value       = VulkanUploader::getAcquiredValue();
+            info.stageMask   = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            waitSemaphoreSubmitInfo.push_back(info);
         }
         std::vector<VkSemaphoreSubmitInfo> signalSemaphoreSubmitInfo;
         {
@@ -691,13 +806,12 @@ void TestLayer1::onUpdate(float timeStep) {
         submitInfo2.signalSemaphoreInfoCount = signalSemaphoreSubmitInfo.size();
         submitInfo2.pSignalSemaphoreInfos    = signalSemaphoreSubmitInfo.data();
         VK_CHECK(
-            vkQueueSubmit2(VulkanContext::getGraphicQueue(), 1 /*submitCount*/, &submitInfo2, 0));
+            vkQueueSubmit2(VulkanContext::getGraphicQueue(), 1 /*submitCount*/, &submitInfo2, frameData.inFlightFence));
     }
 
     vulkanSwapchain->present(VulkanContext::getGraphicQueue(), VK_PRESENT_MODE_MAILBOX_KHR);
 
-    // tempo
-    vkDeviceWaitIdle(VulkanContext::getDevice());
+    frameIndex = (frameIndex + 1) % kFrameInFlightCount;
 }
 
 void TestLayer1::onImGuiRender() {
@@ -713,6 +827,37 @@ void TestLayer1::onImGuiRender() {
     ImGui::Text("%.1f FPS", ImGui::GetIO().Framerate);
     ImGui::Text("Position:  %.2f,%.2f,%.2f", cameraController.getPosition().x, cameraController.getPosition().y, cameraController.getPosition().z);
     ImGui::Text("Direction: %.2f,%.2f,%.2f", cameraController.getDirection().x, cameraController.getDirection().y, cameraController.getDirection().z);
+    const auto& stats = mSceneRenderer->getStats();
+    ImGui::Text("Draw calls: %u (%u instances)", stats.drawCalls, stats.instanceCount);
+    ImGui::Text("Scene CPU:  %.3f ms", stats.cpuTimeMs);
+    ImGui::Text("Scene GPU:  culling %.3f ms, depth pre-pass %.3f ms, mesh pass %.3f ms",
+                stats.gpuCullingMs, stats.gpuDepthPrepassMs, stats.gpuMeshPassMs);
+    ImGui::Text("Lights:     %u clustered, %u uploaded, assignment %.3f ms", stats.lightCount,
+                stats.lightUploadCount, stats.gpuLightClustersMs);
+    ImGui::Text("Binds: %u issued, %u skipped", stats.bindsIssued, stats.bindsSkipped);
+    ImGui::Text("Triangles: %u", stats.triangleCount);
+    if (mSceneRenderer->isUseMultithreadedRecording()) {
+        ImGui::Text("Secondary command buffers: %u", stats.recordJobCount);
+    }
+    ImGui::Text("Transforms updated: %u", mTransformSystem.getUpdatedCount());
+    const auto geometryStats = VulkanGeometryArena::getStatistics();
+    ImGui::Text("Vertex arena: %.1f / %.1f MB, %u meshes, %u free blocks (%.1f%% fragmented)",
+                geometryStats.vertex.usedSize / (1024.0 * 1024.0), geometryStats.vertex.capacity / (1024.0 * 1024.0),
+                geometryStats.vertex.allocationCount, geometryStats.vertex.freeBlockCount,
+                geometryStats.vertex.fragmentation * 100.0f);
+    ImGui::Text("Index arena:  %.1f / %.1f MB, %u meshes, %u free blocks (%.1f%% fragmented)",
+                geometryStats.index.usedSize / (1024.0 * 1024.0), geometryStats.index.capacity / (1024.0 * 1024.0),
+                geometryStats.index.allocationCount, geometryStats.index.freeBlockCount,
+                geometryStats.index.fragmentation * 100.0f);
+    if (mSceneRenderer->isUseGpuCulling()) {
+        ImGui::Text("GPU visible: %u", stats.gpuVisibleCount);
+        if (mSceneRenderer->isUseOcclusionCulling()) {
+            ImGui::SameLine();
+            ImGui::Text("GPU occluded: %u", stats.gpuOccludedCount);
+        }
+    } else if (mSceneRenderer->isUseCpuCulling()) {
+        ImGui::Text("CPU visible: %u / %u", stats.cpuVisibleCount, stats.cpuTotalCount);
+    }
     ImGui::End();
 
     ImGui::PopStyleVar(1);
@@ -732,6 +877,53 @@ void TestLayer1::onImGuiRender() {
 
         ImGui::Checkbox("WalkCamMode", &gWalkCamMode);
 
+        static bool useInstancing = mSceneRenderer->isUseInstancing();
+        if(ImGui::Checkbox("Use Instancing", &useInstancing)) {
+            mSceneRenderer->setUseInstancing(useInstancing);
+        }
+
+        static bool useCpuCulling = mSceneRenderer->isUseCpuCulling();
+        if(ImGui::Checkbox("Use CPU Culling", &useCpuCulling)) {
+            mSceneRenderer->setUseCpuCulling(useCpuCulling);
+        }
+
+        static bool useGpuCulling = mSceneRenderer->isUseGpuCulling();
+        if(ImGui::Checkbox("Use GPU Culling", &useGpuCulling)) {
+            mSceneRenderer->setUseGpuCulling(useGpuCulling);
+        }
+
+        static bool useOcclusionCulling = mSceneRenderer->isUseOcclusionCulling();
+        if(ImGui::Checkbox("Use Occlusion Culling", &useOcclusionCulling)) {
+            mSceneRenderer->setUseOcclusionCulling(useOcclusionCulling);
+        }
+
+        static bool useDepthPrepass = mSceneRenderer->isUseDepthPrepass();
+        if(ImGui::Checkbox("Use Depth Pre-pass", &useDepthPrepass)) {
+            mSceneRenderer->setUseDepthPrepass(useDepthPrepass);
+        }
+
+        static bool useMeshletCulling = mSceneRenderer->isUseMeshletCulling();
+        if(ImGui::Checkbox("Use Meshlet Culling", &useMeshletCulling)) {
+            mSceneRenderer->setUseMeshletCulling(useMeshletCulling);
+        }
+
+        static bool useLod = mSceneRenderer->isUseLod();
+        if(ImGui::Checkbox("Use LOD", &useLod)) {
+            mSceneRenderer->setUseLod(useLod);
+        }
+
+        ImGui::SameLine();
+
+        static float lodPixelError = mSceneRenderer->getLodPixelError();
+        if(ImGui::DragFloat("LOD pixel error", &lodPixelError, 0.1f, 0.1f, 16.0f)) {
+            mSceneRenderer->setLodPixelError(lodPixelError);
+        }
+
+        static bool useMultithreadedRecording = mSceneRenderer->isUseMultithreadedRecording();
+        if(ImGui::Checkbox("Multithreaded Recording", &useMultithreadedRecording)) {
+            mSceneRenderer->setUseMultithreadedRecording(useMultithreadedRecording);
+        }
+
         static bool displayTerrain = true;
         if(ImGui::Checkbox("Display Terrain", &displayTerrain)) {
             mSceneRenderer->setTerrainVisible(displayTerrain);
@@ -747,11 +939,15 @@ void TestLayer1::onImGuiRender() {
             mSceneRenderer->setAmbientLight(ambientLight);
         }
 
+        // The lights are edited in place, the LightSystem is notified with patch().
         for(const auto& entity : mRegistry.view<CDirectionalLight>()) {
             auto& light = mRegistry.get<CDirectionalLight>(entity);
             ImGui::TextUnformatted("Directional Light");
-            ImGui::ColorEdit3("Color:", &light.color.x);
-            ImGui::DragFloat3("Direction:", &light.direction.x, 1.0f, -1.0f, 1.0f);
+            bool changed = ImGui::ColorEdit3("Color:", &light.color.x);
+            changed |= ImGui::DragFloat3("Direction:", &light.direction.x, 1.0f, -1.0f, 1.0f);
+            if(changed) {
+                mRegistry.patch<CDirectionalLight>(entity);
+            }
         }
         unsigned int i = 0;
         for(const auto& entity : mRegistry.view<CTransform, CPointLight>()) {
@@ -760,10 +956,15 @@ void TestLayer1::onImGuiRender() {
 
             ImGui::Text("Point Lights %i", i);
             ImGui::PushID(i);
-            ImGui::Checkbox("Enable",     &light.enable);
-            ImGui::DragFloat3("Position", &trans.position.x);
-            ImGui::ColorEdit3("Color",    &light.diffuse.x);
-            ImGui::DragFloat("Range",     &light.range, 1.0f, 0.1f);
+            bool changed = ImGui::Checkbox("Enable", &light.enable);
+            if(ImGui::DragFloat3("Position", &trans.position.x)) {
+                mRegistry.patch<CTransform>(entity);
+            }
+            changed |= ImGui::ColorEdit3("Color", &light.diffuse.x);
+            changed |= ImGui::DragFloat("Range", &light.range, 1.0f, 0.1f);
+            if(changed) {
+                mRegistry.patch<CPointLight>(entity);
+            }
             ImGui::PopID();
             i++;
         }
@@ -773,11 +974,16 @@ void TestLayer1::onImGuiRender() {
 
             ImGui::Text("Spot Lights %i", i);
             ImGui::PushID(i);
-            ImGui::Checkbox("Enable",      &light.enable);
-            ImGui::DragFloat3("Position",  &trans.position.x);
-            ImGui::ColorEdit3("Color",     &light.color.x);
-            ImGui::DragFloat("Range",      &light.range, 1.0f, 0.1f);
-            ImGui::DragFloat("CutOffAngle",&light.cutOffAngle, 1.0f, 1.0f, 180.f);
+            bool changed = ImGui::Checkbox("Enable", &light.enable);
+            if(ImGui::DragFloat3("Position",  &trans.position.x)) {
+                mRegistry.patch<CTransform>(entity);
+            }
+            changed |= ImGui::ColorEdit3("Color", &light.color.x);
+            changed |= ImGui::DragFloat("Range", &light.range, 1.0f, 0.1f);
+            changed |= ImGui::DragFloat("CutOffAngle", &light.cutOffAngle, 1.0f, 1.0f, 180.f);
+            if(changed) {
+                mRegistry.patch<CSpotLight>(entity);
+            }
             ImGui::PopID();
             i++;
         }
@@ -801,6 +1007,7 @@ bool TestLayer1::onEvent(const Engine::Event& event) {
         vkDeviceWaitIdle(VulkanContext::getDevice());
         vulkanSwapchain->build();
         depthBuffer = VulkanTexture::CreateDepthBuffer(vulkanSwapchain->getSize().width, vulkanSwapchain->getSize().height);
+        mSceneRenderer->setDepthBuffer(depthBuffer);
     });
     event.dispatch<Engine::KeyEvent>([this](const Engine::KeyEvent& e) {
         if (e.isPressed()) {
@@ -820,23 +1027,19 @@ bool TestLayer1::onEvent(const Engine::Event& event) {
                 Engine::Application::Get().GetWindow().toogleMouseRelativeMode();
             }
             if (e.getKey() == Engine::KeyCode::KeyPad1) {
-                auto& light = mRegistry.get<CPointLight>(light1);
-                light.enable = !light.enable;
+                mRegistry.patch<CPointLight>(light1, [](CPointLight& light) { light.enable = !light.enable; });
             }
             if (e.getKey() == Engine::KeyCode::KeyPad2) {
-                auto& light = mRegistry.get<CPointLight>(light2);
-                light.enable = !light.enable;
+                mRegistry.patch<CPointLight>(light2, [](CPointLight& light) { light.enable = !light.enable; });
             }
             if (e.getKey() == Engine::KeyCode::KeyPad3) {
-                auto& light = mRegistry.get<CPointLight>(light3);
-                light.enable = !light.enable;
+                mRegistry.patch<CPointLight>(light3, [](CPointLight& light) { light.enable = !light.enable; });
             }
             if (e.getKey() == Engine::KeyCode::KeyPadMinus) {
                 mSceneRenderer->toggleUseBlinnPhong();
             }
             if (e.getKey() == Engine::KeyCode::F) {
-                auto& light = mRegistry.get<CSpotLight>(flashLight);
-                light.enable = !light.enable;
+                mRegistry.patch<CSpotLight>(flashLight, [](CSpotLight& light) { light.enable = !light.enable; });
             }
             if (e.getKey() == Engine::KeyCode::G) {
                 mSceneRenderer->toggleGammaCorrection();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SceneRenderer.h"
+#include "TransformSystem.h"
 
 #include <Engine/Event.h>
 #include <Engine/Layer.h>
@@ -23,6 +24,7 @@ public:
     bool onEvent(const Engine::Event& event) override;
 
 private:
-    entt::registry mRegistry;
+    entt::registry  mRegistry;
+    TransformSystem mTransformSystem{mRegistry};
     SceneRenderer*  mSceneRenderer{};
 };
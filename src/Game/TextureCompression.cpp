@@ -0,0 +1,712 @@
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+using namespace TextureCompression;
+
+// The 16 texels of a block, RGBA in [0, 255].
+using Block = std::array<std::array<float, 4>, 16>;
+
+// VkFormat values, kept here so the cooker doesn't depend on the Vulkan headers.
+constexpr uint32_t kVkFormatBC1RgbUnorm  = 131; // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+constexpr uint32_t kVkFormatBC1RgbSrgb   = 132; // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+constexpr uint32_t kVkFormatBC1RgbaUnorm = 133; // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+constexpr uint32_t kVkFormatBC1RgbaSrgb  = 134; // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+constexpr uint32_t kVkFormatBC3Unorm     = 137; // VK_FORMAT_BC3_UNORM_BLOCK
+constexpr uint32_t kVkFormatBC3Srgb      = 138; // VK_FORMAT_BC3_SRGB_BLOCK
+constexpr uint32_t kVkFormatBC5Unorm     = 141; // VK_FORMAT_BC5_UNORM_BLOCK
+constexpr uint32_t kVkFormatBC7Unorm     = 145; // VK_FORMAT_BC7_UNORM_BLOCK
+constexpr uint32_t kVkFormatBC7Srgb      = 146; // VK_FORMAT_BC7_SRGB_BLOCK
+
+// Interpolation weights (out of 64) of the 4 bits indices of BC7.
+constexpr uint32_t kBC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+uint8_t toByte(float value) { return static_cast<uint8_t>(std::clamp(value + 0.5f, 0.0f, 255.0f)); }
+
+Block loadBlock(const Image& image, uint32_t blockX, uint32_t blockY) {
+    Block block;
+    for (uint32_t y = 0; y < 4; ++y) {
+        for (uint32_t x = 0; x < 4; ++x) {
+            const uint32_t srcX  = std::min(blockX * 4 + x, image.width - 1);
+            const uint32_t srcY  = std::min(blockY * 4 + y, image.height - 1);
+            const uint8_t* texel = &image.texels[(size_t(srcY) * image.width + srcX) * 4];
+            for (uint32_t c = 0; c < 4; ++c) {
+                block[y * 4 + x][c] = texel[c];
+            }
+        }
+    }
+    return block;
+}
+
+void storeBlock(Image& image, uint32_t blockX, uint32_t blockY, const uint8_t texels[16][4]) {
+    for (uint32_t y = 0; y < 4; ++y) {
+        for (uint32_t x = 0; x < 4; ++x) {
+            const uint32_t dstX = blockX * 4 + x;
+            const uint32_t dstY = blockY * 4 + y;
+            if (dstX < image.width && dstY < image.height) {
+                std::memcpy(&image.texels[(size_t(dstY) * image.width + dstX) * 4], texels[y * 4 + x], 4);
+            }
+        }
+    }
+}
+
+/// @brief Find the line best fitting the channels [0, channelCount) of the block (principal axis)
+///        and return the extremities of the projected texels.
+void fitLine(const Block& block, uint32_t channelCount, float start[4], float end[4]) {
+    float mean[4] = {};
+    for (const auto& texel : block) {
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            mean[c] += texel[c] / 16.0f;
+        }
+    }
+
+    float covariance[4][4] = {};
+    for (const auto& texel : block) {
+        for (uint32_t i = 0; i < channelCount; ++i) {
+            for (uint32_t j = 0; j < channelCount; ++j) {
+                covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+            }
+        }
+    }
+
+    // Power iteration, converge to the eigen vector of the largest eigen value.
+    float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {};
+        float length  = 0.0f;
+        for (uint32_t i = 0; i < channelCount; ++i) {
+            for (uint32_t j = 0; j < channelCount; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+            length += next[i] * next[i];
+        }
+        if (length < 1e-12f) {
+            break; // uniform block
+        }
+        length = std::sqrt(length);
+        for (uint32_t i = 0; i < channelCount; ++i) {
+            axis[i] = next[i] / length;
+        }
+    }
+
+    float minT = std::numeric_limits<float>::max();
+    float maxT = std::numeric_limits<float>::lowest();
+    for (const auto& texel : block) {
+        float t = 0.0f;
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            t += (texel[c] - mean[c]) * axis[c];
+        }
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    for (uint32_t c = 0; c < channelCount; ++c) {
+        start[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+        end[c]   = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+    }
+}
+
+/// @brief Solve the endpoints minimizing the error of the texels for the given interpolation weights.
+/// @return false if the system is singular (all the texels use the same weight).
+bool leastSquaresEndpoints(const Block& block, uint32_t channelCount, const float weights[16], float start[4], float end[4]) {
+    // texel = (1 - w) * start + w * end
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {}, bx[4] = {};
+    for (uint32_t i = 0; i < 16; ++i) {
+        const float a = 1.0f - weights[i];
+        const float b = weights[i];
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            ax[c] += a * block[i][c];
+            bx[c] += b * block[i][c];
+        }
+    }
+    const float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (uint32_t c = 0; c < channelCount; ++c) {
+        start[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+        end[c]   = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+//
+// BC1
+//
+
+uint16_t packRGB565(const float color[3]) {
+    const uint32_t r = static_cast<uint32_t>(std::clamp(color[0] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+    const uint32_t g = static_cast<uint32_t>(std::clamp(color[1] * 63.0f / 255.0f + 0.5f, 0.0f, 63.0f));
+    const uint32_t b = static_cast<uint32_t>(std::clamp(color[2] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void unpackRGB565(uint16_t packed, uint32_t color[3]) {
+    const uint32_t r = (packed >> 11) & 31;
+    const uint32_t g = (packed >> 5) & 63;
+    const uint32_t b = packed & 31;
+    color[0]         = (r << 3) | (r >> 2);
+    color[1]         = (g << 2) | (g >> 4);
+    color[2]         = (b << 3) | (b >> 2);
+}
+
+/// @brief Decode the palette of a BC1 color block.
+/// @return true if the block uses 4 colors, false for 3 colors and transparent black.
+bool bc1Palette(uint16_t color0, uint16_t color1, bool forceFourColors, uint32_t palette[4][4]) {
+    unpackRGB565(color0, palette[0]);
+    unpackRGB565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+    const bool fourColors = forceFourColors || color0 > color1;
+    for (uint32_t c = 0; c < 3; ++c) {
+        if (fourColors) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+    return fourColors;
+}
+
+/// @brief Encode the colors of a block in 4 colors mode, return the squared error.
+float bc1EncodeEndpoints(const Block& block, const float start[3], const float end[3], uint8_t* out) {
+    uint16_t color0 = packRGB565(end);
+    uint16_t color1 = packRGB565(start);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    uint32_t palette[4][4];
+    bc1Palette(color0, color1, true, palette);
+
+    float    error   = 0.0f;
+    uint32_t indices = 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+        float    bestError = std::numeric_limits<float>::max();
+        uint32_t bestIndex = 0;
+        // With color0 == color1 the block is decoded in 3 colors mode, only the index 0 is valid.
+        const uint32_t paletteSize = color0 == color1 ? 1 : 4;
+        for (uint32_t p = 0; p < paletteSize; ++p) {
+            float e = 0.0f;
+            for (uint32_t c = 0; c < 3; ++c) {
+                const float d = block[i][c] - float(palette[p][c]);
+                e += d * d;
+            }
+            if (e < bestError) {
+                bestError = e;
+                bestIndex = p;
+            }
+        }
+        error += bestError;
+        indices |= bestIndex << (2 * i);
+    }
+
+    out[0] = color0 & 0xFF;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF;
+    out[3] = color1 >> 8;
+    std::memcpy(out + 4, &indices, 4);
+    return error;
+}
+
+void bc1EncodeBlock(const Block& block, uint8_t* out) {
+    float start[4], end[4];
+    fitLine(block, 3, start, end);
+    float bestError = bc1EncodeEndpoints(block, start, end, out);
+
+    // Refine the endpoints with the indices found.
+    for (uint32_t iteration = 0; iteration < 2; ++iteration) {
+        uint16_t color0, color1;
+        uint32_t indices;
+        std::memcpy(&color0, out, 2);
+        std::memcpy(&color1, out + 2, 2);
+        std::memcpy(&indices, out + 4, 4);
+
+        // Weight of color1 for each index.
+        constexpr float kWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+        float           weights[16];
+        for (uint32_t i = 0; i < 16; ++i) {
+            weights[i] = kWeights[(indices >> (2 * i)) & 3];
+        }
+        float refinedStart[4], refinedEnd[4];
+        if (!leastSquaresEndpoints(block, 3, weights, refinedEnd, refinedStart)) {
+            break;
+        }
+        uint8_t     candidate[8];
+        const float error = bc1EncodeEndpoints(block, refinedStart, refinedEnd, candidate);
+        if (error >= bestError) {
+            break;
+        }
+        bestError = error;
+        std::memcpy(out, candidate, 8);
+    }
+}
+
+void bc1DecodeBlock(const uint8_t* in, bool forceFourColors, uint8_t texels[16][4]) {
+    uint16_t color0, color1;
+    uint32_t indices;
+    std::memcpy(&color0, in, 2);
+    std::memcpy(&color1, in + 2, 2);
+    std::memcpy(&indices, in + 4, 4);
+
+    uint32_t palette[4][4];
+    bc1Palette(color0, color1, forceFourColors, palette);
+    for (uint32_t i = 0; i < 16; ++i) {
+        const uint32_t index = (indices >> (2 * i)) & 3;
+        for (uint32_t c = 0; c < 4; ++c) {
+            texels[i][c] = static_cast<uint8_t>(palette[index][c]);
+        }
+    }
+}
+
+//
+// BC4 (alpha of BC3, channels of BC5)
+//
+
+void bc4Palette(uint32_t value0, uint32_t value1, uint32_t palette[8]) {
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1) {
+        for (uint32_t i = 1; i < 7; ++i) {
+            palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+        }
+    } else {
+        for (uint32_t i = 1; i < 5; ++i) {
+            palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void bc4EncodeBlock(const Block& block, uint32_t channel, uint8_t* out) {
+    float minValue = 255.0f;
+    float maxValue = 0.0f;
+    for (const auto& texel : block) {
+        minValue = std::min(minValue, texel[channel]);
+        maxValue = std::max(maxValue, texel[channel]);
+    }
+
+    // 8 values mode, value0 > value1. With a uniform block value0 == value1 and all indices are 0.
+    const uint32_t value0 = toByte(maxValue);
+    const uint32_t value1 = toByte(minValue);
+    uint32_t       palette[8];
+    bc4Palette(value0, value1, palette);
+
+    uint64_t indices = 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+        float    bestError = std::numeric_limits<float>::max();
+        uint64_t bestIndex = 0;
+        for (uint32_t p = 0; p < 8; ++p) {
+            const float e = std::abs(block[i][channel] - float(palette[p]));
+            if (e < bestError) {
+                bestError = e;
+                bestIndex = p;
+            }
+        }
+        indices |= bestIndex << (3 * i);
+    }
+
+    out[0] = static_cast<uint8_t>(value0);
+    out[1] = static_cast<uint8_t>(value1);
+    for (uint32_t i = 0; i < 6; ++i) {
+        out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+    }
+}
+
+void bc4DecodeBlock(const uint8_t* in, uint32_t channel, uint8_t texels[16][4]) {
+    uint32_t palette[8];
+    bc4Palette(in[0], in[1], palette);
+
+    uint64_t indices = 0;
+    for (uint32_t i = 0; i < 6; ++i) {
+        indices |= uint64_t(in[2 + i]) << (8 * i);
+    }
+    for (uint32_t i = 0; i < 16; ++i) {
+        texels[i][channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+    }
+}
+
+//
+// BC7, mode 6 only: one subset, RGBA 7 bits endpoints with a P bit each, 4 bits indices.
+//
+
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* data) : mData(data) { std::memset(mData, 0, 16); }
+
+    void write(uint32_t value, uint32_t bitCount) {
+        for (uint32_t i = 0; i < bitCount; ++i, ++mPosition) {
+            mData[mPosition / 8] |= ((value >> i) & 1) << (mPosition % 8);
+        }
+    }
+
+private:
+    uint8_t* mData;
+    uint32_t mPosition{0};
+};
+
+class BitReader {
+public:
+    explicit BitReader(const uint8_t* data) : mData(data) {}
+
+    uint32_t read(uint32_t bitCount) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bitCount; ++i, ++mPosition) {
+            value |= ((mData[mPosition / 8] >> (mPosition % 8)) & 1) << i;
+        }
+        return value;
+    }
+
+private:
+    const uint8_t* mData;
+    uint32_t       mPosition{0};
+};
+
+struct BC7Mode6 {
+    uint32_t endpoints[2][4]; // 7 bits
+    uint32_t pbits[2];
+    uint32_t indices[16];     // 4 bits
+};
+
+void bc7Palette(const BC7Mode6& mode, uint32_t palette[16][4]) {
+    for (uint32_t c = 0; c < 4; ++c) {
+        const uint32_t e0 = (mode.endpoints[0][c] << 1) | mode.pbits[0];
+        const uint32_t e1 = (mode.endpoints[1][c] << 1) | mode.pbits[1];
+        for (uint32_t i = 0; i < 16; ++i) {
+            palette[i][c] = ((64 - kBC7Weights4[i]) * e0 + kBC7Weights4[i] * e1 + 32) >> 6;
+        }
+    }
+}
+
+/// @brief Quantize the endpoints with the given P bits and find the indices, return the squared error.
+float bc7QuantizeMode6(const Block& block, const float start[4], const float end[4], uint32_t pbit0, uint32_t pbit1, BC7Mode6& mode) {
+    mode.pbits[0] = pbit0;
+    mode.pbits[1] = pbit1;
+    for (uint32_t c = 0; c < 4; ++c) {
+        // (value << 1 | pbit) must be the closest to the endpoint.
+        mode.endpoints[0][c] = static_cast<uint32_t>(std::clamp((start[c] - pbit0) / 2.0f + 0.5f, 0.0f, 127.0f));
+        mode.endpoints[1][c] = static_cast<uint32_t>(std::clamp((end[c] - pbit1) / 2.0f + 0.5f, 0.0f, 127.0f));
+    }
+
+    uint32_t palette[16][4];
+    bc7Palette(mode, palette);
+
+    float error = 0.0f;
+    for (uint32_t i = 0; i < 16; ++i) {
+        float bestError = std::numeric_limits<float>::max();
+        for (uint32_t p = 0; p < 16; ++p) {
+            float e = 0.0f;
+            for (uint32_t c = 0; c < 4; ++c) {
+                const float d = block[i][c] - float(palette[p][c]);
+                e += d * d;
+            }
+            if (e < bestError) {
+                bestError       = e;
+                mode.indices[i] = p;
+            }
+        }
+        error += bestError;
+    }
+    return error;
+}
+
+float bc7EncodeEndpoints(const Block& block, const float start[4], const float end[4], BC7Mode6& best) {
+    float bestError = std::numeric_limits<float>::max();
+    for (uint32_t pbits = 0; pbits < 4; ++pbits) {
+        BC7Mode6    mode;
+        const float error = bc7QuantizeMode6(block, start, end, pbits & 1, pbits >> 1, mode);
+        if (error < bestError) {
+            bestError = error;
+            best      = mode;
+        }
+    }
+    return bestError;
+}
+
+void bc7EncodeBlock(const Block& block, uint8_t* out) {
+    float start[4], end[4];
+    fitLine(block, 4, start, end);
+
+    BC7Mode6 mode;
+    float    bestError = bc7EncodeEndpoints(block, start, end, mode);
+    for (uint32_t iteration = 0; iteration < 2; ++iteration) {
+        float weights[16];
+        for (uint32_t i = 0; i < 16; ++i) {
+            weights[i] = kBC7Weights4[mode.indices[i]] / 64.0f;
+        }
+        if (!leastSquaresEndpoints(block, 4, weights, start, end)) {
+            break;
+        }
+        BC7Mode6    candidate;
+        const float error = bc7EncodeEndpoints(block, start, end, candidate);
+        if (error >= bestError) {
+            break;
+        }
+        bestError = error;
+        mode      = candidate;
+    }
+
+    // The most significant bit of the first index is implicit 0, swap the endpoints if needed.
+    if (mode.indices[0] >= 8) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            std::swap(mode.endpoints[0][c], mode.endpoints[1][c]);
+        }
+        std::swap(mode.pbits[0], mode.pbits[1]);
+        for (uint32_t& index : mode.indices) {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer(out);
+    writer.write(1 << 6, 7); // mode 6
+    for (uint32_t c = 0; c < 4; ++c) {
+        writer.write(mode.endpoints[0][c], 7);
+        writer.write(mode.endpoints[1][c], 7);
+    }
+    writer.write(mode.pbits[0], 1);
+    writer.write(mode.pbits[1], 1);
+    writer.write(mode.indices[0], 3);
+    for (uint32_t i = 1; i < 16; ++i) {
+        writer.write(mode.indices[i], 4);
+    }
+}
+
+void bc7DecodeBlock(const uint8_t* in, uint8_t texels[16][4]) {
+    BitReader reader(in);
+    if (reader.read(7) != (1 << 6)) {
+        std::memset(texels, 0, 16 * 4);
+        return;
+    }
+
+    BC7Mode6 mode;
+    for (uint32_t c = 0; c < 4; ++c) {
+        mode.endpoints[0][c] = reader.read(7);
+        mode.endpoints[1][c] = reader.read(7);
+    }
+    mode.pbits[0]   = reader.read(1);
+    mode.pbits[1]   = reader.read(1);
+    mode.indices[0] = reader.read(3);
+    for (uint32_t i = 1; i < 16; ++i) {
+        mode.indices[i] = reader.read(4);
+    }
+
+    uint32_t palette[16][4];
+    bc7Palette(mode, palette);
+    for (uint32_t i = 0; i < 16; ++i) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            texels[i][c] = static_cast<uint8_t>(palette[mode.indices[i]][c]);
+        }
+    }
+}
+
+//
+// Mipmaps
+//
+
+float srgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSRGB(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+Image downsample(const Image& src, MipFilter filter) {
+    static const std::array<float, 256> sSRGBToLinear = [] {
+        std::array<float, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            table[i] = srgbToLinear(i / 255.0f);
+        }
+        return table;
+    }();
+
+    Image dst;
+    dst.width  = std::max(1u, src.width / 2);
+    dst.height = std::max(1u, src.height / 2);
+    dst.texels.resize(size_t(dst.width) * dst.height * 4);
+
+    for (uint32_t y = 0; y < dst.height; ++y) {
+        for (uint32_t x = 0; x < dst.width; ++x) {
+            float sum[4] = {};
+            for (uint32_t i = 0; i < 4; ++i) {
+                const uint32_t srcX  = std::min(x * 2 + (i & 1), src.width - 1);
+                const uint32_t srcY  = std::min(y * 2 + (i >> 1), src.height - 1);
+                const uint8_t* texel = &src.texels[(size_t(srcY) * src.width + srcX) * 4];
+                for (uint32_t c = 0; c < 4; ++c) {
+                    float value = texel[c] / 255.0f;
+                    if (filter == MipFilter::SRGB && c < 3) {
+                        value = sSRGBToLinear[texel[c]];
+                    } else if (filter == MipFilter::NormalMap && c < 3) {
+                        value = value * 2.0f - 1.0f;
+                    }
+                    sum[c] += value * 0.25f;
+                }
+            }
+
+            if (filter == MipFilter::SRGB) {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    sum[c] = linearToSRGB(sum[c]);
+                }
+            } else if (filter == MipFilter::NormalMap) {
+                const float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                if (length > 1e-6f) {
+                    for (uint32_t c = 0; c < 3; ++c) {
+                        sum[c] /= length;
+                    }
+                } else {
+                    sum[0] = sum[1] = 0.0f;
+                    sum[2]          = 1.0f;
+                }
+                for (uint32_t c = 0; c < 3; ++c) {
+                    sum[c] = sum[c] * 0.5f + 0.5f;
+                }
+            }
+
+            uint8_t* texel = &dst.texels[(size_t(y) * dst.width + x) * 4];
+            for (uint32_t c = 0; c < 4; ++c) {
+                texel[c] = toByte(sum[c] * 255.0f);
+            }
+        }
+    }
+    return dst;
+}
+
+} // namespace
+
+uint32_t TextureCompression::getBlockSize(BlockFormat format) { return format == BlockFormat::BC1 ? 8 : 16; }
+
+uint64_t TextureCompression::getCompressedSize(BlockFormat format, uint32_t width, uint32_t height) {
+    const uint64_t blockCountX = (width + 3) / 4;
+    const uint64_t blockCountY = (height + 3) / 4;
+    return blockCountX * blockCountY * getBlockSize(format);
+}
+
+uint32_t TextureCompression::getVkFormat(BlockFormat format, bool sRGB) {
+    switch (format) {
+        case BlockFormat::BC1: return sRGB ? kVkFormatBC1RgbSrgb : kVkFormatBC1RgbUnorm;
+        case BlockFormat::BC3: return sRGB ? kVkFormatBC3Srgb : kVkFormatBC3Unorm;
+        case BlockFormat::BC5: return kVkFormatBC5Unorm;
+        case BlockFormat::BC7: return sRGB ? kVkFormatBC7Srgb : kVkFormatBC7Unorm;
+    }
+    return 0;
+}
+
+bool TextureCompression::getBlockFormat(uint32_t vkFormat, BlockFormat& format, bool& sRGB) {
+    switch (vkFormat) {
+        case kVkFormatBC1RgbUnorm:
+        case kVkFormatBC1RgbaUnorm: format = BlockFormat::BC1; sRGB = false; return true;
+        case kVkFormatBC1RgbSrgb:
+        case kVkFormatBC1RgbaSrgb: format = BlockFormat::BC1; sRGB = true; return true;
+        case kVkFormatBC3Unorm: format = BlockFormat::BC3; sRGB = false; return true;
+        case kVkFormatBC3Srgb: format = BlockFormat::BC3; sRGB = true; return true;
+        case kVkFormatBC5Unorm: format = BlockFormat::BC5; sRGB = false; return true;
+        case kVkFormatBC7Unorm: format = BlockFormat::BC7; sRGB = false; return true;
+        case kVkFormatBC7Srgb: format = BlockFormat::BC7; sRGB = true; return true;
+        default: return false;
+    }
+}
+
+std::vector<uint8_t> TextureCompression::compress(BlockFormat format, const Image& image) {
+    assert(image.texels.size() == size_t(image.width) * image.height * 4);
+
+    const uint32_t       blockCountX = (image.width + 3) / 4;
+    const uint32_t       blockCountY = (image.height + 3) / 4;
+    const uint32_t       blockSize   = getBlockSize(format);
+    std::vector<uint8_t> blocks(getCompressedSize(format, image.width, image.height));
+
+    for (uint32_t blockY = 0; blockY < blockCountY; ++blockY) {
+        for (uint32_t blockX = 0; blockX < blockCountX; ++blockX) {
+            const Block block = loadBlock(image, blockX, blockY);
+            uint8_t*    out   = &blocks[(size_t(blockY) * blockCountX + blockX) * blockSize];
+            switch (format) {
+                case BlockFormat::BC1: bc1EncodeBlock(block, out); break;
+                case BlockFormat::BC3:
+                    bc4EncodeBlock(block, 3, out);
+                    bc1EncodeBlock(block, out + 8);
+                    break;
+                case BlockFormat::BC5:
+                    bc4EncodeBlock(block, 0, out);
+                    bc4EncodeBlock(block, 1, out + 8);
+                    break;
+                case BlockFormat::BC7: bc7EncodeBlock(block, out); break;
+            }
+        }
+    }
+    return blocks;
+}
+
+Image TextureCompression::decompress(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height) {
+    Image image;
+    image.width  = width;
+    image.height = height;
+    image.texels.resize(size_t(width) * height * 4);
+
+    const uint32_t blockCountX = (width + 3) / 4;
+    const uint32_t blockCountY = (height + 3) / 4;
+    const uint32_t blockSize   = getBlockSize(format);
+    for (uint32_t blockY = 0; blockY < blockCountY; ++blockY) {
+        for (uint32_t blockX = 0; blockX < blockCountX; ++blockX) {
+            const uint8_t* in = &blocks[(size_t(blockY) * blockCountX + blockX) * blockSize];
+            uint8_t        texels[16][4];
+            switch (format) {
+                case BlockFormat::BC1: bc1DecodeBlock(in, false, texels); break;
+                case BlockFormat::BC3:
+                    bc1DecodeBlock(in + 8, true, texels);
+                    bc4DecodeBlock(in, 3, texels);
+                    break;
+                case BlockFormat::BC5:
+                    for (auto& texel : texels) {
+                        texel[2] = 0;
+                        texel[3] = 255;
+                    }
+                    bc4DecodeBlock(in, 0, texels);
+                    bc4DecodeBlock(in + 8, 1, texels);
+                    break;
+                case BlockFormat::BC7: bc7DecodeBlock(in, texels); break;
+            }
+            storeBlock(image, blockX, blockY, texels);
+        }
+    }
+    return image;
+}
+
+std::vector<Image> TextureCompression::generateMipChain(const Image& image, MipFilter filter) {
+    std::vector<Image> levels;
+    levels.push_back(image);
+    while (levels.back().width > 1 || levels.back().height > 1) {
+        levels.push_back(downsample(levels.back(), filter));
+    }
+    return levels;
+}
+
+double TextureCompression::computePSNR(const Image& reference, const Image& image, uint32_t channelCount) {
+    assert(reference.width == image.width && reference.height == image.height);
+
+    double         squaredError = 0.0;
+    const uint64_t texelCount   = uint64_t(reference.width) * reference.height;
+    for (uint64_t i = 0; i < texelCount; ++i) {
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            const double d = double(reference.texels[i * 4 + c]) - double(image.texels[i * 4 + c]);
+            squaredError += d * d;
+        }
+    }
+    const double meanSquaredError = squaredError / double(texelCount * channelCount);
+    if (meanSquaredError == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/// @brief CPU side block compression (BC1, BC3, BC5, BC7) and mipmap generation of RGBA8 images.
+///
+/// Used offline by the texture cooker, the decoders exist to measure the quality of the encoders.
+namespace TextureCompression {
+
+/// @brief The block compressed formats, all use 4x4 texel blocks.
+enum class BlockFormat {
+    BC1, ///< RGB, 8 bytes per block.
+    BC3, ///< RGBA, 16 bytes per block (BC1 color and BC4 alpha).
+    BC5, ///< RG, 16 bytes per block (two BC4), used for the normal maps.
+    BC7, ///< RGBA, 16 bytes per block, high quality color.
+};
+
+/// @brief How the texels are averaged when generating the mipmaps.
+enum class MipFilter {
+    Linear,    ///< Average the values as stored.
+    SRGB,      ///< Average the colors in linear space, the alpha as stored.
+    NormalMap, ///< Average the normals stored in [0, 1] and renormalize them.
+};
+
+/// @brief A RGBA8 image (4 bytes per texel, rows tightly packed).
+struct Image {
+    uint32_t             width{0};
+    uint32_t             height{0};
+    std::vector<uint8_t> texels;
+};
+
+/// @brief Return the size in bytes of a 4x4 block.
+[[nodiscard]] uint32_t getBlockSize(BlockFormat format);
+
+/// @brief Return the size in bytes of a compressed image.
+[[nodiscard]] uint64_t getCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+/// @brief Return the VkFormat value of a block format.
+/// @param sRGB Select the sRGB variant, ignored by BC5 which has none.
+[[nodiscard]] uint32_t getVkFormat(BlockFormat format, bool sRGB);
+
+/// @brief Find the block format of a VkFormat value.
+/// @return false if the format is not one of the supported block formats.
+[[nodiscard]] bool getBlockFormat(uint32_t vkFormat, BlockFormat& format, bool& sRGB);
+
+/// @brief Compress a RGBA8 image, the partial blocks on the borders repeat the last texels.
+[[nodiscard]] std::vector<uint8_t> compress(BlockFormat format, const Image& image);
+
+/// @brief Decompress an image to RGBA8.
+///        BC5 writes the red and green channels, blue is 0 and alpha 255.
+///        BC7 only decodes the mode 6 blocks written by compress(), the other modes decode to 0.
+[[nodiscard]] Image decompress(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height);
+
+/// @brief Generate the full mip chain of an image, from the image (level 0) down to 1x1.
+[[nodiscard]] std::vector<Image> generateMipChain(const Image& image, MipFilter filter);
+
+/// @brief Return the peak signal to noise ratio in dB between two images of the same size.
+/// @param channelCount Compare the first channelCount channels (1 to 4).
+[[nodiscard]] double computePSNR(const Image& reference, const Image& image, uint32_t channelCount = 4);
+
+} // namespace TextureCompression
@@ -0,0 +1,173 @@
+// Cook the images of the data directory into block compressed KTX2 files with a full mip chain.
+//
+// The block format is chosen from the file name:
+//   - normal maps (*_nm, *_n, *-nor*, *normal*) : BC5, the mipmaps are renormalized.
+//   - everything else                           : BC7 (or BC1/BC3 with --codec bc1).
+// The mipmaps of the color textures are averaged in linear space, the ones of the data textures
+// (specular, blend, ...) as stored. The game selects the sRGB or UNORM variant when loading.
+//
+// usage: TextureCooker <dataDirectory> <cookedDirectory> [--codec bc7|bc1] [--force]
+#include "ImageDecoder.h"
+#include "Ktx2File.h"
+#include "TextureCompression.h"
+
+#include <Engine/Log.h>
+#include <Engine/ThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+using TextureCompression::BlockFormat;
+using TextureCompression::MipFilter;
+
+struct CookJob {
+    std::filesystem::path source;
+    std::filesystem::path destination;
+};
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+bool isImage(const std::filesystem::path& path) {
+    const std::string extension = toLower(path.extension().string());
+    return extension == ".png" || extension == ".tga" || extension == ".jpg" || extension == ".jpeg";
+}
+
+bool isNormalMap(const std::string& name) {
+    return name.ends_with("_nm") || name.ends_with("_n") || name.find("-nor") != std::string::npos ||
+           name.find("normal") != std::string::npos;
+}
+
+bool isColorMap(const std::string& name) {
+    return !(name.ends_with("_sm") || name.ends_with("_s") || name.find("spec") != std::string::npos ||
+             name.find("spacular") != std::string::npos || name.find("blend") != std::string::npos ||
+             name.find("ambientocclusion") != std::string::npos);
+}
+
+bool isOpaque(const TextureCompression::Image& image) {
+    for (size_t i = 3; i < image.texels.size(); i += 4) {
+        if (image.texels[i] != 255) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool cook(const CookJob& job, bool useBC7) {
+    const DecodedImage decoded = ImageDecoder::decode(job.source);
+    if (!decoded.isValid()) {
+        return false;
+    }
+
+    TextureCompression::Image image;
+    image.width  = decoded.width;
+    image.height = decoded.height;
+    image.texels.assign(decoded.pixels.get(), decoded.pixels.get() + decoded.getSizeInByte());
+
+    const std::string name   = toLower(job.source.stem().string());
+    BlockFormat       format = BlockFormat::BC7;
+    MipFilter         filter = MipFilter::Linear;
+    bool              sRGB   = false;
+    if (isNormalMap(name)) {
+        format = BlockFormat::BC5;
+        filter = MipFilter::NormalMap;
+    } else {
+        sRGB   = isColorMap(name);
+        filter = sRGB ? MipFilter::SRGB : MipFilter::Linear;
+        if (!useBC7) {
+            format = isOpaque(image) ? BlockFormat::BC1 : BlockFormat::BC3;
+        }
+    }
+
+    const std::vector<TextureCompression::Image> mipChain = TextureCompression::generateMipChain(image, filter);
+    std::vector<std::vector<uint8_t>>            levels;
+    levels.reserve(mipChain.size());
+    for (const TextureCompression::Image& level : mipChain) {
+        levels.push_back(TextureCompression::compress(format, level));
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(job.destination.parent_path(), error);
+    return Ktx2::write(job.destination, TextureCompression::getVkFormat(format, sRGB), image.width, image.height,
+                       levels);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Engine::Log::Initialize();
+
+    if (argc < 3) {
+        std::printf("usage: TextureCooker <dataDirectory> <cookedDirectory> [--codec bc7|bc1] [--force]\n");
+        Engine::Log::Shutdown();
+        return 1;
+    }
+    const std::filesystem::path dataDirectory   = argv[1];
+    const std::filesystem::path cookedDirectory = argv[2];
+    bool                        useBC7          = true;
+    bool                        force           = false;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--codec") == 0 && i + 1 < argc) {
+            useBC7 = std::strcmp(argv[++i], "bc1") != 0;
+        } else if (std::strcmp(argv[i], "--force") == 0) {
+            force = true;
+        }
+    }
+    if (!std::filesystem::is_directory(dataDirectory)) {
+        std::printf("%s is not a directory\n", dataDirectory.string().c_str());
+        Engine::Log::Shutdown();
+        return 1;
+    }
+
+    // Only the textures without an up to date cooked file are cooked.
+    std::vector<CookJob> jobs;
+    uint32_t             upToDateCount = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dataDirectory)) {
+        if (!entry.is_regular_file() || !isImage(entry.path())) {
+            continue;
+        }
+        CookJob job;
+        job.source      = entry.path();
+        job.destination = cookedDirectory / std::filesystem::relative(entry.path(), dataDirectory);
+        job.destination.replace_extension(".ktx2");
+
+        std::error_code error;
+        if (!force && std::filesystem::exists(job.destination, error) &&
+            std::filesystem::last_write_time(job.destination, error) >= entry.last_write_time()) {
+            ++upToDateCount;
+            continue;
+        }
+        jobs.push_back(std::move(job));
+    }
+    std::printf("%zu textures to cook, %u up to date\n", jobs.size(), upToDateCount);
+
+    Engine::ThreadPool    threadPool;
+    std::atomic<uint32_t> failedCount = 0;
+    const auto            start       = std::chrono::steady_clock::now();
+    threadPool.parallelFor(static_cast<uint32_t>(jobs.size()), [&](uint32_t index, uint32_t) {
+        if (cook(jobs[index], useBC7)) {
+            std::printf("cooked %s\n", jobs[index].destination.string().c_str());
+        } else {
+            ++failedCount;
+        }
+    });
+    const double elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%zu textures cooked in %.2f ms, %u failed\n", jobs.size() - failedCount, elapsedMs,
+                failedCount.load());
+
+    Engine::Log::Shutdown();
+    return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+#include "TransformSystem.h"
+
+#include <Engine/Log.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/euler_angles.hpp>
+
+#include <algorithm>
+
+namespace {
+    /// @brief Tag of the entities whose CTransform changed since the last update.
+    struct CTransformDirty {};
+} // namespace
+
+glm::mat4 computeModelMatrix(const CTransform& transform) {
+    const auto translateMat = glm::translate(glm::mat4(1), transform.position);
+    const auto rotationMat  = glm::eulerAngleYXZ(glm::radians(transform.rotation.y),
+                                                 glm::radians(transform.rotation.x),
+                                                 glm::radians(transform.rotation.z));
+    const auto scaleMat     = glm::scale(glm::mat4(1), transform.scale);
+    return translateMat * rotationMat * scaleMat;
+}
+
+TransformSystem::TransformSystem(entt::registry& registry)
+    : mRegistry(registry) {
+    mRegistry.on_construct<CTransform>().connect<&TransformSystem::onTransformChanged>(*this);
+    mRegistry.on_update<CTransform>().connect<&TransformSystem::onTransformChanged>(*this);
+    mRegistry.on_destroy<CTransform>().connect<&TransformSystem::onTransformDestroyed>(*this);
+    mRegistry.on_construct<CHierarchy>().connect<&TransformSystem::onHierarchyChanged>(*this);
+    mRegistry.on_update<CHierarchy>().connect<&TransformSystem::onHierarchyChanged>(*this);
+    mRegistry.on_destroy<CHierarchy>().connect<&TransformSystem::onHierarchyChanged>(*this);
+}
+
+TransformSystem::~TransformSystem() {
+    mRegistry.on_construct<CTransform>().disconnect(this);
+    mRegistry.on_update<CTransform>().disconnect(this);
+    mRegistry.on_destroy<CTransform>().disconnect(this);
+    mRegistry.on_construct<CHierarchy>().disconnect(this);
+    mRegistry.on_update<CHierarchy>().disconnect(this);
+    mRegistry.on_destroy<CHierarchy>().disconnect(this);
+}
+
+void TransformSystem::update() {
+    mUpdatedCount = 0;
+
+    if (mOrderDirty) {
+        // All the nodes are dirty after a rebuild.
+        rebuildOrder();
+    } else {
+        for (auto [entity, transform] : mRegistry.view<CTransformDirty, CTransform>().each()) {
+            const uint32_t index = mEntityToIndex[static_cast<size_t>(entt::to_entity(entity))];
+            mLocals[index]       = computeModelMatrix(transform);
+            mDirty[index]        = 1;
+        }
+    }
+    mRegistry.clear<CTransformDirty>();
+
+    // Parents are stored before their children: a single walk propagates the
+    // dirty flag down the sub trees and recomputes the world matrices.
+    const size_t count = mEntities.size();
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t parent = mParents[i];
+        if (parent != kInvalidIndex) {
+            mDirty[i] |= mDirty[parent];
+        }
+        if (!mDirty[i]) {
+            continue;
+        }
+
+        mWorlds[i] = parent != kInvalidIndex ? mWorlds[parent] * mLocals[i] : mLocals[i];
+
+        mRegistry.patch<CWorldTransform>(mEntities[i], [&](CWorldTransform& world) {
+            world.model        = mWorlds[i];
+            world.normalMatrix = glm::transpose(glm::inverse(world.model));
+        });
+        mUpdatedCount++;
+    }
+
+    // Flags are cleared after the walk, a child reads the flag of its parent.
+    std::fill(mDirty.begin(), mDirty.end(), uint8_t{0});
+}
+
+void TransformSystem::rebuildOrder() {
+    mOrderDirty = false;
+
+    // Gather the nodes, the temporary index is the position in the view.
+    auto view = mRegistry.view<CTransform>();
+    std::vector<entt::entity> entities(view.begin(), view.end());
+    const auto count = static_cast<uint32_t>(entities.size());
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto entityIndex = static_cast<size_t>(entt::to_entity(entities[i]));
+        if (entityIndex >= mEntityToIndex.size()) {
+            mEntityToIndex.resize(entityIndex + 1, kInvalidIndex);
+        }
+        mEntityToIndex[entityIndex] = i;
+    }
+
+    // Parent of each node, a parent without transform makes the node a root.
+    std::vector<uint32_t> parents(count, kInvalidIndex);
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto* hierarchy = mRegistry.try_get<CHierarchy>(entities[i]);
+        if (hierarchy && mRegistry.valid(hierarchy->parent) && mRegistry.all_of<CTransform>(hierarchy->parent)) {
+            parents[i] = mEntityToIndex[static_cast<size_t>(entt::to_entity(hierarchy->parent))];
+        }
+    }
+
+    // Depth of each node, each chain is walked once.
+    std::vector<uint32_t> depths(count, kInvalidIndex);
+    std::vector<uint32_t> chain;
+    uint32_t              maxDepth = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t node = i;
+        while (node != kInvalidIndex && depths[node] == kInvalidIndex && chain.size() <= count) {
+            chain.push_back(node);
+            node = parents[node];
+        }
+
+        if (chain.size() > count) {
+            ENGINE_CORE_ERROR("TransformSystem: cycle in the hierarchy of entity {}.", static_cast<uint32_t>(entities[i]));
+            parents[i] = kInvalidIndex;
+            chain.clear();
+            chain.push_back(i);
+            node = kInvalidIndex;
+        }
+
+        uint32_t depth = node == kInvalidIndex ? 0 : depths[node] + 1;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            depths[*it] = depth++;
+        }
+        maxDepth = std::max(maxDepth, depth);
+        chain.clear();
+    }
+
+    // Counting sort by depth.
+    std::vector<uint32_t> offsets(maxDepth + 1, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        offsets[depths[i] + 1]++;
+    }
+    for (uint32_t d = 1; d <= maxDepth; ++d) {
+        offsets[d] += offsets[d - 1];
+    }
+
+    std::vector<uint32_t> sortedIndex(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        sortedIndex[i] = offsets[depths[i]]++;
+    }
+
+    mEntities.resize(count);
+    mParents.resize(count);
+    mLocals.resize(count);
+    mWorlds.resize(count);
+    mDirty.assign(count, 1);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t index = sortedIndex[i];
+        mEntities[index]     = entities[i];
+        mParents[index]      = parents[i] != kInvalidIndex ? sortedIndex[parents[i]] : kInvalidIndex;
+        mLocals[index]       = computeModelMatrix(mRegistry.get<CTransform>(entities[i]));
+        mEntityToIndex[static_cast<size_t>(entt::to_entity(entities[i]))] = index;
+        mRegistry.get_or_emplace<CWorldTransform>(entities[i]);
+    }
+}
+
+void TransformSystem::onTransformChanged(entt::registry& registry, entt::entity entity) {
+    // The world transform is computed lazily by update(), the CTransform is
+    // usually filled right after being emplaced.
+    if (!registry.all_of<CTransformDirty>(entity)) {
+        registry.emplace<CTransformDirty>(entity);
+    }
+
+    if (!registry.all_of<CWorldTransform>(entity)) {
+        mOrderDirty = true;
+    }
+}
+
+void TransformSystem::onTransformDestroyed(entt::registry& registry, entt::entity entity) {
+    registry.remove<CTransformDirty, CWorldTransform>(entity);
+    mOrderDirty = true;
+}
+
+void TransformSystem::onHierarchyChanged(entt::registry&, entt::entity) {
+    mOrderDirty = true;
+}
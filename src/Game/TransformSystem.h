@@ -0,0 +1,76 @@
+#pragma once
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct CTransform {
+    glm::vec3 position = {0.f, 0.f, 0.f};
+    glm::vec3 rotation = {0.f, 0.f, 0.f};
+    glm::vec3 scale    = {1.f, 1.f, 1.f};
+};
+
+/// @brief Attach an entity to a parent, the CTransform become relative to the parent.
+struct CHierarchy {
+    entt::entity parent = entt::null;
+};
+
+/// @brief World matrices of a CTransform, maintained by the TransformSystem.
+struct CWorldTransform {
+    glm::mat4 model        = glm::mat4(1.0f);
+    glm::mat4 normalMatrix = glm::mat4(1.0f); ///< transpose(inverse(model))
+};
+
+/// @brief Compute the model matrix of a transform (translate * rotateYXZ * scale).
+glm::mat4 computeModelMatrix(const CTransform& transform);
+
+/// @brief Keep the CWorldTransform of the entities in sync with their CTransform
+///        and their parent (CHierarchy).
+///
+/// Changes are tracked with the entt construct/update signals of CTransform,
+/// a transform modified in place must be notified with registry.patch<CTransform>().
+/// The CWorldTransform are written with registry.patch<CWorldTransform>() in turn, the
+/// systems which depend on the world transforms listen to its update signal.
+///
+/// The nodes are stored in SoA arrays sorted by depth, so a parent always comes
+/// before its children and the world matrices are propagated with a single linear
+/// walk. Only the dirty nodes and their sub trees are recomputed. The arrays are
+/// rebuilt when an entity is added, removed or re-parented.
+class TransformSystem {
+public:
+    explicit TransformSystem(entt::registry& registry);
+    ~TransformSystem();
+
+    TransformSystem(const TransformSystem&)            = delete;
+    TransformSystem& operator=(const TransformSystem&) = delete;
+
+    TransformSystem(TransformSystem&&)            = delete;
+    TransformSystem& operator=(TransformSystem&&) = delete;
+
+    /// @brief Recompute the world transform of the dirty entities and their children.
+    void update();
+
+    /// @brief Return the number of world transforms recomputed by the last update.
+    [[nodiscard]] uint32_t getUpdatedCount() const { return mUpdatedCount; }
+
+private:
+    void rebuildOrder();
+    void onTransformChanged(entt::registry& registry, entt::entity entity);
+    void onTransformDestroyed(entt::registry& registry, entt::entity entity);
+    void onHierarchyChanged(entt::registry& registry, entt::entity entity);
+
+    static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+    entt::registry& mRegistry;
+    uint32_t        mUpdatedCount{0};
+    bool            mOrderDirty{true};
+
+    // Nodes sorted by depth.
+    std::vector<entt::entity> mEntities;
+    std::vector<uint32_t>     mParents; ///< Index of the parent node or kInvalidIndex.
+    std::vector<glm::mat4>    mLocals;
+    std::vector<glm::mat4>    mWorlds;
+    std::vector<uint8_t>      mDirty;
+    std::vector<uint32_t>     mEntityToIndex; ///< Indexed by the entity identifier.
+};
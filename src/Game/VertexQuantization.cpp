@@ -0,0 +1,198 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+namespace {
+    float signNotZero(float value) { return value >= 0.0f ? 1.0f : -1.0f; }
+
+    /// @brief Octahedral encoding of a direction on 2 x snorm16.
+    ///        The 4 grid points around the exact encoding are tried and the closest direction is
+    ///        kept, plain rounding is up to twice less precise.
+    void encodeDirection(const float direction[3], int16_t encoded[2]) {
+        const glm::vec3 source(direction[0], direction[1], direction[2]);
+        const glm::vec2 octahedral = VertexQuantization::encodeOctahedral(source);
+        if (glm::dot(source, source) == 0.0f) {
+            encoded[0] = encoded[1] = 0;
+            return;
+        }
+
+        const glm::vec3 normalized = glm::normalize(source);
+        const float     x          = std::floor(std::clamp(octahedral.x, -1.0f, 1.0f) * 32767.0f);
+        const float     y          = std::floor(std::clamp(octahedral.y, -1.0f, 1.0f) * 32767.0f);
+        float           bestDot    = -2.0f;
+        for (int i = 0; i < 4; ++i) {
+            const float candidateX = std::min(x + float(i & 1), 32767.0f);
+            const float candidateY = std::min(y + float(i >> 1), 32767.0f);
+            const float dot        = glm::dot(
+                normalized, VertexQuantization::decodeOctahedral({candidateX / 32767.0f, candidateY / 32767.0f}));
+            if (dot > bestDot) {
+                bestDot    = dot;
+                encoded[0] = static_cast<int16_t>(candidateX);
+                encoded[1] = static_cast<int16_t>(candidateY);
+            }
+        }
+    }
+
+    void decodeDirection(const int16_t encoded[2], float direction[3]) {
+        const glm::vec3 decoded = VertexQuantization::decodeOctahedral(
+            {VertexQuantization::decodeSnorm16(encoded[0]), VertexQuantization::decodeSnorm16(encoded[1])});
+        direction[0] = decoded.x;
+        direction[1] = decoded.y;
+        direction[2] = decoded.z;
+    }
+} // namespace
+
+namespace VertexQuantization {
+
+uint16_t encodeUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+int16_t encodeSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+float decodeSnorm16(int16_t value) { return std::max(float(value) / 32767.0f, -1.0f); }
+
+uint16_t encodeHalf(float value) {
+    uint32_t       bits = std::bit_cast<uint32_t>(value);
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7fffffff;
+
+    // Infinity and NaN (kept quiet).
+    if (bits >= 0x7f800000) {
+        return sign | 0x7c00 | (bits > 0x7f800000 ? 0x0200 : 0);
+    }
+    // 65520 and above round to infinity.
+    if (bits >= 0x477ff000) {
+        return sign | 0x7c00;
+    }
+    // Below the smallest normal half (2^-14), the value is a multiple of 2^-24.
+    if (bits < 0x38800000) {
+        const float magnitude = std::bit_cast<float>(bits);
+        return sign | static_cast<uint16_t>(std::nearbyint(magnitude * 16777216.0f));
+    }
+    // Rebias the exponent (127 -> 15) and round the mantissa to nearest even.
+    const uint32_t rounded = bits + 0x0fff + ((bits >> 13) & 1);
+    return sign | static_cast<uint16_t>((rounded - 0x38000000) >> 13);
+}
+
+float decodeHalf(uint16_t value) {
+    const uint32_t sign     = static_cast<uint32_t>(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1f;
+    const uint32_t mantissa = value & 0x03ff;
+    if (exponent == 0) {
+        const float magnitude = float(mantissa) / 16777216.0f;
+        return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 31) {
+        return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3& direction) {
+    const float l1 = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (l1 == 0.0f) {
+        return glm::vec2(0.0f);
+    }
+
+    glm::vec2 encoded(direction.x / l1, direction.y / l1);
+    if (direction.z < 0.0f) {
+        encoded = {(1.0f - std::abs(encoded.y)) * signNotZero(encoded.x),
+                   (1.0f - std::abs(encoded.x)) * signNotZero(encoded.y)};
+    }
+    return encoded;
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2& encoded) {
+    // Same as DecodeOctahedral() in mesh.slang.
+    glm::vec3   direction(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    const float t = std::max(-direction.z, 0.0f);
+    direction.x += direction.x >= 0.0f ? -t : t;
+    direction.y += direction.y >= 0.0f ? -t : t;
+    return glm::normalize(direction);
+}
+
+SubMeshQuantization getQuantization(const glm::vec3& aabbMin, const glm::vec3& aabbMax) {
+    SubMeshQuantization quantization;
+    quantization.offset = glm::vec4(aabbMin, 0.0f);
+    quantization.scale  = glm::vec4(glm::max(aabbMax - aabbMin, glm::vec3(0.0f)) / 65535.0f, 0.0f);
+    return quantization;
+}
+
+PackedMeshVertex encodeVertex(const MeshVertex&          vertex,
+                              const SubMeshQuantization& quantization,
+                              uint16_t                   subMeshIndex) {
+    PackedMeshVertex packed{};
+    for (int axis = 0; axis < 3; ++axis) {
+        const float scale = quantization.scale[axis];
+        const float value = scale > 0.0f ? (vertex.position[axis] - quantization.offset[axis]) / scale : 0.0f;
+        packed.position[axis] = static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 65535.0f)));
+    }
+    packed.position[3] = subMeshIndex;
+
+    encodeDirection(vertex.normal, packed.normal);
+    encodeDirection(vertex.tangent, packed.tangent);
+    packed.uv[0] = encodeHalf(vertex.uv[0]);
+    packed.uv[1] = encodeHalf(vertex.uv[1]);
+    return packed;
+}
+
+MeshVertex decodeVertex(const PackedMeshVertex& vertex, const SubMeshQuantization& quantization) {
+    MeshVertex decoded{};
+    for (int axis = 0; axis < 3; ++axis) {
+        decoded.position[axis] = quantization.offset[axis] + float(vertex.position[axis]) * quantization.scale[axis];
+    }
+    decodeDirection(vertex.normal, decoded.normal);
+    decodeDirection(vertex.tangent, decoded.tangent);
+    decoded.uv[0] = decodeHalf(vertex.uv[0]);
+    decoded.uv[1] = decodeHalf(vertex.uv[1]);
+    return decoded;
+}
+
+PackedMeshData quantize(const MeshDataView& meshData) {
+    PackedMeshData packed;
+    packed.vertices.resize(meshData.vertices.size());
+
+    // The AABB is computed from the vertices, the one of the sub mesh may be larger.
+    const auto packRange = [&](uint32_t firstVertex, uint32_t vertexCount, uint16_t subMeshIndex) {
+        glm::vec3 aabbMin(vertexCount ? FLT_MAX : 0.0f);
+        glm::vec3 aabbMax(vertexCount ? -FLT_MAX : 0.0f);
+        for (uint32_t i = firstVertex; i < firstVertex + vertexCount; ++i) {
+            const glm::vec3 position(meshData.vertices[i].position[0], meshData.vertices[i].position[1],
+                                     meshData.vertices[i].position[2]);
+            aabbMin = glm::min(aabbMin, position);
+            aabbMax = glm::max(aabbMax, position);
+        }
+
+        const SubMeshQuantization quantization = getQuantization(aabbMin, aabbMax);
+        for (uint32_t i = firstVertex; i < firstVertex + vertexCount; ++i) {
+            packed.vertices[i] = encodeVertex(meshData.vertices[i], quantization, subMeshIndex);
+        }
+        packed.subMeshes.push_back(quantization);
+    };
+
+    if (meshData.subMeshes.empty()) {
+        packRange(0, static_cast<uint32_t>(meshData.vertices.size()), 0);
+        return packed;
+    }
+
+    assert(meshData.subMeshes.size() <= std::numeric_limits<uint16_t>::max() + 1u);
+    packed.subMeshes.reserve(meshData.subMeshes.size());
+    // The simplified LODs reuse the vertex range of their LOD 0 sub mesh, the range is encoded
+    // again with the same quantization.
+    for (size_t i = 0; i < meshData.subMeshes.size(); ++i) {
+        const MeshData::SubMesh& subMesh = meshData.subMeshes[i];
+        assert(subMesh.vertexOffset + subMesh.vertexCount <= meshData.vertices.size());
+        packRange(subMesh.vertexOffset, subMesh.vertexCount, static_cast<uint16_t>(i));
+    }
+    return packed;
+}
+
+} // namespace VertexQuantization
@@ -0,0 +1,96 @@
+#pragma once
+#include "MeshData.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Layout of the vertices of a mesh in its vertex buffer.
+enum class MeshVertexFormat : uint8_t {
+    Float,  ///< MeshVertex, 44 bytes of full floats.
+    Packed, ///< PackedMeshVertex, 20 bytes.
+};
+
+/// @brief Compressed vertex, must match PackedVSInput in mesh.slang.
+///
+/// - position: unorm16 relative to the AABB of the sub mesh, w holds the index of the sub mesh
+///   to fetch its SubMeshQuantization.
+/// - normal and tangent: octahedral encoding, snorm16.
+/// - uv: half floats.
+struct PackedMeshVertex {
+    uint16_t position[4];
+    int16_t  normal[2];
+    int16_t  tangent[2];
+    uint16_t uv[2];
+};
+static_assert(sizeof(PackedMeshVertex) == 20);
+
+/// @brief Dequantization of the positions of a sub mesh: position = offset + q * scale.
+///        Must match SubMeshQuantization in mesh.slang (std430 layout).
+struct SubMeshQuantization {
+    glm::vec4 offset{0.0f};
+    glm::vec4 scale{0.0f};
+};
+static_assert(sizeof(SubMeshQuantization) == 32);
+
+/// @brief The vertices of a mesh in the packed format, the indices and sub meshes are unchanged.
+struct PackedMeshData {
+    std::vector<PackedMeshVertex>    vertices;
+    std::vector<SubMeshQuantization> subMeshes; ///< One per sub mesh of the source.
+};
+
+/// @brief Conversion of the vertices between MeshVertex and PackedMeshVertex.
+///
+/// The encoding is lossy, the error of each attribute is bounded:
+/// - position: half a step of the grid, (aabbMax - aabbMin) / 65535 / 2 per axis.
+/// - normal and tangent: below 2e-4 radian (16 bits octahedral).
+/// - uv: the precision of a half float, 2^-11 relative.
+namespace VertexQuantization {
+
+/// @brief Return the size in bytes of a vertex in a format.
+[[nodiscard]] constexpr uint32_t getVertexSize(MeshVertexFormat format) {
+    return format == MeshVertexFormat::Packed ? sizeof(PackedMeshVertex) : sizeof(MeshVertex);
+}
+
+/// @brief Map a value in [0, 1] to [0, 65535], the value is clamped.
+[[nodiscard]] uint16_t encodeUnorm16(float value);
+
+/// @brief Map a value in [-1, 1] to [-32767, 32767], the value is clamped.
+[[nodiscard]] int16_t encodeSnorm16(float value);
+
+/// @brief Inverse of encodeSnorm16, -32768 decodes to -1 as on the GPU.
+[[nodiscard]] float decodeSnorm16(int16_t value);
+
+/// @brief Convert a float to a half float (round to nearest even).
+[[nodiscard]] uint16_t encodeHalf(float value);
+
+/// @brief Convert a half float to a float.
+[[nodiscard]] float decodeHalf(uint16_t value);
+
+/// @brief Project a direction on the octahedron and unfold it on the [-1, 1] square.
+///        A null vector gives (0, 0), it decodes to +Z.
+[[nodiscard]] glm::vec2 encodeOctahedral(const glm::vec3& direction);
+
+/// @brief Inverse of encodeOctahedral, the result is normalized.
+[[nodiscard]] glm::vec3 decodeOctahedral(const glm::vec2& encoded);
+
+/// @brief Return the dequantization of the positions inside an AABB.
+[[nodiscard]] SubMeshQuantization getQuantization(const glm::vec3& aabbMin, const glm::vec3& aabbMax);
+
+/// @brief Pack a vertex.
+/// @param vertex       The vertex to pack, its position must be inside the AABB of the quantization.
+/// @param quantization The quantization of the sub mesh of the vertex.
+/// @param subMeshIndex The index of the sub mesh, stored in position[3].
+[[nodiscard]] PackedMeshVertex encodeVertex(const MeshVertex&          vertex,
+                                            const SubMeshQuantization& quantization,
+                                            uint16_t                   subMeshIndex);
+
+/// @brief Unpack a vertex, as done by the vertex shader.
+[[nodiscard]] MeshVertex decodeVertex(const PackedMeshVertex& vertex, const SubMeshQuantization& quantization);
+
+/// @brief Pack the vertices of a mesh, each sub mesh is quantized in its own AABB.
+///        A mesh without sub mesh is quantized in the AABB of the mesh.
+[[nodiscard]] PackedMeshData quantize(const MeshDataView& meshData);
+
+} // namespace VertexQuantization
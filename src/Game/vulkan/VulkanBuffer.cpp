@@ -1,6 +1,7 @@
 #include "VulkanBuffer.h"
 
 #include "VulkanContext.h"
+#include "VulkanUploader.h"
 #include "VulkanUtils.h"
 
 VulkanBufferPtr VulkanBuffer::Create(const VulkanBufferCreateInfo& createInfo) {
@@ -16,6 +17,18 @@ VulkanBufferPtr VulkanBuffer::CreateStagingBuffer(uint64_t sizeInByte, const cha
     return VulkanBuffer::Create(createInfo);
 }
 
+VulkanBufferPtr VulkanBuffer::CreateDeviceLocal(const VulkanBufferCreateInfo& createInfo, const void* data) {
+    VulkanBufferCreateInfo deviceCreateInfo = createInfo;
+    deviceCreateInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    deviceCreateInfo.memoryProperty    = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    deviceCreateInfo.persistentMapping = false;
+    VulkanBufferPtr buffer = VulkanBuffer::Create(deviceCreateInfo);
+    if (data) {
+        buffer->mUploadValue = VulkanUploader::uploadBuffer(buffer, data, deviceCreateInfo.sizeInByte).value;
+    }
+    return buffer;
+}
+
 VulkanBuffer::VulkanBuffer(const VulkanBufferCreateInfo& createInfo)
     : mSiizeInByte(createInfo.sizeInByte) {
 
@@ -28,15 +41,26 @@ VulkanBuffer::VulkanBuffer(const VulkanBufferCreateInfo& createInfo)
 
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.flags                   = 0;
+    if (createInfo.persistentMapping) {
+        allocInfo.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    }
+    if (createInfo.hostRead) {
+        allocInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+    } else if (createInfo.persistentMapping) {
+        allocInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+    }
     allocInfo.usage                   = VMA_MEMORY_USAGE_UNKNOWN;
     allocInfo.requiredFlags           = createInfo.memoryProperty;
-    allocInfo.preferredFlags          = 0;
+    // Reading uncached memory goes through the bus for each access.
+    allocInfo.preferredFlags          = createInfo.hostRead ? VK_MEMORY_PROPERTY_HOST_CACHED_BIT : 0;
     allocInfo.memoryTypeBits          = 0;
     allocInfo.pool                    = nullptr;
     allocInfo.pUserData               = nullptr;
     allocInfo.priority                = 0;
+    VmaAllocationInfo allocationInfo{};
     VK_CHECK(vmaCreateBuffer(VulkanContext::getVmaAllocator(), &bufferCreateInfo, &allocInfo,
-                             &mBuffer, &mAllocation, nullptr /*allocationInfo*/));
+                             &mBuffer, &mAllocation, &allocationInfo));
+    mMappedData = allocationInfo.pMappedData;
 
     VulkanContext::setDebugObjectName((uint64_t)mBuffer, VK_OBJECT_TYPE_BUFFER,
                                       createInfo.name.c_str());
@@ -47,18 +71,32 @@ VulkanBuffer::~VulkanBuffer() {
 }
 
 void VulkanBuffer::writeData(const void* data, uint64_t size, uint64_t offset) {
+    if (mMappedData) {
+        memcpy((uint8_t*)mMappedData + offset, data, size);
+        return;
+    }
+
     void* mapped{};
     vmaMapMemory(VulkanContext::getVmaAllocator(), mAllocation, &mapped);
     if(mapped) {
-        memcpy(mapped, (uint8_t*)data + offset, size);
+        memcpy((uint8_t*)mapped + offset, data, size);
         vmaUnmapMemory(VulkanContext::getVmaAllocator(), mAllocation);
     }
 }
 
 void* VulkanBuffer::map() {
+    if (mMappedData) {
+        return mMappedData;
+    }
     void* data{};
     vmaMapMemory(VulkanContext::getVmaAllocator(), mAllocation, &data);
     return data;
 }
 
-void VulkanBuffer::unmap() { vmaUnmapMemory(VulkanContext::getVmaAllocator(), mAllocation); }
+void VulkanBuffer::unmap() {
+    if (!mMappedData) {
+        vmaUnmapMemory(VulkanContext::getVmaAllocator(), mAllocation);
+    }
+}
+
+bool VulkanBuffer::isReady() const { return VulkanUploader::isAcquired({mUploadValue}); }
@@ -13,6 +13,9 @@ struct VulkanBufferCreateInfo {
     uint64_t              sizeInByte;
     VkBufferUsageFlags    usage;
     VkMemoryPropertyFlags memoryProperty;
+    bool                  persistentMapping = false; ///< Keep host visible memory mapped for the buffer lifetime.
+    bool                  hostRead          = false; ///< The CPU reads the buffer (readback), prefer host cached memory
+                                                     ///< to write combined memory.
 };
 
 /// @brief
@@ -24,6 +27,15 @@ public:
     [[nodiscard]] static VulkanBufferPtr Create(const VulkanBufferCreateInfo& createInfo);
     [[nodiscard]] static VulkanBufferPtr CreateStagingBuffer(uint64_t sizeInByte, const char* name = nullptr);
 
+    /// @brief Create a buffer in device local memory and queue the upload of its initial content.
+    ///
+    /// The data is copied on the transfer queue through the VulkanUploader staging ring. The buffer
+    /// can be used once the graphic queue has acquired it, when isReady() returns true.
+    ///
+    /// @param createInfo The buffer description, memoryProperty is ignored and TRANSFER_DST is added to the usage.
+    /// @param data       The initial content of the buffer (createInfo.sizeInByte bytes), may be nullptr.
+    [[nodiscard]] static VulkanBufferPtr CreateDeviceLocal(const VulkanBufferCreateInfo& createInfo, const void* data);
+
     /// @brief
     /// @param createInfo
     VulkanBuffer(const VulkanBufferCreateInfo& createInfo);
@@ -43,15 +55,25 @@ public:
     /// @param offset The offset where to write the data inside the buffer.
     void writeData(const void* data, uint64_t size, uint64_t offset = 0);
 
-    /// @brief
+    /// @brief Map the buffer memory, return the persistent mapping if any.
     /// @return
     [[nodiscard]] void* map();
 
     /// @brief
     void unmap();
 
+    /// @brief Return the persistently mapped pointer, nullptr if the buffer was not created
+    ///        with VulkanBufferCreateInfo::persistentMapping.
+    [[nodiscard]] void* getMappedData() const { return mMappedData; }
+
+    /// @brief Return true once the initial content of CreateDeviceLocal() was acquired by the
+    ///        graphic queue, see VulkanUploader::isAcquired(). Always true for the other buffers.
+    [[nodiscard]] bool isReady() const;
+
 private:
     VkBuffer      mBuffer{VK_NULL_HANDLE};
     VmaAllocation mAllocation{VK_NULL_HANDLE};
     uint64_t      mSiizeInByte{0};
+    void*         mMappedData{nullptr};
+    uint64_t      mUploadValue{0}; ///< VulkanUploader::UploadHandle of the initial content, 0 when none.
 };
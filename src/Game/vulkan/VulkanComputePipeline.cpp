@@ -0,0 +1,36 @@
+#include "VulkanComputePipeline.h"
+
+#include "VulkanContext.h"
+#include "VulkanShaderProgram.h"
+
+#include <Engine/Log.h>
+
+VulkanComputePipelinePtr VulkanComputePipeline::Create(
+    const VulkanComputePipelineCreateInfo& createInfo) {
+    if (!createInfo.shader || !createInfo.shader->hasShaderStage(VK_SHADER_STAGE_COMPUTE_BIT)) {
+        ENGINE_CORE_ERROR("Compute pipeline {} require a compute shader.", createInfo.name);
+        return nullptr;
+    }
+
+    VulkanComputePipelinePtr vulkanPipeline = std::make_shared<VulkanComputePipeline>();
+    vulkanPipeline->mDescriptorSetLayout    = createInfo.shader->getDescriptorSetLayouts();
+    vulkanPipeline->mPipelineLayout         = createInfo.shader->getPipelineLayout();
+
+    VkComputePipelineCreateInfo vkcreateInfo{};
+    vkcreateInfo.sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    vkcreateInfo.pNext              = nullptr;
+    vkcreateInfo.flags              = 0;
+    vkcreateInfo.stage              = createInfo.shader->getShaderShages().front();
+    vkcreateInfo.layout             = createInfo.shader->getPipelineLayout();
+    vkcreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+    vkcreateInfo.basePipelineIndex  = 0;
+    VK_CHECK(vkCreateComputePipelines(VulkanContext::getDevice(), VK_NULL_HANDLE, 1, &vkcreateInfo,
+                                      nullptr, &vulkanPipeline->mPipeline));
+
+    VulkanContext::setDebugObjectName((uint64_t)vulkanPipeline->mPipeline, VK_OBJECT_TYPE_PIPELINE, createInfo.name.c_str());
+    return vulkanPipeline;
+}
+
+VulkanComputePipeline::~VulkanComputePipeline() {
+    vkDestroyPipeline(VulkanContext::getDevice(), mPipeline, nullptr);
+}
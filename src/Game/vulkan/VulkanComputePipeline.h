@@ -0,0 +1,38 @@
+#pragma once
+#include "VulkanUtils.h"
+#include "vulkan.h"
+
+#include <memory>
+#include <string>
+
+class VulkanComputePipeline;
+class VulkanShaderProgram;
+using VulkanComputePipelinePtr = std::shared_ptr<VulkanComputePipeline>;
+
+struct VulkanComputePipelineCreateInfo {
+    std::string                          name;
+    std::shared_ptr<VulkanShaderProgram> shader;
+};
+
+/// @brief
+class VulkanComputePipeline {
+public:
+    /// @brief Create a compute pipeline.
+    /// @param createInfo The shader program must contain a compute stage.
+    /// @return
+    static VulkanComputePipelinePtr Create(const VulkanComputePipelineCreateInfo& createInfo);
+
+    /// @brief
+    VulkanComputePipeline() = default;
+    ~VulkanComputePipeline();
+
+    VkPipeline       getPipeline() const { return mPipeline; }
+    VkPipelineLayout getPipelineLayout() const { return mPipelineLayout; }
+    const std::vector<VkDescriptorSetLayout>& getDescriptorSetLayouts() const { return mDescriptorSetLayout; }
+
+private:
+    std::vector<VkDescriptorSetLayout> mDescriptorSetLayout;
+
+    VkPipeline       mPipeline{};
+    VkPipelineLayout mPipelineLayout{};
+};
@@ -37,6 +37,8 @@ VkPhysicalDevice         sPhysicalDevice{VK_NULL_HANDLE};
 VkDevice                 sDevice{VK_NULL_HANDLE};
 uint32_t                 sGraphicQueueFamilyIndex{0};
 VkQueue                  sGraphicsQueue{VK_NULL_HANDLE};
+uint32_t                 sTransferQueueFamilyIndex{0};
+VkQueue                  sTransferQueue{VK_NULL_HANDLE};
 VmaAllocator             sVmaAllocator{VK_NULL_HANDLE};
 VkDebugUtilsMessengerEXT debugMessenger{VK_NULL_HANDLE};
 VkCommandPool            sSingleTimeCommandPool{VK_NULL_HANDLE};
@@ -160,20 +162,33 @@ bool Initialize() {
     // ====================================================
     //   Create Device
     //
-    // Fow now, only use 1 queue that support graphic and compute.
+    // One queue that support graphic and compute for the rendering and,
+    // if the device has one, a transfer only queue for the uploads.
     // ====================================================
 
     sGraphicQueueFamilyIndex = VulkanUtils::findDeviceQueueFamilyIndex(
         sPhysicalDevice, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
 
-    float                   pQueuePriorities = 0.0;
-    VkDeviceQueueCreateInfo queueCreateInfo{};
+    const int32_t transferQueueFamilyIndex = VulkanUtils::findDeviceQueueFamilyIndex(
+        sPhysicalDevice, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    // Without a dedicated family, the uploads share the graphic queue.
+    sTransferQueueFamilyIndex =
+        transferQueueFamilyIndex >= 0 ? transferQueueFamilyIndex : sGraphicQueueFamilyIndex;
+
+    float                                pQueuePriorities = 0.0;
+    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+    VkDeviceQueueCreateInfo              queueCreateInfo{};
     queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queueCreateInfo.pNext;
     queueCreateInfo.flags;
     queueCreateInfo.queueFamilyIndex = sGraphicQueueFamilyIndex;
     queueCreateInfo.queueCount       = 1;
     queueCreateInfo.pQueuePriorities = &pQueuePriorities;
+    queueCreateInfos.push_back(queueCreateInfo);
+    if (sTransferQueueFamilyIndex != sGraphicQueueFamilyIndex) {
+        queueCreateInfo.queueFamilyIndex = sTransferQueueFamilyIndex;
+        queueCreateInfos.push_back(queueCreateInfo);
+    }
 
     VkPhysicalDeviceFeatures2 deviceFeatures{};
     deviceFeatures.sType                       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
@@ -183,9 +198,13 @@ bool Initialize() {
     deviceFeatures.features.multiDrawIndirect  = true;
     deviceFeatures.features.drawIndirectFirstInstance = true;
     deviceFeatures.features.samplerAnisotropy  = true;
+    deviceFeatures.features.shaderStorageImageWriteWithoutFormat = true; // mipmap generation (VulkanMipGenerator)
+    deviceFeatures.features.textureCompressionBC = true; // cooked textures (TextureCooker)
 
     VkPhysicalDeviceVulkan12Features vulkan12Features{};
     vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.drawIndirectCount = true; // vkCmdDrawIndexedIndirectCount (GPU culling)
+    vulkan12Features.timelineSemaphore = true; // upload completion (VulkanUploader)
 
     VkPhysicalDeviceVulkan13Features vulkan13Features{};
     vulkan13Features.sType              = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
@@ -215,8 +234,8 @@ bool Initialize() {
     createInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pNext                   = &deviceFeatures;
     createInfo.flags                   = 0;
-    createInfo.queueCreateInfoCount    = 1;
-    createInfo.pQueueCreateInfos       = &queueCreateInfo;
+    createInfo.queueCreateInfoCount    = queueCreateInfos.size();
+    createInfo.pQueueCreateInfos       = queueCreateInfos.data();
     createInfo.enabledLayerCount       = 0;       // deprecated and ignored.
     createInfo.ppEnabledLayerNames     = nullptr; // deprecated and ignored.
     createInfo.enabledExtensionCount   = deviceExtensions.size();
@@ -227,6 +246,9 @@ bool Initialize() {
     }
 
     vkGetDeviceQueue(sDevice, sGraphicQueueFamilyIndex, 0, &sGraphicsQueue);
+    vkGetDeviceQueue(sDevice, sTransferQueueFamilyIndex, 0, &sTransferQueue);
+    ENGINE_CORE_INFO("Graphic queue family {}, transfer queue family {}", sGraphicQueueFamilyIndex,
+                     sTransferQueueFamilyIndex);
 
     // ==============================================================
     //   Setup memory allocation
@@ -301,6 +323,9 @@ bool isDeviceExtensionSupported() { return true; }
 uint32_t getGraphicQueueFamilyIndex() { return sGraphicQueueFamilyIndex; }
 VkQueue  getGraphicQueue() { return sGraphicsQueue; }
 
+uint32_t getTransferQueueFamilyIndex() { return sTransferQueueFamilyIndex; }
+VkQueue  getTransferQueue() { return sTransferQueue; }
+
 VkCommandBuffer beginSingleTimeCommands() {
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -334,18 +359,6 @@ void endSingleTimeCommands(VkCommandBuffer commandBuffer) {
     vkFreeCommandBuffers(sDevice, sSingleTimeCommandPool, 1, &commandBuffer);
 }
 
-void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-    auto cmd = beginSingleTimeCommands();
-
-    VkBufferCopy copyRegion{};
-    copyRegion.srcOffset = 0; // Optional
-    copyRegion.dstOffset = 0; // Optional
-    copyRegion.size      = size;
-    vkCmdCopyBuffer(cmd, srcBuffer, dstBuffer, 1, &copyRegion);
-
-    endSingleTimeCommands(cmd);
-}
-
 void copyBufferToImage(VkCommandBuffer commandBuffer,
                        VkBuffer        buffer,
                        VkImage         image,
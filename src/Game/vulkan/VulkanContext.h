@@ -24,6 +24,11 @@ VkPhysicalDevice getPhycalDevice();
 VkDevice         getDevice();
 uint32_t         getGraphicQueueFamilyIndex();
 VkQueue          getGraphicQueue();
+/// @brief Return the family of the queue used for the uploads.
+///        Equal to the graphic family if the device has no transfer only queue.
+uint32_t         getTransferQueueFamilyIndex();
+/// @brief Return the queue used for the uploads, may be the graphic queue.
+VkQueue          getTransferQueue();
 VmaAllocator     getVmaAllocator();
 
 bool isLayerSupported();
@@ -42,6 +47,12 @@ void                          copyBufferToImage(
                                                     VkPushConstantRange*   ranges);
 [[nodiscard]] VkPipelineLayout createPipelineLayout(Shader vert, Shader frag);
 
+/// @brief Create a command pool.
+/// @param queueFamilyIndex The queue family of the command buffers allocated from the pool.
+/// @param transient        The command buffers are short-lived (VK_COMMAND_POOL_CREATE_TRANSIENT_BIT).
+/// @param reset            The command buffers can be reset individually (VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT).
+[[nodiscard]] VkCommandPool createCommandPool(uint32_t queueFamilyIndex, bool transient, bool reset) noexcept;
+
 // Debugging
 void CmdBeginsLabel(VkCommandBuffer cmd, std::string_view label);
 void CmdEndLabel(VkCommandBuffer cmd);
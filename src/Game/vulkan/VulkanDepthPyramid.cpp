@@ -0,0 +1,321 @@
+#include "VulkanDepthPyramid.h"
+
+#include "VulkanContext.h"
+#include "VulkanUtils.h"
+
+#include <Engine/Log.h>
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// Size of a group, must match depth_pyramid.slang.
+constexpr uint32_t kGroupSize = 8;
+
+// Must match PushData in depth_pyramid.slang.
+struct PushData {
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+};
+
+VkShaderModule        sShaderModule{VK_NULL_HANDLE};
+VkDescriptorSetLayout sDescriptorSetLayout{VK_NULL_HANDLE};
+VkPipelineLayout      sPipelineLayout{VK_NULL_HANDLE};
+VkPipeline            sPipeline{VK_NULL_HANDLE};
+
+PFN_vkCmdPushDescriptorSetKHR sCmdPushDescriptorSet{nullptr};
+
+std::vector<uint32_t> readSpirv(const std::filesystem::path& path) {
+    std::vector<uint32_t> spirv;
+    std::ifstream         ifs(path.string(), std::ios::binary);
+    if (!ifs) {
+        ENGINE_CORE_ERROR("Fail to open file: {}", path.string());
+        return spirv;
+    }
+    spirv.resize(std::filesystem::file_size(path) / 4);
+    ifs.read((char*)spirv.data(), spirv.size() * 4);
+    return spirv;
+}
+
+void pipelineBarrier(VkCommandBuffer cmd, const VkImageMemoryBarrier2* imageBarriers, uint32_t imageBarrierCount) {
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.imageMemoryBarrierCount = imageBarrierCount;
+    dependencyInfo.pImageMemoryBarriers    = imageBarriers;
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+
+/// @brief Barrier on all the levels of the pyramid, which stays in VK_IMAGE_LAYOUT_GENERAL.
+VkImageMemoryBarrier2 pyramidBarrier(VkImage image, uint32_t levelCount) {
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.oldLayout                       = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout                       = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.image                           = image;
+    barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = levelCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = 1;
+    return barrier;
+}
+
+/// @brief Record the dispatch writing a level from the previous one (or the depth buffer).
+void dispatch(VkCommandBuffer cmd,
+              VkImageView     srcView,
+              VkImageLayout   srcLayout,
+              VkImageView     dstView,
+              uint32_t        srcWidth,
+              uint32_t        srcHeight) {
+    VkDescriptorImageInfo srcImageInfo{};
+    srcImageInfo.imageView   = srcView;
+    srcImageInfo.imageLayout = srcLayout;
+
+    VkDescriptorImageInfo dstImageInfo{};
+    dstImageInfo.imageView   = dstView;
+    dstImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet writes[2]{};
+    writes[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstBinding      = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[0].pImageInfo      = &srcImageInfo;
+    writes[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[1].dstBinding      = 1;
+    writes[1].descriptorCount = 1;
+    writes[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].pImageInfo      = &dstImageInfo;
+    sCmdPushDescriptorSet(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, sPipelineLayout, 0, 2, writes);
+
+    PushData pushData{};
+    pushData.srcWidth  = srcWidth;
+    pushData.srcHeight = srcHeight;
+    pushData.dstWidth  = (srcWidth + 1) / 2;
+    pushData.dstHeight = (srcHeight + 1) / 2;
+    vkCmdPushConstants(cmd, sPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushData), &pushData);
+
+    vkCmdDispatch(cmd, (pushData.dstWidth + kGroupSize - 1) / kGroupSize,
+                  (pushData.dstHeight + kGroupSize - 1) / kGroupSize, 1);
+}
+
+} // namespace
+
+void VulkanDepthPyramid::Init() {
+    const VkDevice device = VulkanContext::getDevice();
+
+    sCmdPushDescriptorSet =
+        (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR");
+    assert(sCmdPushDescriptorSet);
+
+    // The descriptors change for each level, they are pushed into the command buffer.
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding         = 0;
+    bindings[0].descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding         = 1;
+    bindings[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo{};
+    setLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutCreateInfo.flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+    setLayoutCreateInfo.bindingCount = 2;
+    setLayoutCreateInfo.pBindings    = bindings;
+    VK_CHECK(vkCreateDescriptorSetLayout(device, &setLayoutCreateInfo, nullptr, &sDescriptorSetLayout));
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset     = 0;
+    pushConstantRange.size       = sizeof(PushData);
+    sPipelineLayout = VulkanContext::createPipelineLayout(1, &sDescriptorSetLayout, 1, &pushConstantRange);
+    VulkanContext::setDebugObjectName((uint64_t)sPipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "DepthPyramidPipelineLayout");
+
+    const std::vector<uint32_t> spirv = readSpirv("./shaders/depth_pyramid_comp.spv");
+    assert(!spirv.empty());
+    const Shader shader = VulkanContext::createShaderModule(spirv);
+    sShaderModule       = shader.shaderModule;
+
+    VkComputePipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.stage  = shader.stageCreateInfo;
+    pipelineCreateInfo.layout = sPipelineLayout;
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &sPipeline));
+    VulkanContext::setDebugObjectName((uint64_t)sPipeline, VK_OBJECT_TYPE_PIPELINE, "DepthPyramid");
+}
+
+void VulkanDepthPyramid::Shutdown() {
+    const VkDevice device = VulkanContext::getDevice();
+
+    vkDestroyPipeline(device, sPipeline, nullptr);
+    vkDestroyPipelineLayout(device, sPipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, sDescriptorSetLayout, nullptr);
+    vkDestroyShaderModule(device, sShaderModule, nullptr);
+    sPipeline            = VK_NULL_HANDLE;
+    sPipelineLayout      = VK_NULL_HANDLE;
+    sDescriptorSetLayout = VK_NULL_HANDLE;
+    sShaderModule        = VK_NULL_HANDLE;
+}
+
+VulkanDepthPyramidPtr VulkanDepthPyramid::Create(uint32_t depthWidth, uint32_t depthHeight) {
+    return std::make_shared<VulkanDepthPyramid>(depthWidth, depthHeight);
+}
+
+VulkanDepthPyramid::VulkanDepthPyramid(uint32_t depthWidth, uint32_t depthHeight)
+    : mDepthWidth(std::max(1u, depthWidth)), mDepthHeight(std::max(1u, depthHeight)) {
+    mWidth  = (mDepthWidth + 1) / 2;
+    mHeight = (mDepthHeight + 1) / 2;
+    for (uint32_t width = mWidth, height = mHeight; width > 1 || height > 1; ++mLevelCount) {
+        width  = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+
+    const VkDevice device = VulkanContext::getDevice();
+
+    VkImageCreateInfo imageCreateInfo{};
+    imageCreateInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format        = VK_FORMAT_R32_SFLOAT;
+    imageCreateInfo.extent        = {mWidth, mHeight, 1};
+    imageCreateInfo.mipLevels     = mLevelCount;
+    imageCreateInfo.arrayLayers   = 1;
+    imageCreateInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage         = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageCreateInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage         = VMA_MEMORY_USAGE_UNKNOWN;
+    allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    VK_CHECK(vmaCreateImage(VulkanContext::getVmaAllocator(), &imageCreateInfo, &allocInfo, &mImage, &mAllocation,
+                            nullptr /*allocationInfo*/));
+
+    VkImageViewCreateInfo ivCreateInfo{};
+    ivCreateInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    ivCreateInfo.image                           = mImage;
+    ivCreateInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+    ivCreateInfo.format                          = VK_FORMAT_R32_SFLOAT;
+    ivCreateInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    ivCreateInfo.subresourceRange.baseMipLevel   = 0;
+    ivCreateInfo.subresourceRange.levelCount     = mLevelCount;
+    ivCreateInfo.subresourceRange.baseArrayLayer = 0;
+    ivCreateInfo.subresourceRange.layerCount     = 1;
+    VK_CHECK(vkCreateImageView(device, &ivCreateInfo, nullptr, &mView));
+
+    mLevelViews.resize(mLevelCount, VK_NULL_HANDLE);
+    ivCreateInfo.subresourceRange.levelCount = 1;
+    for (uint32_t level = 0; level < mLevelCount; ++level) {
+        ivCreateInfo.subresourceRange.baseMipLevel = level;
+        VK_CHECK(vkCreateImageView(device, &ivCreateInfo, nullptr, &mLevelViews[level]));
+    }
+
+    VulkanContext::setDebugObjectName((uint64_t)mImage, VK_OBJECT_TYPE_IMAGE, "DepthPyramid");
+    VulkanContext::setDebugObjectName((uint64_t)mView, VK_OBJECT_TYPE_IMAGE_VIEW, "DepthPyramid");
+}
+
+VulkanDepthPyramid::~VulkanDepthPyramid() {
+    const VkDevice device = VulkanContext::getDevice();
+    for (VkImageView levelView : mLevelViews) {
+        vkDestroyImageView(device, levelView, nullptr);
+    }
+    vkDestroyImageView(device, mView, nullptr);
+    vmaDestroyImage(VulkanContext::getVmaAllocator(), mImage, mAllocation);
+}
+
+void VulkanDepthPyramid::clear(VkCommandBuffer cmd) {
+    VkImageMemoryBarrier2 barrier = pyramidBarrier(mImage, mLevelCount);
+    barrier.srcStageMask          = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask         = VK_ACCESS_2_NONE;
+    barrier.dstStageMask          = VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    barrier.dstAccessMask         = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.oldLayout             = VK_IMAGE_LAYOUT_UNDEFINED;
+    pipelineBarrier(cmd, &barrier, 1);
+
+    const VkClearColorValue farDepth{{1.0f, 1.0f, 1.0f, 1.0f}};
+    vkCmdClearColorImage(cmd, mImage, VK_IMAGE_LAYOUT_GENERAL, &farDepth, 1, &barrier.subresourceRange);
+
+    barrier               = pyramidBarrier(mImage, mLevelCount);
+    barrier.srcStageMask  = VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    pipelineBarrier(cmd, &barrier, 1);
+
+    mInitialized = true;
+}
+
+void VulkanDepthPyramid::build(VkCommandBuffer cmd, VkImage depthImage, VkImageView depthView) {
+    assert(mInitialized);
+    VulkanContext::CmdBeginsLabel(cmd, "DepthPyramid");
+
+    // The depth buffer is read by the compute shader once the fragment tests are done with it,
+    // the levels are written once the culling passes recorded before are done reading them.
+    VkImageMemoryBarrier2 barriers[2]{};
+    barriers[0].sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barriers[0].srcStageMask                    = VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+    barriers[0].srcAccessMask                   = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[0].dstStageMask                    = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barriers[0].dstAccessMask                   = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    barriers[0].oldLayout                       = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[0].newLayout                       = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image                           = depthImage;
+    barriers[0].subresourceRange.aspectMask     = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    barriers[0].subresourceRange.baseMipLevel   = 0;
+    barriers[0].subresourceRange.levelCount     = 1;
+    barriers[0].subresourceRange.baseArrayLayer = 0;
+    barriers[0].subresourceRange.layerCount     = 1;
+    barriers[1]               = pyramidBarrier(mImage, mLevelCount);
+    barriers[1].srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barriers[1].srcAccessMask = VK_ACCESS_2_NONE;
+    barriers[1].dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    pipelineBarrier(cmd, barriers, 2);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, sPipeline);
+
+    // Each level is read by the dispatch of the next one.
+    VkImageMemoryBarrier2 levelBarrier = pyramidBarrier(mImage, 1);
+    levelBarrier.srcStageMask          = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    levelBarrier.srcAccessMask         = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    levelBarrier.dstStageMask          = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    levelBarrier.dstAccessMask         = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+
+    dispatch(cmd, depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, mLevelViews[0], mDepthWidth, mDepthHeight);
+    uint32_t width  = mWidth;
+    uint32_t height = mHeight;
+    for (uint32_t level = 1; level < mLevelCount; ++level) {
+        levelBarrier.subresourceRange.baseMipLevel = level - 1;
+        pipelineBarrier(cmd, &levelBarrier, 1);
+        dispatch(cmd, mLevelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL, mLevelViews[level], width, height);
+        width  = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+
+    // The depth buffer goes back to the fragment tests, the levels are read by the culling passes.
+    barriers[0].srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barriers[0].srcAccessMask = VK_ACCESS_2_NONE;
+    barriers[0].oldLayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    barriers[0].newLayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[0].dstStageMask  = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barriers[1].srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    barriers[1].dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    pipelineBarrier(cmd, barriers, 2);
+
+    VulkanContext::CmdEndLabel(cmd);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "vulkan.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class VulkanDepthPyramid;
+using VulkanDepthPyramidPtr = std::shared_ptr<VulkanDepthPyramid>;
+
+/// @brief Hierarchical-Z pyramid of a depth buffer, used by the occlusion culling.
+///
+/// The level 0 is half the size of the depth buffer (rounded up) and each level is half of the
+/// previous one, down to 1x1. A texel holds the farthest depth of the depth buffer pixels it
+/// covers, the odd sizes are clamped so a texel at (x, y) of the level l covers exactly the
+/// pixels [x, x + 1) * 2^(l + 1). An object whose nearest depth is behind the texels covering
+/// its screen rectangle is hidden.
+///
+/// The levels are built by a compute shader, one dispatch per level, recorded into a command
+/// buffer of the caller on a queue supporting compute (the graphic queue). The image stays in
+/// VK_IMAGE_LAYOUT_GENERAL, it is written as storage and read as a sampled image.
+class VulkanDepthPyramid {
+public:
+    /// @brief Load the shader and create the pipeline shared by all the pyramids.
+    static void Init();
+
+    /// @brief Destroy the pipeline.
+    static void Shutdown();
+
+    /// @brief Create the pyramid of a depth buffer.
+    static VulkanDepthPyramidPtr Create(uint32_t depthWidth, uint32_t depthHeight);
+
+    VulkanDepthPyramid(uint32_t depthWidth, uint32_t depthHeight);
+    ~VulkanDepthPyramid();
+
+    VulkanDepthPyramid(const VulkanDepthPyramid&)            = delete;
+    VulkanDepthPyramid& operator=(const VulkanDepthPyramid&) = delete;
+
+    /// @brief Record the initialization of the levels to the far depth, nothing is hidden by the
+    ///        pyramid until the first build(). Must be recorded once before the pyramid is read.
+    void clear(VkCommandBuffer cmd);
+
+    /// @brief Record the build of all the levels from a depth buffer of the size of the pyramid.
+    ///
+    /// The depth buffer must be in VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, written by
+    /// the fragment tests, it is read by the compute shader and left in the same layout. The
+    /// levels are readable by the compute shaders recorded after.
+    ///
+    /// @param depthImage The depth buffer image (depth and stencil aspects).
+    /// @param depthView  View of the depth aspect of the depth buffer.
+    void build(VkCommandBuffer cmd, VkImage depthImage, VkImageView depthView);
+
+    /// @brief Return true once clear() was recorded.
+    bool isInitialized() const { return mInitialized; }
+
+    /// @brief View of all the levels, to read in VK_IMAGE_LAYOUT_GENERAL.
+    VkImageView getImageView() const { return mView; }
+
+    uint32_t getDepthWidth() const { return mDepthWidth; }
+    uint32_t getDepthHeight() const { return mDepthHeight; }
+    uint32_t getWidth() const { return mWidth; }   ///< Width of the level 0.
+    uint32_t getHeight() const { return mHeight; } ///< Height of the level 0.
+    uint32_t getLevelCount() const { return mLevelCount; }
+
+private:
+    uint32_t mDepthWidth{};
+    uint32_t mDepthHeight{};
+    uint32_t mWidth{};
+    uint32_t mHeight{};
+    uint32_t mLevelCount{1};
+    bool     mInitialized{false};
+
+    VkImage                  mImage{VK_NULL_HANDLE};
+    VmaAllocation            mAllocation{VK_NULL_HANDLE};
+    VkImageView              mView{VK_NULL_HANDLE};
+    std::vector<VkImageView> mLevelViews; ///< One view per level, read and written by the build.
+};
@@ -13,12 +13,13 @@ void VulkanDescriptorPool::init() {
         .maxInlineUniformBlockBindings = 10 // number of inline uniform block bindings to allocate
     };
 
-    std::array<VkDescriptorPoolSize, 7> poolSize = {
+    std::array<VkDescriptorPoolSize, 8> poolSize = {
         VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_SAMPLER, 100},
         VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 100},
+        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 100},
         VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 100},
         VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 100},
-        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100},
+        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 200},
         VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 100},
         // when inline uniforn block is used, we need to include
         // VkDescriptorPoolInlineUniformBlockCreateInfo in VkDescriptorPoolCreateInfo.pNext
@@ -0,0 +1,123 @@
+#include "VulkanGeometryArena.h"
+
+#include <Engine/Log.h>
+
+#include <cassert>
+#include <deque>
+
+namespace {
+
+VulkanBufferPtr           sVertexBuffer;
+VulkanBufferPtr           sIndexBuffer;
+Engine::FreeListAllocator sVertexAllocator;
+Engine::FreeListAllocator sIndexAllocator;
+uint32_t                  sGeneration{0}; ///< 0 when the arena is not initialized.
+uint32_t                  sNextGeneration{1};
+uint32_t                  sNextAllocationId{1};
+
+/// @brief Ranges released by a frame, the frames in flight may still read them.
+struct Retired {
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t releaseFrame;
+};
+std::deque<Retired> sRetired;
+uint64_t            sFrameNumber{0};
+
+VulkanBufferPtr createBuffer(const char* name, uint64_t sizeInByte, VkBufferUsageFlags usage) {
+    VulkanBufferCreateInfo createInfo{};
+    createInfo.name           = name;
+    createInfo.sizeInByte     = sizeInByte;
+    createInfo.usage          = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    createInfo.memoryProperty = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    return VulkanBuffer::Create(createInfo);
+}
+
+} // namespace
+
+namespace VulkanGeometryArena {
+
+Allocation::~Allocation() {
+    if (generation == 0 || generation != sGeneration) {
+        return;
+    }
+    sRetired.push_back({vertexOffset, indexOffset, sFrameNumber});
+}
+
+void Init(uint64_t vertexCapacity, uint64_t indexCapacity) {
+    assert(sGeneration == 0 && "VulkanGeometryArena already initialized.");
+    sVertexBuffer = createBuffer("GeometryArenaVB", vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    sIndexBuffer  = createBuffer("GeometryArenaIB", indexCapacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    sVertexAllocator.reset(vertexCapacity);
+    sIndexAllocator.reset(indexCapacity);
+    sGeneration = sNextGeneration++;
+}
+
+void Shutdown() {
+    sGeneration = 0;
+    sRetired.clear();
+    sVertexAllocator.reset(0);
+    sIndexAllocator.reset(0);
+    sIndexBuffer.reset();
+    sVertexBuffer.reset();
+}
+
+void beginFrame(uint32_t frameInFlightCount) {
+    sFrameNumber++;
+    // The ranges are retired in frame order, the frame that released them and the ones recorded
+    // before it are done once frameInFlightCount fences have been waited since.
+    while (!sRetired.empty() && sFrameNumber >= sRetired.front().releaseFrame + frameInFlightCount) {
+        sVertexAllocator.free(sRetired.front().vertexOffset);
+        sIndexAllocator.free(sRetired.front().indexOffset);
+        sRetired.pop_front();
+    }
+}
+
+AllocationPtr allocate(uint64_t vertexSize, uint32_t vertexStride, uint64_t indexSize, uint32_t indexStride) {
+    assert(sGeneration != 0 && "VulkanGeometryArena not initialized.");
+
+    const uint64_t vertexOffset = sVertexAllocator.allocate(vertexSize, vertexStride);
+    if (vertexOffset == Engine::FreeListAllocator::kInvalidOffset) {
+        const auto statistics = sVertexAllocator.getStatistics();
+        ENGINE_ERROR("Geometry arena: no room for {} bytes of vertices ({} free, largest block {}).",
+                     vertexSize, statistics.freeSize, statistics.largestFreeBlock);
+        return nullptr;
+    }
+    const uint64_t indexOffset = sIndexAllocator.allocate(indexSize, indexStride);
+    if (indexOffset == Engine::FreeListAllocator::kInvalidOffset) {
+        sVertexAllocator.free(vertexOffset);
+        const auto statistics = sIndexAllocator.getStatistics();
+        ENGINE_ERROR("Geometry arena: no room for {} bytes of indices ({} free, largest block {}).",
+                     indexSize, statistics.freeSize, statistics.largestFreeBlock);
+        return nullptr;
+    }
+
+    auto allocation          = std::make_shared<Allocation>();
+    allocation->vertexOffset = vertexOffset;
+    allocation->vertexSize   = vertexSize;
+    allocation->indexOffset  = indexOffset;
+    allocation->indexSize    = indexSize;
+    allocation->generation   = sGeneration;
+    allocation->id           = sNextAllocationId++;
+    return allocation;
+}
+
+const VulkanBufferPtr& getVertexBuffer() { return sVertexBuffer; }
+
+const VulkanBufferPtr& getIndexBuffer() { return sIndexBuffer; }
+
+void bindVertexBuffer(VkCommandBuffer cmd) {
+    const VkBuffer     buffer = sVertexBuffer->getBuffer();
+    const VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(cmd, 0, 1, &buffer, &offset);
+}
+
+void bindIndexBuffer(VkCommandBuffer cmd, VkIndexType indexType) {
+    vkCmdBindIndexBuffer(cmd, sIndexBuffer->getBuffer(), 0, indexType);
+}
+
+Statistics getStatistics() {
+    return {sVertexAllocator.getStatistics(), sIndexAllocator.getStatistics()};
+}
+
+} // namespace VulkanGeometryArena
@@ -0,0 +1,83 @@
+#pragma once
+#include "VulkanBuffer.h"
+
+#include <Engine/FreeListAllocator.h>
+
+#include <cstdint>
+#include <memory>
+
+/// @brief Global vertex and index buffers shared by all the meshes.
+///
+/// The geometry of a mesh is a range of each buffer, sub allocated with a free list. Since all
+/// the meshes live in the same two buffers, a pass binds them once and draws each mesh with
+/// firstIndex and vertexOffset. The vertex range of a mesh is aligned to its vertex size and the
+/// index range to its index size, so the offsets are whole vertices and indices whatever the
+/// vertex format and the index type. The index buffer is bound again only when the index type
+/// changes.
+///
+/// The capacity is fixed at Init(), an allocation fails when no free block is large enough.
+/// A released range may still be read by the frames in flight, it is retired and returned to the
+/// free list by beginFrame() once their fences have signaled.
+/// Not thread safe, call from the render thread.
+namespace VulkanGeometryArena {
+
+/// @brief The ranges of a mesh, retired when the last reference goes away.
+struct Allocation {
+    uint64_t vertexOffset{0}; ///< Offset in bytes in the vertex buffer.
+    uint64_t vertexSize{0};   ///< Size in bytes in the vertex buffer.
+    uint64_t indexOffset{0};  ///< Offset in bytes in the index buffer.
+    uint64_t indexSize{0};    ///< Size in bytes in the index buffer.
+    uint32_t generation{0};   ///< Init() the ranges belong to, they are not released after a Shutdown().
+    uint32_t id{0};           ///< Unique id of the allocation, the ids are never reused.
+
+    Allocation() = default;
+    Allocation(const Allocation&)            = delete;
+    Allocation& operator=(const Allocation&) = delete;
+    ~Allocation();
+};
+using AllocationPtr = std::shared_ptr<Allocation>;
+
+/// @brief Usage of the two buffers.
+struct Statistics {
+    Engine::FreeListAllocator::Statistics vertex;
+    Engine::FreeListAllocator::Statistics index;
+};
+
+/// @brief Create the buffers.
+/// @param vertexCapacity The size of the vertex buffer in bytes.
+/// @param indexCapacity  The size of the index buffer in bytes.
+void Init(uint64_t vertexCapacity = 256ull * 1024 * 1024, uint64_t indexCapacity = 64ull * 1024 * 1024);
+
+/// @brief Destroy the buffers, the allocations still alive become invalid.
+void Shutdown();
+
+/// @brief Return the ranges retired frameInFlightCount frames ago to the free lists.
+///        Call once per frame, after waiting for the fence of the frame slot.
+/// @param frameInFlightCount The number of frames the GPU may be processing.
+void beginFrame(uint32_t frameInFlightCount);
+
+/// @brief Allocate the ranges of a mesh.
+/// @param vertexSize   The size of the vertices in bytes, must not be 0.
+/// @param vertexStride The size of a vertex, the alignment of the vertex range.
+/// @param indexSize    The size of the indices in bytes, must not be 0.
+/// @param indexStride  The size of an index, the alignment of the index range.
+/// @return The ranges, nullptr if one of the buffers is full.
+[[nodiscard]] AllocationPtr allocate(uint64_t vertexSize, uint32_t vertexStride, uint64_t indexSize, uint32_t indexStride);
+
+/// @brief Return the vertex buffer, to upload the vertices with VulkanUploader::uploadBuffer().
+[[nodiscard]] const VulkanBufferPtr& getVertexBuffer();
+
+/// @brief Return the index buffer, to upload the indices with VulkanUploader::uploadBuffer().
+[[nodiscard]] const VulkanBufferPtr& getIndexBuffer();
+
+/// @brief Bind the vertex buffer at the binding 0.
+void bindVertexBuffer(VkCommandBuffer cmd);
+
+/// @brief Bind the index buffer.
+/// @param indexType The index type of the meshes drawn until the next bind.
+void bindIndexBuffer(VkCommandBuffer cmd, VkIndexType indexType);
+
+/// @brief Return the usage and the fragmentation of the buffers.
+[[nodiscard]] Statistics getStatistics();
+
+} // namespace VulkanGeometryArena
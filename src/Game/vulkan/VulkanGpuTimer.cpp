@@ -0,0 +1,88 @@
+#include "VulkanGpuTimer.h"
+
+#include "VulkanContext.h"
+#include "VulkanUtils.h"
+
+#include <Engine/Log.h>
+
+#include <cassert>
+
+void VulkanGpuTimer::init(const std::string& name, uint32_t scopeCount, uint32_t frameCount) {
+    mScopeCount = scopeCount;
+    mFrameCount = frameCount;
+    mFirstQuery = 0;
+    mElapsedMs.assign(scopeCount, 0.0f);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(VulkanContext::getPhycalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(VulkanContext::getPhycalDevice(), &queueFamilyCount, queueFamilies.data());
+    const uint32_t validBits = queueFamilies[VulkanContext::getGraphicQueueFamilyIndex()].timestampValidBits;
+    if (validBits == 0) {
+        ENGINE_CORE_WARNING("VulkanGpuTimer: the graphic queue doesn't support the timestamps, {} is disabled", name);
+        return;
+    }
+    mTimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(VulkanContext::getPhycalDevice(), &properties);
+    mTimestampPeriod = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo createInfo{};
+    createInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    createInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    createInfo.queryCount = 2 * mScopeCount * mFrameCount;
+    VK_CHECK(vkCreateQueryPool(VulkanContext::getDevice(), &createInfo, nullptr, &mQueryPool));
+    VulkanContext::setDebugObjectName((uint64_t)mQueryPool, VK_OBJECT_TYPE_QUERY_POOL, name);
+
+    // The queries must be reset before the first read.
+    VkCommandBuffer cmd = VulkanContext::beginSingleTimeCommands();
+    vkCmdResetQueryPool(cmd, mQueryPool, 0, createInfo.queryCount);
+    VulkanContext::endSingleTimeCommands(cmd);
+}
+
+void VulkanGpuTimer::destroy() {
+    vkDestroyQueryPool(VulkanContext::getDevice(), mQueryPool, nullptr);
+    mQueryPool = VK_NULL_HANDLE;
+}
+
+void VulkanGpuTimer::beginFrame(VkCommandBuffer cmd, uint32_t frameIndex) {
+    assert(frameIndex < mFrameCount);
+    mFirstQuery = 2 * mScopeCount * frameIndex;
+    if (!isSupported()) {
+        return;
+    }
+
+    // Value and availability of each query, the scopes which were not recorded are not available.
+    // Without VK_QUERY_RESULT_WAIT_BIT the call returns VK_NOT_READY in that case, it is expected.
+    std::vector<uint64_t> results(4 * mScopeCount);
+    vkGetQueryPoolResults(VulkanContext::getDevice(), mQueryPool, mFirstQuery, 2 * mScopeCount,
+                          results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+                          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    for (uint32_t scope = 0; scope < mScopeCount; ++scope) {
+        const uint64_t* begin = &results[4 * scope];
+        const uint64_t* end   = &results[4 * scope + 2];
+        if (begin[1] == 0 || end[1] == 0) {
+            mElapsedMs[scope] = 0.0f;
+            continue;
+        }
+        const uint64_t ticks = ((end[0] & mTimestampMask) - (begin[0] & mTimestampMask)) & mTimestampMask;
+        mElapsedMs[scope]    = static_cast<float>(static_cast<double>(ticks) * mTimestampPeriod * 1e-6);
+    }
+
+    vkCmdResetQueryPool(cmd, mQueryPool, mFirstQuery, 2 * mScopeCount);
+}
+
+void VulkanGpuTimer::writeBegin(VkCommandBuffer cmd, uint32_t scope) const {
+    assert(scope < mScopeCount);
+    if (isSupported()) {
+        vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, mQueryPool, mFirstQuery + 2 * scope);
+    }
+}
+
+void VulkanGpuTimer::writeEnd(VkCommandBuffer cmd, uint32_t scope) const {
+    assert(scope < mScopeCount);
+    if (isSupported()) {
+        vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, mQueryPool, mFirstQuery + 2 * scope + 1);
+    }
+}
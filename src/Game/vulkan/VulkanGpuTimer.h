@@ -0,0 +1,56 @@
+#pragma once
+#include "vulkan.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief GPU durations of the passes of a frame, measured with timestamp queries.
+///
+/// The query pool is split in one region per frame in flight, each scope of a region has a begin
+/// and an end timestamp. beginFrame() reads the durations written the last time the frame slot
+/// was used and records the reset of its region. The two timestamps of a scope can be written in
+/// different command buffers, as long as they execute in order (secondary command buffers).
+class VulkanGpuTimer {
+public:
+    VulkanGpuTimer() = default;
+    ~VulkanGpuTimer() = default;
+
+    VulkanGpuTimer(const VulkanGpuTimer&) = delete;
+    VulkanGpuTimer(VulkanGpuTimer&&) = delete;
+
+    VulkanGpuTimer& operator=(const VulkanGpuTimer&) = delete;
+    VulkanGpuTimer& operator=(VulkanGpuTimer&&) = delete;
+
+    /// @brief Create the query pool.
+    /// @param name       Debug name of the query pool.
+    /// @param scopeCount Number of scopes measured per frame.
+    /// @param frameCount Number of frames in flight.
+    void init(const std::string& name, uint32_t scopeCount, uint32_t frameCount);
+    void destroy();
+
+    /// @brief Read the durations of the frame slot and record the reset of its queries, the caller
+    ///        must have waited for its fence. Must be recorded outside of a rendering scope, before
+    ///        the timestamps of the frame.
+    void beginFrame(VkCommandBuffer cmd, uint32_t frameIndex);
+
+    /// @brief Record the begin / end timestamp of a scope of the current frame. Each one must be
+    ///        recorded at most once per frame, the scopes not recorded read as 0.
+    void writeBegin(VkCommandBuffer cmd, uint32_t scope) const;
+    void writeEnd(VkCommandBuffer cmd, uint32_t scope) const;
+
+    /// @brief Return the duration of a scope the last time the current frame slot was used, in milliseconds.
+    [[nodiscard]] float getElapsedMs(uint32_t scope) const { return scope < mElapsedMs.size() ? mElapsedMs[scope] : 0.0f; }
+
+    /// @brief Return false if the graphic queue doesn't support the timestamps, nothing is recorded.
+    [[nodiscard]] bool isSupported() const { return mQueryPool != VK_NULL_HANDLE; }
+
+private:
+    VkQueryPool        mQueryPool{VK_NULL_HANDLE};
+    double             mTimestampPeriod{1.0}; ///< Nanoseconds per timestamp tick.
+    uint64_t           mTimestampMask{~0ull}; ///< Valid bits of the timestamps.
+    uint32_t           mScopeCount{0};
+    uint32_t           mFrameCount{0};
+    uint32_t           mFirstQuery{0};        ///< First query of the region of the current frame.
+    std::vector<float> mElapsedMs;
+};
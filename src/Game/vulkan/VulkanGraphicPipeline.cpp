@@ -137,14 +137,16 @@ VulkanGraphicPipelinePtr VulkanGraphicPipeline::Create(
     dsStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
     dsStateCI.depthTestEnable  = createInfo.enableDepthTest;
     dsStateCI.depthCompareOp   = createInfo.depthCompareOp;
-    dsStateCI.depthWriteEnable = VK_TRUE;
+    dsStateCI.depthWriteEnable = createInfo.depthWrite;
 
     // =================================================================================
     //                                Blend states
     // =================================================================================
     std::array<VkPipelineColorBlendAttachmentState, 8> colorBlendAttachments{};
-    colorBlendAttachments[0].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-                                              VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    if (createInfo.colorWrite) {
+        colorBlendAttachments[0].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                                  VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    }
     VkPipelineColorBlendStateCreateInfo colorBlending{};
     colorBlending.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     colorBlending.pNext           = nullptr;
@@ -175,9 +177,10 @@ VulkanGraphicPipelinePtr VulkanGraphicPipeline::Create(
     // =================================================================================
     //                      Create the graphic pipeline
     // =================================================================================
+    const VulkanShaderProgram& layoutShader = createInfo.layoutShader ? *createInfo.layoutShader : *createInfo.shader;
     VulkanGraphicPipelinePtr vulkanPipeline = std::make_shared<VulkanGraphicPipeline>();
-    vulkanPipeline->mDescriptorSetLayout    = createInfo.shader->getDescriptorSetLayouts();
-    vulkanPipeline->mPipelineLayout         = createInfo.shader->getPipelineLayout();
+    vulkanPipeline->mDescriptorSetLayout    = layoutShader.getDescriptorSetLayouts();
+    vulkanPipeline->mPipelineLayout         = layoutShader.getPipelineLayout();
 
     VkGraphicsPipelineCreateInfo& vkcreateInfo = vulkanPipeline->mCreateInfo;
     vkcreateInfo.sType                         = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -198,7 +201,7 @@ VulkanGraphicPipelinePtr VulkanGraphicPipeline::Create(
     vkcreateInfo.pDepthStencilState            = &dsStateCI;
     vkcreateInfo.pColorBlendState              = &colorBlending;
     vkcreateInfo.pDynamicState                 = &dynamicStateCreateInfo;
-    vkcreateInfo.layout                        = createInfo.shader->getPipelineLayout();
+    vkcreateInfo.layout                        = layoutShader.getPipelineLayout();
     vkcreateInfo.renderPass                    = VK_NULL_HANDLE;
     vkcreateInfo.subpass                       = 0;
     vkcreateInfo.basePipelineHandle            = VK_NULL_HANDLE;
@@ -16,6 +16,12 @@ struct VulkanGraphicPipelineCreateInfo {
     VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
     bool            enableDepthTest = true;
     VkCompareOp     depthCompareOp  = VK_COMPARE_OP_LESS;
+    bool            depthWrite      = true;
+    bool            colorWrite      = true; ///< False for a depth only pipeline.
+    /// @brief Shader providing the pipeline layout instead of shader, when the stages of shader
+    ///        use a subset of its bindings. The pipeline binds the same descriptor sets as the
+    ///        pipelines created from layoutShader.
+    std::shared_ptr<VulkanShaderProgram> layoutShader;
     std::vector<VkVertexInputAttributeDescription> vertexInput = {};
     uint32_t vertexStride = 0;
 };
@@ -74,7 +74,7 @@ bool VulkanImGuiRenderer::Init(const Engine::SDL3Window& windows) {
     init_info.PipelineRenderingCreateInfo = renderingCreateInfo;
     init_info.Subpass                     = 0; // Optional
     init_info.MinImageCount               = 2;
-    init_info.ImageCount                  = 2;
+    init_info.ImageCount                  = MAX_FRAME_IN_FLIGHT; // One vertex buffer set per frame in flight.
     init_info.MSAASamples                 = VK_SAMPLE_COUNT_1_BIT;
     init_info.Allocator                   = nullptr;
     init_info.CheckVkResultFn             = nullptr;
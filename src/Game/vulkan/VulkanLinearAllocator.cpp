@@ -0,0 +1,68 @@
+#include "VulkanLinearAllocator.h"
+
+#include "VulkanContext.h"
+
+#include <Engine/Log.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+void VulkanLinearAllocator::init(const std::string& name, uint64_t sizePerFrame, uint32_t frameCount) {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(VulkanContext::getPhycalDevice(), &properties);
+    // Both alignments are powers of two, the largest one satisfies the other.
+    mAlignment = std::max<uint64_t>({1, properties.limits.minUniformBufferOffsetAlignment,
+                                     properties.limits.minStorageBufferOffsetAlignment});
+    assert(mAlignment <= kMaxAlignment);
+
+    mSizePerFrame = (sizePerFrame + mAlignment - 1) & ~(mAlignment - 1);
+    mFrameCount   = frameCount;
+
+    VulkanBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.name              = name;
+    bufferCreateInfo.sizeInByte        = mSizePerFrame * mFrameCount;
+    bufferCreateInfo.usage             = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferCreateInfo.memoryProperty    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    bufferCreateInfo.persistentMapping = true;
+    mBuffer     = VulkanBuffer::Create(bufferCreateInfo);
+    mMappedData = static_cast<uint8_t*>(mBuffer->getMappedData());
+    assert(mMappedData);
+
+    beginFrame(0);
+}
+
+void VulkanLinearAllocator::destroy() {
+    mBuffer.reset();
+    mMappedData = nullptr;
+}
+
+void VulkanLinearAllocator::beginFrame(uint32_t frameIndex) {
+    assert(frameIndex < mFrameCount);
+    mRegionBegin = mSizePerFrame * frameIndex;
+    mHead        = mRegionBegin;
+}
+
+VulkanLinearAllocator::Allocation VulkanLinearAllocator::allocate(uint64_t size) {
+    const uint64_t offset = mHead;
+    const uint64_t end    = offset + size;
+    if (end > mRegionBegin + mSizePerFrame) {
+        ENGINE_CORE_ERROR("VulkanLinearAllocator: frame region full ({} + {} > {} bytes)",
+                          getUsedSize(), size, mSizePerFrame);
+        // The offset 0 of a failed push would alias the data of another allocation.
+        assert(false && "VulkanLinearAllocator: frame region full.");
+        return {};
+    }
+
+    mHead = (end + mAlignment - 1) & ~(mAlignment - 1);
+    return {mMappedData + offset, static_cast<uint32_t>(offset)};
+}
+
+uint32_t VulkanLinearAllocator::push(const void* data, uint64_t size) {
+    const Allocation allocation = allocate(size);
+    if (!allocation.data) {
+        return 0;
+    }
+    std::memcpy(allocation.data, data, size);
+    return allocation.offset;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "VulkanBuffer.h"
+
+#include <cstdint>
+#include <string>
+
+/// @brief Linear allocator for the data rewritten every frame (uniform blocks, small arrays).
+///
+/// The allocator owns a single persistently mapped buffer split in one region per frame in
+/// flight. beginFrame() rewinds the region of the frame slot, allocate() bumps a pointer and
+/// return an offset aligned for a dynamic uniform / storage buffer binding. The descriptors
+/// point to the start of the buffer and the offsets are given to vkCmdBindDescriptorSets,
+/// so writing the data of a frame never touches the region read by the other frames.
+class VulkanLinearAllocator {
+public:
+    struct Allocation {
+        void*    data{nullptr}; ///< Mapped pointer, nullptr if the frame region is full.
+        uint32_t offset{0};     ///< Dynamic offset inside getBuffer().
+    };
+
+    VulkanLinearAllocator() = default;
+    ~VulkanLinearAllocator() = default;
+
+    VulkanLinearAllocator(const VulkanLinearAllocator&) = delete;
+    VulkanLinearAllocator(VulkanLinearAllocator&&) = delete;
+
+    VulkanLinearAllocator& operator=(const VulkanLinearAllocator&) = delete;
+    VulkanLinearAllocator& operator=(VulkanLinearAllocator&&) = delete;
+
+    /// @brief Largest offset alignment allowed by the spec, an allocation is padded by less than that.
+    static constexpr uint64_t kMaxAlignment = 256;
+
+    /// @brief Create the buffer.
+    /// @param name           Debug name of the buffer.
+    /// @param sizePerFrame   Capacity of a frame region in bytes.
+    /// @param frameCount     Number of frames in flight.
+    void init(const std::string& name, uint64_t sizePerFrame, uint32_t frameCount);
+    void destroy();
+
+    /// @brief Rewind the region of the frame slot, the caller must have waited for its fence.
+    void beginFrame(uint32_t frameIndex);
+
+    /// @brief Allocate size bytes in the region of the current frame.
+    ///        Assert when the region is full, the allocation has no data in release builds.
+    [[nodiscard]] Allocation allocate(uint64_t size);
+
+    /// @brief Allocate and copy size bytes, return the dynamic offset of the copy.
+    ///        Assert when the region is full, the copy is dropped in release builds.
+    uint32_t push(const void* data, uint64_t size);
+
+    template <typename T>
+    uint32_t push(const T& data) {
+        return push(&data, sizeof(T));
+    }
+
+    [[nodiscard]] VkBuffer getBuffer() const { return mBuffer->getBuffer(); }
+
+    /// @brief Return the number of bytes allocated in the current frame region.
+    [[nodiscard]] uint64_t getUsedSize() const { return mHead - mRegionBegin; }
+
+private:
+    VulkanBufferPtr mBuffer;
+    uint8_t*        mMappedData{nullptr};
+    uint64_t        mAlignment{1};
+    uint64_t        mSizePerFrame{0};
+    uint32_t        mFrameCount{0};
+    uint64_t        mRegionBegin{0};
+    uint64_t        mHead{0};
+};
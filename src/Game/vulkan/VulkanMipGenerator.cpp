@@ -0,0 +1,266 @@
+#include "VulkanMipGenerator.h"
+
+#include "VulkanContext.h"
+#include "VulkanUtils.h"
+
+#include <Engine/Log.h>
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// Levels written by a dispatch and size of a group, must match mipmap.slang.
+constexpr uint32_t kLevelsPerDispatch = 4;
+constexpr uint32_t kGroupSize         = 8;
+
+constexpr uint32_t kFlagSRGB      = 1;
+constexpr uint32_t kFlagNormalMap = 2;
+
+// Must match PushData in mipmap.slang.
+struct PushData {
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint32_t srcLevel;
+    uint32_t levelCount;
+    uint32_t flags;
+};
+
+VkShaderModule        sShaderModule{VK_NULL_HANDLE};
+VkDescriptorSetLayout sDescriptorSetLayout{VK_NULL_HANDLE};
+VkPipelineLayout      sPipelineLayout{VK_NULL_HANDLE};
+VkPipeline            sPipeline{VK_NULL_HANDLE};
+
+PFN_vkCmdPushDescriptorSetKHR sCmdPushDescriptorSet{nullptr};
+
+std::vector<VulkanMipGenerator::MipGenerateInfo> sPendingInfos;
+std::vector<std::shared_ptr<void>>               sPendingOwners;
+
+std::vector<uint32_t> readSpirv(const std::filesystem::path& path) {
+    std::vector<uint32_t> spirv;
+    std::ifstream         ifs(path.string(), std::ios::binary);
+    if (!ifs) {
+        ENGINE_CORE_ERROR("Fail to open file: {}", path.string());
+        return spirv;
+    }
+    spirv.resize(std::filesystem::file_size(path) / 4);
+    ifs.read((char*)spirv.data(), spirv.size() * 4);
+    return spirv;
+}
+
+VkImageMemoryBarrier2 allLevelsBarrier(const VulkanMipGenerator::MipGenerateInfo& info) {
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                           = info.image;
+    barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = info.mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = 1;
+    return barrier;
+}
+
+void pipelineBarrier(VkCommandBuffer                      cmd,
+                     std::span<const VkMemoryBarrier2>      memoryBarriers,
+                     std::span<const VkImageMemoryBarrier2> imageBarriers) {
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount      = static_cast<uint32_t>(memoryBarriers.size());
+    dependencyInfo.pMemoryBarriers         = memoryBarriers.data();
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+    dependencyInfo.pImageMemoryBarriers    = imageBarriers.data();
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+
+/// @brief Record the dispatch writing the levels srcLevel + 1 to srcLevel + 4 of a texture.
+void dispatch(VkCommandBuffer cmd, const VulkanMipGenerator::MipGenerateInfo& info, uint32_t srcLevel) {
+    const uint32_t levelCount = std::min(kLevelsPerDispatch, info.mipLevels - 1 - srcLevel);
+
+    VkDescriptorImageInfo srcImageInfo{};
+    srcImageInfo.imageView   = info.view;
+    srcImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    // The unused slots repeat the last level, the shader never writes them.
+    VkDescriptorImageInfo dstImageInfos[kLevelsPerDispatch]{};
+    for (uint32_t i = 0; i < kLevelsPerDispatch; ++i) {
+        dstImageInfos[i].imageView   = info.storageViews[srcLevel + 1 + std::min(i, levelCount - 1)];
+        dstImageInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+
+    VkWriteDescriptorSet writes[2]{};
+    writes[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstBinding      = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[0].pImageInfo      = &srcImageInfo;
+    writes[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[1].dstBinding      = 1;
+    writes[1].descriptorCount = kLevelsPerDispatch;
+    writes[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].pImageInfo      = dstImageInfos;
+    sCmdPushDescriptorSet(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, sPipelineLayout, 0, 2, writes);
+
+    PushData pushData{};
+    pushData.srcWidth   = std::max(1u, info.width >> srcLevel);
+    pushData.srcHeight  = std::max(1u, info.height >> srcLevel);
+    pushData.srcLevel   = srcLevel;
+    pushData.levelCount = levelCount;
+    pushData.flags      = (info.sRGB ? kFlagSRGB : 0) |
+                     (info.filter == VulkanMipGenerator::MipFilter::NormalMap ? kFlagNormalMap : 0);
+    vkCmdPushConstants(cmd, sPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushData), &pushData);
+
+    const uint32_t dstWidth  = std::max(1u, pushData.srcWidth >> 1);
+    const uint32_t dstHeight = std::max(1u, pushData.srcHeight >> 1);
+    vkCmdDispatch(cmd, (dstWidth + kGroupSize - 1) / kGroupSize, (dstHeight + kGroupSize - 1) / kGroupSize, 1);
+}
+
+} // namespace
+
+void VulkanMipGenerator::Init() {
+    const VkDevice device = VulkanContext::getDevice();
+
+    sCmdPushDescriptorSet =
+        (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR");
+    assert(sCmdPushDescriptorSet);
+
+    // The descriptors change for each texture, they are pushed into the command buffer.
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding         = 0;
+    bindings[0].descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding         = 1;
+    bindings[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = kLevelsPerDispatch;
+    bindings[1].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo{};
+    setLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutCreateInfo.flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+    setLayoutCreateInfo.bindingCount = 2;
+    setLayoutCreateInfo.pBindings    = bindings;
+    VK_CHECK(vkCreateDescriptorSetLayout(device, &setLayoutCreateInfo, nullptr, &sDescriptorSetLayout));
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset     = 0;
+    pushConstantRange.size       = sizeof(PushData);
+    sPipelineLayout = VulkanContext::createPipelineLayout(1, &sDescriptorSetLayout, 1, &pushConstantRange);
+    VulkanContext::setDebugObjectName((uint64_t)sPipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "MipGeneratorPipelineLayout");
+
+    const std::vector<uint32_t> spirv = readSpirv("./shaders/mipmap_comp.spv");
+    assert(!spirv.empty());
+    const Shader shader = VulkanContext::createShaderModule(spirv);
+    sShaderModule       = shader.shaderModule;
+
+    VkComputePipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.stage  = shader.stageCreateInfo;
+    pipelineCreateInfo.layout = sPipelineLayout;
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &sPipeline));
+    VulkanContext::setDebugObjectName((uint64_t)sPipeline, VK_OBJECT_TYPE_PIPELINE, "MipGenerator");
+}
+
+void VulkanMipGenerator::Shutdown() {
+    const VkDevice device = VulkanContext::getDevice();
+
+    sPendingInfos.clear();
+    sPendingOwners.clear();
+
+    vkDestroyPipeline(device, sPipeline, nullptr);
+    vkDestroyPipelineLayout(device, sPipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, sDescriptorSetLayout, nullptr);
+    vkDestroyShaderModule(device, sShaderModule, nullptr);
+    sPipeline            = VK_NULL_HANDLE;
+    sPipelineLayout      = VK_NULL_HANDLE;
+    sDescriptorSetLayout = VK_NULL_HANDLE;
+    sShaderModule        = VK_NULL_HANDLE;
+}
+
+VkFormat VulkanMipGenerator::getStorageFormat(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_B8G8R8A8_SRGB: return VK_FORMAT_B8G8R8A8_UNORM;
+        default: return format;
+    }
+}
+
+bool VulkanMipGenerator::isSRGB(VkFormat format) { return getStorageFormat(format) != format; }
+
+void VulkanMipGenerator::generate(VkCommandBuffer cmd, std::span<const MipGenerateInfo> infos) {
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+    imageBarriers.reserve(infos.size());
+
+    // All the levels of all the textures move to GENERAL at once, the written level 0 becomes
+    // readable and the other levels writable by the compute shader.
+    uint32_t maxMipLevels = 1;
+    for (const MipGenerateInfo& info : infos) {
+        assert(info.storageViews.size() >= info.mipLevels);
+        VkImageMemoryBarrier2 barrier = allLevelsBarrier(info);
+        barrier.srcStageMask          = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+        barrier.srcAccessMask         = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dstStageMask          = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.dstAccessMask         = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        barrier.oldLayout             = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout             = VK_IMAGE_LAYOUT_GENERAL;
+        imageBarriers.push_back(barrier);
+        maxMipLevels = std::max(maxMipLevels, info.mipLevels);
+    }
+    if (imageBarriers.empty()) {
+        return;
+    }
+
+    VulkanContext::CmdBeginsLabel(cmd, "MipGeneration");
+    pipelineBarrier(cmd, {}, imageBarriers);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, sPipeline);
+
+    // The layouts don't change between the level groups, a global memory barrier makes the
+    // levels written by a group visible to the next one.
+    VkMemoryBarrier2 memoryBarrier{};
+    memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    memoryBarrier.srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    memoryBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    memoryBarrier.dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+
+    for (uint32_t srcLevel = 0; srcLevel + 1 < maxMipLevels; srcLevel += kLevelsPerDispatch) {
+        if (srcLevel > 0) {
+            pipelineBarrier(cmd, {&memoryBarrier, 1}, {});
+        }
+        for (const MipGenerateInfo& info : infos) {
+            if (srcLevel + 1 < info.mipLevels) {
+                dispatch(cmd, info, srcLevel);
+            }
+        }
+    }
+
+    for (VkImageMemoryBarrier2& barrier : imageBarriers) {
+        barrier.srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        barrier.dstStageMask  = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        barrier.oldLayout     = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    pipelineBarrier(cmd, {}, imageBarriers);
+    VulkanContext::CmdEndLabel(cmd);
+}
+
+void VulkanMipGenerator::enqueue(std::shared_ptr<void> owner, const MipGenerateInfo& info) {
+    sPendingInfos.push_back(info);
+    sPendingOwners.push_back(std::move(owner));
+}
+
+void VulkanMipGenerator::record(VkCommandBuffer cmd) {
+    if (sPendingInfos.empty()) {
+        return;
+    }
+    generate(cmd, sPendingInfos);
+    sPendingInfos.clear();
+    sPendingOwners.clear();
+}
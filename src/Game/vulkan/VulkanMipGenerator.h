@@ -0,0 +1,70 @@
+#pragma once
+#include "vulkan.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+/// @brief Generate the mipmaps of 2D textures with a compute shader.
+///
+/// A dispatch writes up to 4 levels from a source level. All the textures given to generate()
+/// are processed together, level group by level group, so the whole batch costs one image
+/// barrier call at the beginning, one memory barrier between the level groups and one image
+/// barrier call at the end, whatever the number of textures.
+///
+/// The sRGB textures are filtered in linear space, the normal maps average the normals and
+/// renormalize them. The generation is recorded into a command buffer of the caller, it must
+/// be executed on a queue supporting compute (the graphic queue).
+///
+/// The upload of a texture queues its generation with enqueue(), the render loop records
+/// all the queued generations with record() right after VulkanUploader::acquire().
+namespace VulkanMipGenerator {
+
+/// @brief How the texels are averaged.
+enum class MipFilter {
+    Color,     ///< Average the colors (in linear space for the sRGB formats).
+    NormalMap, ///< Average the normals stored in [0, 1] and renormalize them.
+};
+
+/// @brief The levels of a texture to generate.
+struct MipGenerateInfo {
+    VkImage                      image{VK_NULL_HANDLE};
+    VkImageView                  view{VK_NULL_HANDLE}; ///< View of all the levels in the texture format.
+    std::span<const VkImageView> storageViews;         ///< One view per level in getStorageFormat(), level 0 is unused.
+    uint32_t                     width{1};
+    uint32_t                     height{1};
+    uint32_t                     mipLevels{1};
+    bool                         sRGB{false};
+    MipFilter                    filter{MipFilter::Color};
+};
+
+/// @brief Load the shader and create the pipeline.
+void Init();
+
+/// @brief Destroy the pipeline, the queued generations are dropped.
+void Shutdown();
+
+/// @brief Return the format of the storage views of a texture, sRGB formats can't be used as storage.
+[[nodiscard]] VkFormat getStorageFormat(VkFormat format);
+
+/// @brief Return true if the format is a sRGB format.
+[[nodiscard]] bool isSRGB(VkFormat format);
+
+/// @brief Record the generation of the levels 1 and more of the textures.
+///
+/// All the levels must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with the level 0 written by a
+/// transfer command. They all end in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+///
+/// @param cmd   The command buffer, bound to a compute capable queue.
+/// @param infos The textures.
+void generate(VkCommandBuffer cmd, std::span<const MipGenerateInfo> infos);
+
+/// @brief Queue the generation of a texture until the next record().
+/// @param owner The object owning the image and the views, kept alive until the generation is recorded.
+/// @param info  The texture.
+void enqueue(std::shared_ptr<void> owner, const MipGenerateInfo& info);
+
+/// @brief Record the queued generations with generate(), do nothing if there is none.
+void record(VkCommandBuffer cmd);
+
+} // namespace VulkanMipGenerator
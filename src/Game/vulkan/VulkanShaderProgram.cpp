@@ -243,6 +243,17 @@ std::shared_ptr<VulkanShaderProgram> VulkanShaderProgram::CreateFromSpirv(
                             break;
                         }
                         case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER: {
+                            auto& set               = setInfo[reflectBinding->set];
+                            auto it = std::find_if(set.vkBinding.begin(), set.vkBinding.end(), [&reflectBinding](const VkDescriptorSetLayoutBinding& b){ return b.binding == reflectBinding->binding; });
+                            if(it == set.vkBinding.end()) {
+                                auto& binding           = set.vkBinding.emplace_back();
+                                binding.binding         = reflectBinding->binding;
+                                binding.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                                binding.descriptorCount = 1;
+                                binding.stageFlags      = shaderStage;
+                            } else {
+                                it->stageFlags |= shaderStage;
+                            }
                             break;
                         }
                         case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: {
@@ -256,14 +267,19 @@ std::shared_ptr<VulkanShaderProgram> VulkanShaderProgram::CreateFromSpirv(
                         }
                         case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER: {
                             auto& set = setInfo[reflectBinding->set];
-                            if (reflectBinding->binding == set.vkBinding.size()) {
-                                set.vkBinding.emplace_back();
+                            auto it = std::find_if(set.vkBinding.begin(), set.vkBinding.end(), [&reflectBinding](const VkDescriptorSetLayoutBinding& b){ return b.binding == reflectBinding->binding; });
+                            if(it == set.vkBinding.end()) {
+                                auto& binding           = set.vkBinding.emplace_back();
+                                binding.binding         = reflectBinding->binding;
+                                // The per frame blocks are sub allocated each frame and bound with a dynamic offset.
+                                binding.descriptorType  = reflectBinding->set == SET_INDEX_PERFRAME
+                                                              ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+                                                              : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                                binding.descriptorCount = 1;
+                                binding.stageFlags      = shaderStage;
+                            } else {
+                                it->stageFlags |= shaderStage;
                             }
-                            auto& binding           = set.vkBinding[reflectBinding->binding];
-                            binding.binding         = reflectBinding->binding;
-                            binding.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                            binding.descriptorCount = 1;
-                            binding.stageFlags |= shaderStage;
                             break;
                         }
                         case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC: {
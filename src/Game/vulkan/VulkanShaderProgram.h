@@ -51,6 +51,14 @@ public:
     [[nodiscard]] bool hasDescriptorBinding(uint32_t setIdx, uint32_t bindingIdx) const;
     [[nodiscard]] bool hasDescriptorSet(uint32_t setIdx) const;
     [[nodiscard]] bool hasPushConstant() const { return mPushConstantRanges.size(); };
+    /// @brief Return the shader stages which access the push constant block.
+    [[nodiscard]] VkShaderStageFlags getPushConstantStages() const {
+        VkShaderStageFlags stages{};
+        for (const auto& range : mPushConstantRanges) {
+            stages |= range.stageFlags;
+        }
+        return stages;
+    }
     [[nodiscard]] bool hasShaderStage(VkShaderStageFlagBits stage) const { return mStages & stage; }
     [[nodiscard]] VkPipelineLayout getPipelineLayout() const { return mPipelineLayout; }
     [[nodiscard]] const std::vector<VkPipelineShaderStageCreateInfo>& getShaderShages() const {
@@ -49,11 +49,11 @@ VulkanSwapchain::~VulkanSwapchain() {
 
 void VulkanSwapchain::resize(uint32_t width, uint32_t height) { build(); }
 
-void VulkanSwapchain::acquireNextImage() noexcept {
-    mImageAvailableSemaphore = mImageAvailableSemaphores[mCurrentSemaphoreIndex];
-    mRenderFinishSemaphor    = mImageAvailableSemaphores[mCurrentSemaphoreIndex];
-    mCurrentSemaphoreIndex   = (mCurrentSemaphoreIndex + 1) % mImageCount;
-    acquireNextImage(mImageAvailableSemaphore, mCurrentBackImageIndex);
+void VulkanSwapchain::acquireNextImage(VkSemaphore signalSemaphore) noexcept {
+    acquireNextImage(signalSemaphore, mCurrentBackImageIndex);
+    // The present semaphore is owned by the image: it is only reused once the image
+    // has been presented and acquired again, which a frame fence cannot guarantee.
+    mRenderFinishSemaphor = mRenderFinishSemaphores[mCurrentBackImageIndex];
 }
 
 void VulkanSwapchain::acquireNextImage(VkSemaphore signalSemaphore, uint32_t& imageIndex) noexcept {
@@ -75,10 +75,19 @@ void VulkanSwapchain::acquireNextImage(VkSemaphore signalSemaphore, uint32_t& im
     acquireNextImageInfoKHR.fence      = nullptr;
     acquireNextImageInfoKHR.deviceMask = 1;
     VkResult result = vkAcquireNextImage2KHR(mDevice, &acquireNextImageInfoKHR, &imageIndex);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-        // TODO: recreate the swapchain
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        // The semaphore is not signaled, rebuild and acquire again.
         spdlog::warn("vkAcquireNextImage2KHR return {}", result);
         build();
+        acquireNextImageInfoKHR.swapchain = mSwapchain;
+        result = vkAcquireNextImage2KHR(mDevice, &acquireNextImageInfoKHR, &imageIndex);
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            spdlog::critical("vkAcquireNextImage2KHR() failed after rebuild : {}", result);
+        }
+    } else if (result == VK_SUBOPTIMAL_KHR) {
+        // The image is acquired and the semaphore will be signaled, it must be used.
+        // The swapchain is rebuilt by the resize event.
+        spdlog::warn("vkAcquireNextImage2KHR return {}", result);
     } else if (result == VK_NOT_READY) {
         // VK_NOT_READY is returned if timeout is zero and no image was available.
         spdlog::warn("vkAcquireNextImage2KHR return {}", result);
@@ -226,10 +235,9 @@ void VulkanSwapchain::build() {
 
     //
     // Create a image view for each swapchain image.
-    // Create the binary semaphores for each swapchain image
+    // Create the present binary semaphore for each swapchain image
     //
     mImageViews.resize(imageCount);
-    mImageAvailableSemaphores.resize(imageCount);
     mRenderFinishSemaphores.resize(imageCount);
     for (uint32_t i = 0; i < imageCount; i++) {
         VkImageViewCreateInfo info{};
@@ -248,8 +256,6 @@ void VulkanSwapchain::build() {
 
         VkSemaphoreCreateInfo semaphoreCreateInfo{};
         semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        VK_CHECK(vkCreateSemaphore(mDevice, &semaphoreCreateInfo, nullptr,
-                                   &mImageAvailableSemaphores[i]));
         VK_CHECK(
             vkCreateSemaphore(mDevice, &semaphoreCreateInfo, nullptr, &mRenderFinishSemaphores[i]));
 
@@ -258,13 +264,8 @@ void VulkanSwapchain::build() {
         nameInfo.pNext;
         nameInfo.objectType = VK_OBJECT_TYPE_SEMAPHORE;
 
-        nameInfo.objectHandle = (uint64_t)mImageAvailableSemaphores[i];
-        auto name             = std::format("swapchain_image_available_{}", i);
-        nameInfo.pObjectName  = name.c_str();
-        //vkSetDebugUtilsObjectNameEXT(mDevice, &nameInfo);
-
         nameInfo.objectHandle = (uint64_t)mRenderFinishSemaphores[i];
-        name                  = std::format("swapchain_image_present_ready{}", i);
+        auto name             = std::format("swapchain_image_present_ready{}", i);
         nameInfo.pObjectName  = name.c_str();
         //vkSetDebugUtilsObjectNameEXT(mDevice, &nameInfo);
     }
@@ -275,8 +276,6 @@ void VulkanSwapchain::build() {
     spdlog::info("\tImage Count:  {}", mImageCount);
     spdlog::info("\tSize:         {}", mSwapchainSize);
     spdlog::info("\tPresent Mode: {}", mPresentMode);
-
-    acquireNextImage();
 }
 
 void VulkanSwapchain::present(VkQueue queue, VkPresentModeKHR presentModes) {
@@ -340,8 +339,6 @@ void VulkanSwapchain::present(VkQueue queue, VkPresentModeKHR presentModes) {
     } else if (result != VK_SUCCESS) {
         spdlog::critical("vkQueuePresentKHR() failed : {}", result);
     }
-
-    acquireNextImage();
 }
 
 VkPresentModeKHR VulkanSwapchain::selectPresentMode() const {
@@ -431,11 +428,9 @@ void VulkanSwapchain::destroyRessources() {
 
     for (unsigned i = 0; i < getBufferCount(); i++) {
         vkDestroyImageView(mDevice, mImageViews[i], nullptr);
-        vkDestroySemaphore(mDevice, mImageAvailableSemaphores[i], nullptr);
         vkDestroySemaphore(mDevice, mRenderFinishSemaphores[i], nullptr);
     }
 
     mImageViews.clear();
-    mImageAvailableSemaphores.clear();
     mRenderFinishSemaphores.clear();
 }
@@ -76,9 +76,10 @@ public:
     [[nodiscard]] const std::vector<VkImageView>& getImageViews() const noexcept {
         return mImageViews;
     }
-    [[nodiscard]] VkSemaphore getImageAvailableSemaphores() const noexcept {
-        return mImageAvailableSemaphore;
-    }
+    /**
+     * @brief Get the semaphore the rendering of the current image must signal before present().
+     * @return The present semaphore of the current back image.
+     */
     [[nodiscard]] VkSemaphore getRenderFinishSemaphores() const noexcept {
         return mRenderFinishSemaphor;
     }
@@ -97,7 +98,12 @@ public:
      */
     [[nodiscard]] VkFormat getFormat() const noexcept { return mSwapchainFormat.format; }
 
-    void acquireNextImage() noexcept;
+    /**
+     * @brief Acquire the next back image, rebuild the swapchain if it is out of date.
+     * @param signalSemaphore Semaphore signaled when the image is ready, owned by the caller
+     *                        frame and waited by its submit.
+     */
+    void acquireNextImage(VkSemaphore signalSemaphore) noexcept;
     void acquireNextImage(VkSemaphore signalSemaphore, uint32_t& imageIndex) noexcept;
 
     [[nodiscard]] uint32_t getCurrentBackImageIndex() const noexcept {
@@ -148,19 +154,12 @@ private:
     /**< The image views corresponding to each swapchain' images.*/
     std::vector<VkImageView> mImageViews{};
 
-    // binary semaphore signaled when swapchain is ready
-    //  - signaling by acquireNextImage
-    //  - waiting   by vkQueueSubmit2
-    std::vector<VkSemaphore> mImageAvailableSemaphores;
-
     // binary semaphore signaled when the rendering is finish
     //  - signaling by vkQueueSubmit2
     //  - waiting   by present
     std::vector<VkSemaphore> mRenderFinishSemaphores;
 
-    VkSemaphore mImageAvailableSemaphore{VK_NULL_HANDLE};
     VkSemaphore mRenderFinishSemaphor{VK_NULL_HANDLE};
-    uint32_t    mCurrentSemaphoreIndex{};
 
     uint32_t mCurrentBackImageIndex{};
 };
@@ -2,67 +2,139 @@
 
 #include "VulkanBuffer.h"
 #include "VulkanContext.h"
+#include "VulkanMipGenerator.h"
+#include "VulkanUploader.h"
 #include "VulkanUtils.h"
 
-#include <Engine/Log.h>
+#include "../ImageDecoder.h"
+#include "../Ktx2File.h"
+#include "../TextureCompression.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb/stb_image.h>
+#include <Engine/Log.h>
 
 namespace {
 
-/// @brief
-/// @param cmd
-/// @param buffer
-/// @param image
-/// @param width
-/// @param height
-void copyBufferToImage(
-    VkCommandBuffer cmd, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-    VulkanUtils::transitionImageLayout(
-        cmd, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-        VK_ACCESS_2_TRANSFER_WRITE_BIT, 1);
-
-    VulkanContext::copyBufferToImage(cmd, buffer, image, width, height);
-
-    VulkanUtils::transitionImageLayout(
-        cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, 1);
+/// @brief Create the trilinear anisotropic sampler of the textures loaded from files.
+VkSampler createTextureSampler(uint32_t mipLevels) {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(VulkanContext::getPhycalDevice(), &properties);
+
+    VkSamplerCreateInfo samplerCreateInfo{};
+    samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    // Magnification concerns the oversampling
+    samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+    // minification concerns undersampling
+    samplerCreateInfo.minFilter               = VK_FILTER_LINEAR;
+    samplerCreateInfo.mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerCreateInfo.addressModeU            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.addressModeV            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.addressModeW            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.mipLodBias              = 0.0f;
+    samplerCreateInfo.anisotropyEnable        = VK_TRUE;
+    samplerCreateInfo.maxAnisotropy           = properties.limits.maxSamplerAnisotropy;
+    samplerCreateInfo.compareEnable           = VK_FALSE;
+    samplerCreateInfo.compareOp               = VK_COMPARE_OP_ALWAYS;
+    samplerCreateInfo.minLod                  = 0;
+    samplerCreateInfo.maxLod                  = static_cast<float>(mipLevels);
+    samplerCreateInfo.borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+
+    VkSampler sampler{VK_NULL_HANDLE};
+    VK_CHECK(vkCreateSampler(VulkanContext::getDevice(), &samplerCreateInfo, nullptr, &sampler));
+    return sampler;
 }
 
-void copyBufferToImage2(VkCommandBuffer commandBuffer,
-                        VkBuffer        buffer,
-                        VkImage         image,
-                        uint32_t        width,
-                        uint32_t        height,
-                        uint32_t        layer) {
-    VkBufferImageCopy region{};
-    region.bufferOffset                    = 0;
-    region.bufferRowLength                 = 0;
-    region.bufferImageHeight               = 0;
-    region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel       = 0;
-    region.imageSubresource.baseArrayLayer = layer;
-    region.imageSubresource.layerCount     = 1;
-    region.imageOffset                     = {0, 0, 0};
-    region.imageExtent                     = {width, height, 1};
-
-    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
-                           &region);
+/// @brief Return the cooked file of a texture, "data/a/b.png" is cooked to "cooked/a/b.ktx2".
+///        Return an empty path if the texture is not in a data directory.
+std::filesystem::path getCookedPath(const std::filesystem::path& path) {
+    std::filesystem::path cookedPath;
+    bool                  inData = false;
+    for (const std::filesystem::path& part : path) {
+        if (!inData) {
+            cookedPath /= part == "data" ? std::filesystem::path("cooked") : part;
+            inData = part == "data";
+        } else {
+            cookedPath /= part;
+        }
+    }
+    if (!inData) {
+        return {};
+    }
+    return cookedPath.replace_extension(".ktx2");
+}
+
+/// @brief Read the cooked file of a texture if it exists and is newer than the texture.
+bool readCookedTexture(const std::filesystem::path& path, Ktx2::Texture& texture) {
+    const std::filesystem::path cookedPath = getCookedPath(path);
+    std::error_code             error;
+    if (cookedPath.empty() || !std::filesystem::exists(cookedPath, error)) {
+        return false;
+    }
+    const auto sourceTime = std::filesystem::last_write_time(path, error);
+    if (!error && std::filesystem::last_write_time(cookedPath, error) < sourceTime) {
+        ENGINE_WARNING("{} is older than {}, the texture is decoded", cookedPath.string(), path.string());
+        return false;
+    }
+    return Ktx2::read(cookedPath, texture);
 }
 
 } // namespace
 
-VulkanTexturePtr VulkanTexture::Create(std::filesystem::path path, bool sRGB, bool generateMipmap) {
+VulkanTexturePtr VulkanTexture::Create(std::filesystem::path path,
+                                       bool                  sRGB,
+                                       bool                  generateMipmap,
+                                       bool                  normalMap) {
+    Ktx2::Texture cooked;
+    if (generateMipmap && readCookedTexture(path, cooked)) {
+        return CreateFromKtx2(cooked, path, sRGB);
+    }
+    const DecodedImage image = ImageDecoder::decode(path);
+    return CreateFromImage(image, path, sRGB, generateMipmap, normalMap);
+}
+
+std::vector<VulkanTexturePtr> VulkanTexture::CreateBatch(std::span<const VulkanTextureLoadInfo> loadInfos,
+                                                         Engine::ThreadPool&                    threadPool) {
+    std::vector<VulkanTexturePtr> textures(loadInfos.size());
+
+    // The cooked textures need no decoding, they are copied as is. The other files are decoded.
+    std::vector<std::filesystem::path> paths;
+    std::vector<uint32_t>              decodedIndices;
+    for (uint32_t index = 0; index < loadInfos.size(); ++index) {
+        const VulkanTextureLoadInfo& loadInfo = loadInfos[index];
+        Ktx2::Texture                cooked;
+        if (loadInfo.generateMipmap && readCookedTexture(loadInfo.path, cooked)) {
+            textures[index] = CreateFromKtx2(cooked, loadInfo.path, loadInfo.sRGB);
+        }
+        if (!textures[index]) {
+            paths.push_back(loadInfo.path);
+            decodedIndices.push_back(index);
+        }
+    }
+
+    // The textures are created and their copies queued as soon as each file is decoded,
+    // the image memory is released right after being copied into the staging ring.
+    ImageDecoder::decodeBatch(paths, threadPool, [&](uint32_t decodedIndex, DecodedImage& image) {
+        const uint32_t               index    = decodedIndices[decodedIndex];
+        const VulkanTextureLoadInfo& loadInfo = loadInfos[index];
+        textures[index] =
+            CreateFromImage(image, loadInfo.path, loadInfo.sRGB, loadInfo.generateMipmap, loadInfo.normalMap);
+        image.pixels.reset();
+    });
+    return textures;
+}
+
+VulkanTexturePtr VulkanTexture::CreateFromImage(const DecodedImage&          image,
+                                                const std::filesystem::path& path,
+                                                bool                         sRGB,
+                                                bool                         generateMipmap,
+                                                bool                         normalMap) {
     VulkanTexturePtr texture;
 
     const std::string pathString = path.string();
 
-    int   width, height, channels;
-    auto* data = stbi_load(pathString.c_str(), &width, &height, &channels, 4);
-    if (data) {
+    const int width  = static_cast<int>(image.width);
+    const int height = static_cast<int>(image.height);
+    if (image.isValid()) {
         ENGINE_INFO("Loading {}", pathString);
 
         //
@@ -73,9 +145,6 @@ VulkanTexturePtr VulkanTexture::Create(std::filesystem::path path, bool sRGB, bo
         // VkImageUsageFlags usage     = VK_IMAGE_USAGE_TRANSFER_DST_BIT |
         // VK_IMAGE_USAGE_SAMPLED_BIT;
         if (generateMipmap) {
-            // This is required to allow generating mipmap with vkCmdBlitImage.
-            // vkCmdBlitImage is a transfert operation.
-            // usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
             mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
         }
         VulkanTexture2DCreateInfo createInfo{};
@@ -87,170 +156,101 @@ VulkanTexturePtr VulkanTexture::Create(std::filesystem::path path, bool sRGB, bo
         texture           = std::make_shared<VulkanTexture>(createInfo);
         texture->mPath    = path;
 
-        VkPhysicalDeviceProperties properties{};
-        vkGetPhysicalDeviceProperties(VulkanContext::getPhycalDevice(), &properties);
-
-        VkSamplerCreateInfo samplerCreateInfo{};
-        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-        samplerCreateInfo.pNext;
-        samplerCreateInfo.flags;
-        // Magnification concerns the oversampling
-        samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
-        // minification concerns undersampling
-        samplerCreateInfo.minFilter               = VK_FILTER_LINEAR;
-        samplerCreateInfo.mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        samplerCreateInfo.addressModeU            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerCreateInfo.addressModeV            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerCreateInfo.addressModeW            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerCreateInfo.mipLodBias              = 0.0f;
-        samplerCreateInfo.anisotropyEnable        = VK_TRUE;
-        samplerCreateInfo.maxAnisotropy           = properties.limits.maxSamplerAnisotropy;
-        samplerCreateInfo.compareEnable           = VK_FALSE;
-        samplerCreateInfo.compareOp               = VK_COMPARE_OP_ALWAYS;
-        samplerCreateInfo.minLod                  = 0;
-        samplerCreateInfo.maxLod                  = mipLevels;
-        samplerCreateInfo.borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-        samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
-        VK_CHECK(vkCreateSampler(VulkanContext::getDevice(), &samplerCreateInfo, nullptr,
-                                 &texture->mSampler));
-
-        //
-        // create staging buffer
-        //
-        VkDeviceSize imageSize     = width * height * 4;
-        auto         stagingBuffer = VulkanBuffer::CreateStagingBuffer(imageSize, "Staging");
-        stagingBuffer->writeData(data, imageSize);
-
-        stbi_image_free(data);
+        texture->mSampler = createTextureSampler(mipLevels);
 
         //
-        // Copy the staging buffer into the texture
+        // Upload the level 0 on the transfer queue, the mipmaps are generated by the graphic queue.
         //
-        VkCommandBuffer cmd = VulkanContext::beginSingleTimeCommands();
+        const void*                     layers[] = {image.pixels.get()};
+        VulkanUploader::ImageUploadInfo uploadInfo{};
+        uploadInfo.image     = texture->mImage;
+        uploadInfo.width     = texture->mWidth;
+        uploadInfo.height    = texture->mHeight;
+        uploadInfo.mipLevels = mipLevels;
+        uploadInfo.layerSize = static_cast<uint64_t>(width) * height * 4;
+        uploadInfo.layers    = layers;
+        if (mipLevels > 1) {
+            uploadInfo.onGraphicQueue = GenerateMipmapsWork(
+                texture, normalMap ? VulkanMipGenerator::MipFilter::NormalMap : VulkanMipGenerator::MipFilter::Color);
+        }
+        texture->mUploadHandle = VulkanUploader::uploadImage(texture, uploadInfo);
 
-        VulkanUtils::transitionImageLayout(
-            cmd, texture->mImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-            VK_ACCESS_2_TRANSFER_WRITE_BIT, mipLevels);
+        return texture;
+    }
 
-        VulkanContext::copyBufferToImage(cmd, stagingBuffer->getBuffer(), texture->mImage,
-                                         texture->mWidth, texture->mHeight);
+    return texture;
+}
 
-        // Generate mipmap
-        if (generateMipmap) {
-            VkImageMemoryBarrier barrier{};
-            barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-            barrier.image                           = texture->mImage;
-            barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-            barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-            barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-            barrier.subresourceRange.baseArrayLayer = 0;
-            barrier.subresourceRange.layerCount     = 1;
-            barrier.subresourceRange.levelCount     = 1;
-
-            int32_t mipWidth  = texture->mWidth;
-            int32_t mipHeight = texture->mHeight;
-            for (uint32_t i = 1; i < mipLevels; i++) {
-                barrier.subresourceRange.baseMipLevel = i - 1;
-                barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                barrier.newLayout                     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-                barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
-                barrier.dstAccessMask                 = VK_ACCESS_TRANSFER_READ_BIT;
-
-                vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                     VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                                     &barrier);
-
-                VkImageBlit blit{};
-                blit.srcOffsets[0]                 = {0, 0, 0};
-                blit.srcOffsets[1]                 = {mipWidth, mipHeight, 1};
-                blit.srcSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-                blit.srcSubresource.mipLevel       = i - 1;
-                blit.srcSubresource.baseArrayLayer = 0;
-                blit.srcSubresource.layerCount     = 1;
-                blit.dstOffsets[0]                 = {0, 0, 0};
-                blit.dstOffsets[1]                 = {mipWidth > 1 ? mipWidth / 2 : 1,
-                                      mipHeight > 1 ? mipHeight / 2 : 1, 1};
-                blit.dstSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-                blit.dstSubresource.mipLevel       = i;
-                blit.dstSubresource.baseArrayLayer = 0;
-                blit.dstSubresource.layerCount     = 1;
-
-                vkCmdBlitImage(cmd, texture->mImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                               texture->mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
-                               VK_FILTER_LINEAR);
-
-                barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-                barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
-                                     nullptr, 1, &barrier);
-
-                if (mipWidth > 1) mipWidth /= 2;
-                if (mipHeight > 1) mipHeight /= 2;
-            }
-
-            barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-            barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            barrier.newLayout                     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask                 = VK_ACCESS_SHADER_READ_BIT;
-
-            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
-                                 1, &barrier);
+VulkanTexturePtr VulkanTexture::CreateFromKtx2(const Ktx2::Texture&         cooked,
+                                               const std::filesystem::path& path,
+                                               bool                         sRGB) {
+    // The sRGB and UNORM variants of a block format share the same data, the one requested
+    // by the caller wins over the one chosen by the cooker.
+    TextureCompression::BlockFormat blockFormat;
+    bool                            cookedSRGB;
+    if (!TextureCompression::getBlockFormat(cooked.vkFormat, blockFormat, cookedSRGB)) {
+        return nullptr;
+    }
+    ENGINE_INFO("Loading {} (cooked)", path.string());
 
-        } else {
-            VulkanUtils::transitionImageLayout(
-                cmd, texture->mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
-                VK_ACCESS_2_SHADER_READ_BIT, mipLevels);
-        }
+    const auto mipLevels = static_cast<uint32_t>(cooked.levels.size());
 
-        VulkanContext::endSingleTimeCommands(cmd);
+    VulkanTexture2DCreateInfo createInfo{};
+    createInfo.name           = path.string();
+    createInfo.width          = cooked.width;
+    createInfo.height         = cooked.height;
+    createInfo.format         = static_cast<VkFormat>(TextureCompression::getVkFormat(blockFormat, sRGB));
+    createInfo.mipmap         = mipLevels;
+    createInfo.generateMipmap = false;
+    auto texture              = std::make_shared<VulkanTexture>(createInfo);
+    texture->mPath            = path;
+    texture->mSampler         = createTextureSampler(mipLevels);
 
-        return texture;
+    //
+    // Upload all the levels on the transfer queue, nothing left to do on the graphic queue.
+    //
+    std::vector<VulkanUploader::ImageLevelData> levels;
+    for (std::span<const uint8_t> level : cooked.levels) {
+        levels.push_back({level.data(), level.size()});
     }
+    VulkanUploader::ImageUploadInfo uploadInfo{};
+    uploadInfo.image       = texture->mImage;
+    uploadInfo.width       = texture->mWidth;
+    uploadInfo.height      = texture->mHeight;
+    uploadInfo.mipLevels   = mipLevels;
+    uploadInfo.levels      = levels;
+    texture->mUploadHandle = VulkanUploader::uploadImage(texture, uploadInfo);
 
-    ENGINE_ERROR("Failed to load {}", pathString);
     return texture;
 }
 
-VulkanTexturePtr VulkanTexture::CreateCubeMap(std::filesystem::path paths[6], bool sRGB) {
+VulkanTexturePtr VulkanTexture::CreateCubeMap(std::filesystem::path paths[6],
+                                             bool                  sRGB,
+                                             Engine::ThreadPool*   threadPool) {
     VulkanTexturePtr vulkanTexture;
 
-    bool imageAreValide = true;
+    DecodedImage faces[6];
+    if (threadPool) {
+        ImageDecoder::decodeBatch(std::span(paths, 6), *threadPool,
+                                  [&faces](uint32_t index, DecodedImage& image) { faces[index] = std::move(image); });
+    } else {
+        for (unsigned i = 0; i < 6; i++) {
+            faces[i] = ImageDecoder::decode(paths[i]);
+        }
+    }
 
-    int width      = 0;
-    int height     = 0;
-    int nbChannels = 0;
+    bool imageAreValide = true;
     for (unsigned i = 0; i < 6; i++) {
-        const std::string path = paths[i].string();
-        if (!stbi_info(path.c_str(), &width, &height, &nbChannels)) {
-            ENGINE_ERROR("Failed to query image info fo {}, reason {}", path,
-                         stbi_failure_reason());
+        if (!faces[i].isValid() || faces[i].width != faces[0].width || faces[i].height != faces[0].height) {
+            ENGINE_ERROR("Invalid cube map face {}", paths[i].string());
             imageAreValide = false;
         }
     }
 
-    stbi_uc* data[6] = {};
     if (imageAreValide) {
-        for (unsigned i = 0; i < 6; i++) {
-            const std::string path = paths[i].string();
-            data[i]                = stbi_load(path.c_str(), &width, &height, &nbChannels, 4);
-            if (!data[i]) {
-                ENGINE_ERROR("Failed to query image info fo {}, reason {}", path,
-                             stbi_failure_reason());
-                imageAreValide = false;
-            }
-        }
-    }
+        const uint32_t width  = faces[0].width;
+        const uint32_t height = faces[0].height;
 
-    if (imageAreValide) {
         //
         // Create the cube map
         //
@@ -260,30 +260,15 @@ VulkanTexturePtr VulkanTexture::CreateCubeMap(std::filesystem::path paths[6], bo
         cubeMapCreateInfo.format = sRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
         vulkanTexture            = VulkanTexture::CreateCubeMap(cubeMapCreateInfo);
 
-        VkCommandBuffer cmd = VulkanContext::beginSingleTimeCommands();
-        VulkanUtils::transitionImageLayout(cmd, vulkanTexture->mImage, VK_IMAGE_LAYOUT_UNDEFINED,
-                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                           VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR,
-                                           VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                                           VK_ACCESS_2_TRANSFER_WRITE_BIT, 1, 6);
-
-        VulkanBufferPtr    stagingBuffers[6];
-        const VkDeviceSize imageSize = width * height * 4;
-        for (unsigned i = 0; i < 6; i++) {
-            stagingBuffers[i] = VulkanBuffer::CreateStagingBuffer(imageSize, "Staging");
-            stagingBuffers[i]->writeData(data[i], imageSize);
-
-            copyBufferToImage2(cmd, stagingBuffers[i]->getBuffer(), vulkanTexture->mImage, width,
-                               height, i);
-        }
-
-        VulkanUtils::transitionImageLayout(
-            cmd, vulkanTexture->mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-            VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
-            VK_ACCESS_2_SHADER_READ_BIT, 1, 6);
-
-        VulkanContext::endSingleTimeCommands(cmd);
+        const void* layers[6] = {faces[0].pixels.get(), faces[1].pixels.get(), faces[2].pixels.get(),
+                                 faces[3].pixels.get(), faces[4].pixels.get(), faces[5].pixels.get()};
+        VulkanUploader::ImageUploadInfo uploadInfo{};
+        uploadInfo.image     = vulkanTexture->mImage;
+        uploadInfo.width     = width;
+        uploadInfo.height    = height;
+        uploadInfo.layerSize = static_cast<uint64_t>(width) * height * 4;
+        uploadInfo.layers    = layers;
+        vulkanTexture->mUploadHandle = VulkanUploader::uploadImage(vulkanTexture, uploadInfo);
 
         VkSamplerCreateInfo samplerCreateInfo{};
         samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -308,13 +293,6 @@ VulkanTexturePtr VulkanTexture::CreateCubeMap(std::filesystem::path paths[6], bo
                                  &vulkanTexture->mSampler));
     }
 
-    // clean up
-    for (unsigned i = 0; i < 6; i++) {
-        if (data[i]) {
-            stbi_image_free(data[i]);
-        }
-    }
-
     return vulkanTexture;
 }
 
@@ -328,28 +306,47 @@ VulkanTexturePtr VulkanTexture::Create(const VulkanTexture2DCreateInfo& createIn
     VulkanTexturePtr texture = std::make_shared<VulkanTexture>(createInfo);
 
     if (data) {
-        //
-        // create staging buffer
-        //
         VkDeviceSize imageSize = createInfo.width * createInfo.height;
         if(createInfo.format == VK_FORMAT_R8G8B8A8_UNORM || createInfo.format == VK_FORMAT_R32_SFLOAT)
             imageSize *= 4; // FIXME: Assume RGBA format.
 
-        auto stagingBuffer = VulkanBuffer::CreateStagingBuffer(imageSize, "Staging");
-        stagingBuffer->writeData(data, imageSize);
-
-        //
-        // Copy staging buffer into the image
-        //
-        VkCommandBuffer cmd = VulkanContext::beginSingleTimeCommands();
-        copyBufferToImage(cmd, stagingBuffer->getBuffer(), texture->mImage, texture->mWidth,
-                          texture->mHeight);
-        VulkanContext::endSingleTimeCommands(cmd);
+        const void*                     layers[] = {data};
+        VulkanUploader::ImageUploadInfo uploadInfo{};
+        uploadInfo.image     = texture->mImage;
+        uploadInfo.width     = texture->mWidth;
+        uploadInfo.height    = texture->mHeight;
+        uploadInfo.mipLevels = createInfo.mipmap;
+        uploadInfo.layerSize = imageSize;
+        uploadInfo.layers    = layers;
+        if (createInfo.mipmap > 1 && createInfo.generateMipmap) {
+            uploadInfo.onGraphicQueue = GenerateMipmapsWork(texture, VulkanMipGenerator::MipFilter::Color);
+        }
+        texture->mUploadHandle = VulkanUploader::uploadImage(texture, uploadInfo);
     }
 
     return texture;
 }
 
+std::function<void(VkCommandBuffer)> VulkanTexture::GenerateMipmapsWork(const VulkanTexturePtr&      texture,
+                                                                       VulkanMipGenerator::MipFilter filter) {
+    VulkanMipGenerator::MipGenerateInfo info{};
+    info.image        = texture->mImage;
+    info.view         = texture->mView;
+    info.storageViews = texture->mMipStorageViews;
+    info.width        = texture->mWidth;
+    info.height       = texture->mHeight;
+    info.mipLevels    = texture->mMipLevels;
+    info.sRGB         = VulkanMipGenerator::isSRGB(texture->mFormat);
+    info.filter       = filter;
+
+    // Queued after the acquire, all the textures of the frame are generated together.
+    return [weakTexture = std::weak_ptr<VulkanTexture>(texture), info](VkCommandBuffer) {
+        if (VulkanTexturePtr texture = weakTexture.lock()) {
+            VulkanMipGenerator::enqueue(std::move(texture), info);
+        }
+    };
+}
+
 VulkanTexturePtr VulkanTexture::CreateDepthBuffer(uint32_t width, uint32_t height) {
     VulkanTextureDepthCreateInfo createInfo{};
     createInfo.name   = "DepthBuffer";
@@ -473,23 +470,41 @@ VulkanTexture::~VulkanTexture() {
     ENGINE_CORE_TRACE("Deleting texture: {}", mPath.string());
     vmaDestroyImage(VulkanContext::getVmaAllocator(), mImage, mAllocation);
     vkDestroyImageView(VulkanContext::getDevice(), mView, nullptr);
+    vkDestroyImageView(VulkanContext::getDevice(), mDepthView, nullptr);
+    for (VkImageView mipStorageView : mMipStorageViews) {
+        vkDestroyImageView(VulkanContext::getDevice(), mipStorageView, nullptr);
+    }
     vkDestroySampler(VulkanContext::getDevice(), mSampler, nullptr);
 }
 
 VulkanTexture::VulkanTexture(const VulkanTexture2DCreateInfo& createInfo)
-    : mWidth(createInfo.width), mHeight(createInfo.height) {
+    : mWidth(createInfo.width), mHeight(createInfo.height), mMipLevels(createInfo.mipmap), mFormat(createInfo.format) {
     const VkSampleCountFlagBits nbSamples = VK_SAMPLE_COUNT_1_BIT;
     const VkExtent3D            extent    = {createInfo.width, createInfo.height, 1};
-    const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
-                                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    VkImageUsageFlags           usage     = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    // The mipmaps are written by a compute shader through storage views. The sRGB formats
+    // don't support storage, the storage views use the matching UNORM format and the
+    // sampled view is restricted to sampling.
+    const VkFormat storageFormat = VulkanMipGenerator::getStorageFormat(createInfo.format);
+    const VkFormat viewFormats[] = {createInfo.format, storageFormat};
+    VkImageFormatListCreateInfo formatListCreateInfo{};
+    formatListCreateInfo.sType           = VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO;
+    formatListCreateInfo.viewFormatCount = 2;
+    formatListCreateInfo.pViewFormats    = viewFormats;
+    const bool generateMipmap = createInfo.mipmap > 1 && createInfo.generateMipmap;
+    const bool mutableFormat  = generateMipmap && storageFormat != createInfo.format;
+    if (generateMipmap) {
+        usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
 
     //
     // Create the image
     //
     VkImageCreateInfo imageCreateInfo{};
     imageCreateInfo.sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageCreateInfo.pNext                 = nullptr;
-    imageCreateInfo.flags                 = 0;
+    imageCreateInfo.pNext                 = mutableFormat ? &formatListCreateInfo : nullptr;
+    imageCreateInfo.flags                 = mutableFormat ? VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT : 0;
     imageCreateInfo.imageType             = VK_IMAGE_TYPE_2D;
     imageCreateInfo.format                = createInfo.format;
     imageCreateInfo.extent                = extent;
@@ -518,9 +533,13 @@ VulkanTexture::VulkanTexture(const VulkanTexture2DCreateInfo& createInfo)
     //
     // Create the image view
     //
+    VkImageViewUsageCreateInfo viewUsageCreateInfo{};
+    viewUsageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+    viewUsageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+
     VkImageViewCreateInfo ivCreateInfo           = {};
     ivCreateInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    ivCreateInfo.pNext                           = nullptr;
+    ivCreateInfo.pNext                           = mutableFormat ? &viewUsageCreateInfo : nullptr;
     ivCreateInfo.flags                           = 0;
     ivCreateInfo.image                           = mImage;
     ivCreateInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
@@ -541,6 +560,18 @@ VulkanTexture::VulkanTexture(const VulkanTexture2DCreateInfo& createInfo)
     VulkanContext::setDebugObjectName((uint64_t)mView, VK_OBJECT_TYPE_IMAGE_VIEW,
                                       createInfo.name.c_str());
 
+    // One storage view per generated level.
+    if (generateMipmap) {
+        mMipStorageViews.resize(createInfo.mipmap, VK_NULL_HANDLE);
+        ivCreateInfo.pNext                       = nullptr;
+        ivCreateInfo.format                      = storageFormat;
+        ivCreateInfo.subresourceRange.levelCount = 1;
+        for (uint32_t level = 1; level < createInfo.mipmap; ++level) {
+            ivCreateInfo.subresourceRange.baseMipLevel = level;
+            VK_CHECK(vkCreateImageView(VulkanContext::getDevice(), &ivCreateInfo, nullptr, &mMipStorageViews[level]));
+        }
+    }
+
     VkSamplerCreateInfo samplerCreateInfo{};
     samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
     samplerCreateInfo.pNext;
@@ -565,7 +596,7 @@ VulkanTexture::VulkanTexture(const VulkanTexture2DCreateInfo& createInfo)
 }
 
 VulkanTexture::VulkanTexture(const VulkanTextureCubeMapCreateInfo& createInfo)
-    : mWidth(createInfo.width), mHeight(createInfo.height) {
+    : mWidth(createInfo.width), mHeight(createInfo.height), mFormat(createInfo.format) {
     const VkSampleCountFlagBits nbSamples = VK_SAMPLE_COUNT_1_BIT;
     const VkExtent3D            extent    = {createInfo.width, createInfo.height, 1};
     const uint32_t              mipLevels = 1;
@@ -632,12 +663,13 @@ VulkanTexture::VulkanTexture(const VulkanTextureCubeMapCreateInfo& createInfo)
 }
 
 VulkanTexture::VulkanTexture(const VulkanTextureDepthCreateInfo& createInfo)
-    : mWidth(createInfo.width), mHeight(createInfo.height) {
+    : mWidth(createInfo.width), mHeight(createInfo.height), mFormat(VK_FORMAT_D24_UNORM_S8_UINT) {
     const VkSampleCountFlagBits nbSamples = VK_SAMPLE_COUNT_1_BIT;
     const VkExtent3D            extent    = {createInfo.width, createInfo.height, 1};
+    // Sampled by the build of the Hi-Z pyramid of the occlusion culling.
     const VkImageUsageFlags     usage     = VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                                     VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
-                                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
     //
     // Create the image
@@ -647,7 +679,7 @@ VulkanTexture::VulkanTexture(const VulkanTextureDepthCreateInfo& createInfo)
     imageCreateInfo.pNext                 = nullptr;
     imageCreateInfo.flags                 = 0;
     imageCreateInfo.imageType             = VK_IMAGE_TYPE_2D;
-    imageCreateInfo.format                = VK_FORMAT_D24_UNORM_S8_UINT;
+    imageCreateInfo.format                = mFormat;
     imageCreateInfo.extent                = extent;
     imageCreateInfo.mipLevels             = 1;
     imageCreateInfo.arrayLayers           = 1;
@@ -680,7 +712,7 @@ VulkanTexture::VulkanTexture(const VulkanTextureDepthCreateInfo& createInfo)
     ivCreateInfo.flags                 = 0;
     ivCreateInfo.image                 = mImage;
     ivCreateInfo.viewType              = VK_IMAGE_VIEW_TYPE_2D;
-    ivCreateInfo.format                = VK_FORMAT_D24_UNORM_S8_UINT;
+    ivCreateInfo.format                = mFormat;
     ivCreateInfo.components.r          = VK_COMPONENT_SWIZZLE_IDENTITY;
     ivCreateInfo.components.g          = VK_COMPONENT_SWIZZLE_IDENTITY;
     ivCreateInfo.components.b          = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -693,6 +725,10 @@ VulkanTexture::VulkanTexture(const VulkanTextureDepthCreateInfo& createInfo)
     ivCreateInfo.subresourceRange.layerCount     = 1;
     VK_CHECK(vkCreateImageView(VulkanContext::getDevice(), &ivCreateInfo, nullptr, &mView));
 
+    // A sampled view can only have one aspect.
+    ivCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    VK_CHECK(vkCreateImageView(VulkanContext::getDevice(), &ivCreateInfo, nullptr, &mDepthView));
+
     VulkanContext::setDebugObjectName((uint64_t)mImage, VK_OBJECT_TYPE_IMAGE,
                                       createInfo.name.c_str());
     VulkanContext::setDebugObjectName((uint64_t)mView, VK_OBJECT_TYPE_IMAGE_VIEW,
@@ -1,12 +1,33 @@
 #pragma once
 #include "vulkan.h"
+#include "VulkanMipGenerator.h"
+#include "VulkanUploader.h"
 
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <span>
+#include <vector>
+
+namespace Engine {
+class ThreadPool;
+}
+struct DecodedImage;
+namespace Ktx2 {
+struct Texture;
+}
 
 class VulkanTexture;
 using VulkanTexturePtr = std::shared_ptr<VulkanTexture>;
 
+/// @brief A texture file to load with VulkanTexture::CreateBatch().
+struct VulkanTextureLoadInfo {
+    std::filesystem::path path;
+    bool                  sRGB           = true;
+    bool                  generateMipmap = true;
+    bool                  normalMap      = false; ///< Renormalize the mipmaps.
+};
+
 /// @brief
 struct VulkanTextureCubeMapCreateInfo {
     std::string name;
@@ -22,6 +43,8 @@ struct VulkanTexture2DCreateInfo {
     uint32_t    height = 1;
     uint32_t    mipmap = 1;
     VkFormat    format = VK_FORMAT_R8G8B8_UNORM;
+    /// The levels 1 and more are generated on the GPU, false when they are uploaded.
+    bool        generateMipmap = true;
 };
 
 struct VulkanTextureDepthCreateInfo {
@@ -34,20 +57,41 @@ struct VulkanTextureDepthCreateInfo {
 class VulkanTexture {
 public:
     /// @brief Create a Vulkan texture from a file.
+    ///
+    /// If the texture was cooked (see TextureCooker) and the cooked file is up to date, the
+    /// block compressed levels are uploaded as is, otherwise the file is decoded.
+    ///
     /// @param path           The path of the file.
     /// @param sRGB           Should the texture use sRGB format.
     /// @param generateMipmap Should all mipmap been generated.
+    /// @param normalMap      The texture is a normal map, the mipmaps are renormalized.
     /// @return The Vulkan texture.
     static VulkanTexturePtr Create(std::filesystem::path path,
                                    bool                  sRGB           = true,
-                                   bool                  generateMipmap = true);
+                                   bool                  generateMipmap = true,
+                                   bool                  normalMap      = false);
+
+    /// @brief Create many Vulkan textures from files.
+    ///
+    /// The cooked textures are uploaded first, the other files are decoded in parallel on the
+    /// thread pool, each texture is created and its upload queued on the calling thread as soon
+    /// as its file is decoded.
+    ///
+    /// @param loadInfos  The files to load.
+    /// @param threadPool The workers decoding the files.
+    /// @return The Vulkan textures, in the order of loadInfos, null if the file failed to load.
+    static std::vector<VulkanTexturePtr> CreateBatch(std::span<const VulkanTextureLoadInfo> loadInfos,
+                                                     Engine::ThreadPool&                    threadPool);
 
     /// @brief Create a cube map from 6 images files.
     ///        All image must be the same size.
-    /// @param paths Array of 6 paths.
-    /// @param sRGB Indicate if the cubemap will use sRGB color.
+    /// @param paths      Array of 6 paths.
+    /// @param sRGB       Indicate if the cubemap will use sRGB color.
+    /// @param threadPool If not null, the faces are decoded in parallel on it.
     /// @return The Vulkan texture.
-    static VulkanTexturePtr CreateCubeMap(std::filesystem::path paths[6], bool sRGB = true);
+    static VulkanTexturePtr CreateCubeMap(std::filesystem::path paths[6],
+                                          bool                  sRGB       = true,
+                                          Engine::ThreadPool*   threadPool = nullptr);
 
     /// @brief Create a cube map texture.
     /// @param createInfo Texture creation paramater.
@@ -55,6 +99,7 @@ public:
     static VulkanTexturePtr CreateCubeMap(const VulkanTextureCubeMapCreateInfo& createInfo);
 
     /// @brief Create a texture from memmery.
+    ///        The levels 1 and more are generated from the data when createInfo.mipmap > 1.
     /// @param createInfo Texture creation paramater.
     /// @param data       The initial data of the texture.
     /// @return The Vulkan texture.
@@ -80,31 +125,73 @@ public:
 
     ~VulkanTexture();
 
+    uint32_t    getWidth() const { return mWidth; }
+    uint32_t    getHeight() const { return mHeight; }
+    VkFormat    getFormat() const { return mFormat; }
     VkImage     getImage() const { return mImage; }
     VkImageView getImageView() const { return mView; }
+    /// @brief Return the view of the depth aspect of a depth buffer, to sample it.
+    VkImageView getDepthView() const { return mDepthView; }
     VkSampler   getSampler() const { return mSampler; }
 
+    /// @brief Return the upload of the texture content, if any.
+    VulkanUploader::UploadHandle getUploadHandle() const { return mUploadHandle; }
+
+    /// @brief Return true once the content of the texture was acquired, the frame can sample it.
+    bool isReady() const { return VulkanUploader::isAcquired(mUploadHandle); }
+
     VulkanTexture() = default; // tempo
 
     VulkanTexture(const VulkanTexture2DCreateInfo& createInfo);
     VulkanTexture(const VulkanTextureCubeMapCreateInfo& createInfo);
     VulkanTexture(const VulkanTextureDepthCreateInfo& createInfo);
 private:
+    /// @brief Create a texture from a decoded image, return null if the image is invalid.
+    static VulkanTexturePtr CreateFromImage(const DecodedImage&          image,
+                                            const std::filesystem::path& path,
+                                            bool                         sRGB,
+                                            bool                         generateMipmap,
+                                            bool                         normalMap);
+
+    /// @brief Create a texture from a cooked file, return null if the format is not supported.
+    static VulkanTexturePtr CreateFromKtx2(const Ktx2::Texture&         cooked,
+                                           const std::filesystem::path& path,
+                                           bool                         sRGB);
+
+    /// @brief Return the graphic queue work of the upload, generating the mipmaps of the texture.
+    static std::function<void(VkCommandBuffer)> GenerateMipmapsWork(const VulkanTexturePtr&      texture,
+                                                                    VulkanMipGenerator::MipFilter filter);
+
     /// @brief Width of the texture.
     uint32_t mWidth{};
 
     /// @brief Height of the texture.
     uint32_t mHeight{};
 
+    /// @brief Number of mipmap levels.
+    uint32_t mMipLevels{1};
+
+    /// @brief Format of the texture.
+    VkFormat mFormat{VK_FORMAT_UNDEFINED};
+
     /// @brief The vulkan image handle of the texture.
     VkImage mImage{VK_NULL_HANDLE};
 
     /// @brief The Vulkan image view for the texture.
     VkImageView mView{VK_NULL_HANDLE};
 
+    /// @brief The view of the depth aspect of a depth buffer, VK_NULL_HANDLE for the other textures.
+    VkImageView mDepthView{VK_NULL_HANDLE};
+
+    /// @brief Storage view of each level written by the mipmap generation, level 0 has none.
+    std::vector<VkImageView> mMipStorageViews;
+
     VmaAllocation mAllocation{VK_NULL_HANDLE};
     VkSampler     mSampler{VK_NULL_HANDLE};
 
     /// Path of the texture if it was loaded from a file.
     std::filesystem::path mPath;
+
+    /// The upload of the texture content on the transfer queue.
+    VulkanUploader::UploadHandle mUploadHandle;
 };
@@ -0,0 +1,493 @@
+#include "VulkanUploader.h"
+
+#include "VulkanContext.h"
+#include "VulkanUtils.h"
+
+#include <Engine/Log.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace {
+
+// Number of batches which can be in flight at the same time.
+constexpr uint32_t kBatchCount = 4;
+
+// Alignment of the allocations inside the ring.
+// vkCmdCopyBuffer has no requirement but image copies want a multiple of the texel size.
+constexpr uint64_t kRingAlignment = 16;
+
+// What the graphic queue has to do once a batch is done.
+struct Acquire {
+    uint64_t                                          value{0}; ///< Timeline value of the batch.
+    std::vector<VkBufferMemoryBarrier2>               bufferBarriers;
+    std::vector<VkImageMemoryBarrier2>                imageBarriers;
+    std::vector<std::function<void(VkCommandBuffer)>> graphicQueueWork;
+    std::vector<std::shared_ptr<void>>                resources;
+
+    void clear() {
+        bufferBarriers.clear();
+        imageBarriers.clear();
+        graphicQueueWork.clear();
+        resources.clear();
+    }
+};
+
+struct Batch {
+    VkCommandBuffer                     commandBuffer{VK_NULL_HANDLE};
+    uint64_t                            value{0};    ///< Timeline value signaled by the batch.
+    uint64_t                            ringHead{0}; ///< Ring position released when the batch is done.
+    std::vector<std::shared_ptr<void>>  resources;   ///< Destinations and dedicated staging buffers kept alive.
+    std::vector<VkBufferMemoryBarrier2> releaseBufferBarriers;
+    std::vector<VkImageMemoryBarrier2>  releaseImageBarriers;
+    Acquire                             acquire;
+};
+
+VulkanBufferPtr            sRingBuffer;
+uint8_t*                   sRingData{nullptr};
+uint64_t                   sRingSize{0};
+// Monotonic positions, the ring offset is position % sRingSize.
+uint64_t                   sRingHead{0};
+uint64_t                   sRingTail{0};
+
+VkSemaphore                sTimelineSemaphore{VK_NULL_HANDLE};
+uint64_t                   sSubmittedValue{0};
+uint32_t                   sSrcQueueFamily{VK_QUEUE_FAMILY_IGNORED};
+uint32_t                   sDstQueueFamily{VK_QUEUE_FAMILY_IGNORED};
+
+VkCommandPool              sCommandPool{VK_NULL_HANDLE};
+std::array<Batch, kBatchCount> sBatches;
+uint32_t                   sFirstPendingBatch{0};
+uint32_t                   sPendingBatchCount{0};
+bool                       sRecording{false};
+
+// Acquires of the submitted batches not yet recorded on the graphic queue, in submit order.
+std::deque<Acquire>        sPendingAcquires;
+// Value of the last batch acquired by the graphic queue.
+uint64_t                   sAcquiredValue{0};
+
+// The transfer queue belongs to another family, the resources are released and acquired.
+// Otherwise the release barriers are plain barriers and the timeline semaphore wait of the
+// graphic queue makes the copies visible.
+bool isOwnershipTransfer() { return sSrcQueueFamily != sDstQueueFamily; }
+
+Batch& recordingBatch() { return sBatches[(sFirstPendingBatch + sPendingBatchCount) % kBatchCount]; }
+
+uint64_t getCompletedValue() {
+    uint64_t value = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(VulkanContext::getDevice(), sTimelineSemaphore, &value));
+    return value;
+}
+
+void waitValue(uint64_t value) {
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores    = &sTimelineSemaphore;
+    waitInfo.pValues        = &value;
+    VK_CHECK(vkWaitSemaphores(VulkanContext::getDevice(), &waitInfo, UINT64_MAX));
+}
+
+// Release the oldest submitted batch.
+// Return false if wait is false and the GPU did not complete it yet.
+bool retireOldestBatch(bool wait) {
+    assert(sPendingBatchCount > 0);
+    Batch& batch = sBatches[sFirstPendingBatch];
+    if (wait) {
+        waitValue(batch.value);
+    } else if (getCompletedValue() < batch.value) {
+        return false;
+    }
+
+    sRingTail = batch.ringHead;
+    batch.resources.clear();
+    sFirstPendingBatch = (sFirstPendingBatch + 1) % kBatchCount;
+    sPendingBatchCount--;
+    return true;
+}
+
+Batch& beginBatch() {
+    if (sRecording) {
+        return recordingBatch();
+    }
+
+    // The batches are recycled in order, all of them are in flight.
+    if (sPendingBatchCount == kBatchCount) {
+        retireOldestBatch(true);
+    }
+
+    Batch& batch = recordingBatch();
+    batch.value  = sSubmittedValue + 1;
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(batch.commandBuffer, &beginInfo));
+    sRecording = true;
+    return batch;
+}
+
+// Reserve size bytes in the ring, flush and wait for the GPU when the ring is full.
+uint64_t allocateRing(uint64_t size) {
+    assert(size <= sRingSize);
+    while (true) {
+        // Nothing in flight, restart at the beginning of the ring.
+        if (sRingHead == sRingTail && sPendingBatchCount == 0) {
+            sRingHead = 0;
+            sRingTail = 0;
+        }
+
+        const uint64_t offset = sRingHead % sRingSize;
+        // The allocation never wraps, skip the end of the ring.
+        const uint64_t padding = offset + size > sRingSize ? sRingSize - offset : 0;
+        if (sRingHead + padding + size - sRingTail <= sRingSize) {
+            sRingHead += padding;
+            const uint64_t allocationOffset = sRingHead % sRingSize;
+            sRingHead = (sRingHead + size + kRingAlignment - 1) & ~(kRingAlignment - 1);
+            return allocationOffset;
+        }
+
+        // The space is held by the batch being recorded, submit it.
+        if (sPendingBatchCount == 0) {
+            VulkanUploader::flush();
+        }
+        if (sPendingBatchCount > 0) {
+            retireOldestBatch(true);
+        }
+    }
+}
+
+struct StagingRegion {
+    VkBuffer buffer{VK_NULL_HANDLE};
+    uint64_t offset{0};
+    uint8_t* data{nullptr};
+};
+
+// Reserve staging memory for a copy recorded into the batch returned by beginBatch().
+// The reservation may submit the current batch, so all the data of a copy must be reserved at once.
+StagingRegion reserveStaging(uint64_t size) {
+    if (size > sRingSize) {
+        ENGINE_CORE_WARNING("VulkanUploader: {} bytes upload larger than the ring, use a dedicated staging buffer",
+                            size);
+        VulkanBufferCreateInfo createInfo{};
+        createInfo.name              = "UploadStaging";
+        createInfo.sizeInByte        = size;
+        createInfo.usage             = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        createInfo.memoryProperty    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        createInfo.persistentMapping = true;
+        VulkanBufferPtr staging      = VulkanBuffer::Create(createInfo);
+        const StagingRegion region{staging->getBuffer(), 0, static_cast<uint8_t*>(staging->getMappedData())};
+        beginBatch().resources.push_back(std::move(staging));
+        return region;
+    }
+
+    const uint64_t offset = allocateRing(size);
+    return {sRingBuffer->getBuffer(), offset, sRingData + offset};
+}
+
+void pipelineBarrier(VkCommandBuffer                         cmd,
+                     std::span<const VkBufferMemoryBarrier2> bufferBarriers,
+                     std::span<const VkImageMemoryBarrier2>  imageBarriers) {
+    if (bufferBarriers.empty() && imageBarriers.empty()) {
+        return;
+    }
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+    dependencyInfo.pBufferMemoryBarriers    = bufferBarriers.data();
+    dependencyInfo.imageMemoryBarrierCount  = static_cast<uint32_t>(imageBarriers.size());
+    dependencyInfo.pImageMemoryBarriers     = imageBarriers.data();
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+
+} // namespace
+
+void VulkanUploader::Init(uint64_t ringSizeInByte) {
+    sRingSize = (ringSizeInByte + kRingAlignment - 1) & ~(kRingAlignment - 1);
+    sRingHead = 0;
+    sRingTail = 0;
+
+    VulkanBufferCreateInfo createInfo{};
+    createInfo.name              = "UploadRing";
+    createInfo.sizeInByte        = sRingSize;
+    createInfo.usage             = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    createInfo.memoryProperty    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    createInfo.persistentMapping = true;
+    sRingBuffer = VulkanBuffer::Create(createInfo);
+    sRingData   = static_cast<uint8_t*>(sRingBuffer->getMappedData());
+    assert(sRingData);
+
+    // The resources are created with VK_SHARING_MODE_EXCLUSIVE,
+    // their ownership must move to the graphic family after the copies.
+    const uint32_t transferFamily = VulkanContext::getTransferQueueFamilyIndex();
+    const uint32_t graphicFamily  = VulkanContext::getGraphicQueueFamilyIndex();
+    sSrcQueueFamily = transferFamily != graphicFamily ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+    sDstQueueFamily = transferFamily != graphicFamily ? graphicFamily : VK_QUEUE_FAMILY_IGNORED;
+
+    VkSemaphoreTypeCreateInfo semaphoreTypeInfo{};
+    semaphoreTypeInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeInfo.initialValue  = 0;
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &semaphoreTypeInfo;
+    VK_CHECK(vkCreateSemaphore(VulkanContext::getDevice(), &semaphoreInfo, nullptr, &sTimelineSemaphore));
+    VulkanContext::setDebugObjectName((uint64_t)sTimelineSemaphore, VK_OBJECT_TYPE_SEMAPHORE, "UploadTimeline");
+    sSubmittedValue = 0;
+    sAcquiredValue  = 0;
+
+    sCommandPool = VulkanContext::createCommandPool(transferFamily, true, true);
+    for (Batch& batch : sBatches) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool        = sCommandPool;
+        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        VK_CHECK(vkAllocateCommandBuffers(VulkanContext::getDevice(), &allocInfo, &batch.commandBuffer));
+    }
+}
+
+void VulkanUploader::Shutdown() {
+    flush();
+    while (sPendingBatchCount > 0) {
+        retireOldestBatch(true);
+    }
+    sPendingAcquires.clear();
+
+    for (Batch& batch : sBatches) {
+        batch = {};
+    }
+    vkDestroyCommandPool(VulkanContext::getDevice(), sCommandPool, nullptr);
+    sCommandPool = VK_NULL_HANDLE;
+    vkDestroySemaphore(VulkanContext::getDevice(), sTimelineSemaphore, nullptr);
+    sTimelineSemaphore = VK_NULL_HANDLE;
+
+    sRingBuffer.reset();
+    sRingData = nullptr;
+}
+
+VulkanUploader::UploadHandle VulkanUploader::uploadBuffer(const VulkanBufferPtr& dst,
+                                                          const void*            data,
+                                                          uint64_t               size,
+                                                          uint64_t               dstOffset) {
+    if (size == 0) {
+        return {};
+    }
+    assert(dstOffset + size <= dst->getSizeInByte());
+
+    const StagingRegion staging = reserveStaging(size);
+    std::memcpy(staging.data, data, size);
+    Batch& batch = beginBatch();
+
+    VkBufferCopy region{};
+    region.srcOffset = staging.offset;
+    region.dstOffset = dstOffset;
+    region.size      = size;
+    vkCmdCopyBuffer(batch.commandBuffer, staging.buffer, dst->getBuffer(), 1, &region);
+
+    VkBufferMemoryBarrier2 barrier{};
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    barrier.srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask        = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask       = VK_ACCESS_2_NONE;
+    barrier.srcQueueFamilyIndex = sSrcQueueFamily;
+    barrier.dstQueueFamilyIndex = sDstQueueFamily;
+    barrier.buffer              = dst->getBuffer();
+    barrier.offset              = dstOffset;
+    barrier.size                = size;
+    batch.releaseBufferBarriers.push_back(barrier);
+
+    if (isOwnershipTransfer()) {
+        barrier.srcStageMask  = VK_PIPELINE_STAGE_2_NONE;
+        barrier.srcAccessMask = VK_ACCESS_2_NONE;
+        barrier.dstStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT |
+                                VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT;
+        batch.acquire.bufferBarriers.push_back(barrier);
+        batch.acquire.resources.push_back(dst);
+    }
+
+    batch.resources.push_back(dst);
+    return {batch.value};
+}
+
+VulkanUploader::UploadHandle VulkanUploader::uploadImage(std::shared_ptr<void> owner, const ImageUploadInfo& info) {
+    // Either one level per layer, or all the levels of a single layer one after another.
+    const uint32_t        layerCount = info.levels.empty() ? static_cast<uint32_t>(info.layers.size()) : 1;
+    std::vector<uint64_t> levelOffsets;
+    uint64_t              stagingSize = info.layerSize * layerCount;
+    if (!info.levels.empty()) {
+        stagingSize = 0;
+        for (const ImageLevelData& level : info.levels) {
+            levelOffsets.push_back(stagingSize);
+            stagingSize += (level.size + kRingAlignment - 1) / kRingAlignment * kRingAlignment;
+        }
+    }
+
+    const StagingRegion staging = reserveStaging(stagingSize);
+    if (info.levels.empty()) {
+        for (uint32_t layer = 0; layer < layerCount; ++layer) {
+            std::memcpy(staging.data + info.layerSize * layer, info.layers[layer], info.layerSize);
+        }
+    } else {
+        for (size_t level = 0; level < info.levels.size(); ++level) {
+            std::memcpy(staging.data + levelOffsets[level], info.levels[level].data, info.levels[level].size);
+        }
+    }
+    Batch& batch = beginBatch();
+
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask                    = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask                   = VK_ACCESS_2_NONE;
+    barrier.dstStageMask                    = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.dstAccessMask                   = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                           = info.image;
+    barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = info.mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = layerCount;
+    pipelineBarrier(batch.commandBuffer, {}, {&barrier, 1});
+
+    std::vector<VkBufferImageCopy> regions;
+    for (uint32_t layer = 0; layer < layerCount; ++layer) {
+        VkBufferImageCopy region{};
+        region.bufferOffset                    = staging.offset + info.layerSize * layer;
+        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel       = 0;
+        region.imageSubresource.baseArrayLayer = layer;
+        region.imageSubresource.layerCount     = 1;
+        region.imageExtent                     = {info.width, info.height, 1};
+        regions.push_back(region);
+    }
+    for (uint32_t level = 1; level < info.levels.size(); ++level) {
+        VkBufferImageCopy region{};
+        region.bufferOffset                    = staging.offset + levelOffsets[level];
+        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel       = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount     = 1;
+        region.imageExtent = {std::max(1u, info.width >> level), std::max(1u, info.height >> level), 1};
+        regions.push_back(region);
+    }
+    vkCmdCopyBufferToImage(batch.commandBuffer, staging.buffer, info.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()), regions.data());
+
+    // The image stay in TRANSFER_DST when the graphic queue still has to write the other levels.
+    barrier.srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask        = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask       = VK_ACCESS_2_NONE;
+    barrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout           = info.onGraphicQueue ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+                                                      : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcQueueFamilyIndex = sSrcQueueFamily;
+    barrier.dstQueueFamilyIndex = sDstQueueFamily;
+    batch.releaseImageBarriers.push_back(barrier);
+
+    // Without ownership transfer the release barrier already did the layout transition.
+    if (isOwnershipTransfer()) {
+        barrier.srcStageMask  = VK_PIPELINE_STAGE_2_NONE;
+        barrier.srcAccessMask = VK_ACCESS_2_NONE;
+        barrier.dstStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        barrier.dstAccessMask = info.onGraphicQueue ? VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT
+                                                    : VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        batch.acquire.imageBarriers.push_back(barrier);
+    }
+    if (info.onGraphicQueue) {
+        batch.acquire.graphicQueueWork.push_back(info.onGraphicQueue);
+    }
+    batch.acquire.resources.push_back(owner);
+
+    batch.resources.push_back(std::move(owner));
+    return {batch.value};
+}
+
+void VulkanUploader::flush() {
+    if (sRecording) {
+        Batch& batch = recordingBatch();
+
+        // Release the resources to the graphic queue family.
+        pipelineBarrier(batch.commandBuffer, batch.releaseBufferBarriers, batch.releaseImageBarriers);
+        VK_CHECK(vkEndCommandBuffer(batch.commandBuffer));
+
+        VkCommandBufferSubmitInfo commandBufferInfo{};
+        commandBufferInfo.sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+        commandBufferInfo.commandBuffer = batch.commandBuffer;
+
+        VkSemaphoreSubmitInfo signalInfo{};
+        signalInfo.sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        signalInfo.semaphore = sTimelineSemaphore;
+        signalInfo.value     = batch.value;
+        signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo2 submitInfo{};
+        submitInfo.sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+        submitInfo.commandBufferInfoCount   = 1;
+        submitInfo.pCommandBufferInfos      = &commandBufferInfo;
+        submitInfo.signalSemaphoreInfoCount = 1;
+        submitInfo.pSignalSemaphoreInfos    = &signalInfo;
+        VK_CHECK(vkQueueSubmit2(VulkanContext::getTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE));
+
+        // Hand the acquires over to the graphic queue.
+        batch.acquire.value = batch.value;
+        sPendingAcquires.push_back(std::move(batch.acquire));
+        batch.acquire.clear();
+        batch.releaseBufferBarriers.clear();
+        batch.releaseImageBarriers.clear();
+
+        batch.ringHead  = sRingHead;
+        sSubmittedValue = batch.value;
+        sRecording      = false;
+        sPendingBatchCount++;
+    }
+    collect();
+}
+
+void VulkanUploader::acquire(VkCommandBuffer cmd) {
+    // The batches still in flight are acquired by a later frame, the frame never waits for a copy.
+    const uint64_t completedValue = getCompletedValue();
+    while (!sPendingAcquires.empty() && sPendingAcquires.front().value <= completedValue) {
+        const Acquire& pending = sPendingAcquires.front();
+        pipelineBarrier(cmd, pending.bufferBarriers, pending.imageBarriers);
+        for (const auto& work : pending.graphicQueueWork) {
+            work(cmd);
+        }
+        sAcquiredValue = pending.value;
+        // The callers keep the resources they render alive until the frame is done.
+        sPendingAcquires.pop_front();
+    }
+}
+
+void VulkanUploader::collect() {
+    while (sPendingBatchCount > 0 && retireOldestBatch(false)) {
+    }
+}
+
+bool VulkanUploader::isComplete(UploadHandle handle) { return getCompletedValue() >= handle.value; }
+
+bool VulkanUploader::isAcquired(UploadHandle handle) { return sAcquiredValue >= handle.value; }
+
+void VulkanUploader::wait(UploadHandle handle) {
+    if (handle.value > sSubmittedValue) {
+        flush();
+    }
+    waitValue(handle.value);
+}
+
+VkSemaphore VulkanUploader::getTimelineSemaphore() { return sTimelineSemaphore; }
+
+uint64_t VulkanUploader::getSubmittedValue() { return sSubmittedValue; }
+
+uint64_t VulkanUploader::getAcquiredValue() { return sAcquiredValue; }
+
+uint64_t VulkanUploader::getUsedSize() { return sRingHead - sRingTail; }
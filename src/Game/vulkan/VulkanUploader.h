@@ -0,0 +1,121 @@
+#pragma once
+#include "VulkanBuffer.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+
+/// @brief Asynchronous uploads of buffers and images on the transfer queue.
+///
+/// The uploader owns a persistently mapped host visible ring buffer. The upload functions copy
+/// the data into the ring and record the copy commands into the current batch, no submit happens
+/// until flush(). A batch is submitted on VulkanContext::getTransferQueue() and signals a timeline
+/// semaphore, its value is the UploadHandle returned by the upload functions. The ring space of a
+/// batch is released once the semaphore reaches its value, so many uploads share one submit and
+/// the CPU never waits for the GPU unless the ring is full.
+///
+/// acquire() hands the batches completed by the GPU over to the graphic queue. When the transfer
+/// queue belongs to another family than the graphic queue, the batch ends with a release of the
+/// resources to the graphic family and acquire() records the matching acquire barriers. The render
+/// loop does, each frame:
+///
+///   flush()
+///   acquire(cmd)            at the beginning of the frame command buffer
+///   submit the frame, waiting on getTimelineSemaphore() at getAcquiredValue()
+///
+/// The wait is already satisfied, it only orders the release before the acquire. A resource must
+/// not be used before isAcquired() returns true for its upload, the batches still in flight are
+/// acquired by a later frame.
+///
+/// Uploads larger than the ring use a dedicated staging buffer released with the batch.
+/// Not thread safe, call from the render thread.
+namespace VulkanUploader {
+
+/// @brief Identify the batch of an upload.
+struct UploadHandle {
+    uint64_t value{0}; ///< Value of the timeline semaphore once the batch is done, 0 is always done.
+};
+
+/// @brief Data of a level of an image.
+struct ImageLevelData {
+    const void* data{nullptr};
+    uint64_t    size{0};
+};
+
+/// @brief Description of an image upload.
+///
+/// Either the level 0 of each layer (layers and layerSize), or the precomputed levels of a single
+/// layer image (levels), for instance the mipmaps of a block compressed texture.
+struct ImageUploadInfo {
+    VkImage                           image{VK_NULL_HANDLE};
+    uint32_t                          width{1};
+    uint32_t                          height{1};
+    uint32_t                          mipLevels{1};
+    uint64_t                          layerSize{0}; ///< Size of the data of a layer in bytes.
+    std::span<const void* const>      layers;       ///< Data of each layer, one layer per pointer.
+    std::span<const ImageLevelData>   levels;       ///< Data of the levels from level 0, replace layers when set.
+
+    /// @brief Optional work recorded on the graphic queue right after the acquire (mipmap generation).
+    ///        When set, the image is acquired with all the levels in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    ///        and the callback must move them to their final layout, otherwise the image is acquired in
+    ///        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+    std::function<void(VkCommandBuffer)> onGraphicQueue;
+};
+
+/// @brief Create the ring buffer, the timeline semaphore, the command pool and the batches.
+/// @param ringSizeInByte The capacity of the staging ring.
+void Init(uint64_t ringSizeInByte = 32ull * 1024 * 1024);
+
+/// @brief Wait for the in flight batches and destroy all the ressources.
+void Shutdown();
+
+/// @brief Queue a copy of the data into a buffer.
+///
+/// The data is copied into the staging ring before returning. The buffer must have been
+/// created with VK_BUFFER_USAGE_TRANSFER_DST_BIT, it is kept alive until the copy is done.
+///
+/// @param dst       The destination buffer.
+/// @param data      The data to upload.
+/// @param size      The size of the data in bytes.
+/// @param dstOffset The offset where to write the data inside the destination buffer.
+UploadHandle uploadBuffer(const VulkanBufferPtr& dst, const void* data, uint64_t size, uint64_t dstOffset = 0);
+
+/// @brief Queue the upload of an image.
+/// @param owner The object owning the image, kept alive until the copy is done.
+/// @param info  The image and its data, the data is copied before returning.
+UploadHandle uploadImage(std::shared_ptr<void> owner, const ImageUploadInfo& info);
+
+/// @brief Submit the queued copies, do nothing if there is none.
+void flush();
+
+/// @brief Record the acquire barriers (and the graphic queue work) of the batches completed by the GPU.
+/// @param cmd A command buffer submitted on the graphic queue, waiting on getAcquiredValue().
+void acquire(VkCommandBuffer cmd);
+
+/// @brief Release the staging space of the batches completed by the GPU.
+void collect();
+
+/// @brief Return true if the GPU completed the batch of the upload.
+[[nodiscard]] bool isComplete(UploadHandle handle);
+
+/// @brief Return true if the upload was acquired, the command buffers recorded after acquire() can use it.
+[[nodiscard]] bool isAcquired(UploadHandle handle);
+
+/// @brief Block until the GPU completed the batch of the upload, flush it if needed.
+///        The upload is acquired by the next acquire().
+void wait(UploadHandle handle);
+
+/// @brief Return the timeline semaphore signaled by the batches.
+[[nodiscard]] VkSemaphore getTimelineSemaphore();
+
+/// @brief Return the value signaled by the last submitted batch.
+[[nodiscard]] uint64_t getSubmittedValue();
+
+/// @brief Return the value of the last batch acquired by the graphic queue.
+[[nodiscard]] uint64_t getAcquiredValue();
+
+/// @brief Return the number of bytes of the ring not yet released.
+[[nodiscard]] uint64_t getUsedSize();
+
+} // namespace VulkanUploader
@@ -303,6 +303,32 @@ void VulkanUtils::transitionImageLayout(VkCommandBuffer          cmdBuffer,
     vkCmdPipelineBarrier2(cmdBuffer, &dependencyInfo);
 }
 
+void VulkanUtils::memoryBarrier(VkCommandBuffer       cmdBuffer,
+                                VkPipelineStageFlags2 srcStageMask,
+                                VkAccessFlags2        srcAccessMask,
+                                VkPipelineStageFlags2 dstStageMask,
+                                VkAccessFlags2        dstAccessMask) noexcept {
+    VkMemoryBarrier2 memoryBarrier2{};
+    memoryBarrier2.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    memoryBarrier2.pNext         = nullptr;
+    memoryBarrier2.srcStageMask  = srcStageMask;
+    memoryBarrier2.srcAccessMask = srcAccessMask;
+    memoryBarrier2.dstStageMask  = dstStageMask;
+    memoryBarrier2.dstAccessMask = dstAccessMask;
+
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.pNext                    = nullptr;
+    dependencyInfo.dependencyFlags          = 0;
+    dependencyInfo.memoryBarrierCount       = 1;
+    dependencyInfo.pMemoryBarriers          = &memoryBarrier2;
+    dependencyInfo.bufferMemoryBarrierCount = 0;
+    dependencyInfo.pBufferMemoryBarriers    = nullptr;
+    dependencyInfo.imageMemoryBarrierCount  = 0;
+    dependencyInfo.pImageMemoryBarriers     = nullptr;
+    vkCmdPipelineBarrier2(cmdBuffer, &dependencyInfo);
+}
+
 // ===========================================================================
 //
 //                     std formater specialization
@@ -181,6 +181,18 @@ void transitionImageLayout(VkCommandBuffer          cmdBuffer,
                            VkAccessFlagBits2        dstAccessMask,
                            uint32_t                 mipmap,
                            uint32_t                 layerCount = 1) noexcept;
+
+/// \brief Record a global memory barrier.
+/// \param[in] cmdBuffer     The command buffer to record into.
+/// \param[in] srcStageMask  The stages which must complete before the barrier.
+/// \param[in] srcAccessMask The memory writes made available.
+/// \param[in] dstStageMask  The stages which wait on the barrier.
+/// \param[in] dstAccessMask The memory accesses made visible.
+void memoryBarrier(VkCommandBuffer       cmdBuffer,
+                   VkPipelineStageFlags2 srcStageMask,
+                   VkAccessFlags2        srcAccessMask,
+                   VkPipelineStageFlags2 dstStageMask,
+                   VkAccessFlags2        dstAccessMask) noexcept;
 } // namespace VulkanUtils
 
 #include <vulkan/vk_enum_string_helper.h>
@@ -16,3 +16,7 @@
 #include "vma/vma.h"
 
 constexpr unsigned MAX_FRAME_IN_FLIGHT = 3u;
+
+// Descriptor set holding the per frame data (Shaders/include/buffers.slang).
+// Its uniform buffers are reflected as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC.
+constexpr unsigned SET_INDEX_PERFRAME = 0u;
@@ -0,0 +1,154 @@
+#include "Engine/FreeListAllocator.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using Engine::FreeListAllocator;
+
+TEST(FreeListAllocatorTest, AllocateAndFree) {
+    FreeListAllocator allocator(1000);
+    const uint64_t    a = allocator.allocate(100);
+    const uint64_t    b = allocator.allocate(200);
+    const uint64_t    c = allocator.allocate(300);
+    EXPECT_EQ(a, 0u);
+    EXPECT_EQ(b, 100u);
+    EXPECT_EQ(c, 300u);
+    EXPECT_EQ(allocator.getSize(b), 200u);
+    EXPECT_EQ(allocator.getUsedSize(), 600u);
+
+    // Too large for the remaining 400.
+    EXPECT_EQ(allocator.allocate(401), FreeListAllocator::kInvalidOffset);
+
+    allocator.free(b);
+    EXPECT_EQ(allocator.getUsedSize(), 400u);
+    EXPECT_EQ(allocator.getSize(b), 0u);
+    EXPECT_EQ(allocator.getStatistics().freeBlockCount, 2u);
+
+    // The hole left by b is reused.
+    EXPECT_EQ(allocator.allocate(200), b);
+}
+
+TEST(FreeListAllocatorTest, BestFit) {
+    FreeListAllocator allocator(1000);
+    const uint64_t    a = allocator.allocate(300);
+    EXPECT_NE(allocator.allocate(10), FreeListAllocator::kInvalidOffset);
+    const uint64_t b = allocator.allocate(50);
+    EXPECT_NE(allocator.allocate(10), FreeListAllocator::kInvalidOffset);
+    allocator.free(a);
+    allocator.free(b);
+
+    // The 50 bytes hole is the smallest one able to hold 40 bytes, the 300 one is kept.
+    EXPECT_EQ(allocator.allocate(40), b);
+    EXPECT_EQ(allocator.allocate(300), a);
+}
+
+TEST(FreeListAllocatorTest, Coalesce) {
+    FreeListAllocator     allocator(400);
+    std::vector<uint64_t> offsets;
+    for (int i = 0; i < 4; ++i) {
+        offsets.push_back(allocator.allocate(100));
+    }
+    EXPECT_EQ(allocator.getStatistics().freeBlockCount, 0u);
+
+    // Free the second and the fourth, then the third: it merges with both neighbours.
+    allocator.free(offsets[1]);
+    allocator.free(offsets[3]);
+    EXPECT_EQ(allocator.getStatistics().freeBlockCount, 2u);
+    allocator.free(offsets[2]);
+    EXPECT_EQ(allocator.getStatistics().freeBlockCount, 1u);
+    EXPECT_EQ(allocator.getStatistics().largestFreeBlock, 300u);
+    EXPECT_EQ(allocator.allocate(300), offsets[1]);
+
+    allocator.free(offsets[0]);
+    allocator.free(offsets[1]);
+    const auto statistics = allocator.getStatistics();
+    EXPECT_EQ(statistics.freeBlockCount, 1u);
+    EXPECT_EQ(statistics.largestFreeBlock, 400u);
+    EXPECT_EQ(statistics.allocationCount, 0u);
+}
+
+TEST(FreeListAllocatorTest, Alignment) {
+    // The alignment is not a power of two, as the size of a packed vertex.
+    FreeListAllocator allocator(1000);
+    EXPECT_EQ(allocator.allocate(6), 0u);
+    const uint64_t offset = allocator.allocate(40, 20);
+    EXPECT_EQ(offset, 20u);
+
+    // The padding in front of the allocation is still available.
+    const auto statistics = allocator.getStatistics();
+    EXPECT_EQ(statistics.freeBlockCount, 2u);
+    EXPECT_EQ(allocator.allocate(14), 6u);
+
+    allocator.free(offset);
+    EXPECT_EQ(allocator.allocate(1000 - 20, 20), 20u);
+}
+
+TEST(FreeListAllocatorTest, Fragmentation) {
+    FreeListAllocator     allocator(1000);
+    std::vector<uint64_t> offsets;
+    for (int i = 0; i < 10; ++i) {
+        offsets.push_back(allocator.allocate(100));
+    }
+    EXPECT_FLOAT_EQ(allocator.getStatistics().fragmentation, 0.0f);
+
+    // 5 holes of 100 bytes: 500 bytes are free but 101 can't be allocated.
+    for (int i = 0; i < 10; i += 2) {
+        allocator.free(offsets[i]);
+    }
+    const auto statistics = allocator.getStatistics();
+    EXPECT_EQ(statistics.freeSize, 500u);
+    EXPECT_EQ(statistics.largestFreeBlock, 100u);
+    EXPECT_FLOAT_EQ(statistics.fragmentation, 0.8f);
+    EXPECT_EQ(allocator.allocate(101), FreeListAllocator::kInvalidOffset);
+}
+
+TEST(FreeListAllocatorTest, RandomAllocationsDontOverlap) {
+    constexpr uint64_t kCapacity = 1 << 20;
+    FreeListAllocator  allocator(kCapacity);
+
+    struct Block {
+        uint64_t offset;
+        uint64_t size;
+    };
+    std::vector<Block> blocks;
+    std::mt19937       random(4);
+    for (int i = 0; i < 20000; ++i) {
+        if (!blocks.empty() && random() % 3 == 0) {
+            const size_t index = random() % blocks.size();
+            allocator.free(blocks[index].offset);
+            blocks[index] = blocks.back();
+            blocks.pop_back();
+            continue;
+        }
+        const uint64_t size      = 1 + random() % 4096;
+        const uint64_t alignment = 1 + random() % 64;
+        const uint64_t offset    = allocator.allocate(size, alignment);
+        if (offset == FreeListAllocator::kInvalidOffset) {
+            continue;
+        }
+        ASSERT_EQ(offset % alignment, 0u);
+        ASSERT_LE(offset + size, kCapacity);
+        blocks.push_back({offset, size});
+    }
+
+    std::sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) { return a.offset < b.offset; });
+    uint64_t usedSize = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        usedSize += blocks[i].size;
+        if (i > 0) {
+            ASSERT_LE(blocks[i - 1].offset + blocks[i - 1].size, blocks[i].offset);
+        }
+    }
+    EXPECT_EQ(allocator.getUsedSize(), usedSize);
+
+    // Everything merges back in a single block.
+    for (const Block& block : blocks) {
+        allocator.free(block.offset);
+    }
+    const auto statistics = allocator.getStatistics();
+    EXPECT_EQ(statistics.freeBlockCount, 1u);
+    EXPECT_EQ(statistics.largestFreeBlock, kCapacity);
+}
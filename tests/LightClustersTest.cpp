@@ -0,0 +1,196 @@
+#include "LightClusters.h"
+
+#include <gtest/gtest.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr float kWidth  = 1600.0f;
+constexpr float kHeight = 900.0f;
+constexpr float kNear   = 0.1f;
+constexpr float kFar    = 1000.0f;
+
+glm::mat4 makeProjection() {
+    return glm::perspectiveRH_ZO(glm::radians(60.0f), kWidth / kHeight, kNear, kFar);
+}
+
+/// @brief Framebuffer coordinates of a view space point, y = 0 is the top of the target.
+glm::vec2 project(const glm::mat4& projection, const glm::vec3& point) {
+    const glm::vec4 clip = projection * glm::vec4(point, 1.0f);
+    const glm::vec2 ndc  = glm::vec2(clip) / clip.w;
+    return {(ndc.x * 0.5f + 0.5f) * kWidth, (0.5f - ndc.y * 0.5f) * kHeight};
+}
+
+/// @brief Random view space point in the frustum.
+glm::vec3 randomPoint(std::mt19937& random, const glm::mat4& projection, float maxDepth) {
+    std::uniform_real_distribution<float> ndc(-0.999f, 0.999f);
+    std::uniform_real_distribution<float> depth(kNear, maxDepth);
+    const float d = depth(random);
+    return {(ndc(random) + projection[2][0]) * d / projection[0][0],
+            (ndc(random) + projection[2][1]) * d / projection[1][1],
+            -d};
+}
+
+std::span<const uint32_t> getClusterLights(const std::vector<uint32_t>& clusterLights, uint32_t cluster) {
+    const uint32_t* list = &clusterLights[size_t(cluster) * LightClusters::kClusterStride];
+    return {list + 1, list[0]};
+}
+
+} // namespace
+
+TEST(LightClustersTest, GridMatchesProjection) {
+    const LightClusters::Grid grid = LightClusters::makeGrid(makeProjection(), kWidth, kHeight);
+    EXPECT_NEAR(grid.nearZ, kNear, kNear * 1e-3f);
+    EXPECT_NEAR(grid.farZ, kFar, kFar * 1e-3f);
+    EXPECT_NEAR(LightClusters::getSliceDepth(grid, 0), grid.nearZ, 1e-6f);
+    EXPECT_NEAR(LightClusters::getSliceDepth(grid, LightClusters::kClusterCountZ), grid.farZ, grid.farZ * 1e-4f);
+
+    // The slices are exponential and a depth inside a slice maps back to it.
+    for (uint32_t slice = 0; slice < LightClusters::kClusterCountZ; ++slice) {
+        const float begin = LightClusters::getSliceDepth(grid, slice);
+        const float end   = LightClusters::getSliceDepth(grid, slice + 1);
+        EXPECT_GT(end, begin);
+        EXPECT_EQ(LightClusters::getSlice(grid, std::sqrt(begin * end)), slice);
+    }
+    EXPECT_EQ(LightClusters::getSlice(grid, kNear * 0.5f), 0u);
+    EXPECT_EQ(LightClusters::getSlice(grid, kFar * 2.0f), LightClusters::kClusterCountZ - 1);
+}
+
+TEST(LightClustersTest, FragmentsAreInsideTheirCluster) {
+    const glm::mat4           projection = makeProjection();
+    const LightClusters::Grid grid       = LightClusters::makeGrid(projection, kWidth, kHeight);
+
+    std::mt19937 random(42);
+    for (uint32_t i = 0; i < 10000; ++i) {
+        const glm::vec3 point   = randomPoint(random, projection, 200.0f);
+        const uint32_t  cluster = LightClusters::getClusterIndex(grid, project(projection, point), -point.z);
+        ASSERT_LT(cluster, LightClusters::kClusterCount);
+
+        glm::vec3 aabbMin, aabbMax;
+        LightClusters::computeClusterBounds(grid, cluster, aabbMin, aabbMax);
+        const glm::vec3 epsilon(1e-4f * -point.z);
+        EXPECT_TRUE(glm::all(glm::greaterThanEqual(point, aabbMin - epsilon)));
+        EXPECT_TRUE(glm::all(glm::lessThanEqual(point, aabbMax + epsilon)));
+    }
+}
+
+TEST(LightClustersTest, LightsReachTheFragmentsInRange) {
+    const glm::mat4           projection = makeProjection();
+    const LightClusters::Grid grid       = LightClusters::makeGrid(projection, kWidth, kHeight);
+
+    std::mt19937                          random(7);
+    std::uniform_real_distribution<float> radius(0.5f, 8.0f);
+    std::vector<LightClusters::LightSphere> lights(64);
+    for (LightClusters::LightSphere& light : lights) {
+        light.center = randomPoint(random, projection, 60.0f);
+        light.radius = radius(random);
+    }
+
+    std::vector<uint32_t> clusterLights;
+    LightClusters::assignLights(grid, lights, clusterLights);
+    ASSERT_EQ(clusterLights.size(), size_t(LightClusters::kClusterCount) * LightClusters::kClusterStride);
+
+    // The lists are sorted and the clusters don't overflow with this many lights.
+    uint32_t assignedCount = 0;
+    for (uint32_t cluster = 0; cluster < LightClusters::kClusterCount; ++cluster) {
+        const std::span<const uint32_t> list = getClusterLights(clusterLights, cluster);
+        EXPECT_TRUE(std::is_sorted(list.begin(), list.end()));
+        EXPECT_LT(list.size(), LightClusters::kMaxLightsPerCluster);
+        assignedCount += static_cast<uint32_t>(list.size());
+    }
+    // Far less work than every light in every cluster.
+    EXPECT_GT(assignedCount, 0u);
+    EXPECT_LT(assignedCount, LightClusters::kClusterCount * lights.size() / 10);
+
+    // A fragment lit by a light finds it in its cluster.
+    for (uint32_t i = 0; i < 20000; ++i) {
+        const glm::vec3 point   = randomPoint(random, projection, 60.0f);
+        const uint32_t  cluster = LightClusters::getClusterIndex(grid, project(projection, point), -point.z);
+        const std::span<const uint32_t> list = getClusterLights(clusterLights, cluster);
+        for (uint32_t light = 0; light < lights.size(); ++light) {
+            if (glm::length(point - lights[light].center) < lights[light].radius * 0.999f) {
+                EXPECT_TRUE(std::binary_search(list.begin(), list.end(), light));
+            }
+        }
+    }
+}
+
+TEST(LightClustersTest, LightsOutsideTheFrustumAreNotAssigned) {
+    const glm::mat4           projection = makeProjection();
+    const LightClusters::Grid grid       = LightClusters::makeGrid(projection, kWidth, kHeight);
+
+    // Behind the camera, beyond the far plane and on the left of the frustum.
+    const std::vector<LightClusters::LightSphere> lights = {
+        {{0.0f, 0.0f, 5.0f}, 4.0f},
+        {{0.0f, 0.0f, -1100.0f}, 50.0f},
+        {{-200.0f, 0.0f, -10.0f}, 20.0f},
+    };
+    std::vector<uint32_t> clusterLights;
+    LightClusters::assignLights(grid, lights, clusterLights);
+    for (uint32_t cluster = 0; cluster < LightClusters::kClusterCount; ++cluster) {
+        EXPECT_EQ(getClusterLights(clusterLights, cluster).size(), 0u);
+    }
+}
+
+TEST(LightClustersTest, ClusterCapacity) {
+    const glm::mat4           projection = makeProjection();
+    const LightClusters::Grid grid       = LightClusters::makeGrid(projection, kWidth, kHeight);
+
+    // More lights than a cluster holds, all around the same point: the first ones are kept.
+    const glm::vec3 point(0.0f, 0.0f, -10.0f);
+    std::vector<LightClusters::LightSphere> lights(LightClusters::kMaxLightsPerCluster + 50, {point, 1.0f});
+    std::vector<uint32_t> clusterLights;
+    LightClusters::assignLights(grid, lights, clusterLights);
+
+    const uint32_t cluster = LightClusters::getClusterIndex(grid, project(projection, point), -point.z);
+    const std::span<const uint32_t> list = getClusterLights(clusterLights, cluster);
+    ASSERT_EQ(list.size(), LightClusters::kMaxLightsPerCluster);
+    for (uint32_t i = 0; i < list.size(); ++i) {
+        EXPECT_EQ(list[i], i);
+    }
+}
+
+TEST(LightClustersTest, UnusedSlotsAreSkipped) {
+    const glm::mat4           projection = makeProjection();
+    const LightClusters::Grid grid       = LightClusters::makeGrid(projection, kWidth, kHeight);
+
+    // A released or disabled light slot has a zero range, the slots after it keep their index.
+    const glm::vec3 point(0.0f, 0.0f, -10.0f);
+    const std::vector<LightClusters::LightSphere> lights = {{point, 0.0f}, {point, 1.0f}};
+    std::vector<uint32_t> clusterLights;
+    LightClusters::assignLights(grid, lights, clusterLights);
+
+    const uint32_t cluster = LightClusters::getClusterIndex(grid, project(projection, point), -point.z);
+    const std::span<const uint32_t> list = getClusterLights(clusterLights, cluster);
+    ASSERT_EQ(list.size(), 1u);
+    EXPECT_EQ(list[0], 1u);
+}
+
+TEST(LightClustersTest, SpotLightSphereContainsTheCone) {
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const glm::vec3 position(1.0f, 2.0f, -3.0f);
+    const glm::vec3 direction(0.0f, 0.6f, -0.8f);
+    const float     range = 10.0f;
+
+    for (const float angle : {5.0f, 30.0f, 44.0f, 46.0f, 70.0f, 120.0f}) {
+        const float                      cosOuter = std::cos(glm::radians(angle));
+        const LightClusters::LightSphere sphere   = LightClusters::makeSpotLightSphere(position, direction, range, cosOuter);
+        EXPECT_LE(sphere.radius, range * 1.0001f);
+
+        // Points lit by the spot: within the range and the outer cone.
+        for (uint32_t i = 0; i < 2000; ++i) {
+            const glm::vec3 offset = glm::vec3(unit(random), unit(random), unit(random)) * 2.0f * range - glm::vec3(range);
+            const float     length = glm::length(offset);
+            if (length > range || length == 0.0f || glm::dot(offset / length, direction) < cosOuter) {
+                continue;
+            }
+            EXPECT_LE(glm::length(position + offset - sphere.center), sphere.radius * 1.0001f);
+        }
+    }
+}
@@ -0,0 +1,132 @@
+#include "LightSystem.h"
+#include "TransformSystem.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kFrameCount = 2;
+
+entt::entity createPointLight(entt::registry& registry, float x) {
+    const entt::entity entity = registry.create();
+    registry.emplace<CPointLight>(entity).range        = 5.0f;
+    registry.emplace<CWorldTransform>(entity).model[3] = glm::vec4(x, 0.0f, 0.0f, 1.0f);
+    return entity;
+}
+
+/// @brief Light buffers of a frame slot.
+struct FrameBuffers {
+    std::vector<PointLight>       pointLights       = std::vector<PointLight>(16);
+    std::vector<SpotLight>        spotLights        = std::vector<SpotLight>(16);
+    std::vector<DirectionalLight> directionalLights = std::vector<DirectionalLight>(16);
+
+    uint32_t upload(LightSystem& lightSystem, uint32_t frameIndex) {
+        return lightSystem.upload(frameIndex, pointLights.data(), spotLights.data(), directionalLights.data());
+    }
+};
+
+} // namespace
+
+TEST(LightSystemTest, OnlyTheChangedLightsAreUploaded) {
+    entt::registry registry;
+    createPointLight(registry, 1.0f); // Created before the system.
+    LightSystem lightSystem(registry, kFrameCount);
+    const entt::entity moving = createPointLight(registry, 2.0f);
+    registry.emplace<CDirectionalLight>(registry.create()).color = {1.0f, 1.0f, 1.0f};
+    lightSystem.update();
+
+    ASSERT_EQ(lightSystem.getPointLightCount(), 2u);
+    ASSERT_EQ(lightSystem.getDirectionalLightCount(), 1u);
+    EXPECT_EQ(lightSystem.getSpotLightCount(), 0u);
+
+    // Each frame slot receives the lights once.
+    FrameBuffers frames[kFrameCount];
+    EXPECT_EQ(frames[0].upload(lightSystem, 0), 3u);
+    EXPECT_EQ(frames[1].upload(lightSystem, 1), 3u);
+    EXPECT_EQ(frames[0].upload(lightSystem, 0), 0u);
+
+    // A moved light is written to both frame slots, at its slot.
+    registry.patch<CWorldTransform>(moving, [](CWorldTransform& world) { world.model[3].x = 9.0f; });
+    lightSystem.update();
+    for (uint32_t frame = 0; frame < kFrameCount; ++frame) {
+        EXPECT_EQ(frames[frame].upload(lightSystem, frame), 1u);
+        EXPECT_EQ(frames[frame].pointLights[1].position.x, 9.0f);
+        EXPECT_EQ(frames[frame].pointLights[0].position.x, 1.0f);
+    }
+
+    // A transform which is not a light is ignored.
+    const entt::entity mesh = registry.create();
+    registry.emplace<CWorldTransform>(mesh);
+    registry.patch<CWorldTransform>(mesh);
+    lightSystem.update();
+    EXPECT_EQ(frames[0].upload(lightSystem, 0), 0u);
+
+    // All the lights after an invalidation.
+    lightSystem.invalidate(1);
+    EXPECT_EQ(frames[1].upload(lightSystem, 1), 3u);
+    EXPECT_EQ(frames[1].upload(lightSystem, 1), 0u);
+}
+
+TEST(LightSystemTest, SlotsAreStable) {
+    entt::registry registry;
+    LightSystem    lightSystem(registry, kFrameCount);
+    const entt::entity first  = createPointLight(registry, 1.0f);
+    const entt::entity second = createPointLight(registry, 2.0f);
+    const entt::entity third  = createPointLight(registry, 3.0f);
+    lightSystem.update();
+
+    // A destroyed light leaves a null light, the next lights keep their slot.
+    registry.destroy(second);
+    lightSystem.update();
+    ASSERT_EQ(lightSystem.getPointLightCount(), 3u);
+    EXPECT_EQ(lightSystem.getPointLights()[1].range, 0.0f);
+    EXPECT_EQ(lightSystem.getPointLights()[2].position.x, 3.0f);
+
+    // The released slot is reused.
+    createPointLight(registry, 4.0f);
+    lightSystem.update();
+    ASSERT_EQ(lightSystem.getPointLightCount(), 3u);
+    EXPECT_EQ(lightSystem.getPointLights()[1].position.x, 4.0f);
+
+    // A disabled light, or one without world transform, is a null light.
+    registry.patch<CPointLight>(first, [](CPointLight& light) { light.enable = false; });
+    registry.remove<CWorldTransform>(third);
+    lightSystem.update();
+    EXPECT_EQ(lightSystem.getPointLights()[0].range, 0.0f);
+    EXPECT_EQ(lightSystem.getPointLights()[2].range, 0.0f);
+
+    registry.patch<CPointLight>(first, [](CPointLight& light) { light.enable = true; });
+    lightSystem.update();
+    EXPECT_EQ(lightSystem.getPointLights()[0].range, 5.0f);
+}
+
+TEST(LightSystemTest, RecycledEntity) {
+    entt::registry registry;
+    LightSystem    lightSystem(registry, kFrameCount);
+    const entt::entity spot = registry.create();
+    registry.emplace<CWorldTransform>(spot);
+    auto& spotLight     = registry.emplace<CSpotLight>(spot);
+    spotLight.direction = {0.0f, 0.0f, -1.0f};
+    spotLight.range     = 3.0f;
+    lightSystem.update();
+    ASSERT_EQ(lightSystem.getSpotLightCount(), 1u);
+
+    // The identifier of the spot light is reused by a point light before the next update.
+    registry.destroy(spot);
+    const entt::entity point = createPointLight(registry, 7.0f);
+    ASSERT_EQ(entt::to_entity(point), entt::to_entity(spot));
+    lightSystem.update();
+    EXPECT_EQ(lightSystem.getSpotLights()[0].range, 0.0f);
+    ASSERT_EQ(lightSystem.getPointLightCount(), 1u);
+    EXPECT_EQ(lightSystem.getPointLights()[0].position.x, 7.0f);
+
+    // The spot light slot is free.
+    const entt::entity other = registry.create();
+    registry.emplace<CWorldTransform>(other);
+    registry.emplace<CSpotLight>(other).range = 1.0f;
+    lightSystem.update();
+    EXPECT_EQ(lightSystem.getSpotLightCount(), 1u);
+    EXPECT_EQ(lightSystem.getSpotLights()[0].range, 1.0f);
+}
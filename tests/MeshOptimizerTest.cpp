@@ -0,0 +1,178 @@
+#include "MeshOptimizer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// @brief A grid of quads in the XZ plane, the triangles in a random order.
+MeshData createShuffledGrid(uint32_t size) {
+    MeshData mesh;
+    for (uint32_t z = 0; z <= size; ++z) {
+        for (uint32_t x = 0; x <= size; ++x) {
+            MeshVertex vertex{};
+            vertex.position[0] = float(x);
+            vertex.position[2] = float(z);
+            vertex.normal[1]   = 1.0f;
+            vertex.uv[0]       = float(x) / float(size);
+            vertex.uv[1]       = float(z) / float(size);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t z = 0; z < size; ++z) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const uint32_t i0 = z * (size + 1) + x;
+            const uint32_t i1 = i0 + 1;
+            const uint32_t i2 = i0 + size + 1;
+            const uint32_t i3 = i2 + 1;
+            triangles.push_back({i0, i2, i1});
+            triangles.push_back({i1, i2, i3});
+        }
+    }
+    std::mt19937 random(42);
+    std::shuffle(triangles.begin(), triangles.end(), random);
+    for (const auto& triangle : triangles) {
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    }
+
+    MeshData::SubMesh subMesh;
+    subMesh.indexCount  = static_cast<uint32_t>(mesh.indices.size());
+    subMesh.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    subMesh.aabbMax     = {float(size), 0.0f, float(size)};
+    mesh.subMeshes.push_back(subMesh);
+    mesh.aabbMax = subMesh.aabbMax;
+    return mesh;
+}
+
+/// @brief The triangles as position triplets, rotated to start with the smallest vertex so the
+///        comparison ignores the order of the triangles and of the vertices but not the winding.
+std::vector<std::array<float, 9>> getTriangles(const MeshData& mesh) {
+    std::vector<std::array<float, 9>> triangles;
+    for (const MeshData::SubMesh& subMesh : mesh.subMeshes) {
+        for (uint32_t i = 0; i < subMesh.indexCount; i += 3) {
+            std::array<std::array<float, 3>, 3> corners;
+            for (uint32_t c = 0; c < 3; ++c) {
+                const MeshVertex& vertex = mesh.vertices[subMesh.vertexOffset + mesh.indices[subMesh.firstIndex + i + c]];
+                corners[c]               = {vertex.position[0], vertex.position[1], vertex.position[2]};
+            }
+            std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+            std::array<float, 9> triangle;
+            for (uint32_t c = 0; c < 3; ++c) {
+                std::copy(corners[c].begin(), corners[c].end(), triangle.begin() + c * 3);
+            }
+            triangles.push_back(triangle);
+        }
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+} // namespace
+
+TEST(MeshOptimizerTest, AnalyzeVertexCache) {
+    // Two triangles sharing an edge: 4 vertices transformed for 2 triangles.
+    const std::vector<uint32_t> indices    = {0, 1, 2, 2, 1, 3};
+    const auto                  statistics = MeshOptimizer::analyzeVertexCache(indices, 4);
+    EXPECT_FLOAT_EQ(statistics.acmr, 2.0f);
+    EXPECT_FLOAT_EQ(statistics.atvr, 1.0f);
+
+    // A cache of 3 entries evicts the vertex 0 before it is used again.
+    const std::vector<uint32_t> evicted = {0, 1, 2, 3, 4, 5, 0, 1, 2};
+    EXPECT_FLOAT_EQ(MeshOptimizer::analyzeVertexCache(evicted, 6, 3).acmr, 3.0f);
+    EXPECT_FLOAT_EQ(MeshOptimizer::analyzeVertexCache(evicted, 6, 16).acmr, 2.0f);
+}
+
+TEST(MeshOptimizerTest, VertexCacheImprovesAcmr) {
+    MeshData       mesh        = createShuffledGrid(64);
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    const auto     before      = MeshOptimizer::analyzeVertexCache(mesh.indices, vertexCount);
+    const auto     triangles   = getTriangles(mesh);
+
+    MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+    const auto after = MeshOptimizer::analyzeVertexCache(mesh.indices, vertexCount);
+
+    // A regular grid is close to 0.5 (each vertex shared by 6 triangles) when well ordered.
+    EXPECT_GT(before.acmr, 2.0f);
+    EXPECT_LT(after.acmr, 0.8f);
+    EXPECT_LT(after.atvr, 1.5f);
+    EXPECT_EQ(getTriangles(mesh), triangles);
+}
+
+TEST(MeshOptimizerTest, OverdrawKeepsTrianglesAndCacheEfficiency) {
+    MeshData       mesh        = createShuffledGrid(64);
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    const auto     triangles   = getTriangles(mesh);
+
+    MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+    const auto cacheOptimized = MeshOptimizer::analyzeVertexCache(mesh.indices, vertexCount);
+
+    constexpr float kThreshold = 1.05f;
+    MeshOptimizer::optimizeOverdraw(mesh.indices, mesh.vertices[0].position, sizeof(MeshVertex), vertexCount,
+                                    kThreshold);
+    const auto overdrawOptimized = MeshOptimizer::analyzeVertexCache(mesh.indices, vertexCount);
+
+    EXPECT_EQ(getTriangles(mesh), triangles);
+    // The clusters start with a cold cache, moving them only costs the threshold (and a bit of
+    // rounding on the cluster boundaries).
+    EXPECT_LE(overdrawOptimized.acmr, cacheOptimized.acmr * kThreshold + 0.05f);
+}
+
+TEST(MeshOptimizerTest, VertexFetchOrdersVerticesByFirstUse) {
+    MeshData       mesh        = createShuffledGrid(16);
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    const auto     triangles   = getTriangles(mesh);
+
+    // An unused vertex goes at the end.
+    MeshVertex unused{};
+    unused.position[1] = 100.0f;
+    mesh.vertices.insert(mesh.vertices.begin(), unused);
+    for (uint32_t& index : mesh.indices) {
+        ++index;
+    }
+    mesh.subMeshes[0].vertexCount = vertexCount + 1;
+
+    const uint32_t usedCount = MeshOptimizer::optimizeVertexFetch(mesh.indices, mesh.vertices.data(),
+                                                                  vertexCount + 1, sizeof(MeshVertex));
+    EXPECT_EQ(usedCount, vertexCount);
+    EXPECT_EQ(mesh.vertices.back().position[1], 100.0f);
+    EXPECT_EQ(getTriangles(mesh), triangles);
+
+    // Each index is at most one more than the largest index before it.
+    uint32_t next = 0;
+    for (const uint32_t index : mesh.indices) {
+        ASSERT_LE(index, next);
+        next = std::max(next, index + 1);
+    }
+}
+
+TEST(MeshOptimizerTest, OptimizeMeshData) {
+    // Two sub meshes, the second one using vertexOffset and firstIndex.
+    MeshData       mesh   = createShuffledGrid(32);
+    const MeshData second = createShuffledGrid(16);
+
+    MeshData::SubMesh subMesh   = second.subMeshes[0];
+    subMesh.firstIndex          = static_cast<uint32_t>(mesh.indices.size());
+    subMesh.vertexOffset        = static_cast<uint32_t>(mesh.vertices.size());
+    mesh.indices.insert(mesh.indices.end(), second.indices.begin(), second.indices.end());
+    mesh.vertices.insert(mesh.vertices.end(), second.vertices.begin(), second.vertices.end());
+    mesh.subMeshes.push_back(subMesh);
+
+    const auto triangles = getTriangles(mesh);
+    const auto report    = MeshOptimizer::optimize(mesh);
+
+    EXPECT_LT(report.after.acmr, report.before.acmr);
+    EXPECT_LT(report.after.atvr, report.before.atvr);
+    EXPECT_EQ(getTriangles(mesh), triangles);
+    for (const MeshData::SubMesh& optimized : mesh.subMeshes) {
+        for (uint32_t i = 0; i < optimized.indexCount; ++i) {
+            EXPECT_LT(mesh.indices[optimized.firstIndex + i], optimized.vertexCount);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#include "MeshShapes.h"
+
+#include "MeshSimplifier.h"
+
+#include <gtest/gtest.h>
+
+#include <span>
+
+namespace {
+
+/// @brief Return the number of indices of a LOD, the whole mesh when it has no LOD.
+size_t getLodIndexCount(const MeshData& mesh, size_t lod) {
+    if (mesh.lods.empty()) {
+        return mesh.indices.size();
+    }
+    size_t count = 0;
+    for (const MeshData::SubMesh& subMesh :
+         std::span(mesh.subMeshes).subspan(mesh.lods[lod].firstSubMesh, mesh.lods[lod].subMeshCount)) {
+        count += subMesh.indexCount;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(MeshShapesTest, GeoSphereWithoutSubdivisionIsAnIcosahedron) {
+    const MeshData mesh = MeshShapes::createGeoSphere(1.0f, 0);
+    ASSERT_FALSE(mesh.indices.empty());
+    EXPECT_TRUE(mesh.lods.empty());
+    EXPECT_EQ(getLodIndexCount(mesh, 0), 20u * 3u);
+}
+
+TEST(MeshShapesTest, GeoSphereLodsEndWithTheIcosahedron) {
+    const MeshData mesh = MeshShapes::createGeoSphere(1.0f, 2);
+    ASSERT_EQ(mesh.lods.size(), 3u);
+    EXPECT_EQ(getLodIndexCount(mesh, 0), 320u * 3u);
+    EXPECT_EQ(getLodIndexCount(mesh, 1), 80u * 3u);
+    EXPECT_EQ(getLodIndexCount(mesh, 2), 20u * 3u);
+    EXPECT_EQ(mesh.lods[0].error, 0.0f);
+    EXPECT_LT(mesh.lods[1].error, mesh.lods[2].error);
+}
+
+TEST(MeshShapesTest, GeoSphereLodCountIsCapped) {
+    const MeshData mesh = MeshShapes::createGeoSphere(1.0f, 5);
+    EXPECT_EQ(mesh.lods.size(), MeshSimplifier::kMaxLodCount);
+}
+
+TEST(MeshShapesTest, SphereLodsStopWhenTheCountsAreClamped) {
+    // 20 x 8, 10 x 4 then 8 x 4, halving again would give 8 x 4 once more.
+    const MeshData mesh = MeshShapes::createSphere(1.0f, 20, 8);
+    ASSERT_EQ(mesh.lods.size(), 3u);
+    for (size_t lod = 1; lod < mesh.lods.size(); ++lod) {
+        EXPECT_LT(getLodIndexCount(mesh, lod), getLodIndexCount(mesh, lod - 1));
+    }
+}
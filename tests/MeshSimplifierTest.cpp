@@ -0,0 +1,146 @@
+#include "MeshSimplifier.h"
+
+#include "MeshTestUtils.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// @brief Count the uses of each edge, by position.
+std::map<std::pair<std::tuple<float, float, float>, std::tuple<float, float, float>>, int>
+countEdges(const MeshData& mesh, std::span<const uint32_t> indices) {
+    std::map<std::pair<std::tuple<float, float, float>, std::tuple<float, float, float>>, int> edges;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int corner = 0; corner < 3; ++corner) {
+            const glm::vec3 a = getPosition(mesh, indices[i + corner]);
+            const glm::vec3 b = getPosition(mesh, indices[i + (corner + 1) % 3]);
+            auto            ka = std::make_tuple(a.x, a.y, a.z);
+            auto            kb = std::make_tuple(b.x, b.y, b.z);
+            edges[{std::min(ka, kb), std::max(ka, kb)}]++;
+        }
+    }
+    return edges;
+}
+
+} // namespace
+
+TEST(MeshSimplifierTest, FlatGridKeepsItsBorder) {
+    // A 33 x 33 grid on the plane y = 0, the interior collapses without error.
+    constexpr uint32_t kSize = 33;
+    MeshData           mesh;
+    for (uint32_t z = 0; z < kSize; ++z) {
+        for (uint32_t x = 0; x < kSize; ++x) {
+            MeshVertex vertex{};
+            vertex.position[0] = float(x);
+            vertex.position[2] = float(z);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    for (uint32_t z = 0; z + 1 < kSize; ++z) {
+        for (uint32_t x = 0; x + 1 < kSize; ++x) {
+            const uint32_t a = z * kSize + x;
+            mesh.indices.insert(mesh.indices.end(), {a, a + kSize, a + 1, a + 1, a + kSize, a + kSize + 1});
+        }
+    }
+
+    std::vector<uint32_t> result;
+    const float           error = MeshSimplifier::simplify(mesh.indices, mesh.vertices[0].position, sizeof(MeshVertex),
+                                                           static_cast<uint32_t>(mesh.vertices.size()), 0, FLT_MAX, result);
+    EXPECT_LT(result.size(), mesh.indices.size() / 4);
+    EXPECT_NEAR(error, 0.0f, 1e-4f);
+
+    // The border vertices are all still used, the area is unchanged and no triangle flipped.
+    std::vector<bool> used(mesh.vertices.size(), false);
+    float             area = 0.0f;
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const glm::vec3 a = getPosition(mesh, result[i]);
+        const glm::vec3 b = getPosition(mesh, result[i + 1]);
+        const glm::vec3 c = getPosition(mesh, result[i + 2]);
+        const glm::vec3 normal = glm::cross(b - a, c - a);
+        EXPECT_GT(normal.y, 0.0f);
+        area += normal.y / 2.0f;
+        used[result[i]] = used[result[i + 1]] = used[result[i + 2]] = true;
+    }
+    EXPECT_NEAR(area, float((kSize - 1) * (kSize - 1)), 1e-2f);
+    for (uint32_t i = 0; i < kSize; ++i) {
+        EXPECT_TRUE(used[i]) << i;
+        EXPECT_TRUE(used[(kSize - 1) * kSize + i]) << i;
+        EXPECT_TRUE(used[i * kSize]) << i;
+        EXPECT_TRUE(used[i * kSize + kSize - 1]) << i;
+    }
+}
+
+TEST(MeshSimplifierTest, SphereStaysClosedAndOriented) {
+    const MeshData mesh = createSphere(1.0f, 64, 32);
+
+    std::vector<uint32_t> result;
+    const auto            target = static_cast<uint32_t>(mesh.indices.size() / 8 / 3 * 3);
+    const float           error  = MeshSimplifier::simplify(mesh.indices, mesh.vertices[0].position, sizeof(MeshVertex),
+                                                            static_cast<uint32_t>(mesh.vertices.size()), target,
+                                                            FLT_MAX, result);
+    EXPECT_LE(result.size(), target);
+    EXPECT_GT(error, 0.0f);
+
+    // Every edge is still shared by two triangles: the seam didn't open.
+    for (const auto& [edge, uses] : countEdges(mesh, result)) {
+        ASSERT_EQ(uses, 2);
+    }
+
+    // The triangles face outwards and stay close to the sphere.
+    float maxDistance = 0.0f;
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const glm::vec3 a = getPosition(mesh, result[i]);
+        const glm::vec3 b = getPosition(mesh, result[i + 1]);
+        const glm::vec3 c = getPosition(mesh, result[i + 2]);
+        const glm::vec3 center = (a + b + c) / 3.0f;
+        ASSERT_GT(glm::dot(glm::cross(b - a, c - a), center), 0.0f);
+        maxDistance = std::max(maxDistance, 1.0f - glm::length(center));
+    }
+    EXPECT_LT(maxDistance, 0.2f);
+}
+
+TEST(MeshSimplifierTest, MaxErrorStopsTheSimplification) {
+    const MeshData        mesh = createSphere(1.0f, 32, 16);
+    std::vector<uint32_t> result;
+    const float           error = MeshSimplifier::simplify(mesh.indices, mesh.vertices[0].position, sizeof(MeshVertex),
+                                                           static_cast<uint32_t>(mesh.vertices.size()), 0, 0.01f, result);
+    EXPECT_LE(error, 0.01f);
+    EXPECT_GT(result.size(), mesh.indices.size() / 4);
+}
+
+TEST(MeshSimplifierTest, GenerateLods) {
+    MeshData       mesh         = createSphere(1.0f, 64, 32);
+    const auto     vertexCount  = mesh.vertices.size();
+    const uint32_t lodCount     = MeshSimplifier::generateLods(mesh);
+    ASSERT_GE(lodCount, 3u);
+    ASSERT_EQ(mesh.lods.size(), lodCount);
+    ASSERT_EQ(mesh.subMeshes.size(), lodCount);
+    EXPECT_EQ(mesh.vertices.size(), vertexCount);
+
+    for (uint32_t lod = 1; lod < lodCount; ++lod) {
+        const MeshData::SubMesh& previous = mesh.subMeshes[mesh.lods[lod - 1].firstSubMesh];
+        const MeshData::SubMesh& current  = mesh.subMeshes[mesh.lods[lod].firstSubMesh];
+        EXPECT_EQ(mesh.lods[lod].subMeshCount, 1u);
+        EXPECT_GT(mesh.lods[lod].error, mesh.lods[lod - 1].error);
+        EXPECT_LE(current.indexCount * 4, previous.indexCount * 3);
+        EXPECT_EQ(current.vertexOffset, previous.vertexOffset);
+        EXPECT_EQ(current.firstIndex + current.indexCount <= mesh.indices.size(), true);
+    }
+
+    // Already done.
+    EXPECT_EQ(MeshSimplifier::generateLods(mesh), lodCount);
+}
+
+TEST(MeshSimplifierTest, SelectLod) {
+    const std::vector<MeshData::Lod> lods = {{0, 1, 0.0f}, {1, 1, 0.01f}, {2, 1, 0.05f}};
+    EXPECT_EQ(selectMeshLod({}, 1.0f), 0u);
+    EXPECT_EQ(selectMeshLod(lods, 0.0f), 0u);
+    EXPECT_EQ(selectMeshLod(lods, 0.009f), 0u);
+    EXPECT_EQ(selectMeshLod(lods, 0.01f), 1u);
+    EXPECT_EQ(selectMeshLod(lods, 0.04f), 1u);
+    EXPECT_EQ(selectMeshLod(lods, 1.0f), 2u);
+}
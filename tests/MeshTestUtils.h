@@ -0,0 +1,59 @@
+#pragma once
+#include "MeshData.h"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+/// @brief Meshes shared by the tests of the mesh processing (simplification, meshlets).
+
+inline glm::vec3 getPosition(const MeshData& mesh, uint32_t index) {
+    const float* position = mesh.vertices[index].position;
+    return {position[0], position[1], position[2]};
+}
+
+/// @brief UV sphere, the triangles face outwards. The first and last columns are at the same
+///        positions with different uv (a seam), the poles are welded to one position.
+inline MeshData createSphere(float radius, uint32_t sliceCount, uint32_t stackCount) {
+    MeshData mesh;
+    for (uint32_t stack = 0; stack <= stackCount; ++stack) {
+        const float phi = std::numbers::pi_v<float> * float(stack) / float(stackCount);
+        for (uint32_t slice = 0; slice <= sliceCount; ++slice) {
+            // The seam column shares the positions of the first one.
+            const float theta = 2.0f * std::numbers::pi_v<float> * float(slice % sliceCount) / float(sliceCount);
+            MeshVertex  vertex{};
+            const glm::vec3 normal(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            const glm::vec3 position = (stack == 0 || stack == stackCount) ? glm::vec3(0.0f, std::cos(phi), 0.0f) * radius
+                                                                             : normal * radius;
+            for (int axis = 0; axis < 3; ++axis) {
+                vertex.position[axis] = position[axis];
+                vertex.normal[axis]   = normal[axis];
+            }
+            vertex.uv[0] = float(slice) / float(sliceCount);
+            vertex.uv[1] = float(stack) / float(stackCount);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    const uint32_t rowSize = sliceCount + 1;
+    for (uint32_t stack = 0; stack < stackCount; ++stack) {
+        for (uint32_t slice = 0; slice < sliceCount; ++slice) {
+            const uint32_t a = stack * rowSize + slice;
+            const uint32_t b = a + 1;
+            const uint32_t c = a + rowSize;
+            const uint32_t d = c + 1;
+            if (stack != 0) {
+                mesh.indices.insert(mesh.indices.end(), {a, b, c});
+            }
+            if (stack != stackCount - 1) {
+                mesh.indices.insert(mesh.indices.end(), {b, d, c});
+            }
+        }
+    }
+    mesh.subMeshes.push_back({static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(mesh.vertices.size()),
+                              0, 0, glm::vec3(-radius), glm::vec3(radius)});
+    mesh.aabbMin = glm::vec3(-radius);
+    mesh.aabbMax = glm::vec3(radius);
+    return mesh;
+}
@@ -0,0 +1,157 @@
+#include "MeshletBuilder.h"
+
+#include "MeshTestUtils.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+/// @brief The triangles of an index list, rotated so the smallest index is first (the winding is kept).
+std::multiset<std::array<uint32_t, 3>> getTriangles(std::span<const uint32_t> indices) {
+    std::multiset<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        std::array<uint32_t, 3> triangle{indices[i], indices[i + 1], indices[i + 2]};
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.insert(triangle);
+    }
+    return triangles;
+}
+
+} // namespace
+
+TEST(MeshletBuilderTest, MeshletsCoverTheTriangles) {
+    MeshData                    mesh   = createSphere(1.0f, 64, 32);
+    const std::vector<uint32_t> source = mesh.indices;
+
+    std::vector<MeshData::Meshlet> meshlets;
+    const uint32_t count = MeshletBuilder::build(mesh.indices, mesh.vertices[0].position, sizeof(MeshVertex),
+                                                 static_cast<uint32_t>(mesh.vertices.size()), meshlets);
+    ASSERT_EQ(count, meshlets.size());
+    ASSERT_GT(count, 1u);
+
+    // Same triangles with the same winding, each one in exactly one meshlet.
+    EXPECT_EQ(getTriangles(mesh.indices), getTriangles(source));
+
+    uint32_t firstIndex = 0;
+    uint32_t triangleCount = 0;
+    for (const MeshData::Meshlet& meshlet : meshlets) {
+        EXPECT_EQ(meshlet.firstIndex, firstIndex);
+        EXPECT_GT(meshlet.triangleCount, 0u);
+        EXPECT_LE(meshlet.triangleCount, MeshletBuilder::kMaxTriangleCount);
+        EXPECT_LE(meshlet.vertexCount, MeshletBuilder::kMaxVertexCount);
+
+        const std::span<const uint32_t> indices(mesh.indices.data() + meshlet.firstIndex, meshlet.triangleCount * 3);
+        const std::set<uint32_t>        vertices(indices.begin(), indices.end());
+        EXPECT_EQ(vertices.size(), meshlet.vertexCount);
+
+        firstIndex += meshlet.triangleCount * 3;
+        triangleCount += meshlet.triangleCount;
+    }
+    EXPECT_EQ(firstIndex, mesh.indices.size());
+
+    // The meshlets are mostly full, the greedy growth doesn't leave a trail of small ones.
+    EXPECT_LT(count, triangleCount / MeshletBuilder::kMaxTriangleCount * 2);
+}
+
+TEST(MeshletBuilderTest, BoundsContainTheTriangles) {
+    MeshData                       mesh = createSphere(2.0f, 48, 24);
+    std::vector<MeshData::Meshlet> meshlets;
+    MeshletBuilder::build(mesh.indices, mesh.vertices[0].position, sizeof(MeshVertex),
+                          static_cast<uint32_t>(mesh.vertices.size()), meshlets);
+
+    std::mt19937                          random(42);
+    std::uniform_real_distribution<float> coordinate(-6.0f, 6.0f);
+    uint32_t                              culledCount = 0;
+    for (const MeshData::Meshlet& meshlet : meshlets) {
+        EXPECT_NEAR(glm::length(meshlet.coneAxis), 1.0f, 1e-4f);
+        EXPECT_LT(meshlet.coneCutoff, 1.0f);
+
+        for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.triangleCount * 3; ++i) {
+            EXPECT_LE(glm::length(getPosition(mesh, mesh.indices[i]) - meshlet.center), meshlet.radius * 1.0001f);
+        }
+
+        // When the cone test culls, every triangle of the meshlet faces away from the viewer.
+        for (int sample = 0; sample < 64; ++sample) {
+            const glm::vec3 viewPosition(coordinate(random), coordinate(random), coordinate(random));
+            if (!MeshletBuilder::isBackFacing(meshlet, viewPosition)) {
+                continue;
+            }
+            culledCount++;
+            for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.triangleCount * 3; i += 3) {
+                const glm::vec3 a = getPosition(mesh, mesh.indices[i]);
+                const glm::vec3 b = getPosition(mesh, mesh.indices[i + 1]);
+                const glm::vec3 c = getPosition(mesh, mesh.indices[i + 2]);
+                ASSERT_LE(glm::dot(glm::cross(b - a, c - a), viewPosition - a), 0.0f);
+            }
+        }
+    }
+    // Seen from outside, about half of a sphere faces away.
+    EXPECT_GT(culledCount, meshlets.size() * 64 / 8);
+}
+
+TEST(MeshletBuilderTest, FlatGridIsCulledFromBehind) {
+    // A 40 x 40 grid on the plane y = 0, facing +y.
+    constexpr uint32_t kSize = 40;
+    MeshData           mesh;
+    for (uint32_t z = 0; z < kSize; ++z) {
+        for (uint32_t x = 0; x < kSize; ++x) {
+            MeshVertex vertex{};
+            vertex.position[0] = float(x);
+            vertex.position[2] = float(z);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    for (uint32_t z = 0; z + 1 < kSize; ++z) {
+        for (uint32_t x = 0; x + 1 < kSize; ++x) {
+            const uint32_t a = z * kSize + x;
+            mesh.indices.insert(mesh.indices.end(), {a, a + kSize, a + 1, a + 1, a + kSize, a + kSize + 1});
+        }
+    }
+
+    std::vector<MeshData::Meshlet> meshlets;
+    MeshletBuilder::build(mesh.indices, mesh.vertices[0].position, sizeof(MeshVertex),
+                          static_cast<uint32_t>(mesh.vertices.size()), meshlets);
+    for (const MeshData::Meshlet& meshlet : meshlets) {
+        EXPECT_NEAR(meshlet.coneAxis.y, 1.0f, 1e-5f);
+        EXPECT_NEAR(meshlet.coneCutoff, 0.0f, 1e-3f);
+        EXPECT_TRUE(MeshletBuilder::isBackFacing(meshlet, {20.0f, -100.0f, 20.0f}));
+        EXPECT_FALSE(MeshletBuilder::isBackFacing(meshlet, {20.0f, 100.0f, 20.0f}));
+    }
+}
+
+TEST(MeshletBuilderTest, BuildMeshletsOfTheSubMeshes) {
+    // Two sub meshes sharing the vertices, like the LODs of a simplified mesh.
+    MeshData       mesh       = createSphere(1.0f, 32, 16);
+    const uint32_t indexCount = static_cast<uint32_t>(mesh.indices.size());
+    mesh.indices.insert(mesh.indices.end(), mesh.indices.begin(), mesh.indices.begin() + indexCount / 2 / 3 * 3);
+    MeshData::SubMesh second = mesh.subMeshes[0];
+    second.firstIndex        = indexCount;
+    second.indexCount        = static_cast<uint32_t>(mesh.indices.size()) - indexCount;
+    mesh.subMeshes.push_back(second);
+    // An empty sub mesh has no meshlet.
+    mesh.subMeshes.push_back({0, 0, static_cast<uint32_t>(mesh.indices.size()), 0, {}, {}});
+
+    const uint32_t count = MeshletBuilder::buildMeshlets(mesh);
+    ASSERT_EQ(count, mesh.meshlets.size());
+    EXPECT_EQ(mesh.subMeshes[0].firstMeshlet, 0u);
+    EXPECT_EQ(mesh.subMeshes[1].firstMeshlet, mesh.subMeshes[0].meshletCount);
+    EXPECT_EQ(mesh.subMeshes[0].meshletCount + mesh.subMeshes[1].meshletCount, count);
+    EXPECT_EQ(mesh.subMeshes[2].meshletCount, 0u);
+
+    for (const MeshData::SubMesh& subMesh : mesh.subMeshes) {
+        uint32_t triangleCount = 0;
+        for (uint32_t i = subMesh.firstMeshlet; i < subMesh.firstMeshlet + subMesh.meshletCount; ++i) {
+            triangleCount += mesh.meshlets[i].triangleCount;
+        }
+        EXPECT_EQ(triangleCount * 3, subMesh.indexCount);
+    }
+
+    // Already done.
+    EXPECT_EQ(MeshletBuilder::buildMeshlets(mesh), count);
+}
@@ -0,0 +1,139 @@
+#include "Ktx2File.h"
+#include "TextureCompression.h"
+
+#include <Engine/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+using namespace TextureCompression;
+
+namespace {
+
+constexpr uint32_t kWidth  = 512;
+constexpr uint32_t kHeight = 256;
+
+/// @brief A deterministic image with smooth gradients, edges and a bit of noise, like a real texture.
+Image createTestImage() {
+    Image image;
+    image.width  = kWidth;
+    image.height = kHeight;
+    image.texels.resize(size_t(kWidth) * kHeight * 4);
+    uint32_t seed = 1234;
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            seed             = seed * 1664525u + 1013904223u;
+            const int  noise = static_cast<int>(seed >> 28) - 8;
+            const bool tile  = ((x / 32) + (y / 32)) % 2 == 0;
+            uint8_t*   texel = &image.texels[(size_t(y) * kWidth + x) * 4];
+            texel[0] = static_cast<uint8_t>(std::clamp<int>(x * 255 / kWidth + noise, 0, 255));
+            texel[1] = static_cast<uint8_t>(std::clamp<int>(y * 255 / kHeight + noise, 0, 255));
+            texel[2] = static_cast<uint8_t>(tile ? 200 : 60);
+            texel[3] = static_cast<uint8_t>(128 + 127 * std::sin(x * 0.05f));
+        }
+    }
+    return image;
+}
+
+/// @brief A normal map of bumps, stored in [0, 1].
+Image createTestNormalMap() {
+    Image image;
+    image.width  = kWidth;
+    image.height = kHeight;
+    image.texels.resize(size_t(kWidth) * kHeight * 4);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            const float nx    = 0.5f * std::sin(x * 0.1f);
+            const float ny    = 0.5f * std::cos(y * 0.07f);
+            const float nz    = std::sqrt(std::max(0.0f, 1.0f - nx * nx - ny * ny));
+            uint8_t*    texel = &image.texels[(size_t(y) * kWidth + x) * 4];
+            texel[0] = static_cast<uint8_t>((nx * 0.5f + 0.5f) * 255.0f + 0.5f);
+            texel[1] = static_cast<uint8_t>((ny * 0.5f + 0.5f) * 255.0f + 0.5f);
+            texel[2] = static_cast<uint8_t>((nz * 0.5f + 0.5f) * 255.0f + 0.5f);
+            texel[3] = 255;
+        }
+    }
+    return image;
+}
+
+double roundTripPSNR(BlockFormat format, const Image& image, uint32_t channelCount) {
+    const std::vector<uint8_t> blocks = compress(format, image);
+    EXPECT_EQ(blocks.size(), getCompressedSize(format, image.width, image.height));
+    const Image decoded = decompress(format, blocks.data(), image.width, image.height);
+    return computePSNR(image, decoded, channelCount);
+}
+
+} // namespace
+
+class TextureCookerTest : public testing::Test {
+protected:
+    static void SetUpTestSuite() { Engine::Log::Initialize(); }
+    static void TearDownTestSuite() { Engine::Log::Shutdown(); }
+
+    void SetUp() override {
+        mDirectory = std::filesystem::temp_directory_path() / "TextureCookerTest";
+        std::filesystem::create_directories(mDirectory);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(mDirectory); }
+
+    std::filesystem::path mDirectory;
+};
+
+TEST_F(TextureCookerTest, RoundTripPSNR) {
+    const Image image     = createTestImage();
+    const Image normalMap = createTestNormalMap();
+
+    // BC1 has no alpha, compare the color only.
+    EXPECT_GE(roundTripPSNR(BlockFormat::BC1, image, 3), 32.0);
+    EXPECT_GE(roundTripPSNR(BlockFormat::BC3, image, 4), 32.0);
+    EXPECT_GE(roundTripPSNR(BlockFormat::BC7, image, 4), 35.0);
+    // BC5 keeps the x and y of the normals.
+    EXPECT_GE(roundTripPSNR(BlockFormat::BC5, normalMap, 2), 40.0);
+}
+
+TEST_F(TextureCookerTest, MipChain) {
+    const std::vector<Image> mipChain = generateMipChain(createTestImage(), MipFilter::SRGB);
+    ASSERT_EQ(mipChain.size(), 10u); // 512x256 down to 1x1
+    for (uint32_t level = 0; level < mipChain.size(); ++level) {
+        EXPECT_EQ(mipChain[level].width, std::max(1u, kWidth >> level));
+        EXPECT_EQ(mipChain[level].height, std::max(1u, kHeight >> level));
+    }
+
+    // The normals stay unit length after filtering.
+    const std::vector<Image> normalChain = generateMipChain(createTestNormalMap(), MipFilter::NormalMap);
+    for (const Image& level : normalChain) {
+        const uint8_t* texel = level.texels.data();
+        const float    x     = texel[0] / 127.5f - 1.0f;
+        const float    y     = texel[1] / 127.5f - 1.0f;
+        const float    z     = texel[2] / 127.5f - 1.0f;
+        EXPECT_NEAR(std::sqrt(x * x + y * y + z * z), 1.0f, 0.02f);
+    }
+}
+
+TEST_F(TextureCookerTest, Ktx2RoundTrip) {
+    const std::vector<Image>          mipChain = generateMipChain(createTestImage(), MipFilter::SRGB);
+    std::vector<std::vector<uint8_t>> levels;
+    for (const Image& level : mipChain) {
+        levels.push_back(compress(BlockFormat::BC7, level));
+    }
+
+    const std::filesystem::path path     = mDirectory / "texture.ktx2";
+    const uint32_t              vkFormat = getVkFormat(BlockFormat::BC7, true);
+    ASSERT_TRUE(Ktx2::write(path, vkFormat, kWidth, kHeight, levels));
+
+    Ktx2::Texture texture;
+    ASSERT_TRUE(Ktx2::read(path, texture));
+    EXPECT_EQ(texture.vkFormat, vkFormat);
+    EXPECT_EQ(texture.width, kWidth);
+    EXPECT_EQ(texture.height, kHeight);
+    ASSERT_EQ(texture.levels.size(), levels.size());
+    for (size_t level = 0; level < levels.size(); ++level) {
+        ASSERT_EQ(texture.levels[level].size(), levels[level].size());
+        EXPECT_EQ(std::memcmp(texture.levels[level].data(), levels[level].data(), levels[level].size()), 0);
+    }
+}
@@ -0,0 +1,178 @@
+#include "VertexQuantization.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+glm::vec3 toVec3(const float value[3]) { return {value[0], value[1], value[2]}; }
+
+/// @brief Angle in radian between two directions, acos() is not precise enough for small angles.
+float getAngle(const glm::vec3& a, const glm::vec3& b) {
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+glm::vec3 randomDirection(std::mt19937& random) {
+    std::normal_distribution<float> distribution;
+    glm::vec3 direction;
+    do {
+        direction = {distribution(random), distribution(random), distribution(random)};
+    } while (glm::dot(direction, direction) < 1e-6f);
+    return glm::normalize(direction);
+}
+
+} // namespace
+
+TEST(VertexQuantizationTest, PackedVertexIsLessThanHalf) {
+    EXPECT_EQ(VertexQuantization::getVertexSize(MeshVertexFormat::Float), 44u);
+    EXPECT_EQ(VertexQuantization::getVertexSize(MeshVertexFormat::Packed), 20u);
+}
+
+TEST(VertexQuantizationTest, PositionErrorIsHalfAStep) {
+    const glm::vec3 aabbMin(-3.0f, 0.5f, -100.0f);
+    const glm::vec3 aabbMax(7.0f, 0.75f, 250.0f);
+    const auto      quantization = VertexQuantization::getQuantization(aabbMin, aabbMax);
+
+    std::mt19937                          random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < 10000; ++i) {
+        MeshVertex vertex{};
+        for (int axis = 0; axis < 3; ++axis) {
+            vertex.position[axis] = aabbMin[axis] + unit(random) * (aabbMax[axis] - aabbMin[axis]);
+        }
+        const PackedMeshVertex packed  = VertexQuantization::encodeVertex(vertex, quantization, 7);
+        const MeshVertex       decoded = VertexQuantization::decodeVertex(packed, quantization);
+        ASSERT_EQ(packed.position[3], 7);
+        for (int axis = 0; axis < 3; ++axis) {
+            // Half a grid step, plus the rounding of the float operations.
+            const float extent = aabbMax[axis] - aabbMin[axis];
+            const float bound  = extent / 65535.0f / 2.0f + std::abs(aabbMax[axis]) * 4.0f * FLT_EPSILON;
+            ASSERT_LE(std::abs(decoded.position[axis] - vertex.position[axis]), bound) << "axis " << axis;
+        }
+    }
+
+    // The corners of the AABB are exact.
+    MeshVertex corner{};
+    corner.position[0] = aabbMax.x;
+    corner.position[1] = aabbMin.y;
+    corner.position[2] = aabbMax.z;
+    const MeshVertex decoded =
+        VertexQuantization::decodeVertex(VertexQuantization::encodeVertex(corner, quantization, 0), quantization);
+    EXPECT_FLOAT_EQ(decoded.position[0], aabbMax.x);
+    EXPECT_FLOAT_EQ(decoded.position[1], aabbMin.y);
+    EXPECT_FLOAT_EQ(decoded.position[2], aabbMax.z);
+}
+
+TEST(VertexQuantizationTest, FlatAABB) {
+    // A plane has a null extent on one axis, the positions must not be NaN.
+    const auto quantization = VertexQuantization::getQuantization({-1.0f, 2.0f, -1.0f}, {1.0f, 2.0f, 1.0f});
+    MeshVertex vertex{};
+    vertex.position[0] = 0.25f;
+    vertex.position[1] = 2.0f;
+    vertex.position[2] = -0.5f;
+    const MeshVertex decoded =
+        VertexQuantization::decodeVertex(VertexQuantization::encodeVertex(vertex, quantization, 0), quantization);
+    EXPECT_FLOAT_EQ(decoded.position[1], 2.0f);
+    EXPECT_NEAR(decoded.position[0], 0.25f, 2.0f / 65535.0f);
+    EXPECT_NEAR(decoded.position[2], -0.5f, 2.0f / 65535.0f);
+}
+
+TEST(VertexQuantizationTest, OctahedralErrorBound) {
+    // 16 bits per component, a step of the grid is at most about 4 / 32767 of the unfolded
+    // square, the closest of the 4 neighbours is within 1.3e-4 radian.
+    constexpr float kMaxAngle = 2e-4f;
+
+    std::mt19937 random(2);
+    float        maxAngle = 0.0f;
+    for (int i = 0; i < 100000; ++i) {
+        MeshVertex      vertex{};
+        const glm::vec3 normal  = randomDirection(random);
+        const glm::vec3 tangent = randomDirection(random);
+        for (int axis = 0; axis < 3; ++axis) {
+            vertex.normal[axis]  = normal[axis];
+            vertex.tangent[axis] = tangent[axis];
+        }
+        const SubMeshQuantization quantization{};
+        const MeshVertex          decoded =
+            VertexQuantization::decodeVertex(VertexQuantization::encodeVertex(vertex, quantization, 0), quantization);
+        maxAngle = std::max({maxAngle, getAngle(normal, toVec3(decoded.normal)),
+                             getAngle(tangent, toVec3(decoded.tangent))});
+        ASSERT_NEAR(glm::length(toVec3(decoded.normal)), 1.0f, 1e-5f);
+    }
+    EXPECT_LE(maxAngle, kMaxAngle);
+
+    // The axes and the seams of the octahedron.
+    const glm::vec3 directions[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1},
+                                    {0, 0, -1}, {1, 1, 0}, {-1, 0, -1}, {0.5f, -0.5f, -0.01f}};
+    for (const glm::vec3& direction : directions) {
+        const glm::vec3 decoded = VertexQuantization::decodeOctahedral(VertexQuantization::encodeOctahedral(direction));
+        EXPECT_LE(getAngle(direction, decoded), 1e-5f);
+    }
+}
+
+TEST(VertexQuantizationTest, HalfFloat) {
+    // Exact values.
+    for (const float value : {0.0f, 1.0f, -2.0f, 0.5f, 65504.0f, 0.000061035156f /*2^-14*/, 5.9604645e-8f /*2^-24*/}) {
+        EXPECT_EQ(VertexQuantization::decodeHalf(VertexQuantization::encodeHalf(value)), value) << value;
+    }
+    EXPECT_EQ(VertexQuantization::encodeHalf(1.0f), 0x3c00);
+    EXPECT_EQ(VertexQuantization::encodeHalf(-2.0f), 0xc000);
+    EXPECT_EQ(VertexQuantization::encodeHalf(1e6f), 0x7c00);
+    EXPECT_TRUE(std::isnan(VertexQuantization::decodeHalf(
+        VertexQuantization::encodeHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+    // Round to nearest: the relative error is at most 2^-11 for the normal values.
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> uv(-16.0f, 16.0f);
+    for (int i = 0; i < 100000; ++i) {
+        const float value   = uv(random);
+        const float decoded = VertexQuantization::decodeHalf(VertexQuantization::encodeHalf(value));
+        ASSERT_LE(std::abs(decoded - value), std::max(std::abs(value) * 0x1p-11f, 0x1p-25f)) << value;
+    }
+
+    // Every half survives the round trip.
+    for (uint32_t bits = 0; bits < 0x10000; ++bits) {
+        const auto half = static_cast<uint16_t>(bits);
+        if ((half & 0x7c00) == 0x7c00 && (half & 0x03ff)) {
+            continue; // NaN
+        }
+        ASSERT_EQ(VertexQuantization::encodeHalf(VertexQuantization::decodeHalf(half)), half) << bits;
+    }
+}
+
+TEST(VertexQuantizationTest, QuantizeSubMeshes) {
+    // Two sub meshes far apart, each one is quantized in its own AABB.
+    MeshData mesh;
+    for (int i = 0; i < 4; ++i) {
+        MeshVertex vertex{};
+        vertex.position[0] = float(i) * 0.001f;
+        vertex.normal[1]   = 1.0f;
+        mesh.vertices.push_back(vertex);
+    }
+    for (int i = 0; i < 4; ++i) {
+        MeshVertex vertex{};
+        vertex.position[0] = 1000.0f + float(i);
+        vertex.normal[1]   = 1.0f;
+        mesh.vertices.push_back(vertex);
+    }
+    mesh.subMeshes.push_back({0, 4, 0, 0, {}, {}});
+    mesh.subMeshes.push_back({0, 4, 0, 4, {}, {}});
+
+    const PackedMeshData packed = VertexQuantization::quantize(mesh);
+    ASSERT_EQ(packed.vertices.size(), mesh.vertices.size());
+    ASSERT_EQ(packed.subMeshes.size(), 2u);
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        const uint16_t subMeshIndex = packed.vertices[i].position[3];
+        ASSERT_EQ(subMeshIndex, i < 4 ? 0 : 1);
+        const MeshVertex decoded = VertexQuantization::decodeVertex(packed.vertices[i], packed.subMeshes[subMeshIndex]);
+        // The small sub mesh keeps its precision (3e-3 / 65535), not the one of the whole mesh.
+        const float extent = i < 4 ? 0.003f : 3.0f;
+        EXPECT_NEAR(decoded.position[0], mesh.vertices[i].position[0],
+                    extent / 65535.0f / 2.0f + std::abs(mesh.vertices[i].position[0]) * 4.0f * FLT_EPSILON);
+    }
+}